@@ -3333,6 +3333,21 @@ void* LexerNew(const wxString& content, size_t options )
     return scanner;
 }
 
+void* LexerNew(const char* buffer, size_t length, size_t options )
+{
+    yyscan_t scanner;
+    yylex_init(&scanner);
+    struct yyguts_t * yyg = (struct yyguts_t*)scanner;
+    CppLexerUserData *userData = new CppLexerUserData(options);
+    
+    userData->SetCurrentPF(NULL);
+    yyg->yyextra_r = userData;
+    
+    yy_switch_to_buffer(yy_scan_bytes(buffer,(int)length,scanner),scanner);
+    yycolumn = 1;
+    return scanner;
+}
+
 void* LexerNew(const wxFileName& filename, size_t options )
 {
     wxFileName fn = filename;
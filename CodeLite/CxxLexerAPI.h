@@ -253,6 +253,11 @@ typedef void* Scanner_t;
  */
 WXDLLIMPEXP_CL Scanner_t LexerNew(const wxString& buffer, size_t options = kLexerOpt_None);
 
+/**
+ * @brief create a new Lexer for a UTF-8 buffer of 'length' bytes (no encoding conversion is done)
+ */
+WXDLLIMPEXP_CL Scanner_t LexerNew(const char* buffer, size_t length, size_t options);
+
 /**
  * @brief create a scanner for a given file name
  */
@@ -1,11 +1,15 @@
 #include "CxxPreProcessor.h"
 #include <wx/regex.h>
 #include "file_logger.h"
+#include "fileutils.h"
 
 CxxPreProcessor::CxxPreProcessor()
     : m_options(0)
     , m_maxDepth(-1)
     , m_currentDepth(0)
+    , m_useHeaderCache(true)
+    , m_headersScanned(0)
+    , m_headersFromCache(0)
 {
 }
 
@@ -17,6 +21,11 @@ void CxxPreProcessor::Parse(const wxFileName& filename, size_t options)
     try {
         //CL_DEBUG("Calling CxxPreProcessor::Parse for file '%s'\n", filename.GetFullPath());
         m_options = options;
+        m_headersScanned = 0;
+        m_headersFromCache = 0;
+        m_recorders.clear();
+        m_modificationTimes.clear();
+        m_includePathsKey = wxJoin(m_includePaths, ';');
         scanner = new CxxPreProcessorScanner(filename, m_options);
         // Remove the option so recursive scanner won't get it
         m_options &= ~kLexerOpt_DontCollectMacrosDefinedInThisFile;
@@ -39,6 +48,183 @@ void CxxPreProcessor::Parse(const wxFileName& filename, size_t options)
 
     // Make sure that the scanner is deleted
     wxDELETE(scanner);
+    m_recorders.clear();
+    clDEBUG1() << "CxxPreProcessor:" << filename.GetFullName() << ":" << m_headersFromCache
+               << "headers taken from the cache," << m_headersScanned << "headers scanned" << clEndl;
+}
+
+void CxxPreProcessor::ParseInclude(const wxFileName& filename)
+{
+    if(m_useHeaderCache && ReplayHeader(filename)) {
+        ++m_headersFromCache;
+        return;
+    }
+    ++m_headersScanned;
+
+    wxString fullpath = filename.GetFullPath();
+    if(m_useHeaderCache) {
+        Recorder recorder;
+        recorder.entry.reset(new CxxPreProcessorHeaderCache::Entry());
+        recorder.entry->filename = fullpath;
+        recorder.entry->options = m_options;
+        recorder.entry->includePaths = m_includePathsKey;
+        m_recorders.push_back(recorder);
+
+        // this file is a dependency of all the headers being recorded
+        time_t lastModified = GetModificationTime(fullpath);
+        for(size_t i = 0; i < m_recorders.size(); ++i) {
+            m_recorders[i].entry->files.push_back(std::make_pair(fullpath, lastModified));
+        }
+    }
+
+    CxxPreProcessorScanner* scanner = new CxxPreProcessorScanner(filename, m_options);
+    try {
+        if(scanner && !scanner->IsNull()) {
+            scanner->Parse(this);
+        }
+    } catch(CxxLexerException& e) {
+        // catch the exception
+        CL_DEBUG("Exception caught: %s\n", e.message);
+    }
+    // make sure we always delete the scanner
+    wxDELETE(scanner);
+
+    if(m_useHeaderCache) {
+        CxxPreProcessorHeaderCache::Get().Insert(m_recorders.back().entry);
+        m_recorders.pop_back();
+    }
+}
+
+bool CxxPreProcessor::ReplayHeader(const wxFileName& filename)
+{
+    CxxPreProcessorHeaderCache::Entry::Vec_t variants = CxxPreProcessorHeaderCache::Get().Find(filename.GetFullPath());
+    for(size_t i = 0; i < variants.size(); ++i) {
+        const CxxPreProcessorHeaderCache::Entry& entry = *variants[i];
+        if(!IsEntryValid(entry)) continue;
+
+        // The state this header depends on is now a dependency of the headers being recorded
+        // (the current state matches the one recorded, so the lookups are simply repeated)
+        std::unordered_map<wxString, std::pair<bool, wxString> >::const_iterator iterMacro = entry.macros.begin();
+        for(; iterMacro != entry.macros.end(); ++iterMacro) {
+            RecordMacroLookup(iterMacro->first);
+        }
+        std::unordered_map<wxString, bool>::const_iterator iterInclude = entry.includes.begin();
+        for(; iterInclude != entry.includes.end(); ++iterInclude) {
+            RecordIncludeLookup(iterInclude->first);
+        }
+        for(size_t j = 0; j < m_recorders.size(); ++j) {
+            m_recorders[j].entry->files.insert(
+                m_recorders[j].entry->files.end(), entry.files.begin(), entry.files.end());
+        }
+
+        // Apply the header effects
+        for(size_t j = 0; j < entry.definitions.size(); ++j) {
+            DefineMacro(entry.definitions[j]);
+        }
+        std::unordered_map<wxString, wxString>::const_iterator iterMapping = entry.fileMapping.begin();
+        for(; iterMapping != entry.fileMapping.end(); ++iterMapping) {
+            AddFileMapping(iterMapping->first, iterMapping->second);
+        }
+        return true;
+    }
+    return false;
+}
+
+bool CxxPreProcessor::IsEntryValid(const CxxPreProcessorHeaderCache::Entry& entry)
+{
+    if(entry.options != m_options || entry.includePaths != m_includePathsKey) return false;
+
+    std::unordered_map<wxString, std::pair<bool, wxString> >::const_iterator iterMacro = entry.macros.begin();
+    for(; iterMacro != entry.macros.end(); ++iterMacro) {
+        CxxPreProcessorToken::Map_t::const_iterator iter = m_tokens.find(iterMacro->first);
+        bool defined = (iter != m_tokens.end());
+        if(defined != iterMacro->second.first) return false;
+        if(defined && iter->second.value != iterMacro->second.second) return false;
+    }
+
+    std::unordered_map<wxString, bool>::const_iterator iterInclude = entry.includes.begin();
+    for(; iterInclude != entry.includes.end(); ++iterInclude) {
+        bool resolved = (m_fileMapping.count(iterInclude->first) > 0);
+        if(resolved != iterInclude->second) return false;
+    }
+
+    // Last, make sure that none of the files was modified since it was scanned
+    for(size_t i = 0; i < entry.files.size(); ++i) {
+        if(GetModificationTime(entry.files[i].first) != entry.files[i].second) return false;
+    }
+    return true;
+}
+
+time_t CxxPreProcessor::GetModificationTime(const wxString& filename)
+{
+    // A file is checked once per Parse() call
+    std::unordered_map<wxString, time_t>::iterator iter = m_modificationTimes.find(filename);
+    if(iter != m_modificationTimes.end()) { return iter->second; }
+    time_t lastModified = FileUtils::GetFileModificationTime(wxFileName(filename));
+    m_modificationTimes.insert(std::make_pair(filename, lastModified));
+    return lastModified;
+}
+
+void CxxPreProcessor::RecordMacroLookup(const wxString& name)
+{
+    if(m_recorders.empty()) return;
+
+    CxxPreProcessorToken::Map_t::const_iterator iter = m_tokens.find(name);
+    std::pair<bool, wxString> state = (iter == m_tokens.end()) ? std::make_pair(false, wxString())
+                                                               : std::make_pair(true, iter->second.value);
+    for(size_t i = 0; i < m_recorders.size(); ++i) {
+        Recorder& recorder = m_recorders[i];
+        // a macro defined by the header itself is not part of its incoming state
+        if(recorder.defined.count(name) || recorder.entry->macros.count(name)) continue;
+        recorder.entry->macros.insert(std::make_pair(name, state));
+    }
+}
+
+void CxxPreProcessor::RecordIncludeLookup(const wxString& includeStatement)
+{
+    if(m_recorders.empty()) return;
+
+    bool resolved = (m_fileMapping.count(includeStatement) > 0);
+    for(size_t i = 0; i < m_recorders.size(); ++i) {
+        Recorder& recorder = m_recorders[i];
+        if(recorder.entry->fileMapping.count(includeStatement) || recorder.entry->includes.count(includeStatement)) {
+            continue;
+        }
+        recorder.entry->includes.insert(std::make_pair(includeStatement, resolved));
+    }
+}
+
+void CxxPreProcessor::AddFileMapping(const wxString& includeStatement, const wxString& filename)
+{
+    RecordIncludeLookup(includeStatement);
+    for(size_t i = 0; i < m_recorders.size(); ++i) {
+        m_recorders[i].entry->fileMapping.insert(std::make_pair(includeStatement, filename));
+    }
+
+    if(filename.IsEmpty()) {
+        // remember that we could not locate this include statement
+        m_noSuchFiles.insert(includeStatement);
+    }
+    m_fileMapping.insert(std::make_pair(includeStatement, filename));
+}
+
+const CxxPreProcessorToken* CxxPreProcessor::FindMacro(const wxString& name)
+{
+    RecordMacroLookup(name);
+    CxxPreProcessorToken::Map_t::const_iterator iter = m_tokens.find(name);
+    if(iter == m_tokens.end()) return NULL;
+    return &(iter->second);
+}
+
+void CxxPreProcessor::DefineMacro(const CxxPreProcessorToken& token)
+{
+    // Defining a macro depends on whether it already exists (existing definitions are kept)
+    RecordMacroLookup(token.name);
+    for(size_t i = 0; i < m_recorders.size(); ++i) {
+        m_recorders[i].defined.insert(token.name);
+        m_recorders[i].entry->definitions.push_back(token);
+    }
+    m_tokens.insert(std::make_pair(token.name, token));
 }
 
 bool
@@ -55,6 +241,7 @@ CxxPreProcessor::ExpandInclude(const wxFileName& currentFile, const wxString& in
 
     if(m_noSuchFiles.count(includeStatement)) {
         // wxPrintf("No such file hit\n");
+        RecordIncludeLookup(includeStatement);
         return false;
     }
 
@@ -63,6 +250,7 @@ CxxPreProcessor::ExpandInclude(const wxFileName& currentFile, const wxString& in
         // if this file has a mapped file, it means that we either
         // already scanned it or could not find a match for it
         // wxPrintf("File already been scanned\n");
+        RecordIncludeLookup(includeStatement);
         return false;
     }
 
@@ -79,7 +267,7 @@ CxxPreProcessor::ExpandInclude(const wxFileName& currentFile, const wxString& in
             if(fixedFileName.FileExists()) {
                 fixedFileName.Normalize(wxPATH_NORM_DOTS);
                 tmpfile = fixedFileName.GetFullPath();
-                m_fileMapping.insert(std::make_pair(includeStatement, tmpfile));
+                AddFileMapping(includeStatement, tmpfile);
                 outFile = fixedFileName;
                 return true;
             } else {
@@ -89,8 +277,7 @@ CxxPreProcessor::ExpandInclude(const wxFileName& currentFile, const wxString& in
     }
 
     // remember that we could not locate this include statement
-    m_noSuchFiles.insert(includeStatement);
-    m_fileMapping.insert(std::make_pair(includeStatement, wxString()));
+    AddFileMapping(includeStatement, wxString());
     return false;
 }
 
@@ -29,11 +29,19 @@
 #include "CxxLexerAPI.h"
 #include <wx/filename.h>
 #include "CxxPreProcessorScanner.h"
+#include "CxxPreProcessorHeaderCache.h"
 #include <set>
 #include "codelite_exports.h"
+#include "macros.h"
 
 class WXDLLIMPEXP_CL CxxPreProcessor
 {
+    // a header being scanned while its outcome is collected for the CxxPreProcessorHeaderCache
+    struct Recorder {
+        CxxPreProcessorHeaderCache::Entry::Ptr_t entry;
+        wxStringSet_t defined;
+    };
+
     CxxPreProcessorToken::Map_t m_tokens;
     wxArrayString m_includePaths;
     std::set<wxString> m_noSuchFiles;
@@ -41,6 +49,20 @@ class WXDLLIMPEXP_CL CxxPreProcessor
     size_t m_options;
     int m_maxDepth;
     int m_currentDepth;
+    bool m_useHeaderCache;
+    wxString m_includePathsKey;
+    std::vector<Recorder> m_recorders;
+    std::unordered_map<wxString, time_t> m_modificationTimes;
+    size_t m_headersScanned;
+    size_t m_headersFromCache;
+
+protected:
+    time_t GetModificationTime(const wxString& filename);
+    void RecordMacroLookup(const wxString& name);
+    void RecordIncludeLookup(const wxString& includeStatement);
+    void AddFileMapping(const wxString& includeStatement, const wxString& filename);
+    bool ReplayHeader(const wxFileName& filename);
+    bool IsEntryValid(const CxxPreProcessorHeaderCache::Entry& entry);
 
 public:
     CxxPreProcessor();
@@ -57,6 +79,12 @@ public:
 
     void SetOptions(size_t options) { this->m_options = options; }
     size_t GetOptions() const { return m_options; }
+    /**
+     * @brief when enabled (the default) the macros defined by header files are taken from the
+     * CxxPreProcessorHeaderCache when possible
+     */
+    void SetUseHeaderCache(bool useHeaderCache) { this->m_useHeaderCache = useHeaderCache; }
+    bool IsUseHeaderCache() const { return m_useHeaderCache; }
     /**
      * @brief return a command that generates a single file with all defines in it
      */
@@ -89,6 +117,22 @@ public:
      */
     void Parse(const wxFileName& filename, size_t options);
 
+    /**
+     * @brief parse an include file found by the scanner (after it was resolved with ExpandInclude)
+     */
+    void ParseInclude(const wxFileName& filename);
+
+    /**
+     * @brief find a macro by name
+     * @return the macro or NULL if it is not defined
+     */
+    const CxxPreProcessorToken* FindMacro(const wxString& name);
+
+    /**
+     * @brief define a macro found by the scanner. An existing definition is not modified
+     */
+    void DefineMacro(const CxxPreProcessorToken& token);
+
     /**
      * @brief return the definitions collected as an array
      * @return
@@ -0,0 +1,49 @@
+#include "CxxPreProcessorHeaderCache.h"
+
+// Number of variants (different incoming states) kept per header
+#define MAX_VARIANTS_PER_HEADER 4
+
+// Safety net: drop everything once the cache holds this many entries
+#define MAX_ENTRIES 20000
+
+CxxPreProcessorHeaderCache::CxxPreProcessorHeaderCache() {}
+
+CxxPreProcessorHeaderCache::~CxxPreProcessorHeaderCache() {}
+
+CxxPreProcessorHeaderCache& CxxPreProcessorHeaderCache::Get()
+{
+    static CxxPreProcessorHeaderCache cache;
+    return cache;
+}
+
+CxxPreProcessorHeaderCache::Entry::Vec_t CxxPreProcessorHeaderCache::Find(const wxString& filename)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::unordered_map<wxString, Entry::Vec_t>::iterator iter = m_entries.find(filename);
+    if(iter == m_entries.end()) { return Entry::Vec_t(); }
+    return iter->second;
+}
+
+void CxxPreProcessorHeaderCache::Insert(Entry::Ptr_t entry)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_count >= MAX_ENTRIES) {
+        m_entries.clear();
+        m_count = 0;
+    }
+
+    Entry::Vec_t& variants = m_entries[entry->filename];
+    variants.insert(variants.begin(), entry);
+    ++m_count;
+    if(variants.size() > MAX_VARIANTS_PER_HEADER) {
+        variants.pop_back();
+        --m_count;
+    }
+}
+
+void CxxPreProcessorHeaderCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+    m_count = 0;
+}
@@ -0,0 +1,70 @@
+#ifndef CXXPREPROCESSORHEADERCACHE_H
+#define CXXPREPROCESSORHEADERCACHE_H
+
+#include "CxxLexerAPI.h"
+#include "codelite_exports.h"
+#include "wxStringHash.h"
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <wx/string.h>
+
+/**
+ * @class CxxPreProcessorHeaderCache
+ * @brief a session wide cache of the macros contributed by each header file scanned by CxxPreProcessor.
+ * An entry records the outcome of scanning a header (and the headers it includes) together with the part of the
+ * incoming state the scan depended on: the macros tested before the header defined them, the include statements
+ * that were already resolved (include-once) and the modification time of every file scanned. A header included
+ * again with a matching state is replayed from the cache instead of being lexed.
+ * This class is thread safe
+ */
+class WXDLLIMPEXP_CL CxxPreProcessorHeaderCache
+{
+public:
+    struct Entry {
+        wxString filename;
+        size_t options = 0;
+        wxString includePaths;
+        // macros tested by the header before it defined them: name -> <defined, value>
+        std::unordered_map<wxString, std::pair<bool, wxString> > macros;
+        // include statements looked up by the header that it did not resolve itself: statement -> already resolved
+        std::unordered_map<wxString, bool> includes;
+        // the files scanned (the header and its nested includes) and their modification time
+        std::vector<std::pair<wxString, time_t> > files;
+        // the header effects, replayed on a cache hit
+        std::vector<CxxPreProcessorToken> definitions;
+        std::unordered_map<wxString, wxString> fileMapping;
+        typedef std::shared_ptr<Entry> Ptr_t;
+        typedef std::vector<Ptr_t> Vec_t;
+    };
+
+protected:
+    std::mutex m_mutex;
+    std::unordered_map<wxString, Entry::Vec_t> m_entries;
+    size_t m_count = 0;
+
+public:
+    static CxxPreProcessorHeaderCache& Get();
+
+    CxxPreProcessorHeaderCache();
+    virtual ~CxxPreProcessorHeaderCache();
+
+    /**
+     * @brief return the cached variants of 'filename' (most recent first)
+     */
+    Entry::Vec_t Find(const wxString& filename);
+
+    /**
+     * @brief add an entry to the cache. Only the most recent few variants of a header are kept
+     */
+    void Insert(Entry::Ptr_t entry);
+
+    /**
+     * @brief clear the cache content
+     */
+    void Clear();
+};
+
+#endif // CXXPREPROCESSORHEADERCACHE_H
@@ -65,9 +65,9 @@ private:
     void ReadUntilMatch(int type, CxxLexerToken& token) ;
     
     void GetRestOfPPLine(wxString &rest, bool collectNumberOnly = false);
-    bool CheckIfDefined(const CxxPreProcessorToken::Map_t& table);
-    bool CheckIf(const CxxPreProcessorToken::Map_t& table);
-    bool IsTokenExists(const CxxPreProcessorToken::Map_t& table, const CxxLexerToken& token);
+    bool CheckIfDefined(CxxPreProcessor* pp);
+    bool CheckIf(CxxPreProcessor* pp);
+    bool IsTokenExists(CxxPreProcessor* pp, const CxxLexerToken& token);
     
 public:
     CxxPreProcessorScanner(const wxFileName &file, size_t options);
@@ -39,6 +39,17 @@ void CxxTokenizer::Reset(const wxString& buffer)
     }
 }
 
+void CxxTokenizer::Reset(const char* buffer, size_t length)
+{
+    if(m_scanner) {
+        ::LexerDestroy(&m_scanner);
+    }
+    m_buffer.clear();
+    if(length) {
+        m_scanner = ::LexerNew(buffer, length, 0);
+    }
+}
+
 bool CxxTokenizer::ReadUntilClosingBracket(int delim, wxString& bufferRead)
 {
     CxxLexerToken tok;
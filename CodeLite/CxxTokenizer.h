@@ -27,6 +27,12 @@ public:
      */
     void Reset(const wxString& buffer);
 
+    /**
+     * @brief reset the lexer with a UTF-8 buffer (e.g. a clFileView). The buffer is copied by the lexer, so it may be
+     * released once this function returns
+     */
+    void Reset(const char* buffer, size_t length);
+
     /**
      * @brief read until 'delim' is found. Return true if 'delim' found
      * also, return the data read
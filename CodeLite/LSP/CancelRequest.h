@@ -0,0 +1,21 @@
+#ifndef CANCELREQUEST_H
+#define CANCELREQUEST_H
+
+#include "LSP/MessageWithParams.h"
+#include "LSP/Notification.h"
+
+namespace LSP
+{
+
+/**
+ * @brief the "$/cancelRequest" notification: ask the server to stop working on a request that is no longer needed.
+ * The server still replies to the cancelled request (usually with a kErrorCodeRequestCancelled error)
+ */
+class WXDLLIMPEXP_CL CancelRequest : public LSP::Notification
+{
+public:
+    CancelRequest(int requestId);
+    virtual ~CancelRequest();
+};
+};     // namespace LSP
+#endif // CANCELREQUEST_H
@@ -3,6 +3,8 @@
 
 #include <wx/filename.h>
 #include "LSP/Notification.h"
+#include "LSP/basic_types.h"
+#include <vector>
 
 namespace LSP
 {
@@ -10,7 +12,16 @@ namespace LSP
 class WXDLLIMPEXP_CL DidChangeTextDocumentRequest : public LSP::Notification
 {
 public:
+    /**
+     * @brief full document synchronization: send the entire file content
+     */
     DidChangeTextDocumentRequest(const wxFileName& filename, const std::string& fileContent);
+    /**
+     * @brief incremental synchronization: send the edits made since the last synchronization. The changes are
+     * applied by the server in the order they appear in the list
+     */
+    DidChangeTextDocumentRequest(const wxFileName& filename,
+                                 const std::vector<TextDocumentContentChangeEvent>& contentChanges);
     virtual ~DidChangeTextDocumentRequest();
 };
 
@@ -30,6 +30,13 @@ JSONItem LSP::InitializeRequest::ToJSON(const wxString& name, IPathConverter::Pt
     params.append(capabilities);
     JSONItem textDocument = JSONItem::createObject("textDocument");
     capabilities.append(textDocument);
+
+    // the document synchronization kind (full or incremental) is picked by the server, see
+    // LanguageServerProtocol::GetTextDocumentSyncKind()
+    JSONItem synchronization = JSONItem::createObject("synchronization");
+    textDocument.append(synchronization);
+    synchronization.addProperty("dynamicRegistration", false);
+    synchronization.addProperty("didSave", true);
     return json;
 }
 
@@ -0,0 +1,135 @@
+#include "LSP/MessageFramer.h"
+#include "file_logger.h"
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#define HEADER_CONTENT_LENGTH "content-length:"
+
+LSP::MessageFramer::MessageFramer() {}
+
+LSP::MessageFramer::~MessageFramer() {}
+
+void LSP::MessageFramer::RestoreTerminator()
+{
+    if(m_hasTerminator) {
+        m_buffer[m_terminatorPos] = m_terminatorSaved;
+        m_hasTerminator = false;
+    }
+}
+
+void LSP::MessageFramer::Compact()
+{
+    if(m_readPos == 0) { return; }
+    size_t count = m_writePos - m_readPos;
+    if(count) { ::memmove(m_buffer.data(), m_buffer.data() + m_readPos, count); }
+    m_scanPos -= m_readPos;
+    m_contentStart = (m_contentStart >= m_readPos) ? (m_contentStart - m_readPos) : 0;
+    m_writePos = count;
+    m_readPos = 0;
+}
+
+void LSP::MessageFramer::Append(const char* data, size_t len)
+{
+    RestoreTerminator();
+    if(len == 0) { return; }
+
+    if(m_readPos == m_writePos) {
+        // everything was consumed, start from the beginning of the buffer
+        m_readPos = m_writePos = m_scanPos = m_contentStart = 0;
+    }
+
+    // keep one spare byte for the payload terminator
+    if((m_writePos + len + 1) > m_buffer.size()) {
+        Compact();
+        if((m_writePos + len + 1) > m_buffer.size()) {
+            m_buffer.resize(std::max((m_writePos + len + 1), m_buffer.size() * 2));
+        }
+    }
+    ::memcpy(m_buffer.data() + m_writePos, data, len);
+    m_writePos += len;
+}
+
+bool LSP::MessageFramer::ParseHeader()
+{
+    // Look for the empty line that ends the header section. Resume the search where the previous call stopped
+    const char* base = m_buffer.data();
+    size_t start = std::max(m_scanPos, m_readPos);
+    size_t headerEnd = std::string::npos;
+    for(size_t i = start; (i + 3) < m_writePos; ++i) {
+        if(base[i] == '\r' && base[i + 1] == '\n' && base[i + 2] == '\r' && base[i + 3] == '\n') {
+            headerEnd = i;
+            break;
+        }
+    }
+    if(headerEnd == std::string::npos) {
+        // the separator might be split between two reads
+        m_scanPos = (m_writePos > 3) ? std::max(m_readPos, m_writePos - 3) : m_readPos;
+        return false;
+    }
+
+    // Parse the header lines (the names are case insensitive), we only care about Content-Length
+    bool found = false;
+    size_t lineStart = m_readPos;
+    while(lineStart < headerEnd) {
+        const char* lineEnd = (const char*)::memchr(base + lineStart, '\n', headerEnd - lineStart);
+        size_t lineLen = lineEnd ? (lineEnd - (base + lineStart)) : (headerEnd - lineStart);
+        size_t nameLen = sizeof(HEADER_CONTENT_LENGTH) - 1;
+        if(lineLen > nameLen && ::strncasecmp(base + lineStart, HEADER_CONTENT_LENGTH, nameLen) == 0) {
+            m_contentLength = ::strtoul(base + lineStart + nameLen, nullptr, 10);
+            found = true;
+        }
+        lineStart += lineLen + 1;
+    }
+
+    m_contentStart = headerEnd + 4;
+    m_scanPos = m_contentStart;
+    if(!found) {
+        // not a valid message header, skip it
+        clWARNING() << "LSP: received a message without a Content-Length header, ignoring it" << clEndl;
+        m_readPos = m_contentStart;
+        return false;
+    }
+    m_hasHeader = true;
+    return true;
+}
+
+bool LSP::MessageFramer::Next(const char*& payload, size_t& len)
+{
+    RestoreTerminator();
+    while(!m_hasHeader) {
+        if(m_readPos == m_writePos) { return false; }
+        size_t readPos = m_readPos;
+        if(!ParseHeader() && (m_readPos == readPos)) { return false; }
+    }
+
+    if((m_writePos - m_contentStart) < m_contentLength) {
+        // incomplete payload
+        return false;
+    }
+
+    payload = m_buffer.data() + m_contentStart;
+    len = m_contentLength;
+
+    // NUL terminate the payload. The byte we override belongs to the next message (or to the spare byte) so we
+    // restore it on the next call
+    m_terminatorPos = m_contentStart + m_contentLength;
+    m_terminatorSaved = m_buffer[m_terminatorPos];
+    m_buffer[m_terminatorPos] = 0;
+    m_hasTerminator = true;
+
+    // consume the message
+    m_readPos = m_terminatorPos;
+    m_scanPos = m_readPos;
+    m_hasHeader = false;
+    return true;
+}
+
+void LSP::MessageFramer::Clear()
+{
+    m_hasTerminator = false;
+    m_hasHeader = false;
+    m_readPos = m_writePos = m_scanPos = m_contentStart = 0;
+    m_contentLength = 0;
+}
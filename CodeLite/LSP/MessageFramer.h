@@ -0,0 +1,68 @@
+#ifndef LSP_MESSAGEFRAMER_H
+#define LSP_MESSAGEFRAMER_H
+
+#include "codelite_exports.h"
+#include <stddef.h>
+#include <vector>
+
+namespace LSP
+{
+
+/**
+ * @class MessageFramer
+ * @brief split the byte stream received from a language server into JSON-RPC messages.
+ * Each message is made of a header section (terminated by an empty line) followed by a 'Content-Length' bytes
+ * long UTF-8 payload. The header of a message is parsed once; the bytes are kept in a buffer that is reused for the
+ * lifetime of the connection (it only grows when a message bigger than any previous one arrives)
+ */
+class WXDLLIMPEXP_CL MessageFramer
+{
+    std::vector<char> m_buffer;
+    size_t m_readPos = 0;       // start of the unconsumed bytes
+    size_t m_writePos = 0;      // end of the unconsumed bytes
+    size_t m_scanPos = 0;       // where to resume the search for the end of the header section
+    size_t m_contentStart = 0;  // payload offset of the current message (valid when m_hasHeader is true)
+    size_t m_contentLength = 0; // payload length of the current message
+    bool m_hasHeader = false;   // true when the header section of the current message was parsed
+    size_t m_terminatorPos = 0; // see Next()
+    char m_terminatorSaved = 0;
+    bool m_hasTerminator = false;
+
+protected:
+    void RestoreTerminator();
+    void Compact();
+    bool ParseHeader();
+
+public:
+    MessageFramer();
+    virtual ~MessageFramer();
+
+    /**
+     * @brief append bytes received from the server
+     */
+    void Append(const char* data, size_t len);
+
+    /**
+     * @brief extract the next complete message
+     * @param payload [output] the message payload (UTF-8 JSON). The payload is NUL terminated (payload[len] == 0)
+     * so it can be passed as-is to a C JSON parser. It points into the internal buffer and remains valid until the
+     * next call to Append(), Next() or Clear()
+     * @param len [output] the payload length in bytes
+     * @return false if no complete message is available
+     */
+    bool Next(const char*& payload, size_t& len);
+
+    /**
+     * @brief discard all the buffered bytes
+     */
+    void Clear();
+
+    /**
+     * @brief number of bytes received but not consumed yet
+     */
+    size_t GetBufferedSize() const { return m_writePos - m_readPos; }
+};
+
+}; // namespace LSP
+
+#endif // LSP_MESSAGEFRAMER_H
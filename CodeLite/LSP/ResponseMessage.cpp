@@ -95,6 +95,21 @@ LSP::ResponseMessage::ResponseMessage(wxString& message, IPathConverter::Ptr_t p
     }
 }
 
+LSP::ResponseMessage::ResponseMessage(const char* payload, size_t len, IPathConverter::Ptr_t pathConverter)
+    : m_pathConverter(pathConverter)
+{
+    // parse the bytes directly, no need to go through wxString
+    m_json.reset(new JSON(cJSON_Parse(payload)));
+    if(!m_json->isOk()) {
+        m_json.reset(nullptr);
+        return;
+    }
+
+    // the raw text is only needed for error messages (see LSP::ResponseError)
+    if(Has("error")) { m_jsonMessage = wxString::FromUTF8(payload, len); }
+    FromJSON(m_json->toElement(), m_pathConverter);
+}
+
 LSP::ResponseMessage::~ResponseMessage() {}
 
 std::string LSP::ResponseMessage::ToString(IPathConverter::Ptr_t pathConverter) const
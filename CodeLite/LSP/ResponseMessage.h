@@ -24,6 +24,12 @@ protected:
 
 public:
     ResponseMessage(wxString& message, IPathConverter::Ptr_t pathConverter);
+    /**
+     * @brief construct a response from a complete message payload (see LSP::MessageFramer)
+     * @param payload UTF-8 JSON text, must be NUL terminated
+     * @param len the payload length in bytes
+     */
+    ResponseMessage(const char* payload, size_t len, IPathConverter::Ptr_t pathConverter);
     virtual ~ResponseMessage();
     virtual JSONItem ToJSON(const wxString& name, IPathConverter::Ptr_t pathConverter) const;
     virtual void FromJSON(const JSONItem& json, IPathConverter::Ptr_t pathConverter);
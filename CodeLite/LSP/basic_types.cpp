@@ -85,11 +85,13 @@ JSONItem TextDocumentItem::ToJSON(const wxString& name, IPathConverter::Ptr_t pa
 void TextDocumentContentChangeEvent::FromJSON(const JSONItem& json, IPathConverter::Ptr_t pathConverter)
 {
     m_text = json.namedObject("text").toString();
+    if(json.hasNamedObject("range")) { m_range.FromJSON(json.namedObject("range"), pathConverter); }
 }
 
 JSONItem TextDocumentContentChangeEvent::ToJSON(const wxString& name, IPathConverter::Ptr_t pathConverter) const
 {
     JSONItem json = JSONItem::createObject(name);
+    if(m_range.IsOk()) { json.append(m_range.ToJSON("range", pathConverter)); }
     json.addProperty("text", m_text);
     return json;
 }
@@ -104,7 +106,7 @@ JSONItem Range::ToJSON(const wxString& name, IPathConverter::Ptr_t pathConverter
 {
     JSONItem json = JSONItem::createObject(name);
     json.append(m_start.ToJSON("start", pathConverter));
-    json.append(m_start.ToJSON("end", pathConverter));
+    json.append(m_end.ToJSON("end", pathConverter));
     return json;
 }
 
@@ -121,4 +121,23 @@ JSONItem CompletionParams::ToJSON(const wxString& name, IPathConverter::Ptr_t pa
     JSONItem json = TextDocumentPositionParams::ToJSON(name, pathConverter);
     return json;
 }
+
+//===----------------------------------------------------------------------------------
+// CancelParams
+//===----------------------------------------------------------------------------------
+CancelParams::CancelParams() {}
+
+void CancelParams::FromJSON(const JSONItem& json, IPathConverter::Ptr_t pathConverter)
+{
+    wxUnusedVar(pathConverter);
+    m_id = json.namedObject("id").toInt(wxNOT_FOUND);
+}
+
+JSONItem CancelParams::ToJSON(const wxString& name, IPathConverter::Ptr_t pathConverter) const
+{
+    wxUnusedVar(pathConverter);
+    JSONItem json = JSONItem::createObject(name);
+    json.addProperty("id", m_id);
+    return json;
+}
 }; // namespace LSP
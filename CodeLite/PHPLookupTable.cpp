@@ -9,6 +9,12 @@
 #include "fileextmanager.h"
 #include "fileutils.h"
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <wx/filefn.h>
 #include <wx/filename.h>
 #include <wx/log.h>
 #include <wx/stopwatch.h>
@@ -21,6 +27,12 @@ wxDEFINE_EVENT(wxPHP_PARSE_PROGRESS, clParseEvent);
 
 static wxString PHP_SCHEMA_VERSION = "9.3.0.1";
 
+// Number of parsed files waiting to be stored. Bounds the memory used when the parsers are faster than the database
+#define PHP_PARSE_QUEUE_SIZE 256
+
+// Minimum interval between two wxPHP_PARSE_PROGRESS events
+#define PHP_PARSE_PROGRESS_INTERVAL_MS 250
+
 //------------------------------------------------
 // Metadata table
 //------------------------------------------------
@@ -816,6 +828,7 @@ void PHPLookupTable::Close()
     try {
         if(m_db.IsOpen()) { m_db.Close(); }
         m_filename.Clear();
+        std::lock_guard<std::mutex> lock(m_allClassesMutex);
         m_allClasses.clear();
 
     } catch(wxSQLite3Exception& e) {
@@ -944,6 +957,19 @@ wxLongLong PHPLookupTable::GetFileLastParsedTimestamp(const wxFileName& filename
     return 0;
 }
 
+void PHPLookupTable::GetFilesLastParsedTimestamp(std::unordered_map<wxString, time_t>& timestamps)
+{
+    timestamps.clear();
+    try {
+        wxSQLite3ResultSet res = m_db.ExecuteQuery("SELECT FILE_NAME, LAST_UPDATED FROM FILES_TABLE");
+        while(res.NextRow()) {
+            timestamps.insert({ res.GetString("FILE_NAME"), (time_t)res.GetInt64("LAST_UPDATED").GetValue() });
+        }
+    } catch(wxSQLite3Exception& e) {
+        CL_WARNING("PHPLookupTable::GetFilesLastParsedTimestamp: %s", e.GetMessage());
+    }
+}
+
 void PHPLookupTable::UpdateFileLastParsedTimestamp(const wxFileName& filename)
 {
     try {
@@ -1296,16 +1322,24 @@ void PHPLookupTable::DoFixVarsDocComment(PHPEntityBase::List_t& matches, wxLongL
 
 void PHPLookupTable::UpdateClassCache(const wxString& classname)
 {
+    std::lock_guard<std::mutex> lock(m_allClassesMutex);
     if(m_allClasses.count(classname) == 0) { m_allClasses.insert(classname); }
 }
 
-bool PHPLookupTable::ClassExists(const wxString& classname) const { return m_allClasses.count(classname) != 0; }
+bool PHPLookupTable::ClassExists(const wxString& classname) const
+{
+    std::lock_guard<std::mutex> lock(m_allClassesMutex);
+    return m_allClasses.count(classname) != 0;
+}
 
 void PHPLookupTable::RebuildClassCache()
 {
     // locate the scope
     clDEBUG() << "Rebuilding PHP class cache..." << clEndl;
-    m_allClasses.clear();
+    {
+        std::lock_guard<std::mutex> lock(m_allClassesMutex);
+        m_allClasses.clear();
+    }
     size_t count = 0;
     try {
         wxString sql;
@@ -1375,6 +1409,156 @@ size_t PHPLookupTable::FindFunctionsByFile(const wxFileName& filename, PHPEntity
     return functions.size();
 }
 
+static void SendParseEvent(wxEventType type, size_t totalFiles, size_t curfileIndex, const wxString& filename = "")
+{
+    clParseEvent event(type);
+    event.SetTotalFiles(totalFiles);
+    event.SetCurfileIndex(curfileIndex);
+    event.SetFileName(filename);
+    EventNotifier::Get()->AddPendingEvent(event);
+}
+
+void PHPLookupTable::RecreateSymbolsDatabase(const wxArrayString& files, eUpdateMode updateMode,
+                                             const std::function<bool()>& pFuncGoingDown, bool parseFuncBodies)
+{
+    // The files are parsed by a pool of threads. The calling thread owns the database connection and is the only
+    // one writing to it: it pops the parsed files from a bounded queue and stores them in a single transaction
+    std::mutex queueMutex;
+    std::condition_variable queueNotEmpty;
+    std::condition_variable queueNotFull;
+    std::deque<PHPSourceFile::Ptr_t> queue;
+    std::atomic_bool stop(false);
+    std::atomic<size_t> nextFile(0);
+    std::atomic<size_t> filesDone(0);
+    size_t runningParsers = 0;
+
+    // Load the timestamps once instead of querying the database per file
+    std::unordered_map<wxString, time_t> timestamps;
+    if(updateMode == kUpdateMode_Fast) { GetFilesLastParsedTimestamp(timestamps); }
+
+    auto parser = [&]() {
+        while(!stop) {
+            size_t i = nextFile++;
+            if(i >= files.GetCount()) { break; }
+
+            wxFileName fnFile(files.Item(i));
+            PHPSourceFile::Ptr_t source;
+
+            // Parse only valid PHP files. A single stat() tells us if the file exists and when it was modified
+            wxStructStat st;
+            if(FileExtManager::GetType(fnFile.GetFullName()) == FileExtManager::TypePhp &&
+               ::wxStat(fnFile.GetFullPath(), &st) == 0) {
+                bool reParseNeeded = true;
+                if(updateMode == kUpdateMode_Fast) {
+                    std::unordered_map<wxString, time_t>::const_iterator iter = timestamps.find(fnFile.GetFullPath());
+                    if(iter != timestamps.end() && st.st_mtime <= iter->second) { reParseNeeded = false; }
+                }
+
+                if(reParseNeeded) {
+                    source.reset(new PHPSourceFile(fnFile, this));
+                    source->SetParseFunctionBody(parseFuncBodies);
+                    source->Parse();
+                }
+            }
+            ++filesDone;
+            if(!source) { continue; }
+
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueNotFull.wait(lock, [&]() { return stop || queue.size() < PHP_PARSE_QUEUE_SIZE; });
+            if(stop) { break; }
+            queue.push_back(source);
+            queueNotEmpty.notify_one();
+        }
+
+        std::lock_guard<std::mutex> lock(queueMutex);
+        --runningParsers;
+        queueNotEmpty.notify_one();
+    };
+
+    // Make sure the parsers are stopped and joined on every exit path
+    struct ParsersJoiner {
+        std::vector<std::thread> threads;
+        std::atomic_bool& stop;
+        std::mutex& mutex;
+        std::condition_variable& notFull;
+        ParsersJoiner(std::atomic_bool& s, std::mutex& m, std::condition_variable& cv)
+            : stop(s)
+            , mutex(m)
+            , notFull(cv)
+        {
+        }
+        ~ParsersJoiner()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stop.store(true);
+            }
+            notFull.notify_all();
+            for(std::thread& thr : threads) {
+                thr.join();
+            }
+        }
+    } joiner(stop, queueMutex, queueNotFull);
+
+    SendParseEvent(wxPHP_PARSE_STARTED, files.GetCount(), 0);
+    wxStopWatch sw;
+    sw.Start();
+
+    try {
+        {
+            std::lock_guard<std::mutex> lock(m_allClassesMutex);
+            m_allClasses.clear(); // clear the cache
+        }
+        m_db.Begin();
+
+        // The calling thread is busy writing, so keep one core for it
+        size_t threadsCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+        if(threadsCount > 1) { --threadsCount; }
+        runningParsers = threadsCount;
+        for(size_t i = 0; i < threadsCount; ++i) {
+            joiner.threads.push_back(std::thread(parser));
+        }
+
+        wxStopWatch progressTimer;
+        progressTimer.Start();
+        while(!pFuncGoingDown()) {
+            PHPSourceFile::Ptr_t source;
+            {
+                // Wake up periodically so we can check pFuncGoingDown() even when the parsers are busy
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueNotEmpty.wait_for(lock, std::chrono::milliseconds(PHP_PARSE_PROGRESS_INTERVAL_MS),
+                                       [&]() { return !queue.empty() || runningParsers == 0; });
+                if(queue.empty() && runningParsers == 0) { break; }
+                if(!queue.empty()) {
+                    source = queue.front();
+                    queue.pop_front();
+                    queueNotFull.notify_one();
+                }
+            }
+
+            if(source) { UpdateSourceFile(*source, false); }
+            if(progressTimer.Time() >= PHP_PARSE_PROGRESS_INTERVAL_MS) {
+                SendParseEvent(wxPHP_PARSE_PROGRESS, files.GetCount(), filesDone,
+                               source ? source->GetFilename().GetFullPath() : wxString());
+                progressTimer.Start();
+            }
+        }
+        m_db.Commit();
+        clDEBUG1() << _("PHP: parsed ") << files.GetCount() << " in " << sw.Time() << " milliseconds" << clEndl;
+
+    } catch(wxSQLite3Exception& e) {
+        try {
+            m_db.Rollback();
+
+        } catch(...) {
+        }
+        clWARNING() << "PHPLookupTable::UpdateSourceFiles:" << e.GetMessage() << clEndl;
+    }
+
+    // always make sure that the end event is sent
+    SendParseEvent(wxPHP_PARSE_ENDED, files.GetCount(), files.GetCount());
+}
+
 void PHPLookupTable::ParseFolder(const wxString& folder, const wxString& filemask, eUpdateMode updateMode)
 {
     clFilesScanner scanner;
@@ -36,7 +36,10 @@
 #include "fileutils.h"
 #include "smart_ptr.h"
 #include "wx/wxsqlite3.h"
+#include <functional>
+#include <mutex>
 #include <set>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 #include <wx/longlong.h>
@@ -65,6 +68,8 @@ class WXDLLIMPEXP_CL PHPLookupTable
     wxFileName m_filename;
     size_t m_sizeLimit;
     std::unordered_set<wxString> m_allClasses;
+    // m_allClasses is read by the parsing threads while the database is updated
+    mutable std::mutex m_allClassesMutex;
 
 public:
     enum eLookupFlags {
@@ -146,6 +151,11 @@ private:
      */
     wxLongLong GetFileLastParsedTimestamp(const wxFileName& filename);
 
+    /**
+     * @brief load the timestamp of the last parse of every file in the database with a single query
+     */
+    void GetFilesLastParsedTimestamp(std::unordered_map<wxString, time_t>& timestamps);
+
     /**
      * @brief update the file's last updated timestamp
      */
@@ -282,12 +292,13 @@ public:
     void UpdateSourceFile(PHPSourceFile& source, bool autoCommit = true);
 
     /**
-     * @brief update list of source files
+     * @brief update list of source files. The files are parsed by a pool of threads while the calling thread
+     * stores the results into the database
+     * @param pFuncGoingDown polled by the calling thread, return true to stop
      */
-    template <typename GoindDownFunc>
-    void RecreateSymbolsDatabase(const wxArrayString& files, eUpdateMode updateMode, GoindDownFunc pFuncGoingDown,
-                                 bool parseFuncBodies = true);
-    
+    void RecreateSymbolsDatabase(const wxArrayString& files, eUpdateMode updateMode,
+                                 const std::function<bool()>& pFuncGoingDown, bool parseFuncBodies = true);
+
     /**
      * @brief parse folder
      */
@@ -312,99 +323,4 @@ public:
     wxSQLite3Database& Database() { return m_db; }
 };
 
-template <typename GoindDownFunc>
-void PHPLookupTable::RecreateSymbolsDatabase(const wxArrayString& files, eUpdateMode updateMode,
-                                             GoindDownFunc pFuncGoingDown, bool parseFuncBodies)
-{
-    try {
-
-        {
-            clParseEvent event(wxPHP_PARSE_STARTED);
-            event.SetTotalFiles(files.GetCount());
-            event.SetCurfileIndex(0);
-            EventNotifier::Get()->AddPendingEvent(event);
-        }
-
-        wxStopWatch sw;
-        sw.Start();
-
-        m_allClasses.clear(); // clear the cache
-        m_db.Begin();
-        for(size_t i = 0; i < files.GetCount(); ++i) {
-            if(pFuncGoingDown()) { break; }
-            {
-                clParseEvent event(wxPHP_PARSE_PROGRESS);
-                event.SetTotalFiles(files.GetCount());
-                event.SetCurfileIndex(i);
-                event.SetFileName(files.Item(i));
-                EventNotifier::Get()->AddPendingEvent(event);
-            }
-
-            wxFileName fnFile(files.Item(i));
-            bool reParseNeeded(true);
-
-            if(updateMode == kUpdateMode_Fast) {
-                // Check to see if we need to re-parse this file
-                // and store it to the database
-
-                if(!fnFile.Exists()) {
-                    reParseNeeded = false;
-                } else {
-                    time_t lastModifiedOnDisk = fnFile.GetModificationTime().GetTicks();
-                    wxLongLong lastModifiedInDB = GetFileLastParsedTimestamp(fnFile);
-                    if(lastModifiedOnDisk <= lastModifiedInDB.ToLong()) { reParseNeeded = false; }
-                }
-            }
-
-            // Ensure that the file exists
-            if(!fnFile.Exists()) { reParseNeeded = false; }
-
-            // Parse only valid PHP files
-            if(FileExtManager::GetType(fnFile.GetFullName()) != FileExtManager::TypePhp) { reParseNeeded = false; }
-
-            if(reParseNeeded) {
-                // For performance reaons, load the file into memory and then parse it
-                wxFileName fnSourceFile(files.Item(i));
-                wxString content;
-                if(!FileUtils::ReadFileContent(fnSourceFile, content, wxConvISO8859_1)) {
-                    clWARNING() << "PHP: Failed to read file:" << fnSourceFile << "for parsing" << clEndl;
-                    continue;
-                }
-                PHPSourceFile sourceFile(content, this);
-                sourceFile.SetFilename(fnSourceFile);
-                sourceFile.SetParseFunctionBody(parseFuncBodies);
-                sourceFile.Parse();
-                UpdateSourceFile(sourceFile, false);
-            }
-        }
-        m_db.Commit();
-        long elapsedMs = sw.Time();
-        clDEBUG1() << _("PHP: parsed ") << files.GetCount() << " in " << elapsedMs << " milliseconds" << clEndl;
-
-        {
-            clParseEvent event(wxPHP_PARSE_ENDED);
-            event.SetTotalFiles(files.GetCount());
-            event.SetCurfileIndex(files.GetCount());
-            EventNotifier::Get()->AddPendingEvent(event);
-        }
-
-    } catch(wxSQLite3Exception& e) {
-        try {
-            m_db.Rollback();
-
-        } catch(...) {
-        }
-
-        {
-            // always make sure that the end event is sent
-            clParseEvent event(wxPHP_PARSE_ENDED);
-            event.SetTotalFiles(files.GetCount());
-            event.SetCurfileIndex(files.GetCount());
-            EventNotifier::Get()->AddPendingEvent(event);
-        }
-
-        clWARNING() << "PHPLookupTable::UpdateSourceFiles:" << e.GetMessage() << clEndl;
-    }
-}
-
 #endif // PHPLOOKUPTABLE_H
@@ -24,6 +24,7 @@
 
 PHPSourceFile::PHPSourceFile(const wxString& content, PHPLookupTable* lookup)
     : m_text(content)
+    , m_textLoaded(true)
     , m_parseFunctionBody(false)
     , m_depth(0)
     , m_reachedEOF(false)
@@ -35,6 +36,7 @@ PHPSourceFile::PHPSourceFile(const wxString& content, PHPLookupTable* lookup)
 
 PHPSourceFile::PHPSourceFile(const wxFileName& filename, PHPLookupTable* lookup)
     : m_filename(filename)
+    , m_textLoaded(false)
     , m_parseFunctionBody(false)
     , m_depth(0)
     , m_reachedEOF(false)
@@ -43,10 +45,25 @@ PHPSourceFile::PHPSourceFile(const wxFileName& filename, PHPLookupTable* lookup)
 {
     // Filename is kept in absolute path
     m_filename.MakeAbsolute();
-    
-    wxString content;
-    if(FileUtils::ReadFileContent(filename, content, wxConvISO8859_1)) { m_text.swap(content); }
-    m_scanner = ::phpLexerNew(m_text, kPhpLexerOpt_ReturnComments);
+
+    // UTF-8 files are handed to the lexer as-is, straight from the file view. The text itself is only decoded if
+    // someone asks for it (see GetText())
+    clFileView view;
+    if(view.Open(m_filename) && view.IsUTF8()) {
+        m_scanner = ::phpLexerNew(view.GetData(), view.GetLength(), kPhpLexerOpt_ReturnComments);
+    } else {
+        m_scanner = ::phpLexerNew(GetText(), kPhpLexerOpt_ReturnComments);
+    }
+}
+
+const wxString& PHPSourceFile::GetText() const
+{
+    if(!m_textLoaded) {
+        m_textLoaded = true;
+        wxString content;
+        if(FileUtils::ReadFileContent(m_filename, content, wxConvISO8859_1)) { m_text.swap(content); }
+    }
+    return m_text;
 }
 
 PHPSourceFile::~PHPSourceFile()
@@ -1357,19 +1374,9 @@ wxString PHPSourceFile::DoMakeIdentifierAbsolute(const wxString& type, bool exac
 {
     if(m_converter) { return m_converter->MakeIdentifierAbsolute(type); }
 
-    static std::unordered_set<std::string> phpKeywords;
-    if(phpKeywords.empty()) {
-        phpKeywords.insert("string");
-        phpKeywords.insert("array");
-        phpKeywords.insert("mixed");
-        phpKeywords.insert("bool");
-        phpKeywords.insert("integer");
-        phpKeywords.insert("boolean");
-        phpKeywords.insert("double");
-        phpKeywords.insert("float");
-        phpKeywords.insert("float");
-        phpKeywords.insert("void");
-    }
+    // Files are parsed by multiple threads: initialize the set once, in a thread safe manner
+    static const std::unordered_set<std::string> phpKeywords = { "string",  "array",  "mixed", "bool", "integer",
+                                                                 "boolean", "double", "float", "void" };
     wxString typeWithNS(type);
     typeWithNS.Trim().Trim(false);
 
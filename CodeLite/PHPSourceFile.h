@@ -36,7 +36,8 @@ class WXDLLIMPEXP_CL PHPLookupTable;
 
 class WXDLLIMPEXP_CL PHPSourceFile
 {
-    wxString m_text;
+    mutable wxString m_text;
+    mutable bool m_textLoaded;
     PHPEntityBase::List_t m_scopes;
     PHPEntityBase::List_t m_defines;
     PHPScanner_t m_scanner;
@@ -274,7 +275,7 @@ public:
     /**
      * @brief return the source file text
      */
-    const wxString& GetText() const { return m_text; }
+    const wxString& GetText() const;
 
     /**
      * @brief parse the source file
@@ -3315,6 +3315,17 @@ void* phpLexerNew(const wxString& content, size_t options )
     return scanner;
 }
 
+void* phpLexerNew(const char* buffer, size_t length, size_t options )
+{
+    yyscan_t scanner;
+    phplex_init(&scanner);
+    struct yyguts_t * yyg = (struct yyguts_t*)scanner;
+    yyg->yyextra_r = new phpLexerUserData(options);
+    php_switch_to_buffer(php_scan_bytes(buffer, (int)length, scanner), scanner);
+    yylineno = 0;
+    return scanner;
+}
+
 void phpLexerDestroy(void** scanner)
 {
     struct yyguts_t * yyg = (struct yyguts_t*)(*scanner);
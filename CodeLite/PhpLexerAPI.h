@@ -194,6 +194,11 @@ WXDLLIMPEXP_CL phpLexerUserData* phpLexerGetUserData(PHPScanner_t scanner);
  */
 WXDLLIMPEXP_CL PHPScanner_t phpLexerNew(const wxString& content, size_t options = kPhpLexerOpt_None);
 
+/**
+ * @brief create a new Lexer for a UTF-8 buffer of 'length' bytes (no encoding conversion is done)
+ */
+WXDLLIMPEXP_CL PHPScanner_t phpLexerNew(const char* buffer, size_t length, size_t options);
+
 /**
  * @brief destroy the current lexer and perform cleanup
  */
@@ -179,6 +179,7 @@ void UnixProcess::StartReaderThread()
                 } else if(!content.empty()) {
                     clProcessEvent evt(wxEVT_ASYNC_PROCESS_OUTPUT);
                     evt.SetOutput(wxString() << content);
+                    evt.SetStringRaw(content);
                     process->m_owner->AddPendingEvent(evt);
                 }
                 content.clear();
@@ -23,5 +23,6 @@ clFileSystemEvent& clFileSystemEvent::operator=(const clFileSystemEvent& src)
     m_path = src.m_path;
     m_newpath = src.m_newpath;
     m_paths = src.m_paths;
+    m_isFolder = src.m_isFolder;
     return *this;
 }
@@ -34,6 +34,7 @@ protected:
     wxString m_path;
     wxString m_newpath;
     wxArrayString m_paths;
+    bool m_isFolder = false;
 
 public:
     clFileSystemEvent(wxEventType commandType = wxEVT_NULL, int winid = 0);
@@ -49,6 +50,11 @@ public:
     void SetPaths(const wxArrayString& paths) { this->m_paths = paths; }
     const wxArrayString& GetPaths() const { return m_paths; }
     wxArrayString& GetPaths() { return m_paths; }
+    /**
+     * @brief wxEVT_FILE_NOT_FOUND: the path was a folder
+     */
+    void SetIsFolder(bool isFolder) { this->m_isFolder = isFolder; }
+    bool IsFolder() const { return m_isFolder; }
 };
 
 typedef void (wxEvtHandler::*clFileSystemEventFunction)(clFileSystemEvent&);
@@ -1,14 +1,37 @@
 #include "clFileSystemWatcher.h"
+#include "codelite_events.h"
+#include "file_logger.h"
+#include "fileutils.h"
 #include <algorithm>
 #include <set>
-#include "fileutils.h"
+
+#if CL_FSW_USE_INOTIFY
+#include <dirent.h>
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <chrono>
+#endif
 
 wxDEFINE_EVENT(wxEVT_FILE_MODIFIED, clFileSystemEvent);
 wxDEFINE_EVENT(wxEVT_FILE_NOT_FOUND, clFileSystemEvent);
+wxDEFINE_EVENT(wxEVT_FILE_WATCHER_OVERFLOW, clFileSystemEvent);
 
 // In milliseconds
 #define FILE_CHECK_INTERVAL 500
 
+#if CL_FSW_USE_INOTIFY
+// Events are delivered once the watched tree was quiet for FSW_COALESCE_MS, but no later than FSW_MAX_DELAY_MS after
+// the first event of a burst (in milliseconds)
+#define FSW_COALESCE_MS 50
+#define FSW_MAX_DELAY_MS 250
+#define FSW_INOTIFY_MASK                                                                                   \
+    (IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | \
+     IN_DELETE_SELF | IN_MOVE_SELF)
+#endif
+
 clFileSystemWatcher::clFileSystemWatcher()
     : m_owner(NULL)
 #if CL_FSW_USE_TIMER
@@ -18,19 +41,15 @@ clFileSystemWatcher::clFileSystemWatcher()
 #if CL_FSW_USE_TIMER
     Bind(wxEVT_TIMER, &clFileSystemWatcher::OnTimer, this);
 #else
-    m_watcher.SetOwner(this);
-    Bind(wxEVT_FSWATCHER, &clFileSystemWatcher::OnFileModified, this);
+    m_shutdown.store(false);
 #endif
 }
 
 clFileSystemWatcher::~clFileSystemWatcher()
 {
-#if CL_FSW_USE_TIMER
     Stop();
+#if CL_FSW_USE_TIMER
     Unbind(wxEVT_TIMER, &clFileSystemWatcher::OnTimer, this);
-#else
-    m_watcher.RemoveAll();
-    Unbind(wxEVT_FSWATCHER, &clFileSystemWatcher::OnFileModified, this);
 #endif
 }
 
@@ -46,11 +65,26 @@ void clFileSystemWatcher::SetFile(const wxFileName& filename)
         m_files.insert(std::make_pair(filename.GetFullPath(), f));
     }
 #else
-    m_watcher.RemoveAll();
-    wxFileName dironly = filename;
-    dironly.SetFullName(""); // must be directory only
-    m_watcher.Add(dironly);
-    m_watchedFile = filename; // but we keep the file name for later usage
+    if(filename.Exists()) {
+        std::vector<wxString> oldFolders;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for(const auto& p : m_files) {
+                oldFolders.push_back(p.second.filename.GetPath());
+            }
+            m_files.clear();
+            File f;
+            f.filename = filename;
+            f.lastModified = 0;
+            f.file_size = 0;
+            m_files.insert(std::make_pair(filename.GetFullPath(), f));
+        }
+        // we watch the parent folder so we also catch files that are replaced (e.g. saved using rename)
+        if(IsRunning()) { DoAddWatch(filename.GetPath(), false); }
+        for(const wxString& folder : oldFolders) {
+            DoRemoveFileWatch(folder);
+        }
+    }
 #endif
 }
 
@@ -62,6 +96,28 @@ void clFileSystemWatcher::Start()
     m_timer = new wxTimer(this);
     m_timer->Start(FILE_CHECK_INTERVAL, true);
 #else
+    Stop();
+
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(m_fd < 0) {
+        clWARNING() << "File system watcher: inotify_init1 error:" << strerror(errno) << clEndl;
+        return;
+    }
+
+    std::vector<wxString> dirs;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for(const auto& p : m_files) {
+            dirs.push_back(p.second.filename.GetPath());
+        }
+    }
+    for(const wxString& dir : dirs) {
+        DoAddWatch(dir, false);
+    }
+
+    // the folders are watched by the reader thread: adding a watch per sub folder of a big tree can take a while
+    m_shutdown.store(false);
+    m_thread = new std::thread(&clFileSystemWatcher::DoReadEvents, this);
 #endif
 }
 
@@ -73,17 +129,34 @@ void clFileSystemWatcher::Stop()
     }
     wxDELETE(m_timer);
 #else
-    m_watcher.RemoveAll();
+    if(m_thread) {
+        m_shutdown.store(true);
+        m_thread->join();
+        wxDELETE(m_thread);
+    }
+
+    if(m_fd != -1) {
+        // closing the descriptor removes all the watches
+        ::close(m_fd);
+        m_fd = -1;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_watches.clear();
+    m_watchesByPath.clear();
 #endif
 }
 
 void clFileSystemWatcher::Clear()
 {
-#if CL_FSW_USE_TIMER
     Stop();
+#if CL_FSW_USE_TIMER
     m_files.clear();
 #else
-    m_watcher.RemoveAll();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_files.clear();
+    m_folders.Clear();
+    m_excludeFolders.clear();
 #endif
 }
 
@@ -144,36 +217,323 @@ void clFileSystemWatcher::OnTimer(wxTimerEvent& event)
 }
 #endif
 
-#if !CL_FSW_USE_TIMER
-void clFileSystemWatcher::OnFileModified(wxFileSystemWatcherEvent& event)
+#if CL_FSW_USE_INOTIFY
+bool clFileSystemWatcher::DoAddWatch(const wxString& path, bool folder)
 {
-    if(event.GetChangeType() == wxFSW_EVENT_MODIFY) {
-        const wxFileName& modpath = event.GetPath();
-        if(modpath == m_watchedFile) {
-            if(GetOwner()) {
-                clFileSystemEvent evt(wxEVT_FILE_MODIFIED);
-                evt.SetPath(modpath.GetFullPath());
-                GetOwner()->AddPendingEvent(evt);
+    int wd = inotify_add_watch(m_fd, path.mb_str(wxConvUTF8).data(), FSW_INOTIFY_MASK);
+    if(wd < 0) {
+        if(errno == ENOSPC) {
+            clWARNING() << "File system watcher: inotify watch limit reached, can't watch:" << path
+                        << "(see /proc/sys/fs/inotify/max_user_watches)" << clEndl;
+        } else {
+            clDEBUG1() << "File system watcher: can't watch:" << path << "." << strerror(errno) << clEndl;
+        }
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Watch& watch = m_watches[wd];
+    if(!watch.path.IsEmpty() && watch.path != path) {
+        // the same folder (inode) was moved, it is now known by its new name
+        m_watchesByPath.erase(watch.path);
+        watch.folder = false;
+    }
+    watch.path = path;
+    watch.folder = watch.folder || folder;
+    m_watchesByPath[path] = wd;
+    return true;
+}
+
+void clFileSystemWatcher::DoAddFolderWatch(const wxString& folder, std::vector<wxString>* files)
+{
+    std::vector<wxString> Q;
+    Q.push_back(folder);
+    while(!Q.empty()) {
+        wxString dirpath = Q.back();
+        Q.pop_back();
+        if(!DoAddWatch(dirpath, true)) { continue; }
+
+        DIR* dir = ::opendir(dirpath.mb_str(wxConvUTF8).data());
+        if(!dir) { continue; }
+
+        struct dirent* entry = NULL;
+        while((entry = ::readdir(dir)) != NULL) {
+            if(strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) { continue; }
+
+            wxString name(entry->d_name, wxConvUTF8);
+            wxString fullpath;
+            fullpath << dirpath << "/" << name;
+
+            // symbolic links to folders are not followed
+            bool isDir = (entry->d_type == DT_DIR) || (entry->d_type == DT_UNKNOWN && wxFileName::DirExists(fullpath));
+            if(isDir) {
+                bool excluded = false;
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    excluded = m_excludeFolders.count(name);
+                }
+                if(!excluded) { Q.push_back(fullpath); }
+
+            } else if(files) {
+                files->push_back(fullpath);
+            }
+        }
+        ::closedir(dir);
+    }
+}
+
+void clFileSystemWatcher::DoRemoveFolderWatch(const wxString& folder)
+{
+    wxString prefix = folder + "/";
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<int> removed;
+    for(const auto& p : m_watches) {
+        if(p.second.path == folder || p.second.path.StartsWith(prefix)) { removed.push_back(p.first); }
+    }
+
+    for(int wd : removed) {
+        ::inotify_rm_watch(m_fd, wd);
+        m_watchesByPath.erase(m_watches[wd].path);
+        m_watches.erase(wd);
+    }
+}
+
+void clFileSystemWatcher::DoRemoveFileWatch(const wxString& folder)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto iter = m_watchesByPath.find(folder);
+    if(iter == m_watchesByPath.end()) { return; }
+
+    // keep the watch if it is part of a folder watch, or if another watched file lives in the same folder
+    int wd = iter->second;
+    if(m_watches[wd].folder) { return; }
+    for(const auto& p : m_files) {
+        if(p.second.filename.GetPath() == folder) { return; }
+    }
+    ::inotify_rm_watch(m_fd, wd);
+    m_watches.erase(wd);
+    m_watchesByPath.erase(iter);
+}
+
+void clFileSystemWatcher::DoProcessEvent(const struct inotify_event* event, std::map<wxString, size_t>& pending)
+{
+    if(event->mask & IN_Q_OVERFLOW) {
+        // Events were dropped by the kernel: we no longer know what changed. Let the owner re-scan
+        clWARNING() << "File system watcher: inotify queue overflow, some events were lost" << clEndl;
+        CallAfter(&clFileSystemWatcher::OnOverflow);
+        return;
+    }
+
+    Watch watch;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto iter = m_watches.find(event->wd);
+        if(iter == m_watches.end()) { return; }
+        if(event->mask & IN_IGNORED) {
+            // the watch was removed (the folder was deleted or unmounted)
+            m_watchesByPath.erase(iter->second.path);
+            m_watches.erase(iter);
+            return;
+        }
+        watch = iter->second;
+    }
+
+    // events about the watched folder itself are reported by its parent folder
+    if(event->len == 0) { return; }
+
+    wxString name(event->name, wxConvUTF8);
+    wxString path;
+    path << watch.path << "/" << name;
+
+    if(event->mask & IN_ISDIR) {
+        if(!watch.folder) { return; }
+        if(event->mask & (IN_CREATE | IN_MOVED_TO)) {
+            bool excluded = false;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                excluded = m_excludeFolders.count(name);
             }
+            if(excluded) { return; }
+
+            // files might have been created in the new folder before we started watching it
+            std::vector<wxString> files;
+            DoAddFolderWatch(path, &files);
+            for(const wxString& file : files) {
+                pending[file] |= kCreated;
+            }
+
+        } else if(event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+            DoRemoveFolderWatch(path);
+            pending[path] |= (kDeleted | kFolder);
         }
+        return;
+    }
+
+    if(!watch.folder) {
+        // a watch for a specific file, ignore its siblings
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_files.count(path) == 0) { return; }
+    }
+
+    size_t& flags = pending[path];
+    if(event->mask & (IN_CREATE | IN_MOVED_TO)) { flags |= kCreated; }
+    if(event->mask & (IN_DELETE | IN_MOVED_FROM)) { flags |= kDeleted; }
+    if(event->mask & (IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB)) { flags |= kModified; }
+}
+
+void clFileSystemWatcher::DoReadEvents()
+{
+    typedef std::chrono::steady_clock clock_t;
+
+    wxArrayString folders;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        folders = m_folders;
+    }
+    for(const wxString& folder : folders) {
+        DoAddFolderWatch(folder, NULL);
+    }
+
+    // the buffer must be aligned for struct inotify_event
+    std::vector<struct inotify_event> buffer((64 * 1024) / sizeof(struct inotify_event));
+    char* bufferStart = reinterpret_cast<char*>(buffer.data());
+    size_t bufferSize = buffer.size() * sizeof(struct inotify_event);
+
+    std::map<wxString, size_t> pending;
+    clock_t::time_point firstEvent, lastEvent;
+    while(!m_shutdown.load()) {
+        struct pollfd pfd;
+        pfd.fd = m_fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        int rc = ::poll(&pfd, 1, pending.empty() ? 100 : FSW_COALESCE_MS);
+
+        clock_t::time_point now = clock_t::now();
+        if(rc > 0 && (pfd.revents & POLLIN)) {
+            ssize_t len = ::read(m_fd, bufferStart, bufferSize);
+            if(len > 0) {
+                if(pending.empty()) { firstEvent = now; }
+                lastEvent = now;
+                const char* ptr = bufferStart;
+                while(ptr < bufferStart + len) {
+                    const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(ptr);
+                    DoProcessEvent(event, pending);
+                    ptr += sizeof(struct inotify_event) + event->len;
+                }
+            }
+        }
+
+        if(pending.empty()) { continue; }
+        if((now - lastEvent) >= std::chrono::milliseconds(FSW_COALESCE_MS) ||
+           (now - firstEvent) >= std::chrono::milliseconds(FSW_MAX_DELAY_MS)) {
+            Changes_t changes(pending.begin(), pending.end());
+            pending.clear();
+            CallAfter(&clFileSystemWatcher::OnChanges, changes);
+        }
+    }
+}
+
+void clFileSystemWatcher::OnOverflow()
+{
+    if(!GetOwner()) { return; }
+    clFileSystemEvent evt(wxEVT_FILE_WATCHER_OVERFLOW);
+    GetOwner()->AddPendingEvent(evt);
+}
+
+void clFileSystemWatcher::OnChanges(const Changes_t& changes)
+{
+    if(!GetOwner()) { return; }
+
+    wxArrayString created;
+    for(const auto& change : changes) {
+        const wxString& path = change.first;
+        size_t flags = change.second;
+
+        bool isWatchedFile = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            isWatchedFile = m_files.count(path);
+        }
+
+        bool exists = wxFileName::FileExists(path) || wxFileName::DirExists(path);
+        if(!exists) {
+            if(!(flags & kDeleted)) { continue; }
+            if(isWatchedFile) {
+                // same as the timer implementation: a missing file is no longer watched
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_files.erase(path);
+            }
+            clFileSystemEvent evt(wxEVT_FILE_NOT_FOUND);
+            evt.SetPath(path);
+            evt.SetIsFolder(flags & kFolder);
+            GetOwner()->AddPendingEvent(evt);
+
+        } else if((flags & kCreated) && !isWatchedFile) {
+            created.Add(path);
+
+        } else {
+            // a watched file that was re-created (e.g. saved using rename) is reported as modified
+            clFileSystemEvent evt(wxEVT_FILE_MODIFIED);
+            evt.SetPath(path);
+            GetOwner()->AddPendingEvent(evt);
+        }
+    }
+
+    if(!created.IsEmpty()) {
+        clFileSystemEvent evt(wxEVT_FILE_CREATED);
+        evt.SetPath(created.Item(0));
+        evt.SetPaths(created);
+        GetOwner()->AddPendingEvent(evt);
     }
 }
 #endif
 
 void clFileSystemWatcher::RemoveFile(const wxFileName& filename)
 {
-#if CL_FSW_USE_TIMER
+#if CL_FSW_USE_INOTIFY
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_files.count(filename.GetFullPath()) == 0) { return; }
+        m_files.erase(filename.GetFullPath());
+    }
+    DoRemoveFileWatch(filename.GetPath());
+#else
     if(m_files.count(filename.GetFullPath())) {
         m_files.erase(filename.GetFullPath());
     }
 #endif
 }
 
+bool clFileSystemWatcher::AddFolder(const wxString& folder, const wxStringSet_t& excludeFolders)
+{
+#if CL_FSW_USE_INOTIFY
+    wxString path = folder;
+    while(path.length() > 1 && path.EndsWith("/")) {
+        path.RemoveLast();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_folders.Add(path);
+        m_excludeFolders.insert(excludeFolders.begin(), excludeFolders.end());
+    }
+
+    if(IsRunning()) { DoAddFolderWatch(path, NULL); }
+    return true;
+#else
+    wxUnusedVar(folder);
+    wxUnusedVar(excludeFolders);
+    return false;
+#endif
+}
+
+bool clFileSystemWatcher::IsFolderWatchSupported() { return CL_FSW_USE_INOTIFY; }
+
 bool clFileSystemWatcher::IsRunning() const
 {
 #if CL_FSW_USE_TIMER
     return m_timer;
 #else
-    return m_watcher.GetWatchedPathsCount();
+    return m_thread != nullptr;
 #endif
 }
@@ -3,18 +3,27 @@
 
 #include "codelite_exports.h"
 #include "clFileSystemEvent.h"
+#include "macros.h"
 #include <map>
 #include <wx/timer.h>
 #include <wx/filename.h>
 
-#ifdef __WXMSW__
-#define CL_FSW_USE_TIMER 1
+#if defined(__linux__)
+#define CL_FSW_USE_INOTIFY 1
+#define CL_FSW_USE_TIMER 0
 #else
+#define CL_FSW_USE_INOTIFY 0
 #define CL_FSW_USE_TIMER 1
 #endif
 
-#if !CL_FSW_USE_TIMER
-#include <wx/fswatcher.h>
+#if CL_FSW_USE_INOTIFY
+#include "wxStringHash.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #endif
 
 class WXDLLIMPEXP_CL clFileSystemWatcher : public wxEvtHandler
@@ -28,12 +37,31 @@ public:
     };
 
     wxEvtHandler* m_owner;
-#if CL_FSW_USE_TIMER
     clFileSystemWatcher::File::Map_t m_files;
+#if CL_FSW_USE_TIMER
     wxTimer* m_timer;
 #else
-    wxFileSystemWatcher m_watcher;
-    wxFileName m_watchedFile;
+    enum eChange {
+        kCreated = (1 << 0),
+        kModified = (1 << 1),
+        kDeleted = (1 << 2),
+        kFolder = (1 << 3),
+    };
+    typedef std::vector<std::pair<wxString, size_t> > Changes_t;
+
+    struct Watch {
+        wxString path;
+        bool folder = false; // true: part of a recursive folder watch, false: watched for a specific file
+    };
+
+    int m_fd = -1;
+    std::thread* m_thread = nullptr;
+    std::atomic_bool m_shutdown;
+    std::mutex m_mutex; // protects m_files and the members below, they are accessed by the reader thread
+    std::unordered_map<int, Watch> m_watches;
+    std::unordered_map<wxString, int> m_watchesByPath;
+    wxArrayString m_folders;
+    wxStringSet_t m_excludeFolders;
 #endif
 
 public:
@@ -43,7 +71,14 @@ protected:
 #if CL_FSW_USE_TIMER
     void OnTimer(wxTimerEvent& event);
 #else
-    void OnFileModified(wxFileSystemWatcherEvent& event);
+    void DoReadEvents();
+    void DoProcessEvent(const struct inotify_event* event, std::map<wxString, size_t>& pending);
+    bool DoAddWatch(const wxString& path, bool folder);
+    void DoAddFolderWatch(const wxString& folder, std::vector<wxString>* files);
+    void DoRemoveFolderWatch(const wxString& folder);
+    void DoRemoveFileWatch(const wxString& folder);
+    void OnChanges(const Changes_t& changes);
+    void OnOverflow();
 #endif
 
 public:
@@ -63,10 +98,25 @@ public:
      */
     void RemoveFile(const wxFileName& filename);
 
+    /**
+     * @brief watch a folder and all its sub folders (recursively). Besides wxEVT_FILE_MODIFIED and
+     * wxEVT_FILE_NOT_FOUND (clFileSystemEvent::IsFolder() is set for a folder), the owner receives
+     * wxEVT_FILE_CREATED (use clFileSystemEvent::GetPaths()) for new files.
+     * wxEVT_FILE_WATCHER_OVERFLOW is sent when changes were lost (the kernel queue overflowed): the owner should
+     * re-scan the folder. Folders named in 'excludeFolders' are not watched
+     * @return false if the current backend does not support folder watching (see IsFolderWatchSupported())
+     */
+    bool AddFolder(const wxString& folder, const wxStringSet_t& excludeFolders = wxStringSet_t());
+
+    /**
+     * @brief return true if AddFolder() is supported on this platform
+     */
+    static bool IsFolderWatchSupported();
+
     /**
      * @brief start to watching list of files.
      * This object fires the following events (clFileSystemEvent):
-     * wxEVT_FILE_MODIFIED, wxEVT_FILE_DELETED
+     * wxEVT_FILE_MODIFIED, wxEVT_FILE_NOT_FOUND
      */
     void Start();
 
@@ -88,5 +138,6 @@ public:
 
 wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_CL, wxEVT_FILE_MODIFIED, clFileSystemEvent);
 wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_CL, wxEVT_FILE_NOT_FOUND, clFileSystemEvent);
+wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_CL, wxEVT_FILE_WATCHER_OVERFLOW, clFileSystemEvent);
 
 #endif // CLFILESYSTEMWATCHER_H
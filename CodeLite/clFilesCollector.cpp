@@ -1,11 +1,264 @@
 #include "clFilesCollector.h"
 #include "file_logger.h"
 #include "fileutils.h"
-#include <queue>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include <wx/dir.h>
+#include <wx/filefn.h>
 #include <wx/filename.h>
 #include <wx/tokenzr.h>
-#include <vector>
+
+#ifndef __WXMSW__
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+// Reading folders is mostly waiting on the file system (especially over the network), so we use more threads
+// than cores, within these bounds
+#define MIN_SCAN_THREADS 4
+#define MAX_SCAN_THREADS 16
+
+namespace
+{
+/**
+ * @brief decides which folders are traversed and which files are collected. Only needs the entry name for the
+ * common cases so no extra system call is made per entry
+ */
+struct ScanFilter {
+    wxArrayString spec;
+    wxArrayString excludeSpec;
+    wxArrayString excludeFoldersSpec;
+    const wxStringSet_t* excludeFolders = nullptr;
+    bool excludeFoldersHasPaths = false;
+
+    ScanFilter(const wxString& filespec, const wxString& excludeFilespec)
+    {
+        spec = ::wxStringTokenize(filespec.Lower(), ";,|", wxTOKEN_STRTOK);
+        excludeSpec = ::wxStringTokenize(excludeFilespec.Lower(), ";,|", wxTOKEN_STRTOK);
+    }
+
+    void SetExcludeFolders(const wxStringSet_t& folders)
+    {
+        excludeFolders = &folders;
+        for(const wxString& folder : folders) {
+            if(folder.find_first_of("/\\") != wxString::npos) {
+                excludeFoldersHasPaths = true;
+                break;
+            }
+        }
+    }
+
+    bool IsFolderExcluded(const wxString& name, const wxString& fullpath) const
+    {
+        if(FileUtils::WildMatch(excludeFoldersSpec, name)) { return true; }
+        if(!excludeFolders) { return false; }
+        if(excludeFolders->count(name)) { return true; }
+        // Resolving the real path costs a system call, only do it when there are paths to compare against.
+        // Use FileUtils::RealPath() here to cope with symlinks on Linux
+        return excludeFoldersHasPaths &&
+               (excludeFolders->count(fullpath) || excludeFolders->count(FileUtils::RealPath(fullpath)));
+    }
+
+    bool IsFileIncluded(const wxString& name) const
+    {
+        return !FileUtils::WildMatch(excludeSpec, name) && FileUtils::WildMatch(spec, name);
+    }
+};
+
+/**
+ * @class ParallelDirCrawler
+ * @brief traverse a folder tree using a pool of threads, each one reading a whole folder at a time. The calling
+ * thread takes part in the scan and more threads are started only while there are folders waiting in the queue
+ */
+class ParallelDirCrawler
+{
+    const ScanFilter& m_filter;
+    const clFilesScanner::FilesCallback_t& m_callback;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<wxString> m_queue;
+    wxStringSet_t m_visitedLinks;
+    std::vector<std::thread> m_threads;
+    size_t m_busy = 0;
+    size_t m_maxThreads = MIN_SCAN_THREADS;
+    std::atomic_bool m_stop;
+    std::mutex m_callbackMutex;
+    size_t m_count = 0;
+
+protected:
+    void Worker();
+    void ReadFolder(const wxString& dirpath, std::vector<wxString>& folders, std::vector<wxString>& files);
+    void Deliver(const std::vector<wxString>& files);
+    bool IsNewLinkTarget(const wxString& fullpath);
+
+public:
+    ParallelDirCrawler(const ScanFilter& filter, const clFilesScanner::FilesCallback_t& callback)
+        : m_filter(filter)
+        , m_callback(callback)
+        , m_stop(false)
+    {
+        size_t cores = std::thread::hardware_concurrency();
+        m_maxThreads = std::max<size_t>(MIN_SCAN_THREADS, std::min<size_t>(MAX_SCAN_THREADS, cores));
+    }
+
+    /**
+     * @brief scan 'rootFolder' and return the number of files passed to the callback
+     */
+    size_t Run(const wxString& rootFolder);
+};
+
+size_t ParallelDirCrawler::Run(const wxString& rootFolder)
+{
+    m_queue.push_back(rootFolder);
+    m_visitedLinks.insert(FileUtils::RealPath(rootFolder));
+    Worker();
+
+    // Once the calling thread is done, the queue is drained and no more threads can be started
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        threads.swap(m_threads);
+    }
+    for(std::thread& thr : threads) {
+        thr.join();
+    }
+    clDEBUG1() << "clFilesScanner:" << rootFolder << "scanned using" << (threads.size() + 1) << "threads";
+    return m_count;
+}
+
+void ParallelDirCrawler::Worker()
+{
+    std::vector<wxString> folders;
+    std::vector<wxString> files;
+    while(true) {
+        wxString dirpath;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [&]() { return m_stop || !m_queue.empty() || m_busy == 0; });
+            // Nothing left to read and nobody is reading a folder that may add more work
+            if(m_stop || m_queue.empty()) { break; }
+            dirpath.swap(m_queue.front());
+            m_queue.pop_front();
+            ++m_busy;
+        }
+
+        folders.clear();
+        files.clear();
+        ReadFolder(dirpath, folders, files);
+        if(!files.empty()) { Deliver(files); }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_busy;
+            m_queue.insert(m_queue.end(), folders.begin(), folders.end());
+            if(!m_stop && m_queue.size() > 1 && (m_threads.size() + 1) < m_maxThreads) {
+                m_threads.push_back(std::thread(&ParallelDirCrawler::Worker, this));
+            }
+        }
+        m_cv.notify_all();
+    }
+    m_cv.notify_all();
+}
+
+void ParallelDirCrawler::Deliver(const std::vector<wxString>& files)
+{
+    std::lock_guard<std::mutex> lock(m_callbackMutex);
+    if(m_stop) { return; }
+    m_count += files.size();
+    if(!m_callback(files)) { m_stop.store(true); }
+}
+
+bool ParallelDirCrawler::IsNewLinkTarget(const wxString& fullpath)
+{
+    // Guard against symlink loops: a linked folder is only traversed the first time we reach its target
+    wxString realpath = FileUtils::RealPath(fullpath);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_visitedLinks.insert(realpath).second;
+}
+
+#ifdef __WXMSW__
+void ParallelDirCrawler::ReadFolder(const wxString& dirpath, std::vector<wxString>& folders,
+                                    std::vector<wxString>& files)
+{
+    wxDir dir(dirpath);
+    if(!dir.IsOpened()) { return; }
+
+    wxString dirWithSep = dir.GetNameWithSep();
+    wxString filename;
+    bool cont = dir.GetFirst(&filename);
+    while(cont && !m_stop) {
+        wxString fullpath;
+        fullpath << dirWithSep << filename;
+        if(wxFileName::DirExists(fullpath)) {
+            if(!m_filter.IsFolderExcluded(filename, fullpath)) { folders.push_back(fullpath); }
+        } else if(m_filter.IsFileIncluded(filename)) {
+            files.push_back(fullpath);
+        }
+        cont = dir.GetNext(&filename);
+    }
+}
+#else
+void ParallelDirCrawler::ReadFolder(const wxString& dirpath, std::vector<wxString>& folders,
+                                    std::vector<wxString>& files)
+{
+    // readdir() fetches the entries from the kernel in large batches (getdents) and, unlike wxDir, it reports the
+    // entry type so we do not need to stat() every entry
+    DIR* dir = ::opendir(dirpath.fn_str());
+    if(!dir) { return; }
+
+    wxString dirWithSep = dirpath;
+    if(!dirWithSep.EndsWith(wxFILE_SEP_PATH)) { dirWithSep << wxFILE_SEP_PATH; }
+
+    struct dirent* entry = nullptr;
+    while(!m_stop && (entry = ::readdir(dir)) != nullptr) {
+        const char* name = entry->d_name;
+        if(name[0] == '.' && (name[1] == 0 || (name[1] == '.' && name[2] == 0))) { continue; }
+
+        wxString filename(name, *wxConvFileName);
+        if(filename.IsEmpty()) {
+            clDEBUG1() << "clFilesScanner: can not convert file name in folder:" << dirpath;
+            continue;
+        }
+
+        bool isDirectory = false;
+        bool isSymlink = false;
+        switch(entry->d_type) {
+        case DT_DIR:
+            isDirectory = true;
+            break;
+        case DT_REG:
+            // plain file: decided by name only
+            if(m_filter.IsFileIncluded(filename)) { files.push_back(dirWithSep + filename); }
+            continue;
+        case DT_LNK:
+            isSymlink = true;
+            // fall through
+        default: {
+            // symlinks (we follow them) and file systems that do not report the type (DT_UNKNOWN)
+            wxStructStat st;
+            isDirectory = (::wxStat(dirWithSep + filename, &st) == 0) && S_ISDIR(st.st_mode);
+            break;
+        }
+        }
+
+        wxString fullpath = dirWithSep + filename;
+        if(isDirectory) {
+            if(!m_filter.IsFolderExcluded(filename, fullpath) && (!isSymlink || IsNewLinkTarget(fullpath))) {
+                folders.push_back(fullpath);
+            }
+        } else if(m_filter.IsFileIncluded(filename)) {
+            files.push_back(fullpath);
+        }
+    }
+    ::closedir(dir);
+}
+#endif
+} // namespace
 
 clFilesScanner::clFilesScanner() {}
 
@@ -21,42 +274,21 @@ size_t clFilesScanner::Scan(const wxString& rootFolder, std::vector<wxFileName>&
         return 0;
     }
 
-    wxArrayString specArr = ::wxStringTokenize(filespec.Lower(), ";,|", wxTOKEN_STRTOK);
-    wxArrayString excludeSpecArr = ::wxStringTokenize(excludeFilespec.Lower(), ";,|", wxTOKEN_STRTOK);
-    wxArrayString excludeFoldersSpecArr = ::wxStringTokenize(excludeFoldersSpec.Lower(), ";,|", wxTOKEN_STRTOK);
-    std::queue<wxString> Q;
-    Q.push(rootFolder);
+    ScanFilter filter(filespec, excludeFilespec);
+    filter.excludeFoldersSpec = ::wxStringTokenize(excludeFoldersSpec.Lower(), ";,|", wxTOKEN_STRTOK);
 
-    while(!Q.empty()) {
-        wxString dirpath = Q.front();
-        Q.pop();
+    std::vector<wxString> files;
+    clFilesScanner::FilesCallback_t callback = [&](const std::vector<wxString>& batch) {
+        files.insert(files.end(), batch.begin(), batch.end());
+        return true;
+    };
+    ParallelDirCrawler crawler(filter, callback);
+    crawler.Run(rootFolder);
 
-        wxDir dir(dirpath);
-        if(!dir.IsOpened()) { continue; }
-
-        wxString filename;
-        bool cont = dir.GetFirst(&filename);
-        while(cont) {
-            // Check to see if this is a folder
-            wxString fullpath;
-            fullpath << dir.GetNameWithSep() << filename;
-            bool isDirectory = wxFileName::DirExists(fullpath);
-            bool isFile = !isDirectory;
-            // Use FileUtils::RealPath() here to cope with symlinks on Linux
-            if(isDirectory /* a folder */ &&
-               !FileUtils::WildMatch(excludeFoldersSpecArr, filename) /* does not match the exclude folder spec */) {
-                // Traverse into this folder
-                Q.push(fullpath);
-            } else if(isFile && /* a file */
-                      !FileUtils::WildMatch(excludeSpecArr, filename) /* does not match the exclude file spec */ &&
-                      FileUtils::WildMatch(specArr, filename) /* matches the file spec array */) {
-                // Include this file
-                filesOutput.push_back(fullpath);
-            } else {
-                clDEBUG1() << "Files Collector: ignoring file:" << fullpath;
-            }
-            cont = dir.GetNext(&filename);
-        }
+    std::sort(files.begin(), files.end());
+    filesOutput.reserve(files.size());
+    for(const wxString& file : files) {
+        filesOutput.push_back(file);
     }
     return filesOutput.size();
 }
@@ -65,51 +297,28 @@ size_t clFilesScanner::Scan(const wxString& rootFolder, std::vector<wxString>& f
                             const wxString& excludeFilespec, const wxStringSet_t& excludeFolders)
 {
     filesOutput.clear();
+    FilesCallback_t callback = [&](const std::vector<wxString>& batch) {
+        filesOutput.insert(filesOutput.end(), batch.begin(), batch.end());
+        return true;
+    };
+    ScanWithCallback(rootFolder, callback, filespec, excludeFilespec, excludeFolders);
+    std::sort(filesOutput.begin(), filesOutput.end());
+    return filesOutput.size();
+}
+
+size_t clFilesScanner::ScanWithCallback(const wxString& rootFolder, const FilesCallback_t& callback,
+                                        const wxString& filespec, const wxString& excludeFilespec,
+                                        const wxStringSet_t& excludeFolders)
+{
     if(!wxFileName::DirExists(rootFolder)) {
         clDEBUG() << "clFilesScanner: No such dir:" << rootFolder << clEndl;
         return 0;
     }
 
-    wxArrayString specArr = ::wxStringTokenize(filespec.Lower(), ";,|", wxTOKEN_STRTOK);
-    wxArrayString excludeSpecArr = ::wxStringTokenize(excludeFilespec.Lower(), ";,|", wxTOKEN_STRTOK);
-    std::queue<wxString> Q;
-    Q.push(rootFolder);
-
-    while(!Q.empty()) {
-        wxString dirpath = Q.front();
-        Q.pop();
-
-        wxDir dir(dirpath);
-        if(!dir.IsOpened()) { continue; }
-
-        wxString filename;
-        bool cont = dir.GetFirst(&filename);
-        while(cont) {
-            // Check to see if this is a folder
-            wxString fullpath;
-            fullpath << dir.GetNameWithSep() << filename;
-            bool isDirectory = wxFileName::DirExists(fullpath);
-            // Use FileUtils::RealPath() here to cope with symlinks on Linux
-            bool isExcludeDir =
-#if defined(__FreeBSD__)
-                ((FileUtils::IsSymlink(fullpath) && excludeFolders.count(FileUtils::RealPath(fullpath)))
-#else
-                (excludeFolders.count(FileUtils::RealPath(fullpath))
-#endif
-                    || excludeFolders.count(filename));
-            if(isDirectory && !isExcludeDir) {
-                // Traverse into this folder
-                Q.push(fullpath);
-            } else if(!isDirectory && FileUtils::WildMatch(excludeSpecArr, filename)) {
-                // Do nothing
-            } else if(!isDirectory && FileUtils::WildMatch(specArr, filename)) {
-                // Include this file
-                filesOutput.push_back(fullpath);
-            }
-            cont = dir.GetNext(&filename);
-        }
-    }
-    return filesOutput.size();
+    ScanFilter filter(filespec, excludeFilespec);
+    filter.SetExcludeFolders(excludeFolders);
+    ParallelDirCrawler crawler(filter, callback);
+    return crawler.Run(rootFolder);
 }
 
 size_t clFilesScanner::ScanNoRecurse(const wxString& rootFolder, clFilesScanner::EntryData::Vec_t& results,
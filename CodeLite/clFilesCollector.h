@@ -3,6 +3,7 @@
 
 #include "codelite_exports.h"
 #include "macros.h"
+#include <functional>
 #include <vector>
 #include <wx/string.h>
 #include <wx/filename.h>
@@ -24,16 +25,23 @@ public:
         kIsSymlink = (1 << 3),
     };
 
+    /**
+     * @brief receives a batch of matching files (full paths). Calls are serialized, but they are made from the
+     * scanning threads. Return false to stop the scan
+     */
+    typedef std::function<bool(const std::vector<wxString>&)> FilesCallback_t;
+
 public:
     clFilesScanner();
     virtual ~clFilesScanner();
 
     /**
-     * @brief collect all files matching a given pattern from a root folder
+     * @brief collect all files matching a given pattern from a root folder. The folders are read in parallel, the
+     * output is sorted
      * @param rootFolder the scan root folder
      * @param filesOutput [output] output result full path entries
      * @param filespec files spec
-     * @param excludeFolders list of folder to exclude from the search
+     * @param excludeFolders list of folder to exclude from the search. Either names or full paths
      * @return number of files found
      */
     size_t Scan(const wxString& rootFolder, std::vector<wxString>& filesOutput, const wxString& filespec = "*",
@@ -43,6 +51,14 @@ public:
      */
     size_t Scan(const wxString& rootFolder, std::vector<wxFileName>& filesOutput, const wxString& filespec,
                 const wxString& excludeFilespec, const wxString& excludeFoldersSpec);
+    /**
+     * @brief same as the first Scan(), but instead of collecting the files, stream them to 'callback' as soon as
+     * each folder is read (in no particular order)
+     * @return number of files found
+     */
+    size_t ScanWithCallback(const wxString& rootFolder, const FilesCallback_t& callback,
+                            const wxString& filespec = "*", const wxString& excludeFilespec = "",
+                            const wxStringSet_t& excludeFolders = wxStringSet_t());
     /**
      * @brief scan folder for files and folders. This function does not recurse into folders. Everything that matches
      * "matchSpec" will get collected.
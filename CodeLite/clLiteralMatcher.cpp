@@ -0,0 +1,110 @@
+#include "clLiteralMatcher.h"
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CL_LITERAL_MATCHER_SSE2 1
+#endif
+
+namespace
+{
+inline bool IsAsciiAlpha(unsigned char ch) { return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z'); }
+inline unsigned char AsciiLower(unsigned char ch) { return (ch >= 'A' && ch <= 'Z') ? (ch | 0x20) : ch; }
+#ifdef CL_LITERAL_MATCHER_SSE2
+inline int CountTrailingZeros(unsigned int mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward(&index, mask);
+    return (int)index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+#endif
+} // namespace
+
+clLiteralMatcher::clLiteralMatcher(const std::string& needle, bool matchCase)
+    : m_needle(needle)
+    , m_matchCase(matchCase)
+{
+    if(!m_matchCase) {
+        for(size_t i = 0; i < m_needle.length(); ++i) {
+            m_needle[i] = AsciiLower(m_needle[i]);
+        }
+    }
+}
+
+clLiteralMatcher::~clLiteralMatcher() {}
+
+bool clLiteralMatcher::CanMatch(const wxString& needle, bool matchCase)
+{
+    if(needle.empty()) { return false; }
+    if(matchCase) { return true; }
+    for(size_t i = 0; i < needle.length(); ++i) {
+        if((wxUint32)needle[i].GetValue() > 0x7F) { return false; }
+    }
+    return true;
+}
+
+bool clLiteralMatcher::Verify(const char* p) const
+{
+    if(m_matchCase) { return memcmp(p, m_needle.c_str(), m_needle.length()) == 0; }
+    for(size_t i = 0; i < m_needle.length(); ++i) {
+        if(AsciiLower(p[i]) != (unsigned char)m_needle[i]) { return false; }
+    }
+    return true;
+}
+
+size_t clLiteralMatcher::Find(const char* buffer, size_t len, size_t offset) const
+{
+    const size_t n = m_needle.length();
+    if(n == 0 || offset >= len || len - offset < n) { return std::string::npos; }
+
+    const unsigned char first = m_needle[0];
+    const unsigned char last = m_needle[n - 1];
+    // When folding the case, OR-ing with 0x20 maps both cases of a letter to its lower case form
+    const unsigned char firstFold = (!m_matchCase && IsAsciiAlpha(first)) ? 0x20 : 0;
+    const unsigned char lastFold = (!m_matchCase && IsAsciiAlpha(last)) ? 0x20 : 0;
+
+    size_t i = offset;
+    const size_t end = len - n + 1; // the last position where a match can start (exclusive)
+
+#ifdef CL_LITERAL_MATCHER_SSE2
+    const __m128i vFirst = _mm_set1_epi8((char)first);
+    const __m128i vLast = _mm_set1_epi8((char)last);
+    const __m128i vFirstFold = _mm_set1_epi8((char)firstFold);
+    const __m128i vLastFold = _mm_set1_epi8((char)lastFold);
+    for(; i + 16 <= end; i += 16) {
+        __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + i));
+        __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + i + n - 1));
+        __m128i eqFirst = _mm_cmpeq_epi8(vFirst, _mm_or_si128(blockFirst, vFirstFold));
+        __m128i eqLast = _mm_cmpeq_epi8(vLast, _mm_or_si128(blockLast, vLastFold));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_and_si128(eqFirst, eqLast));
+        while(mask) {
+            int bit = CountTrailingZeros(mask);
+            if(Verify(buffer + i + bit)) { return i + bit; }
+            mask &= (mask - 1);
+        }
+    }
+#endif
+
+    // Scalar tail (or the entire buffer when SSE2 is not available)
+    if(m_matchCase) {
+        while(i < end) {
+            const char* p = (const char*)memchr(buffer + i, first, end - i);
+            if(!p) { break; }
+            i = p - buffer;
+            if((unsigned char)buffer[i + n - 1] == last && Verify(buffer + i)) { return i; }
+            ++i;
+        }
+    } else {
+        for(; i < end; ++i) {
+            if(((unsigned char)buffer[i] | firstFold) == first &&
+               ((unsigned char)buffer[i + n - 1] | lastFold) == last && Verify(buffer + i)) {
+                return i;
+            }
+        }
+    }
+    return std::string::npos;
+}
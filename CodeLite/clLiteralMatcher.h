@@ -0,0 +1,40 @@
+#ifndef CLLITERALMATCHER_H
+#define CLLITERALMATCHER_H
+
+#include "codelite_exports.h"
+#include <string>
+#include <wx/string.h>
+
+/**
+ * @class clLiteralMatcher
+ * @brief a byte level literal (non regex) matcher that works directly on UTF-8 buffers.
+ * Candidates are located by comparing the first and the last bytes of the needle against 16 bytes at a time (when SSE2
+ * is available) and only then the whole needle is verified. Case insensitive search folds ASCII letters only
+ */
+class WXDLLIMPEXP_CL clLiteralMatcher
+{
+    std::string m_needle;
+    bool m_matchCase = true;
+
+protected:
+    bool Verify(const char* p) const;
+
+public:
+    clLiteralMatcher(const std::string& needle, bool matchCase);
+    virtual ~clLiteralMatcher();
+
+    /**
+     * @brief can 'needle' be searched by this matcher? Case insensitive search is only supported for ASCII needles
+     */
+    static bool CanMatch(const wxString& needle, bool matchCase);
+
+    /**
+     * @brief find the first occurrence of the needle in buffer[offset, len)
+     * @return the byte offset of the match or std::string::npos
+     */
+    size_t Find(const char* buffer, size_t len, size_t offset) const;
+
+    const std::string& GetNeedle() const { return m_needle; }
+};
+
+#endif // CLLITERALMATCHER_H
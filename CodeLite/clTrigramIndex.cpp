@@ -0,0 +1,541 @@
+#include "clTrigramIndex.h"
+#include "file_logger.h"
+#include "fileutils.h"
+#include "macros.h"
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <unordered_set>
+
+#define TRIGRAM_INDEX_MAGIC 0x49544c43 // "CLTI"
+#define TRIGRAM_INDEX_VERSION 1
+
+// Files larger than this are not indexed (they are always scanned)
+#define TRIGRAM_INDEX_MAX_FILE_SIZE (8 * 1024 * 1024)
+
+namespace
+{
+inline unsigned char FoldCase(unsigned char ch) { return (ch >= 'A' && ch <= 'Z') ? (ch | 0x20) : ch; }
+inline unsigned int MakeTrigram(const char* p)
+{
+    return ((unsigned int)FoldCase(p[0]) << 16) | ((unsigned int)FoldCase(p[1]) << 8) | FoldCase(p[2]);
+}
+
+bool WriteUInt32(FILE* fp, unsigned int n) { return fwrite(&n, sizeof(n), 1, fp) == 1; }
+bool ReadUInt32(FILE* fp, unsigned int& n) { return fread(&n, sizeof(n), 1, fp) == 1; }
+bool WriteInt64(FILE* fp, wxInt64 n) { return fwrite(&n, sizeof(n), 1, fp) == 1; }
+bool ReadInt64(FILE* fp, wxInt64& n) { return fread(&n, sizeof(n), 1, fp) == 1; }
+
+class clTrigramIndexRequest : public ThreadRequest
+{
+public:
+    wxFileName m_indexFile;
+    wxArrayString m_files;
+    bool m_sync = false;
+};
+} // namespace
+
+clTrigramIndex::clTrigramIndex() {}
+
+clTrigramIndex::~clTrigramIndex() {}
+
+void clTrigramIndex::CollectTrigrams(const char* buffer, size_t len, std::vector<unsigned int>& trigrams)
+{
+    trigrams.clear();
+    if(len < 3) { return; }
+
+    // A bitmap of all possible trigrams (2^24 bits), used to de-duplicate them in a single pass
+    static thread_local std::vector<unsigned long long> seen;
+    if(seen.empty()) { seen.resize((1 << 24) / 64, 0); }
+    for(size_t i = 0; i + 2 < len; ++i) {
+        unsigned int key = MakeTrigram(buffer + i);
+        unsigned long long bit = 1ULL << (key & 63);
+        if((seen[key >> 6] & bit) == 0) {
+            seen[key >> 6] |= bit;
+            trigrams.push_back(key);
+        }
+    }
+
+    // reset the bitmap for the next call
+    for(size_t i = 0; i < trigrams.size(); ++i) {
+        seen[trigrams[i] >> 6] = 0;
+    }
+}
+
+bool clTrigramIndex::ExtractLiterals(const wxString& findWhat, bool isRegex, std::vector<std::string>& literals)
+{
+    literals.clear();
+    if(!isRegex) {
+        const wxScopedCharBuffer cb = findWhat.ToUTF8();
+        literals.push_back(std::string(cb.data(), cb.length()));
+        return true;
+    }
+
+    // Simple regular expressions only: collect the runs of literal characters. Alternations and groups
+    // can make any part of the expression optional, so we don't try to be smart about them
+    wxString current;
+    wxArrayString runs;
+    for(size_t i = 0; i < findWhat.length(); ++i) {
+        wxChar ch = findWhat[i];
+        switch(ch) {
+        case '|':
+        case '(':
+        case ')':
+            return false;
+        case '*':
+        case '?':
+        case '{':
+            // the previous atom is optional
+            if(!current.empty()) { current.RemoveLast(); }
+            runs.Add(current);
+            current.clear();
+            if(ch == '{') {
+                while(i < findWhat.length() && findWhat[i] != '}') {
+                    ++i;
+                }
+            }
+            break;
+        case '[':
+            // skip the bracket expression. A ']' right after the opening bracket is part of the set
+            runs.Add(current);
+            current.clear();
+            ++i;
+            if(i < findWhat.length() && findWhat[i] == '^') { ++i; }
+            if(i < findWhat.length() && findWhat[i] == ']') { ++i; }
+            while(i < findWhat.length() && findWhat[i] != ']') {
+                if(findWhat[i] == '\\') {
+                    ++i;
+                } else if(findWhat[i] == '[' && i + 1 < findWhat.length() &&
+                          (findWhat[i + 1] == ':' || findWhat[i + 1] == '.' || findWhat[i + 1] == '=')) {
+                    // a POSIX class ([:alpha:]), collating element ([.a.]) or equivalence class ([=a=]):
+                    // skip to its closing delimiter, the ']' inside does not end the bracket expression
+                    wxChar delim = findWhat[i + 1];
+                    i += 2;
+                    while(i + 1 < findWhat.length() && !(findWhat[i] == delim && findWhat[i + 1] == ']')) {
+                        ++i;
+                    }
+                    ++i;
+                }
+                ++i;
+            }
+            break;
+        case '\\':
+            if(i + 1 < findWhat.length() && !wxIsalnum(findWhat[i + 1])) {
+                // an escaped literal
+                current << findWhat[++i];
+            } else {
+                // a character class (\w, \d etc), a back reference, an anchor or a character code (\x41, \u0041,
+                // \cA). The escape is opaque: its digits are not part of the literal that follows it
+                runs.Add(current);
+                current.clear();
+                ++i;
+                if(i >= findWhat.length()) { break; }
+                wxChar esc = findWhat[i];
+                if(esc == 'c') {
+                    ++i;
+                } else if(esc == 'x' || esc == 'u' || esc == 'U' || wxIsdigit(esc)) {
+                    while(i + 1 < findWhat.length() && wxIsxdigit(findWhat[i + 1])) {
+                        ++i;
+                    }
+                }
+            }
+            break;
+        case '.':
+        case '^':
+        case '$':
+        case '+':
+            runs.Add(current);
+            current.clear();
+            break;
+        default:
+            current << ch;
+            break;
+        }
+    }
+    runs.Add(current);
+
+    for(size_t i = 0; i < runs.size(); ++i) {
+        if(runs.Item(i).length() < 3) { continue; }
+        const wxScopedCharBuffer cb = runs.Item(i).ToUTF8();
+        literals.push_back(std::string(cb.data(), cb.length()));
+    }
+    return !literals.empty();
+}
+
+void clTrigramIndex::DoAddFile(const wxString& path, time_t lastModified, bool indexed,
+                               const std::vector<unsigned int>& trigrams)
+{
+    // A re-indexed file gets a new id, so the posting lists remain sorted
+    DoRemoveFile(path);
+
+    unsigned int fileId = (unsigned int)m_files.size();
+    FileEntry entry;
+    entry.path = path;
+    entry.lastModified = lastModified;
+    entry.indexed = indexed;
+    m_files.push_back(entry);
+    m_fileIds[path] = fileId;
+    for(size_t i = 0; i < trigrams.size(); ++i) {
+        m_postings[trigrams[i]].push_back(fileId);
+    }
+    m_modified = true;
+}
+
+void clTrigramIndex::DoRemoveFile(const wxString& path)
+{
+    std::unordered_map<wxString, size_t>::iterator iter = m_fileIds.find(path);
+    if(iter == m_fileIds.end()) { return; }
+    m_files[iter->second].alive = false;
+    m_fileIds.erase(iter);
+    ++m_deadCount;
+    m_modified = true;
+}
+
+void clTrigramIndex::DoCompact()
+{
+    if(m_deadCount == 0) { return; }
+
+    // Assign new ids to the live files, preserving their order
+    std::vector<unsigned int> newIds(m_files.size(), (unsigned int)-1);
+    std::vector<FileEntry> files;
+    files.reserve(m_files.size() - m_deadCount);
+    for(size_t i = 0; i < m_files.size(); ++i) {
+        if(!m_files[i].alive) { continue; }
+        newIds[i] = (unsigned int)files.size();
+        files.push_back(m_files[i]);
+    }
+
+    std::unordered_map<unsigned int, std::vector<unsigned int> >::iterator iter = m_postings.begin();
+    while(iter != m_postings.end()) {
+        std::vector<unsigned int>& ids = iter->second;
+        size_t count = 0;
+        for(size_t i = 0; i < ids.size(); ++i) {
+            if(newIds[ids[i]] != (unsigned int)-1) { ids[count++] = newIds[ids[i]]; }
+        }
+        ids.resize(count);
+        if(ids.empty()) {
+            iter = m_postings.erase(iter);
+        } else {
+            ids.shrink_to_fit();
+            ++iter;
+        }
+    }
+
+    m_files.swap(files);
+    m_fileIds.clear();
+    for(size_t i = 0; i < m_files.size(); ++i) {
+        m_fileIds[m_files[i].path] = i;
+    }
+    m_deadCount = 0;
+    m_modified = true;
+}
+
+bool clTrigramIndex::Load(const wxFileName& filename)
+{
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_files.clear();
+    m_fileIds.clear();
+    m_postings.clear();
+    m_deadCount = 0;
+    m_modified = false;
+    m_stats = Stats();
+    m_filename = filename;
+
+    const wxCharBuffer cfile = filename.GetFullPath().mb_str(wxConvUTF8);
+    FILE* fp = fopen(cfile.data(), "rb");
+    if(!fp) { return false; }
+
+    bool ok = true;
+    unsigned int magic = 0, version = 0, count = 0;
+    ok = ReadUInt32(fp, magic) && ReadUInt32(fp, version) && magic == TRIGRAM_INDEX_MAGIC &&
+         version == TRIGRAM_INDEX_VERSION && ReadUInt32(fp, count);
+    for(unsigned int i = 0; ok && i < count; ++i) {
+        unsigned int len = 0, indexed = 0;
+        wxInt64 lastModified = 0;
+        ok = ReadUInt32(fp, len);
+        std::string path(len, 0);
+        ok = ok && (len == 0 || fread(&path[0], 1, len, fp) == len) && ReadInt64(fp, lastModified) &&
+             ReadUInt32(fp, indexed);
+        if(ok) {
+            FileEntry entry;
+            entry.path = wxString::FromUTF8(path.c_str(), path.length());
+            entry.lastModified = (time_t)lastModified;
+            entry.indexed = indexed != 0;
+            m_fileIds[entry.path] = m_files.size();
+            m_files.push_back(entry);
+        }
+    }
+
+    ok = ok && ReadUInt32(fp, count);
+    for(unsigned int i = 0; ok && i < count; ++i) {
+        unsigned int key = 0, len = 0;
+        ok = ReadUInt32(fp, key) && ReadUInt32(fp, len);
+        if(!ok) { break; }
+        std::vector<unsigned int>& ids = m_postings[key];
+        ids.resize(len);
+        ok = len == 0 || fread(&ids[0], sizeof(unsigned int), len, fp) == len;
+        for(unsigned int j = 0; ok && j < len; ++j) {
+            ok = ids[j] < m_files.size();
+        }
+    }
+    fclose(fp);
+
+    if(!ok) {
+        clWARNING() << "Trigram index:" << filename << "is corrupted. It will be rebuilt" << clEndl;
+        m_files.clear();
+        m_fileIds.clear();
+        m_postings.clear();
+        return false;
+    }
+    clDEBUG() << "Trigram index: loaded" << m_files.size() << "files from" << filename << clEndl;
+    return true;
+}
+
+bool clTrigramIndex::Save()
+{
+    std::lock_guard<std::mutex> lk(m_mutex);
+    return DoSave();
+}
+
+bool clTrigramIndex::DoSave()
+{
+    if(!m_modified || !m_filename.IsOk()) { return true; }
+    DoCompact();
+
+    // Write into a temporary file first so a crash won't leave a truncated index behind
+    wxString tmpfile = m_filename.GetFullPath() + ".tmp";
+    const wxCharBuffer cfile = tmpfile.mb_str(wxConvUTF8);
+    FILE* fp = fopen(cfile.data(), "wb");
+    if(!fp) {
+        clWARNING() << "Trigram index: failed to open file:" << tmpfile << "for write" << clEndl;
+        return false;
+    }
+
+    bool ok = WriteUInt32(fp, TRIGRAM_INDEX_MAGIC) && WriteUInt32(fp, TRIGRAM_INDEX_VERSION) &&
+              WriteUInt32(fp, (unsigned int)m_files.size());
+    for(size_t i = 0; ok && i < m_files.size(); ++i) {
+        const wxScopedCharBuffer cb = m_files[i].path.ToUTF8();
+        ok = WriteUInt32(fp, (unsigned int)cb.length()) && fwrite(cb.data(), 1, cb.length(), fp) == cb.length() &&
+             WriteInt64(fp, (wxInt64)m_files[i].lastModified) && WriteUInt32(fp, m_files[i].indexed ? 1 : 0);
+    }
+
+    ok = ok && WriteUInt32(fp, (unsigned int)m_postings.size());
+    std::unordered_map<unsigned int, std::vector<unsigned int> >::const_iterator iter = m_postings.begin();
+    for(; ok && iter != m_postings.end(); ++iter) {
+        const std::vector<unsigned int>& ids = iter->second;
+        ok = WriteUInt32(fp, iter->first) && WriteUInt32(fp, (unsigned int)ids.size()) &&
+             fwrite(ids.data(), sizeof(unsigned int), ids.size(), fp) == ids.size();
+    }
+    fclose(fp);
+
+    if(!ok || !::wxRenameFile(tmpfile, m_filename.GetFullPath(), true)) {
+        clWARNING() << "Trigram index: failed to write file:" << m_filename << clEndl;
+        clRemoveFile(tmpfile);
+        return false;
+    }
+    m_modified = false;
+    return true;
+}
+
+void clTrigramIndex::Clear()
+{
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_files.clear();
+    m_fileIds.clear();
+    m_postings.clear();
+    m_deadCount = 0;
+    m_modified = false;
+    m_stats = Stats();
+    m_filename.Clear();
+}
+
+void clTrigramIndex::Update(const wxArrayString& files, bool removeOthers)
+{
+    std::vector<unsigned int> trigrams;
+    size_t updated = 0;
+    for(size_t i = 0; i < files.size(); ++i) {
+        const wxString& path = files.Item(i);
+        time_t lastModified = FileUtils::GetFileModificationTime(path);
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            std::unordered_map<wxString, size_t>::iterator iter = m_fileIds.find(path);
+            if(lastModified == 0) {
+                // the file no longer exists
+                DoRemoveFile(path);
+                continue;
+            }
+            if(iter != m_fileIds.end() && m_files[iter->second].lastModified == lastModified) { continue; }
+        }
+
+        // Read and index the file without holding the lock
+        bool indexed = false;
+        trigrams.clear();
+        clFileView view;
+        if(view.Open(path) && view.GetLength() > 0 && view.GetLength() <= TRIGRAM_INDEX_MAX_FILE_SIZE) {
+            // Binary files are not indexed
+            indexed = memchr(view.GetData(), 0, view.GetLength()) == nullptr;
+            if(indexed) { CollectTrigrams(view.GetData(), view.GetLength(), trigrams); }
+        }
+
+        std::lock_guard<std::mutex> lk(m_mutex);
+        DoAddFile(path, lastModified, indexed, trigrams);
+        ++updated;
+    }
+
+    std::lock_guard<std::mutex> lk(m_mutex);
+    if(removeOthers) {
+        wxStringSet_t keep(files.begin(), files.end());
+        for(size_t i = 0; i < m_files.size(); ++i) {
+            if(m_files[i].alive && keep.count(m_files[i].path) == 0) { DoRemoveFile(m_files[i].path); }
+        }
+    }
+
+    // Don't let the dead entries pile up
+    if(m_deadCount > (m_files.size() / 4)) { DoCompact(); }
+    clDEBUG() << "Trigram index:" << updated << "files were (re)indexed" << clEndl;
+}
+
+bool clTrigramIndex::Filter(const wxString& findWhat, bool isRegex, wxArrayString& files)
+{
+    // Files the index rules out, with the modification time they were indexed with
+    std::vector<std::pair<wxString, time_t> > pruned;
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        if(!DoFilter(findWhat, isRegex, files, pruned)) { return false; }
+    }
+
+    // The index may lag behind the disk: files modified outside of CodeLite (e.g. by 'git checkout') or while the
+    // index is being synchronised must still be scanned. Only the pruned files need to be checked
+    size_t stale = 0;
+    for(size_t i = 0; i < pruned.size(); ++i) {
+        if(FileUtils::GetFileModificationTime(pruned[i].first) != pruned[i].second) {
+            files.Add(pruned[i].first);
+            ++stale;
+        }
+    }
+
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_stats.filesPruned += pruned.size() - stale;
+    m_stats.filesUnknown += stale;
+    if(stale) { clDEBUG() << "Trigram index:" << stale << "files were modified since they were indexed" << clEndl; }
+    return true;
+}
+
+bool clTrigramIndex::DoFilter(const wxString& findWhat, bool isRegex, wxArrayString& files,
+                              std::vector<std::pair<wxString, time_t> >& pruned)
+{
+    std::vector<std::string> literals;
+    if(m_files.empty() || !ExtractLiterals(findWhat, isRegex, literals)) {
+        ++m_stats.misses;
+        return false;
+    }
+
+    // Intersect the posting lists of all the trigrams of all the required literals
+    std::vector<unsigned int> candidates;
+    bool first = true;
+    std::vector<unsigned int> tmp;
+    for(size_t i = 0; i < literals.size(); ++i) {
+        const std::string& literal = literals[i];
+        for(size_t j = 0; j + 2 < literal.length(); ++j) {
+            std::unordered_map<unsigned int, std::vector<unsigned int> >::const_iterator iter =
+                m_postings.find(MakeTrigram(literal.c_str() + j));
+            if(iter == m_postings.end()) {
+                candidates.clear();
+                first = false;
+                break;
+            }
+            if(first) {
+                candidates = iter->second;
+                first = false;
+            } else {
+                tmp.clear();
+                std::set_intersection(candidates.begin(), candidates.end(), iter->second.begin(), iter->second.end(),
+                                      std::back_inserter(tmp));
+                candidates.swap(tmp);
+            }
+            if(candidates.empty()) { break; }
+        }
+    }
+
+    if(first) {
+        // all the literals are shorter than a trigram
+        ++m_stats.misses;
+        return false;
+    }
+
+    ++m_stats.hits;
+    wxArrayString filtered;
+    filtered.reserve(files.size());
+    for(size_t i = 0; i < files.size(); ++i) {
+        const wxString& path = files.Item(i);
+        std::unordered_map<wxString, size_t>::const_iterator iter = m_fileIds.find(path);
+        if(iter == m_fileIds.end() || !m_files[iter->second].indexed) {
+            // We know nothing about this file, it must be scanned
+            ++m_stats.filesUnknown;
+            filtered.Add(path);
+
+        } else if(std::binary_search(candidates.begin(), candidates.end(), (unsigned int)iter->second)) {
+            filtered.Add(path);
+
+        } else {
+            pruned.push_back(std::make_pair(path, m_files[iter->second].lastModified));
+        }
+    }
+    files.swap(filtered);
+    return true;
+}
+
+clTrigramIndex::Stats clTrigramIndex::GetStats() const
+{
+    std::lock_guard<std::mutex> lk(m_mutex);
+    Stats stats = m_stats;
+    stats.filesIndexed = m_files.size() - m_deadCount;
+    return stats;
+}
+
+bool clTrigramIndex::IsOk() const
+{
+    std::lock_guard<std::mutex> lk(m_mutex);
+    return !m_files.empty();
+}
+
+//----------------------------------------------------------------
+// clTrigramIndexer
+//----------------------------------------------------------------
+
+clTrigramIndexer::clTrigramIndexer(clTrigramIndex* index)
+    : m_index(index)
+{
+}
+
+clTrigramIndexer::~clTrigramIndexer() {}
+
+void clTrigramIndexer::Sync(const wxFileName& filename, const wxArrayString& files)
+{
+    clTrigramIndexRequest* req = new clTrigramIndexRequest();
+    req->m_indexFile = filename;
+    req->m_files = files;
+    req->m_sync = true;
+    Add(req);
+}
+
+void clTrigramIndexer::Update(const wxArrayString& files)
+{
+    clTrigramIndexRequest* req = new clTrigramIndexRequest();
+    req->m_files = files;
+    Add(req);
+}
+
+void clTrigramIndexer::ProcessRequest(ThreadRequest* request)
+{
+    clTrigramIndexRequest* req = static_cast<clTrigramIndexRequest*>(request);
+    if(req->m_sync) {
+        m_index->Load(req->m_indexFile);
+        m_index->Update(req->m_files, true);
+        m_index->Save();
+    } else {
+        // Don't rewrite the whole index for every saved file. If we crash before the index is saved, the next Sync()
+        // will spot the modification times that changed and re-index these files
+        m_index->Update(req->m_files, false);
+    }
+}
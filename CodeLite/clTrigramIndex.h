@@ -0,0 +1,127 @@
+#ifndef CLTRIGRAMINDEX_H
+#define CLTRIGRAMINDEX_H
+
+#include "codelite_exports.h"
+#include "worker_thread.h"
+#include "wxStringHash.h"
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <wx/arrstr.h>
+#include <wx/filename.h>
+#include <wx/string.h>
+
+/**
+ * @class clTrigramIndex
+ * @brief a persistent trigram index of the workspace files. For every 3 bytes sequence (ASCII letters are folded to
+ * lower case) the index keeps the list of files containing it. It is used to narrow down the list of files that need
+ * to be scanned by the "Find In Files" before they are read from the disk.
+ * All the public methods are thread safe
+ */
+class WXDLLIMPEXP_CL clTrigramIndex
+{
+public:
+    struct Stats {
+        size_t hits = 0;          // queries answered by the index
+        size_t misses = 0;        // queries the index could not help with (short needle, complex regex etc)
+        size_t filesIndexed = 0;  // number of files in the index
+        size_t filesPruned = 0;   // total number of candidate files removed by the index
+        size_t filesUnknown = 0;  // total number of candidate files that were not in the index
+    };
+
+protected:
+    struct FileEntry {
+        wxString path;
+        time_t lastModified = 0;
+        bool indexed = false; // false for files that are too big or binary, they are always a candidate
+        bool alive = true;    // false when the file was removed or re-indexed under a new id
+    };
+
+    mutable std::mutex m_mutex;
+    wxFileName m_filename;
+    std::vector<FileEntry> m_files;
+    std::unordered_map<wxString, size_t> m_fileIds;
+    std::unordered_map<unsigned int, std::vector<unsigned int> > m_postings;
+    size_t m_deadCount = 0;
+    bool m_modified = false;
+    Stats m_stats;
+
+protected:
+    static void CollectTrigrams(const char* buffer, size_t len, std::vector<unsigned int>& trigrams);
+    static bool ExtractLiterals(const wxString& findWhat, bool isRegex, std::vector<std::string>& literals);
+    void DoAddFile(const wxString& path, time_t lastModified, bool indexed, const std::vector<unsigned int>& trigrams);
+    void DoRemoveFile(const wxString& path);
+    void DoCompact();
+    bool DoFilter(const wxString& findWhat, bool isRegex, wxArrayString& files,
+                  std::vector<std::pair<wxString, time_t> >& pruned);
+    bool DoSave();
+
+public:
+    clTrigramIndex();
+    virtual ~clTrigramIndex();
+
+    /**
+     * @brief load the index from the disk. If the file does not exist (or is corrupted), the index is cleared and
+     * will be written to 'filename' on the next Save()
+     */
+    bool Load(const wxFileName& filename);
+
+    /**
+     * @brief write the index to the disk (only if it was modified)
+     */
+    bool Save();
+
+    /**
+     * @brief clear the index (in memory)
+     */
+    void Clear();
+
+    /**
+     * @brief bring the index up to date with 'files'. Files with the same modification time as the one recorded in
+     * the index are skipped
+     * @param removeOthers when true, files not listed in 'files' are removed from the index
+     */
+    void Update(const wxArrayString& files, bool removeOthers);
+
+    /**
+     * @brief remove files from the candidates list that can not contain 'findWhat'. Files that were modified since
+     * they were indexed are kept
+     * @return true if the index was able to narrow down the list
+     */
+    bool Filter(const wxString& findWhat, bool isRegex, wxArrayString& files);
+
+    /**
+     * @brief return the index usage statistics
+     */
+    Stats GetStats() const;
+
+    bool IsOk() const;
+};
+
+/**
+ * @class clTrigramIndexer
+ * @brief a background thread that keeps a clTrigramIndex up to date
+ */
+class WXDLLIMPEXP_CL clTrigramIndexer : public WorkerThread
+{
+    clTrigramIndex* m_index;
+
+public:
+    clTrigramIndexer(clTrigramIndex* index);
+    virtual ~clTrigramIndexer();
+
+    /**
+     * @brief load the index stored at 'filename' and synchronise it with the workspace files
+     */
+    void Sync(const wxFileName& filename, const wxArrayString& files);
+
+    /**
+     * @brief re-index the given files (e.g. after they were saved)
+     */
+    void Update(const wxArrayString& files);
+
+    void ProcessRequest(ThreadRequest* request);
+};
+
+#endif // CLTRIGRAMINDEX_H
@@ -55,6 +55,7 @@ clCommandEvent& clCommandEvent::operator=(const clCommandEvent& src)
     m_oldName = src.m_oldName;
     m_lineNumber = src.m_lineNumber;
     m_selected = src.m_selected;
+    m_stringRaw = src.m_stringRaw;
 
     // Copy wxCommandEvent members here
     m_eventType = src.m_eventType;
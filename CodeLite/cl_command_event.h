@@ -31,6 +31,7 @@
 #include "codelite_exports.h"
 #include "entry.h"
 #include "wxCodeCompletionBoxEntry.hpp"
+#include <string>
 #include <vector>
 #include <wx/arrstr.h>
 #include <wx/event.h>
@@ -146,6 +147,7 @@ protected:
     bool m_allowed;
     int m_lineNumber;
     bool m_selected;
+    std::string m_stringRaw;
 
 public:
     clCommandEvent(wxEventType commandType = wxEVT_NULL, int winid = 0);
@@ -176,6 +178,15 @@ public:
         return *this;
     }
     int GetLineNumber() const { return m_lineNumber; }
+    /**
+     * @brief raw bytes attached to the event (e.g. data read from a process, before any conversion to wxString)
+     */
+    clCommandEvent& SetStringRaw(const std::string& stringRaw)
+    {
+        this->m_stringRaw = stringRaw;
+        return *this;
+    }
+    const std::string& GetStringRaw() const { return m_stringRaw; }
     clCommandEvent& SetAllowed(bool allowed)
     {
         this->m_allowed = allowed;
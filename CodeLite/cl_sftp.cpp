@@ -30,8 +30,27 @@
 #include <sys/stat.h>
 #include <wx/filefn.h>
 #include <libssh/sftp.h>
+#include <deque>
 #include "cl_standard_paths.h"
 
+// Transfers are split into chunks of this size and up to SFTP_MAX_PENDING_REQUESTS of them are kept in flight,
+// so a transfer costs roughly one round trip per SFTP_MAX_PENDING_REQUESTS chunks instead of one per chunk.
+// 32K is the largest read/write every SFTP server must accept
+#define SFTP_CHUNK_SIZE 32768
+#define SFTP_MAX_PENDING_REQUESTS 16
+
+class SFTPFileCloser
+{
+    sftp_file m_file;
+
+public:
+    SFTPFileCloser(sftp_file f)
+        : m_file(f)
+    {
+    }
+    ~SFTPFileCloser() { sftp_close(m_file); }
+};
+
 class SFTPDirCloser
 {
     sftp_dir m_dir;
@@ -147,23 +166,13 @@ void clSFTP::Write(const wxMemoryBuffer& fileContent, const wxString& remotePath
                           sftp_get_error(m_sftp));
     }
 
-    char* p = (char*)fileContent.GetData();
-    const int maxChunkSize = 65536;
-    wxInt64 bytesLeft = fileContent.GetDataLen();
-
-    while(bytesLeft > 0) {
-        wxInt64 chunkSize = bytesLeft > maxChunkSize ? maxChunkSize : bytesLeft;
-        wxInt64 bytesWritten = sftp_write(file, p, chunkSize);
-        if(bytesWritten < 0) {
-            sftp_close(file);
-            throw clException(wxString() << _("Can't write data to file: ") << tmpRemoteFile << ". "
-                                         << ssh_get_error(m_ssh->GetSession()),
-                              sftp_get_error(m_sftp));
-        }
-        bytesLeft -= bytesWritten;
-        p += bytesWritten;
-    }
+    bool written = DoWrite(file, (const char*)fileContent.GetData(), fileContent.GetDataLen());
     sftp_close(file);
+    if(!written) {
+        throw clException(wxString() << _("Can't write data to file: ") << tmpRemoteFile << ". "
+                                     << ssh_get_error(m_ssh->GetSession()),
+                          sftp_get_error(m_sftp));
+    }
 
     // Unlink the original file if it exists
     bool needUnlink = false;
@@ -192,6 +201,90 @@ void clSFTP::Write(const wxMemoryBuffer& fileContent, const wxString& remotePath
     if(attributes && attributes->GetPermissions()) { Chmod(remotePath, attributes->GetPermissions()); }
 }
 
+bool clSFTP::DoWrite(sftp_file file, const char* p, size_t bytesLeft)
+{
+#if LIBSSH_VERSION_INT >= SSH_VERSION_INT(0, 11, 0)
+    // Pipeline the writes: keep several chunks in flight and collect the acknowledgements in order
+    std::deque<sftp_aio> pending;
+    bool success = true;
+    while(success && (bytesLeft > 0 || !pending.empty())) {
+        while(pending.size() < SFTP_MAX_PENDING_REQUESTS && bytesLeft > 0) {
+            size_t chunkSize = bytesLeft > SFTP_CHUNK_SIZE ? SFTP_CHUNK_SIZE : bytesLeft;
+            sftp_aio aio = NULL;
+            ssize_t nbytes = sftp_aio_begin_write(file, p, chunkSize, &aio);
+            if(nbytes < 0) {
+                success = false;
+                break;
+            }
+            pending.push_back(aio);
+            bytesLeft -= nbytes;
+            p += nbytes;
+        }
+        if(!success || pending.empty()) { break; }
+
+        sftp_aio aio = pending.front();
+        pending.pop_front();
+        success = sftp_aio_wait_write(&aio) >= 0;
+        sftp_aio_free(aio);
+    }
+
+    // Discard the requests we no longer care about
+    while(!pending.empty()) {
+        sftp_aio_free(pending.front());
+        pending.pop_front();
+    }
+    return success && bytesLeft == 0;
+#else
+    // This version of libssh has no asynchronous write API
+    while(bytesLeft > 0) {
+        size_t chunkSize = bytesLeft > SFTP_CHUNK_SIZE ? SFTP_CHUNK_SIZE : bytesLeft;
+        ssize_t bytesWritten = sftp_write(file, p, chunkSize);
+        if(bytesWritten <= 0) { return false; }
+        bytesLeft -= bytesWritten;
+        p += bytesWritten;
+    }
+    return true;
+#endif
+}
+
+void clSFTP::WriteRanges(const wxMemoryBuffer& fileContent, const wxString& remotePath, const Ranges_t& ranges)
+{
+    if(!m_sftp) { throw clException("SFTP is not initialized"); }
+
+    // Update the file in place: no O_TRUNC
+    sftp_file file = sftp_open(m_sftp, remotePath.mb_str(wxConvUTF8).data(), O_WRONLY, 0);
+    if(file == NULL) {
+        throw clException(wxString() << _("Can't open file: ") << remotePath << ". "
+                                     << ssh_get_error(m_ssh->GetSession()),
+                          sftp_get_error(m_sftp));
+    }
+
+    {
+        // Ensure the file is closed before we truncate it
+        SFTPFileCloser fc(file);
+        const char* data = (const char*)fileContent.GetData();
+        for(size_t i = 0; i < ranges.size(); ++i) {
+            const Range_t& range = ranges[i];
+            if(sftp_seek64(file, range.first) < 0 || !DoWrite(file, data + range.first, range.second)) {
+                throw clException(wxString() << _("Can't write data to file: ") << remotePath << ". "
+                                             << ssh_get_error(m_ssh->GetSession()),
+                                  sftp_get_error(m_sftp));
+            }
+        }
+    }
+
+    // The new content might be shorter than the old one
+    struct sftp_attributes_struct attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.flags = SSH_FILEXFER_ATTR_SIZE;
+    attr.size = fileContent.GetDataLen();
+    if(sftp_setstat(m_sftp, remotePath.mb_str(wxConvUTF8).data(), &attr) < 0) {
+        throw clException(wxString() << _("Failed to truncate file: ") << remotePath << ". "
+                                     << ssh_get_error(m_ssh->GetSession()),
+                          sftp_get_error(m_sftp));
+    }
+}
+
 SFTPAttribute::List_t clSFTP::List(const wxString& folder, size_t flags, const wxString& filter)
 {
     sftp_dir dir;
@@ -260,6 +353,9 @@ SFTPAttribute::Ptr_t clSFTP::Read(const wxString& remotePath, wxMemoryBuffer& bu
                           sftp_get_error(m_sftp));
     }
 
+    // Ensure the file is closed
+    SFTPFileCloser fc(file);
+
     SFTPAttribute::Ptr_t fileAttr = Stat(remotePath);
     if(!fileAttr) {
         throw clException(wxString() << _("Could not stat file:") << remotePath << ". "
@@ -269,30 +365,56 @@ SFTPAttribute::Ptr_t clSFTP::Read(const wxString& remotePath, wxMemoryBuffer& bu
     wxInt64 fileSize = fileAttr->GetSize();
     if(fileSize == 0) return fileAttr;
 
-    // Allocate buffer for the file content
-    char pBuffer[65536]; // buffer
-
-    // Read the entire file content
-    wxInt64 bytesLeft = fileSize;
-    wxInt64 bytesRead = 0;
-    while(bytesLeft > 0) {
-        wxInt64 nbytes = sftp_read(file, pBuffer, sizeof(pBuffer));
-        bytesRead += nbytes;
-        bytesLeft -= nbytes;
-        buffer.AppendData(pBuffer, nbytes);
-    }
-
+    // Read the entire file content directly into the output buffer
+    char* pData = (char*)buffer.GetWriteBuf(fileSize);
+    wxInt64 bytesRead = DoRead(file, pData, fileSize);
     if(bytesRead != fileSize) {
-        sftp_close(file);
-        buffer.Clear();
+        buffer.UngetWriteBuf(0);
         throw clException(wxString() << _("Could not read file:") << remotePath << ". "
                                      << ssh_get_error(m_ssh->GetSession()),
                           sftp_get_error(m_sftp));
     }
-    sftp_close(file);
+    buffer.UngetWriteBuf(fileSize);
     return fileAttr;
 }
 
+wxInt64 clSFTP::DoRead(sftp_file file, char* data, wxInt64 fileSize)
+{
+    // Pipeline the reads: keep several chunks in flight and consume the replies in order
+    std::deque<std::pair<int, uint32_t> > pending; // request id + requested length
+    wxInt64 requested = 0;
+    wxInt64 bytesRead = 0;
+    bool success = true;
+    while(success && bytesRead < fileSize) {
+        while(pending.size() < SFTP_MAX_PENDING_REQUESTS && requested < fileSize) {
+            uint32_t len = (fileSize - requested) > SFTP_CHUNK_SIZE ? SFTP_CHUNK_SIZE : (fileSize - requested);
+            int id = sftp_async_read_begin(file, len);
+            if(id < 0) {
+                success = false;
+                break;
+            }
+            pending.push_back(std::make_pair(id, len));
+            requested += len;
+        }
+        if(!success || pending.empty()) { break; }
+
+        std::pair<int, uint32_t> req = pending.front();
+        pending.pop_front();
+        int nbytes = sftp_async_read(file, data + bytesRead, req.second, req.first);
+        // A short read means that the file changed since we stat-ed it, the next chunks would not line up
+        success = (nbytes == (int)req.second);
+        if(nbytes > 0) { bytesRead += nbytes; }
+    }
+
+    // Collect the replies we no longer need, libssh keeps them in memory until we do
+    char scratch[SFTP_CHUNK_SIZE];
+    while(!pending.empty()) {
+        sftp_async_read(file, scratch, pending.front().second, pending.front().first);
+        pending.pop_front();
+    }
+    return bytesRead;
+}
+
 void clSFTP::CreateDir(const wxString& dirname)
 {
     if(!m_sftp) { throw clException("SFTP is not initialized"); }
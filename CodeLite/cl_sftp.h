@@ -33,11 +33,14 @@
 #include <wx/filename.h>
 #include "codelite_exports.h"
 #include "cl_sftp_attribute.h"
+#include <vector>
 #include <wx/buffer.h>
 
 // We do it this way to avoid exposing the include to <libssh/sftp.h> to files including this header
 struct sftp_session_struct;
 typedef struct sftp_session_struct* SFTPSession_t;
+struct sftp_file_struct;
+typedef struct sftp_file_struct* SFTPFile_t;
 
 class WXDLLIMPEXP_CL clSFTP
 {
@@ -47,8 +50,21 @@ class WXDLLIMPEXP_CL clSFTP
     wxString m_currentFolder;
     wxString m_account;
 
+protected:
+    /**
+     * @brief write the buffer into an opened remote file, keeping several requests in flight when libssh supports it
+     */
+    bool DoWrite(SFTPFile_t file, const char* p, size_t bytesLeft);
+    /**
+     * @brief read 'fileSize' bytes from an opened remote file into 'data', keeping several requests in flight
+     * @return the number of bytes read
+     */
+    wxInt64 DoRead(SFTPFile_t file, char* data, wxInt64 fileSize);
+
 public:
     typedef wxSharedPtr<clSFTP> Ptr_t;
+    typedef std::pair<wxInt64, wxInt64> Range_t; // offset + length
+    typedef std::vector<Range_t> Ranges_t;
     enum {
         SFTP_BROWSE_FILES = 0x00000001,
         SFTP_BROWSE_FOLDERS = 0x00000002,
@@ -98,6 +114,12 @@ public:
                const wxString& remotePath,
                SFTPAttribute::Ptr_t attributes = SFTPAttribute::Ptr_t(NULL)) ;
 
+    /**
+     * @brief update an existing remote file in place: write only the 'ranges' of 'fileContent' and truncate the
+     * file to the size of 'fileContent'. Unlike Write(), the update is not atomic
+     */
+    void WriteRanges(const wxMemoryBuffer& fileContent, const wxString& remotePath, const Ranges_t& ranges);
+
     /**
      * @brief read remote file and return its content
      * @return the file content + the file attributes
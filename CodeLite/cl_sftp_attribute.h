@@ -44,6 +44,7 @@ class WXDLLIMPEXP_CL SFTPAttribute : public wxClientData
     size_t m_size;
     SFTPAttribute_t m_attributes;
     size_t m_permissions;
+    time_t m_modificationTime;
     wxString m_symlinkPath; // incase this file represents a symlink, this member will hold the target path
 
 public:
@@ -75,6 +76,7 @@ public:
     void Assign(SFTPAttribute_t attr);
 
     size_t GetSize() const { return m_size; }
+    time_t GetModificationTime() const { return m_modificationTime; }
     wxString GetTypeAsString() const;
     const wxString& GetName() const { return m_name; }
 
@@ -50,6 +50,7 @@
 #include "wx/tokenzr.h"
 #include "wxStringHash.h"
 #include <algorithm>
+#include <memory>
 #include <set>
 #include <sstream>
 #include <wx/app.h>
@@ -65,6 +66,7 @@
 #include <wx/log.h>
 #include <wx/stdpaths.h>
 #include <wx/string.h>
+#include <wx/thread.h>
 #include <wx/txtstrm.h>
 #include <wx/wfstream.h>
 
@@ -77,6 +79,19 @@
 #define PIPE_NAME "/tmp/codelite_indexer.%s.sock"
 #endif
 
+// libctags keeps its state in global variables, so an indexer process parses one file at a time. Large batches of
+// files are dealt between the indexer and up to INDEXER_MAX_HELPERS helper processes
+#define INDEXER_MAX_HELPERS 7
+// Batches smaller than this are sent to the main indexer only
+#define INDEXER_HELPERS_MIN_FILES 50
+
+static size_t GetIndexerHelpersCount()
+{
+    int cpus = wxThread::GetCPUCount();
+    if(cpus <= 1) { return 0; }
+    return std::min((size_t)cpus - 1, (size_t)INDEXER_MAX_HELPERS);
+}
+
 wxDEFINE_EVENT(wxEVT_TAGS_DB_UPGRADE, wxCommandEvent);
 wxDEFINE_EVENT(wxEVT_TAGS_DB_UPGRADE_INTER, wxCommandEvent);
 
@@ -177,14 +192,24 @@ TagsManager::~TagsManager()
 
 #ifndef __WXMSW__
         // Clear the socket file
-        std::stringstream s;
-        s << wxGetProcessId();
-
-        char channel_name[1024];
-        memset(channel_name, 0, sizeof(channel_name));
-        sprintf(channel_name, PIPE_NAME, s.str().c_str());
-        ::unlink(channel_name);
-        ::remove(channel_name);
+        std::string channel_name = DoGetIndexerChannel();
+        ::unlink(channel_name.c_str());
+        ::remove(channel_name.c_str());
+#endif
+    }
+
+    m_canRestartIndexer = false;
+    for(size_t i = 0; i < m_indexerHelpers.size(); ++i) {
+        if(!m_indexerHelpers[i]) { continue; }
+#ifndef __WXMSW__
+        m_indexerHelpers[i]->Terminate();
+#endif
+        wxDELETE(m_indexerHelpers[i]);
+
+#ifndef __WXMSW__
+        std::string channel_name = DoGetIndexerChannel(i + 1);
+        ::unlink(channel_name.c_str());
+        ::remove(channel_name.c_str());
 #endif
     }
 }
@@ -311,8 +336,27 @@ void TagsManager::StartCodeLiteIndexer()
     }
 
     // concatenate the PID to identifies this channel to this instance of codelite
-    cmd << wxT("\"") << m_codeliteIndexerPath.GetFullPath() << wxT("\" ") << uid << wxT(" --pid");
-    m_codeliteIndexerProcess =
+    if(!m_codeliteIndexerProcess) {
+        cmd << wxT("\"") << m_codeliteIndexerPath.GetFullPath() << wxT("\" ") << uid << wxT(" --pid");
+        m_codeliteIndexerProcess =
+            CreateAsyncProcess(this, cmd, IProcessCreateDefault, clStandardPaths::Get().GetUserDataDir());
+    }
+
+    m_indexerHelpers.resize(GetIndexerHelpersCount(), NULL);
+    for(size_t i = 0; i < m_indexerHelpers.size(); ++i) {
+        if(!m_indexerHelpers[i]) { DoStartIndexerHelper(i); }
+    }
+}
+
+void TagsManager::DoStartIndexerHelper(size_t index)
+{
+    if(!m_canRestartIndexer || !m_codeliteIndexerPath.FileExists()) return;
+
+    // A helper is identified by "<PID>_<N>". The indexer reads the PID part to monitor its parent process
+    wxString cmd;
+    cmd << wxT("\"") << m_codeliteIndexerPath.GetFullPath() << wxT("\" ") << wxGetProcessId() << wxT("_")
+        << (index + 1) << wxT(" --pid --workers 1");
+    m_indexerHelpers[index] =
         CreateAsyncProcess(this, cmd, IProcessCreateDefault, clStandardPaths::Get().GetUserDataDir());
 }
 
@@ -324,11 +368,25 @@ void TagsManager::RestartCodeLiteIndexer()
     // by the termination handler
 }
 
+void TagsManager::DoRestartIndexerHelper(size_t index)
+{
+    // Called from the parser thread: the helpers are owned by the main thread
+    CallAfter([this, index]() {
+        if(index < m_indexerHelpers.size() && m_indexerHelpers[index]) { m_indexerHelpers[index]->Terminate(); }
+    });
+}
+
 void TagsManager::SetCodeLiteIndexerPath(const wxString& path) { m_codeliteIndexerPath = path; }
 
 void TagsManager::OnIndexerTerminated(clProcessEvent& event)
 {
-    wxUnusedVar(event);
+    for(size_t i = 0; i < m_indexerHelpers.size(); ++i) {
+        if(m_indexerHelpers[i] && m_indexerHelpers[i] == event.GetProcess()) {
+            wxDELETE(m_indexerHelpers[i]);
+            DoStartIndexerHelper(i);
+            return;
+        }
+    }
     wxDELETE(m_codeliteIndexerProcess);
     StartCodeLiteIndexer();
 }
@@ -336,16 +394,39 @@ void TagsManager::OnIndexerTerminated(clProcessEvent& event)
 //---------------------------------------------------------------------
 // Parsing
 //---------------------------------------------------------------------
-void TagsManager::SourceToTags(const wxFileName& source, wxString& tags)
+std::string TagsManager::DoGetIndexerChannel(size_t indexer) const
 {
     std::stringstream s;
     s << wxGetProcessId();
+    if(indexer > 0) { s << "_" << indexer; }
 
     char channel_name[1024];
     memset(channel_name, 0, sizeof(channel_name));
     sprintf(channel_name, PIPE_NAME, s.str().c_str());
+    return channel_name;
+}
+
+std::string TagsManager::DoGetIndexerCtagsOptions()
+{
+    wxString ctagsCmd;
+    ctagsCmd << wxT(" ") << m_tagsOptions.ToString()
+             << wxT(" --excmd=pattern --sort=no --fields=aKmSsnit --c-kinds=+p --C++-kinds=+p ");
+    return ctagsCmd.mb_str(wxConvUTF8).data();
+}
+
+void TagsManager::DoReplyToTags(const clIndexerReply& reply, wxString& tags) const
+{
+    // convert the data into wxString
+    if(m_encoding == wxFONTENCODING_DEFAULT || m_encoding == wxFONTENCODING_SYSTEM)
+        tags = wxString(reply.getTags().c_str(), wxConvUTF8);
+    else
+        tags = wxString(reply.getTags().c_str(), wxCSConv(m_encoding));
+    if(tags.empty()) { tags = wxString::From8BitData(reply.getTags().c_str()); }
+}
 
-    clNamedPipeClient client(channel_name);
+void TagsManager::SourceToTags(const wxFileName& source, wxString& tags)
+{
+    clNamedPipeClient client(DoGetIndexerChannel().c_str());
 
     // Build a request for the indexer
     clIndexerRequest req;
@@ -358,12 +439,9 @@ void TagsManager::SourceToTags(const wxFileName& source, wxString& tags)
     req.setFiles(files);
 
     // set ctags options to be used
-    wxString ctagsCmd;
-    ctagsCmd << wxT(" ") << m_tagsOptions.ToString()
-             << wxT(" --excmd=pattern --sort=no --fields=aKmSsnit --c-kinds=+p --C++-kinds=+p ");
-    req.setCtagOptions(ctagsCmd.mb_str(wxConvUTF8).data());
+    req.setCtagOptions(DoGetIndexerCtagsOptions());
 
-    // clDEBUG1() << "Sending CTAGS command:" << ctagsCmd << clEndl;
+    // clDEBUG1() << "Sending CTAGS command:" << req.getCtagOptions() << clEndl;
     // connect to the indexer
     if(!client.connect()) {
         clWARNING() << "Failed to connect to indexer process. Indexer ID:" << wxGetProcessId() << clEndl;
@@ -393,15 +471,80 @@ void TagsManager::SourceToTags(const wxFileName& source, wxString& tags)
     }
 
     // clDEBUG1() << "SourceToTags: [" << reply.getTags() << "]" << clEndl;
+    DoReplyToTags(reply, tags);
+    // clDEBUG1() << "Tags:\n" << tags << clEndl;
+}
 
-    // convert the data into wxString
-    if(m_encoding == wxFONTENCODING_DEFAULT || m_encoding == wxFONTENCODING_SYSTEM)
-        tags = wxString(reply.getTags().c_str(), wxConvUTF8);
-    else
-        tags = wxString(reply.getTags().c_str(), wxCSConv(m_encoding));
-    if(tags.empty()) { tags = wxString::From8BitData(reply.getTags().c_str()); }
+bool TagsManager::SourcesToTags(const wxArrayString& sources, const SourceToTagsCallback_t& callback)
+{
+    if(sources.IsEmpty()) { return true; }
 
-    // clDEBUG1() << "Tags:\n" << tags << clEndl;
+    // Connect to the indexers. A helper that is not running (yet) is simply not used
+    size_t poolSize = 1 + (sources.size() >= INDEXER_HELPERS_MIN_FILES ? GetIndexerHelpersCount() : 0);
+    std::vector<std::unique_ptr<clNamedPipeClient> > clients;
+    std::vector<size_t> indexers;
+    for(size_t i = 0; i < poolSize; ++i) {
+        std::unique_ptr<clNamedPipeClient> client(new clNamedPipeClient(DoGetIndexerChannel(i).c_str()));
+        if(client->connect()) {
+            clients.push_back(std::move(client));
+            indexers.push_back(i);
+        } else {
+            clWARNING() << "Failed to connect to indexer process:" << DoGetIndexerChannel(i) << clEndl;
+        }
+    }
+    if(clients.empty()) { return false; }
+
+    // Deal the files between the indexers: file 'i' is parsed by clients[i % count]. Each indexer gets a single
+    // request and replies per file
+    size_t count = clients.size();
+    std::string ctagsOptions = DoGetIndexerCtagsOptions();
+    for(size_t c = 0; c < count; ++c) {
+        clIndexerRequest req;
+        req.setCmd(clIndexerRequest::CLI_PARSE_FILES);
+
+        std::vector<std::string> files;
+        files.reserve((sources.size() / count) + 1);
+        for(size_t i = c; i < sources.size(); i += count) {
+            files.push_back(sources.Item(i).mb_str(wxConvUTF8).data());
+        }
+        req.setFiles(files);
+        req.setCtagOptions(ctagsOptions);
+
+        if(!clIndexerProtocol::SendRequest(clients[c].get(), req)) {
+            clWARNING() << "Failed to send request to indexer:" << DoGetIndexerChannel(indexers[c]) << clEndl;
+            return false;
+        }
+    }
+
+    // Read the replies in the order of 'sources'. While we wait for a reply, the other indexers keep parsing
+    for(size_t i = 0; i < sources.size(); ++i) {
+        size_t c = i % count;
+        clIndexerReply reply;
+        try {
+            std::string errmsg;
+            if(!clIndexerProtocol::ReadReply(clients[c].get(), reply, errmsg)) {
+                clWARNING() << "Failed to read indexer reply: " << (wxString() << errmsg) << clEndl;
+                if(indexers[c] == 0) {
+                    RestartCodeLiteIndexer();
+                } else {
+                    DoRestartIndexerHelper(indexers[c] - 1);
+                }
+                return false;
+            }
+        } catch(std::bad_alloc& ex) {
+            // we can't re-sync with the stream
+            clWARNING() << "std::bad_alloc exception caught" << clEndl;
+            return false;
+        }
+
+        wxString tags;
+        DoReplyToTags(reply, tags);
+        if(!callback(sources.Item(i), tags)) {
+            // closing the connections will stop the indexers from sending the remaining files
+            break;
+        }
+    }
+    return true;
 }
 
 TagTreePtr TagsManager::TreeFromTags(const wxString& tags, int& count)
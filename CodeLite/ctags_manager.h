@@ -45,6 +45,7 @@
 #include "wx/event.h"
 #include "wx/process.h"
 #include "wxStringHash.h"
+#include <functional>
 #include <set>
 #include <wx/stopwatch.h>
 #include <wx/thread.h>
@@ -59,6 +60,7 @@ class DirTraverser;
 class Language;
 class Language;
 class IProcess;
+class clIndexerReply;
 
 // Change this macro if you dont want to use the parser thread for performing
 // the workspcae retag
@@ -138,6 +140,10 @@ class WXDLLIMPEXP_CL TagsManager : public wxEvtHandler
 public:
     enum RetagType { Retag_Full, Retag_Quick, Retag_Quick_No_Scan };
     enum eLanguage { kCxx, kJavaScript };
+    /**
+     * @brief called by SourcesToTags() for every file parsed. Return false to stop the parsing
+     */
+    typedef std::function<bool(const wxString& filename, const wxString& tags)> SourceToTagsCallback_t;
 
 public:
     wxCriticalSection m_crawlerLocker;
@@ -145,6 +151,8 @@ public:
 private:
     wxFileName m_codeliteIndexerPath;
     IProcess* m_codeliteIndexerProcess;
+    // Additional indexer processes used to parse large batches of files in parallel (see SourcesToTags())
+    std::vector<IProcess*> m_indexerHelpers;
     wxString m_ctagsCmd;
     wxStopWatch m_watch;
     TagsOptionsData m_tagsOptions;
@@ -294,7 +302,7 @@ public:
     void Delete(const wxFileName& path, const wxString& fileName);
 
     /**
-     * Start a codelite_indexer process
+     * Start a codelite_indexer process, and the helper indexers used by SourcesToTags()
      */
     void StartCodeLiteIndexer();
 
@@ -532,6 +540,14 @@ public:
      */
     void SourceToTags(const wxFileName& source, wxString& tags);
 
+    /**
+     * Pass a list of source files to the ctags process. A large list is dealt between the indexer and its helper
+     * processes so the files are parsed on all the cores. The indexers reply per file, as soon as a file is parsed,
+     * and 'callback' is called with its tags (in the order of 'sources')
+     * @return false if the communication with the indexer failed
+     */
+    bool SourcesToTags(const wxArrayString& sources, const SourceToTagsCallback_t& callback);
+
     /**
      * return list of files from the database(s). The returned list is ordered
      * by name (ascending)
@@ -839,6 +855,14 @@ protected:
     std::map<wxString, bool> m_typeScopeContainerCache;
 
     void DoParseModifiedText(const wxString& text, std::vector<TagEntryPtr>& tags);
+    /**
+     * @brief return the channel of the indexer. 0 is the main indexer, 1..N are the helper indexers
+     */
+    std::string DoGetIndexerChannel(size_t indexer = 0) const;
+    void DoStartIndexerHelper(size_t index);
+    void DoRestartIndexerHelper(size_t index);
+    std::string DoGetIndexerCtagsOptions();
+    void DoReplyToTags(const clIndexerReply& reply, wxString& tags) const;
 
     /**
      * Handler ctags process termination
@@ -25,21 +25,245 @@
 
 #include "cl_standard_paths.h"
 #include "file_logger.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <sys/time.h>
+#include <thread>
 #include <wx/crt.h>
+#include <wx/filefn.h>
 #include <wx/filename.h>
 #include <wx/log.h>
 #include <wx/stdpaths.h>
 #include <wx/utils.h>
+#ifndef __WXMSW__
+#include <pthread.h>
+#endif
+
+// Rotate the log file once it grows beyond this size
+#define FILE_LOGGER_MAX_FILE_SIZE (10 * 1024 * 1024)
+// Number of rotated files to keep: codelite.log.1 ... codelite.log.N
+#define FILE_LOGGER_MAX_BACKUPS 3
+// A safety net only: the writer is notified whenever the queue becomes non empty
+#define FILE_LOGGER_WAKEUP_MS 1000
 
 int FileLogger::m_verbosity = FileLogger::Error;
 wxString FileLogger::m_logfile;
 std::unordered_map<wxThreadIdType, wxString> FileLogger::m_threads;
 wxCriticalSection FileLogger::m_cs;
 
+namespace
+{
+// Set once the writer is destroyed at exit. From there on, lines are written directly by the logging thread
+std::atomic<bool> s_writerDestroyed(false);
+// Set in a child created with fork() after the writer was created: it inherits the writer object but not its thread.
+// Checked for every line, so it must not cost a system call
+std::atomic<bool> s_forkedChild(false);
+
+#ifndef __WXMSW__
+void OnForkChild() { s_forkedChild.store(true); }
+#endif
+
+bool IsForkedChild() { return s_forkedChild.load(); }
+
+bool CanUseWriter() { return !s_writerDestroyed.load() && !IsForkedChild(); }
+
+void WriteToFile(const wxString& filename, const wxString& text)
+{
+    if(filename.IsEmpty()) { return; }
+    FILE* fp = wxFopen(filename, wxT("a+"));
+    if(fp) {
+        const wxScopedCharBuffer utf8 = text.ToUTF8();
+        fwrite(utf8.data(), 1, utf8.length(), fp);
+        fclose(fp);
+    }
+}
+
+/**
+ * @class FileLoggerWriter
+ * @brief owns the log file and a background thread that writes the queued lines into it in batches.
+ * The logging threads push their lines into a lock-free stack, the writer takes the whole stack at once
+ */
+class FileLoggerWriter
+{
+    struct Entry {
+        wxString text;
+        Entry* next = nullptr;
+    };
+
+    std::atomic<Entry*> m_head;
+    std::thread* m_thread = nullptr;
+
+    // Used to put the writer to sleep while the queue is empty
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_shutdown = false;
+
+    // Protects the log file. It is not held while sleeping, nor by the logging threads
+    std::mutex m_fileMutex;
+    wxString m_filename;
+    FILE* m_fp = nullptr;
+    wxFileOffset m_fileSize = 0;
+
+private:
+    FileLoggerWriter()
+        : m_head(nullptr)
+    {
+#ifndef __WXMSW__
+        pthread_atfork(nullptr, nullptr, &OnForkChild);
+#endif
+        m_thread = new std::thread(&FileLoggerWriter::DoWriterLoop, this);
+    }
+
+    void DoWriterLoop()
+    {
+        while(true) {
+            bool shutdown = false;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cv.wait_for(lock, std::chrono::milliseconds(FILE_LOGGER_WAKEUP_MS),
+                              [this]() { return m_head.load() != nullptr || m_shutdown; });
+                shutdown = m_shutdown;
+            }
+
+            // Write without holding m_mutex, so the logging threads are never blocked by the disk
+            {
+                std::lock_guard<std::mutex> lock(m_fileMutex);
+                DoWriteBatch(m_head.exchange(nullptr));
+            }
+            if(shutdown && m_head.load() == nullptr) { break; }
+        }
+    }
+
+    /**
+     * @brief write a batch of lines taken from the queue. Must be called with m_fileMutex held
+     */
+    void DoWriteBatch(Entry* entries)
+    {
+        if(!entries) { return; }
+
+        // The stack is in LIFO order, restore the order in which the lines were logged
+        Entry* ordered = nullptr;
+        while(entries) {
+            Entry* next = entries->next;
+            entries->next = ordered;
+            ordered = entries;
+            entries = next;
+        }
+
+        std::string batch;
+        while(ordered) {
+            const wxScopedCharBuffer utf8 = ordered->text.ToUTF8();
+            batch.append(utf8.data(), utf8.length());
+            Entry* next = ordered->next;
+            delete ordered;
+            ordered = next;
+        }
+
+        if(!DoOpen()) { return; }
+        fwrite(batch.c_str(), 1, batch.length(), m_fp);
+        fflush(m_fp);
+        m_fileSize += batch.length();
+        if(m_fileSize > FILE_LOGGER_MAX_FILE_SIZE) { DoRotate(); }
+    }
+
+    bool DoOpen()
+    {
+        if(m_fp) { return true; }
+        if(m_filename.IsEmpty()) { return false; }
+        m_fp = wxFopen(m_filename, wxT("a+"));
+        if(!m_fp) { return false; }
+        m_fileSize = wxFileName::FileExists(m_filename) ? wxFileName::GetSize(m_filename).GetValue() : 0;
+        return true;
+    }
+
+    void DoClose()
+    {
+        if(m_fp) {
+            fclose(m_fp);
+            m_fp = nullptr;
+        }
+        m_fileSize = 0;
+    }
+
+    void DoRotate()
+    {
+        DoClose();
+        // codelite.log.N-1 -> codelite.log.N ... codelite.log -> codelite.log.1
+        for(int i = FILE_LOGGER_MAX_BACKUPS - 1; i >= 0; --i) {
+            wxString from = (i == 0) ? m_filename : wxString() << m_filename << "." << i;
+            wxString to;
+            to << m_filename << "." << (i + 1);
+            if(wxFileName::FileExists(from)) { wxRenameFile(from, to, true); }
+        }
+        DoOpen();
+    }
+
+public:
+    static FileLoggerWriter& Get()
+    {
+        static FileLoggerWriter writer;
+        return writer;
+    }
+
+    ~FileLoggerWriter()
+    {
+        s_writerDestroyed.store(true);
+        if(IsForkedChild()) {
+            // exit() called in a child process: the writer thread does not exist here and the mutexes may have been
+            // locked at the time of the fork. Leave everything as is
+            return;
+        }
+
+        // Write everything that is still queued before we go down
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_shutdown = true;
+        }
+        m_cv.notify_one();
+        m_thread->join();
+        wxDELETE(m_thread);
+
+        std::lock_guard<std::mutex> lock(m_fileMutex);
+        DoWriteBatch(m_head.exchange(nullptr));
+        DoClose();
+    }
+
+    void SetFile(const wxString& filename)
+    {
+        std::lock_guard<std::mutex> lock(m_fileMutex);
+        if(filename == m_filename) { return; }
+        // Lines that were queued for the previous file are written to it first
+        DoWriteBatch(m_head.exchange(nullptr));
+        DoClose();
+        m_filename = filename;
+    }
+
+    /**
+     * @brief queue 'text' to the log file. The content of 'text' is moved into the queue
+     */
+    void Push(wxString& text)
+    {
+        Entry* entry = new Entry();
+        entry->text.swap(text);
+        Entry* head = m_head.load(std::memory_order_relaxed);
+        do {
+            entry->next = head;
+        } while(!m_head.compare_exchange_weak(head, entry, std::memory_order_release, std::memory_order_relaxed));
+
+        // Only the first line of a batch needs to wake the writer. Taking the mutex orders this push with the
+        // writer's test of the queue: either it sees the new line, or it is already waiting and gets notified
+        if(head == nullptr) {
+            { std::lock_guard<std::mutex> lock(m_mutex); }
+            m_cv.notify_one();
+        }
+    }
+};
+} // namespace
+
 FileLogger::FileLogger(int requestedVerbo)
     : _requestedLogLevel(requestedVerbo)
-    , m_fp(nullptr)
 {
 }
 
@@ -119,6 +343,7 @@ void FileLogger::OpenLog(const wxString& fullName, int verbosity)
     m_logfile.Clear();
     m_logfile << clStandardPaths::Get().GetUserDataDir() << wxFileName::GetPathSeparator() << fullName;
     m_verbosity = verbosity;
+    if(CanUseWriter()) { FileLoggerWriter::Get().SetFile(m_logfile); }
 }
 
 void FileLogger::AddLogLine(const wxArrayString& arr, int verbosity)
@@ -131,12 +356,12 @@ void FileLogger::AddLogLine(const wxArrayString& arr, int verbosity)
 void FileLogger::Flush()
 {
     if(m_buffer.IsEmpty()) { return; }
-    if(!m_fp) { m_fp = wxFopen(m_logfile, wxT("a+")); }
-
-    if(m_fp) {
-        wxFprintf(m_fp, "%s\n", m_buffer);
-        fclose(m_fp);
-        m_fp = nullptr;
+    m_buffer << "\n";
+    if(!CanUseWriter()) {
+        // Logging from a static destructor (the writer thread is gone) or from a forked child (it never existed)
+        WriteToFile(m_logfile, m_buffer);
+    } else {
+        FileLoggerWriter::Get().Push(m_buffer);
     }
     m_buffer.Clear();
 }
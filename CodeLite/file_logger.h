@@ -46,7 +46,6 @@ protected:
     static int m_verbosity;
     static wxString m_logfile;
     int _requestedLogLevel;
-    FILE* m_fp;
     wxString m_buffer;
     static std::unordered_map<wxThreadIdType, wxString> m_threads;
     static wxCriticalSection m_cs;
@@ -66,6 +65,12 @@ public:
 
     int GetRequestedLogLevel() const { return _requestedLogLevel; }
 
+    /**
+     * @brief return true if a line logged with 'level' should be written. The logging macros test this before
+     * building the line, so a disabled level costs a single branch
+     */
+    static bool CanLog(int level) { return level <= m_verbosity; }
+
     /**
      * @brief give a thread-id a unique name which will be displayed in log
      */
@@ -160,7 +165,7 @@ public:
     }
 
     /**
-     * @brief flush the logger content
+     * @brief flush the logger content. The content is queued and written to the log file by a background thread
      */
     void Flush();
 };
@@ -177,22 +182,44 @@ template <typename T> FileLogger& operator<<(FileLogger& logger, const T& obj)
     return logger;
 }
 
-#define CL_SYSTEM(...) FileLogger(FileLogger::System).AddLogLine(wxString::Format(__VA_ARGS__), FileLogger::System);
-#define CL_ERROR(...) FileLogger(FileLogger::Error).AddLogLine(wxString::Format(__VA_ARGS__), FileLogger::Error);
-#define CL_WARNING(...) FileLogger(FileLogger::Warning).AddLogLine(wxString::Format(__VA_ARGS__), FileLogger::Warning);
-#define CL_DEBUG(...) FileLogger(FileLogger::Dbg).AddLogLine(wxString::Format(__VA_ARGS__), FileLogger::Dbg);
-#define CL_DEBUGS(s) FileLogger(FileLogger::Dbg).AddLogLine(s, FileLogger::Dbg);
+// Skip the whole statement (including the evaluation of its arguments) when 'level' is disabled.
+// The empty 'if' branch keeps a trailing 'else' in the calling code bound to the caller's own 'if'
+#define CL_LOG_IF_ENABLED(level) \
+    if(!FileLogger::CanLog(level)) { \
+    } else
+
+#define CL_SYSTEM(...) \
+    CL_LOG_IF_ENABLED(FileLogger::System) \
+    FileLogger(FileLogger::System).AddLogLine(wxString::Format(__VA_ARGS__), FileLogger::System);
+#define CL_ERROR(...) \
+    CL_LOG_IF_ENABLED(FileLogger::Error) \
+    FileLogger(FileLogger::Error).AddLogLine(wxString::Format(__VA_ARGS__), FileLogger::Error);
+#define CL_WARNING(...) \
+    CL_LOG_IF_ENABLED(FileLogger::Warning) \
+    FileLogger(FileLogger::Warning).AddLogLine(wxString::Format(__VA_ARGS__), FileLogger::Warning);
+#define CL_DEBUG(...) \
+    CL_LOG_IF_ENABLED(FileLogger::Dbg) \
+    FileLogger(FileLogger::Dbg).AddLogLine(wxString::Format(__VA_ARGS__), FileLogger::Dbg);
+#define CL_DEBUGS(s) CL_LOG_IF_ENABLED(FileLogger::Dbg) FileLogger(FileLogger::Dbg).AddLogLine(s, FileLogger::Dbg);
 #define CL_DEBUG1(...) \
+    CL_LOG_IF_ENABLED(FileLogger::Developer) \
     FileLogger(FileLogger::Developer).AddLogLine(wxString::Format(__VA_ARGS__), FileLogger::Developer);
-#define CL_DEBUG_ARR(arr) FileLogger(FileLogger::Dbg).AddLogLine(arr, FileLogger::Dbg);
-#define CL_DEBUG1_ARR(arr) FileLogger(FileLogger::Developer).AddLogLine(arr, FileLogger::Developer);
+#define CL_DEBUG_ARR(arr) \
+    CL_LOG_IF_ENABLED(FileLogger::Dbg) FileLogger(FileLogger::Dbg).AddLogLine(arr, FileLogger::Dbg);
+#define CL_DEBUG1_ARR(arr) \
+    CL_LOG_IF_ENABLED(FileLogger::Developer) FileLogger(FileLogger::Developer).AddLogLine(arr, FileLogger::Developer);
 
 // New API
-#define clDEBUG() FileLogger(FileLogger::Dbg) << FileLogger::Prefix(FileLogger::Dbg)
-#define clDEBUG1() FileLogger(FileLogger::Developer) << FileLogger::Prefix(FileLogger::Developer)
-#define clERROR() FileLogger(FileLogger::Error) << FileLogger::Prefix(FileLogger::Error)
-#define clWARNING() FileLogger(FileLogger::Warning) << FileLogger::Prefix(FileLogger::Warning)
-#define clSYSTEM() FileLogger(FileLogger::System) << FileLogger::Prefix(FileLogger::System)
+#define clDEBUG() CL_LOG_IF_ENABLED(FileLogger::Dbg) FileLogger(FileLogger::Dbg) << FileLogger::Prefix(FileLogger::Dbg)
+#define clDEBUG1() \
+    CL_LOG_IF_ENABLED(FileLogger::Developer) \
+    FileLogger(FileLogger::Developer) << FileLogger::Prefix(FileLogger::Developer)
+#define clERROR() \
+    CL_LOG_IF_ENABLED(FileLogger::Error) FileLogger(FileLogger::Error) << FileLogger::Prefix(FileLogger::Error)
+#define clWARNING() \
+    CL_LOG_IF_ENABLED(FileLogger::Warning) FileLogger(FileLogger::Warning) << FileLogger::Prefix(FileLogger::Warning)
+#define clSYSTEM() \
+    CL_LOG_IF_ENABLED(FileLogger::System) FileLogger(FileLogger::System) << FileLogger::Prefix(FileLogger::System)
 
 // A replacement for wxLogMessage
 #define clLogMessage(msg) clDEBUG() << msg
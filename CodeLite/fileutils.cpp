@@ -52,6 +52,13 @@
 #include <sys/wait.h>
 #include <unistd.h>
 #endif
+#ifdef __WXMSW__
+#include <wx/msw/wrapwin.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 #include <wx/filename.h>
 
 void FileUtils::OpenFileExplorer(const wxString& path)
@@ -736,3 +743,160 @@ bool FileUtils::FindExe(const wxString& name, wxFileName& exepath, const wxArray
     }
     return false;
 }
+
+//----------------------------------------------------------------
+// clFileView
+//----------------------------------------------------------------
+
+clFileView::clFileView() {}
+
+clFileView::clFileView(const wxFileName& filename) { Open(filename); }
+
+clFileView::~clFileView() { Close(); }
+
+bool clFileView::Open(const wxFileName& filename)
+{
+    Close();
+
+    // The file is read into a private buffer rather than mapped: a mapping of a file that is truncated by another
+    // process (an editor saving it, git checkout) raises SIGBUS in the thread reading it, and on Windows a mapped file
+    // can not be truncated at all
+#ifdef __WXMSW__
+    HANDLE file = ::CreateFileW(filename.GetFullPath().wc_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                                NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if(file == INVALID_HANDLE_VALUE) { return false; }
+
+    LARGE_INTEGER size;
+    if(!::GetFileSizeEx(file, &size)) {
+        ::CloseHandle(file);
+        return false;
+    }
+
+    m_buffer.resize((size_t)size.QuadPart);
+    size_t bytesRead = 0;
+    while(bytesRead < m_buffer.size()) {
+        DWORD chunk = 0;
+        DWORD toRead = (DWORD)std::min(m_buffer.size() - bytesRead, (size_t)(1 << 30));
+        if(!::ReadFile(file, &m_buffer[bytesRead], toRead, &chunk, NULL)) {
+            ::CloseHandle(file);
+            m_buffer.clear();
+            return false;
+        }
+        if(chunk == 0) { break; } // the file was truncated while we were reading it
+        bytesRead += chunk;
+    }
+    ::CloseHandle(file);
+#else
+    const wxCharBuffer cfile = filename.GetFullPath().mb_str(wxConvUTF8);
+    int fd = ::open(cfile.data(), O_RDONLY);
+    if(fd < 0) { return false; }
+
+    struct stat st;
+    if(::fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+
+    m_buffer.resize((size_t)st.st_size);
+    size_t bytesRead = 0;
+    while(bytesRead < m_buffer.size()) {
+        ssize_t chunk = ::read(fd, &m_buffer[bytesRead], m_buffer.size() - bytesRead);
+        if(chunk < 0 && errno == EINTR) { continue; }
+        if(chunk < 0) {
+            clDEBUG() << "Failed to read file:" << filename << "." << strerror(errno) << clEndl;
+            ::close(fd);
+            m_buffer.clear();
+            return false;
+        }
+        if(chunk == 0) { break; } // the file was truncated while we were reading it
+        bytesRead += (size_t)chunk;
+    }
+    ::close(fd);
+#endif
+
+    // A file that grew while we were reading it is cut at its size when we opened it
+    m_buffer.resize(bytesRead);
+    m_length = m_buffer.size();
+    m_data = m_buffer.empty() ? nullptr : m_buffer.data();
+    m_isOk = true;
+    return true;
+}
+
+void clFileView::Close()
+{
+    std::vector<char>().swap(m_buffer);
+    m_data = nullptr;
+    m_length = 0;
+    m_isOk = false;
+    m_encoding = kEncodingUnknown;
+}
+
+clFileView::eEncoding clFileView::GetEncoding() const
+{
+    if(m_encoding != kEncodingUnknown) { return m_encoding; }
+
+    const unsigned char* p = (const unsigned char*)m_data;
+    size_t len = m_length;
+    if(len >= 3 && p[0] == 0xEF && p[1] == 0xBB && p[2] == 0xBF) {
+        m_encoding = kEncodingUTF8BOM;
+        return m_encoding;
+    }
+    if(len >= 2 && p[0] == 0xFF && p[1] == 0xFE) {
+        m_encoding = kEncodingUTF16LE;
+        return m_encoding;
+    }
+    if(len >= 2 && p[0] == 0xFE && p[1] == 0xFF) {
+        m_encoding = kEncodingUTF16BE;
+        return m_encoding;
+    }
+
+    // Validate the UTF-8 sequences
+    m_encoding = kEncodingUTF8;
+    size_t i = 0;
+    while(i < len) {
+        unsigned char ch = p[i];
+        if(ch == 0) {
+            m_encoding = kEncodingBinary;
+            break;
+        }
+        size_t extra = 0;
+        if(ch < 0x80) {
+            ++i;
+            continue;
+        } else if((ch & 0xE0) == 0xC0) {
+            extra = 1;
+        } else if((ch & 0xF0) == 0xE0) {
+            extra = 2;
+        } else if((ch & 0xF8) == 0xF0) {
+            extra = 3;
+        } else {
+            m_encoding = kEncoding8Bit;
+            break;
+        }
+
+        if(i + extra >= len) {
+            m_encoding = kEncoding8Bit;
+            break;
+        }
+        for(size_t j = 1; j <= extra; ++j) {
+            if((p[i + j] & 0xC0) != 0x80) {
+                m_encoding = kEncoding8Bit;
+                break;
+            }
+        }
+        if(m_encoding != kEncodingUTF8) { break; }
+        i += extra + 1;
+    }
+    return m_encoding;
+}
+
+wxString clFileView::ToString(const wxMBConv& conv) const
+{
+    if(m_length == 0) { return wxEmptyString; }
+    wxString str(m_data, conv, m_length);
+    if(str.IsEmpty()) {
+        // Conversion failed
+        str = wxString::From8BitData(m_data, m_length);
+    }
+    return str;
+}
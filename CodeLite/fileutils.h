@@ -31,6 +31,7 @@
 #include <wx/filename.h>
 #include <wx/log.h>
 #include "asyncprocess.h"
+#include <vector>
 
 #define clRemoveFile(filename) FileUtils::RemoveFile(filename, (wxString() << __FILE__ << ":" << __LINE__))
 
@@ -267,4 +268,65 @@ public:
      */
     static bool FindExe(const wxString& name, wxFileName& exepath, const wxArrayString& hint = wxArrayString());
 };
+
+/**
+ * @class clFileView
+ * @brief a read-only view of a file, loaded with a single read. The content is exposed as raw bytes, no encoding
+ * conversion is done. The encoding is only detected when it is requested.
+ * @note the file is not memory mapped: it may be modified or truncated by another process while the view is in use
+ */
+class WXDLLIMPEXP_CL clFileView
+{
+public:
+    enum eEncoding {
+        kEncodingUnknown = -1,
+        kEncodingUTF8,    // including plain ASCII
+        kEncodingUTF8BOM, // UTF-8 with a byte order mark
+        kEncodingUTF16LE,
+        kEncodingUTF16BE,
+        kEncoding8Bit, // not a valid UTF-8, probably one of the ISO-8859 code pages
+        kEncodingBinary,
+    };
+
+protected:
+    const char* m_data = nullptr;
+    size_t m_length = 0;
+    bool m_isOk = false;
+    mutable eEncoding m_encoding = kEncodingUnknown;
+    std::vector<char> m_buffer;
+
+private:
+    clFileView(const clFileView&);
+    clFileView& operator=(const clFileView&);
+
+public:
+    clFileView();
+    clFileView(const wxFileName& filename);
+    virtual ~clFileView();
+
+    /**
+     * @brief read 'filename' into memory. An empty file is a valid (empty) view
+     */
+    bool Open(const wxFileName& filename);
+    void Close();
+
+    bool IsOk() const { return m_isOk; }
+    const char* GetData() const { return m_data; }
+    size_t GetLength() const { return m_length; }
+
+    /**
+     * @brief return the file encoding. The encoding is detected on the first call
+     */
+    eEncoding GetEncoding() const;
+
+    /**
+     * @brief can the content be consumed as-is by UTF-8 code?
+     */
+    bool IsUTF8() const { return GetEncoding() == kEncodingUTF8 || GetEncoding() == kEncodingUTF8BOM; }
+
+    /**
+     * @brief decode the content into a wxString
+     */
+    wxString ToString(const wxMBConv& conv = wxConvUTF8) const;
+};
 #endif // FILEUTILS_H
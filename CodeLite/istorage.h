@@ -327,6 +327,18 @@ public:
      */
     virtual void Store(TagTreePtr tree, const wxFileName& path, bool autoCommit = true) = 0;
 
+    /**
+     * @brief enter bulk-load mode. Use it before storing a large number of tags (e.g. full retag): the search indexes
+     * and the insert trigger are dropped so the inserts only append rows to the table. EndBulkLoad() rebuilds them.
+     * The tags of a file can still be deleted efficiently while in this mode
+     */
+    virtual void BeginBulkLoad() = 0;
+
+    /**
+     * @brief leave bulk-load mode and rebuild the indexes and triggers dropped by BeginBulkLoad()
+     */
+    virtual void EndBulkLoad() = 0;
+
     /**
      * A very dengerous API call, which drops all tables from the database
      * and recreate the schema from fresh. It is used when upgrading database between different
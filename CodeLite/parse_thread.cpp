@@ -49,6 +49,11 @@
 
 #define DEBUG_MESSAGE(x) CL_DEBUG1(x.c_str())
 
+// Parsing this many files switches the database into bulk-load mode (see ITagsStorage::BeginBulkLoad())
+#define BULK_LOAD_MIN_FILES 500
+// In bulk-load mode, the number of files stored per transaction
+#define BULK_LOAD_FILES_PER_TX 200
+
 #define TEST_DESTROY()                                                                                        \
     {                                                                                                         \
         if(TestDestroy()) {                                                                                   \
@@ -370,23 +375,61 @@ void ParseThread::ParseAndStoreFiles(ParseRequest* req, const wxArrayString& arr
     // Loop over the files and parse them
     int totalSymbols(0);
     DEBUG_MESSAGE(wxString::Format(wxT("Parsing and saving files to database....")));
-    for(size_t i = 0; i < arrFiles.GetCount(); i++) {
 
+    // When parsing many files (e.g. full retag), the database indexes are rebuilt once at the end instead of being
+    // updated for every tag. The old tags of a file are replaced in the same transaction as its new tags, so a file
+    // that was not parsed (cancel, indexer failure) keeps its old tags
+    bool bulkLoad = (arrFiles.GetCount() >= BULK_LOAD_MIN_FILES);
+    size_t filesInTx(0);
+    wxStopWatch sw;
+    if(bulkLoad) {
+        db->BeginBulkLoad();
+        db->Begin();
+    }
+
+    // The files are sent to the indexers (see TagsManager::SourcesToTags()). They reply per file so we store the
+    // tags of a file while the next ones are being parsed
+    bool destroyRequested(false);
+    wxArrayString storedFiles;
+    storedFiles.Alloc(arrFiles.GetCount());
+    bool ok = TagsManagerST::Get()->SourcesToTags(arrFiles, [&](const wxString& filename, const wxString& tags) {
+        if(bulkLoad) {
+            db->DeleteByFileName(wxFileName(), filename, false);
+            if(!tags.IsEmpty()) { db->Store(DoTreeFromTags(tags, totalSymbols), wxFileName(), false); }
+            if(++filesInTx == BULK_LOAD_FILES_PER_TX) {
+                db->Commit();
+                db->Begin();
+                filesInTx = 0;
+            }
+        } else if(!tags.IsEmpty()) {
+            DoStoreTags(tags, filename, totalSymbols, db);
+        }
+        storedFiles.Add(filename);
         // give a shutdown request a chance
-        TEST_DESTROY();
+        destroyRequested = TestDestroy();
+        return !destroyRequested;
+    });
 
-        wxString tags; // output
-        TagsManagerST::Get()->SourceToTags(arrFiles.Item(i), tags);
+    if(bulkLoad) {
+        db->Commit();
+        db->EndBulkLoad();
+    }
 
-        if(tags.IsEmpty() == false) {
-            DoStoreTags(tags, arrFiles.Item(i), totalSymbols, db);
-        }
+    if(destroyRequested) {
+        DEBUG_MESSAGE(wxString::Format(wxT("ParseThread::ParseAndStoreFiles -> received 'TestDestroy()'")));
+        return;
+    }
+
+    if(!ok) {
+        // Their retag timestamp is not updated, so they are parsed again by the next retag
+        clWARNING() << "Lost the connection to the indexer." << (arrFiles.GetCount() - storedFiles.GetCount())
+                    << "files were not parsed" << clEndl;
     }
 
     DEBUG_MESSAGE(wxString(wxT("Done")));
 
-    // Update the retagging timestamp
-    TagsManagerST::Get()->UpdateFilesRetagTimestamp(arrFiles, db);
+    // Update the retagging timestamp of the files that were actually parsed
+    TagsManagerST::Get()->UpdateFilesRetagTimestamp(storedFiles, db);
 
     if(req->_evtHandler) {
         wxCommandEvent e(wxEVT_PARSE_THREAD_MESSAGE);
@@ -395,6 +438,10 @@ void ParseThread::ParseAndStoreFiles(ParseRequest* req, const wxArrayString& arr
             message << wxT("INFO: Found ") << initalCount << wxT(" system include files. ");
         message << arrFiles.GetCount() << wxT(" needed to be parsed. Stored ") << totalSymbols
                 << wxT(" new tags to the database");
+        if(bulkLoad) {
+            long elapsed = sw.Time();
+            message << wxT(" (") << ((totalSymbols * 1000L) / (elapsed > 0 ? elapsed : 1)) << wxT(" tags/sec)");
+        }
 
         e.SetClientData(new wxString(message.c_str()));
         req->_evtHandler->AddPendingEvent(e);
@@ -699,12 +746,20 @@ void ParseThread::DoNotifyReady(wxEvtHandler* caller, int requestType)
 void ParseThread::ProcessColourRequest(ParseRequest* req)
 {
     CxxTokenizer tokenizer;
-    // read the file content
+    // UTF-8 files are handed to the lexer as raw bytes, other encodings are decoded first
+    clFileView view;
     wxString content;
-    if(FileUtils::ReadFileContent(req->getFile(), content)) {
-        wxString flatStrLocals, flatClasses;
-
+    bool isOk = false;
+    if(view.Open(req->getFile()) && view.IsUTF8()) {
+        tokenizer.Reset(view.GetData(), view.GetLength());
+        isOk = true;
+    } else if(FileUtils::ReadFileContent(req->getFile(), content)) {
         tokenizer.Reset(content);
+        isOk = true;
+    }
+
+    if(isOk) {
+        wxString flatStrLocals, flatClasses;
 
         // lex the file and collect all tokens of type IDENTIFIER
         wxStringSet_t tokens;
@@ -23,15 +23,21 @@
 //////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////
 #include "clFilesCollector.h"
+#include "clLiteralMatcher.h"
+#include "clTrigramIndex.h"
 #include "cppwordscanner.h"
 #include "dirtraverser.h"
+#include "file_logger.h"
 #include "fileutils.h"
 #include "macros.h"
 #include "search_thread.h"
 #include "wx/event.h"
 #include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <memory>
 #include <set>
+#include <thread>
 #include <wx/dir.h>
 #if wxUSE_GUI
 #include <wx/fontmap.h>
@@ -55,8 +61,12 @@ wxDEFINE_EVENT(wxEVT_SEARCH_THREAD_SEARCHSTARTED, wxCommandEvent);
         wxPostEvent(owner, event);            \
     } else if(m_notifiedWindow) {             \
         wxPostEvent(m_notifiedWindow, event); \
-    }                                         \
-    wxThread::Sleep(1);
+    }
+
+// Matches are sent to the owner in batches: whenever this many matches were collected
+// or when this many milliseconds passed since the last batch was sent
+#define SEARCH_RESULTS_FLUSH_COUNT 500
+#define SEARCH_RESULTS_FLUSH_INTERVAL_MS 50
 
 //----------------------------------------------------------------
 // SearchData
@@ -104,8 +114,16 @@ SearchThread::~SearchThread() {}
 void SearchThread::IndexWordChars()
 {
     m_wordCharsMap.clear();
+    m_asciiWordChars.assign(128, false);
+    m_hasNonAsciiWordChars = false;
     for(size_t i = 0; i < m_wordChars.Length(); i++) {
-        m_wordCharsMap[m_wordChars.GetChar(i)] = true;
+        wxChar ch = m_wordChars.GetChar(i);
+        m_wordCharsMap[ch] = true;
+        if((wxUint32)ch < 128) {
+            m_asciiWordChars[ch] = true;
+        } else {
+            m_hasNonAsciiWordChars = true;
+        }
     }
 }
 
@@ -192,7 +210,31 @@ void SearchThread::DoSearchFiles(ThreadRequest* req)
     wxArrayString fileList;
     GetFiles(data, fileList);
 
-    wxStopWatch sw;
+    // Let the index drop the files that can not contain a match
+    if(m_trigramIndex) {
+        wxString findWhat = data->GetFindString();
+        if(data->IsEnablePipeSupport() && !data->IsRegularExpression() && findWhat.Find('|') != wxNOT_FOUND) {
+            findWhat = findWhat.BeforeFirst('|');
+        }
+        // The index is built from the raw file bytes and only folds the case of ASCII letters: a non ASCII string is
+        // only meaningful for a case sensitive search in UTF-8 files
+        bool isAscii = findWhat.IsAscii();
+#if wxUSE_GUI
+        bool isUtf8 = wxFontMapper::GetEncodingFromName(data->GetEncoding()) == wxFONTENCODING_UTF8;
+#else
+        bool isUtf8 = data->GetEncoding().CmpNoCase("UTF-8") == 0;
+#endif
+        bool canUseIndex = isAscii || (isUtf8 && data->IsMatchCase());
+        size_t count = fileList.size();
+        if(canUseIndex && m_trigramIndex->Filter(findWhat, data->IsRegularExpression(), fileList)) {
+            clTrigramIndex::Stats stats = m_trigramIndex->GetStats();
+            clDEBUG() << "Search index: scanning" << fileList.size() << "out of" << count << "files. Hits:" << stats.hits
+                      << "Misses:" << stats.misses << clEndl;
+        }
+    }
+
+    m_results.clear();
+    m_lastFlush.Start();
 
     // Send startup message to main thread
     if(m_notifiedWindow || data->GetOwner()) {
@@ -206,18 +248,188 @@ void SearchThread::DoSearchFiles(ThreadRequest* req)
         }
     }
 
-    for(size_t i = 0; i < fileList.Count(); i++) {
-        m_summary.SetNumFileScanned((int)i + 1);
+    size_t workersCount = GetWorkersCount();
+    bool completed = true;
+    if(workersCount > 1 && fileList.size() > workersCount) {
+        completed = DoSearchFilesParallel(fileList, data, workersCount);
+    } else {
+        completed = DoSearchFilesSerial(fileList, data);
+    }
 
+    if(!completed) {
+        // Send cancel event
+        SendEvent(wxEVT_SEARCH_THREAD_SEARCHCANCELED, data->GetOwner());
+        StopSearch(false);
+    }
+}
+
+size_t SearchThread::GetWorkersCount() const
+{
+    if(m_workersCount > 0) { return m_workersCount; }
+    int cpus = wxThread::GetCPUCount();
+    return cpus > 0 ? (size_t)cpus : 1;
+}
+
+bool SearchThread::DoSearchFilesSerial(const wxArrayString& files, const SearchData* data)
+{
+    wxRegEx noRegex;
+    wxRegEx& re = data->IsRegularExpression() ? GetRegex(data->GetFindString(), data->IsMatchCase()) : noRegex;
+    for(size_t i = 0; i < files.size(); i++) {
         // give user chance to cancel the search ...
-        if(TestStopSearch()) {
-            // Send cancel event
-            SendEvent(wxEVT_SEARCH_THREAD_SEARCHCANCELED, data->GetOwner());
-            StopSearch(false);
-            break;
+        if(TestStopSearch()) { return false; }
+
+        SearchResultList results;
+        bool readOk = DoSearchFile(files.Item(i), data, re, results);
+        DoFileScanned(files.Item(i), readOk, results, data);
+    }
+    return true;
+}
+
+//----------------------------------------------------------------
+// Parallel search
+//----------------------------------------------------------------
+
+/**
+ * @class SearchWorkQueues
+ * @brief a set of per-worker queues of file indexes. A worker consumes its own queue from the front (lowest index
+ * first) and when it runs dry, it steals from the back of the other workers queues
+ */
+class SearchWorkQueues
+{
+    struct Queue {
+        std::mutex m_mutex;
+        std::deque<size_t> m_items;
+    };
+    std::vector<std::unique_ptr<Queue> > m_queues;
+
+public:
+    SearchWorkQueues(size_t workersCount, size_t itemsCount)
+    {
+        for(size_t i = 0; i < workersCount; ++i) {
+            m_queues.push_back(std::unique_ptr<Queue>(new Queue()));
+        }
+        // Distribute the files in a round-robin manner so all the workers progress through the list from its
+        // start. This keeps the in-order merge moving forward instead of waiting for the first chunk
+        for(size_t i = 0; i < itemsCount; ++i) {
+            m_queues[i % workersCount]->m_items.push_back(i);
         }
-        DoSearchFile(fileList.Item(i), data);
     }
+
+    bool Pop(size_t worker, size_t& index)
+    {
+        {
+            Queue& q = *m_queues[worker];
+            std::lock_guard<std::mutex> lk(q.m_mutex);
+            if(!q.m_items.empty()) {
+                index = q.m_items.front();
+                q.m_items.pop_front();
+                return true;
+            }
+        }
+
+        // Our queue is empty, try to steal from the others
+        for(size_t i = 1; i < m_queues.size(); ++i) {
+            Queue& victim = *m_queues[(worker + i) % m_queues.size()];
+            std::lock_guard<std::mutex> lk(victim.m_mutex);
+            if(!victim.m_items.empty()) {
+                index = victim.m_items.back();
+                victim.m_items.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+struct SearchFileSlot {
+    SearchResultList m_results;
+    bool m_readOk = true;
+    bool m_done = false;
+};
+
+bool SearchThread::DoSearchFilesParallel(const wxArrayString& files, const SearchData* data, size_t workersCount)
+{
+    SearchWorkQueues queues(workersCount, files.size());
+    std::vector<SearchFileSlot> slots(files.size());
+    std::mutex slotsMutex;
+    std::condition_variable slotsCV;
+
+    std::vector<std::thread*> workers;
+    for(size_t w = 0; w < workersCount; ++w) {
+        workers.push_back(new std::thread([&, w]() {
+            // wxRegEx is not safe to share between threads, each worker compiles its own copy
+            wxRegEx re;
+            if(data->IsRegularExpression()) {
+#ifndef __WXMAC__
+                int flags = wxRE_ADVANCED;
+#else
+                int flags = wxRE_DEFAULT;
+#endif
+                if(!data->IsMatchCase()) { flags |= wxRE_ICASE; }
+                re.Compile(data->GetFindString(), flags);
+            }
+
+            size_t index = 0;
+            while(!TestStopSearch() && queues.Pop(w, index)) {
+                SearchResultList results;
+                bool readOk = DoSearchFile(files.Item(index), data, re, results);
+                {
+                    std::lock_guard<std::mutex> lk(slotsMutex);
+                    slots[index].m_results.swap(results);
+                    slots[index].m_readOk = readOk;
+                    slots[index].m_done = true;
+                }
+                slotsCV.notify_one();
+            }
+        }));
+    }
+
+    // Merge the results back in the files order and stream them to the owner
+    bool cancelled = false;
+    size_t next = 0;
+    while(next < files.size()) {
+        SearchResultList results;
+        bool readOk = true;
+        {
+            std::unique_lock<std::mutex> lk(slotsMutex);
+            if(!slotsCV.wait_for(lk, std::chrono::milliseconds(100), [&]() { return slots[next].m_done; })) {
+                // Timeout, check if the user cancelled the search
+                if(TestStopSearch()) {
+                    cancelled = true;
+                    break;
+                }
+                continue;
+            }
+            results.swap(slots[next].m_results);
+            readOk = slots[next].m_readOk;
+        }
+        DoFileScanned(files.Item(next), readOk, results, data);
+        ++next;
+    }
+
+    for(size_t i = 0; i < workers.size(); ++i) {
+        workers[i]->join();
+        wxDELETE(workers[i]);
+    }
+    return !cancelled && !TestStopSearch();
+}
+
+void SearchThread::DoFileScanned(const wxString& fileName, bool readOk, SearchResultList& results,
+                                 const SearchData* data)
+{
+    m_summary.SetNumFileScanned(m_summary.GetNumFileScanned() + 1);
+    if(!readOk) {
+        m_summary.GetFailedFiles().Add(fileName);
+        return;
+    }
+
+    if(!results.empty()) {
+        m_summary.SetNumMatchesFound(m_summary.GetNumMatchesFound() + (int)results.size());
+        m_results.splice(m_results.end(), results);
+    }
+
+    // Even when this file had no matches, give the pending ones a chance to be flushed
+    if(!m_results.empty()) { SendEvent(wxEVT_SEARCH_THREAD_MATCHFOUND, data->GetOwner()); }
 }
 
 bool SearchThread::TestStopSearch()
@@ -236,14 +448,19 @@ void SearchThread::StopSearch(bool stop)
     m_stopSearch = stop;
 }
 
-void SearchThread::DoSearchFile(const wxString& fileName, const SearchData* data)
+bool SearchThread::DoSearchFile(const wxString& fileName, const SearchData* data, wxRegEx& re,
+                                SearchResultList& results)
 {
     // Process single lines
     int lineNumber = 1;
-    if(!wxFileName::FileExists(fileName)) { return; }
+    if(!wxFileName::FileExists(fileName)) { return true; }
 
     size_t size = FileUtils::GetFileSize(fileName);
-    if(size == 0) { return; }
+    if(size == 0) { return true; }
+
+    // Plain literal search: scan the raw bytes without converting the file into a wxString
+    if(CanSearchLiteral(data)) { return DoSearchFileLiteral(fileName, data, results); }
+
     wxString fileData;
     fileData.Alloc(size);
 
@@ -251,15 +468,9 @@ void SearchThread::DoSearchFile(const wxString& fileName, const SearchData* data
     // support for other encoding
     wxFontEncoding enc = wxFontMapper::GetEncodingFromName(data->GetEncoding().c_str());
     wxCSConv fontEncConv(enc);
-    if(!FileUtils::ReadFileContent(fileName, fileData, fontEncConv)) {
-        m_summary.GetFailedFiles().Add(fileName);
-        return;
-    }
+    if(!FileUtils::ReadFileContent(fileName, fileData, fontEncConv)) { return false; }
 #else
-    if(!FileUtils::ReadFileContent(fileName, fileData, wxConvLibc)) {
-        m_summary.GetFailedFiles().Add(fileName);
-        return;
-    }
+    if(!FileUtils::ReadFileContent(fileName, fileData, wxConvLibc)) { return false; }
 #endif
     // take a wild guess and see if we really need to construct
     // a TextStatesPtr object (it is quite an expensive operation)
@@ -289,7 +500,7 @@ void SearchThread::DoSearchFile(const wxString& fileName, const SearchData* data
         while(tkz.HasMoreTokens()) {
             // Read the next line
             wxString line = tkz.NextToken();
-            DoSearchLineRE(line, lineNumber, lineOffset, fileName, data, states);
+            DoSearchLineRE(line, lineNumber, lineOffset, fileName, data, states, re, results);
             lineOffset += line.Length() + 1;
             lineNumber++;
         }
@@ -313,26 +524,117 @@ void SearchThread::DoSearchFile(const wxString& fileName, const SearchData* data
         }
 
         // Dont search for empty strings
-        if(findString.empty()) { return; }
-        
+        if(findString.empty()) { return true; }
+
         if(!data->IsMatchCase()) { findString.MakeLower(); }
         while(tkz.HasMoreTokens()) {
 
             // Read the next line
             wxString line = tkz.NextToken();
-            DoSearchLine(line, lineNumber, lineOffset, fileName, data, findString, filters, states);
+            DoSearchLine(line, lineNumber, lineOffset, fileName, data, findString, filters, states, results);
             lineOffset += line.Length() + 1;
             lineNumber++;
         }
     }
 
-    if(m_results.empty() == false) { SendEvent(wxEVT_SEARCH_THREAD_MATCHFOUND, data->GetOwner()); }
+    return true;
+}
+
+bool SearchThread::CanSearchLiteral(const SearchData* data) const
+{
+    if(data->IsRegularExpression()) { return false; }
+    // Pipe filters are applied per line, leave them to the generic code path
+    if(data->IsEnablePipeSupport() && data->GetFindString().Find('|') != wxNOT_FOUND) { return false; }
+    if(data->IsMatchWholeWord() && m_hasNonAsciiWordChars) { return false; }
+    if(!clLiteralMatcher::CanMatch(data->GetFindString(), data->IsMatchCase())) { return false; }
+#if wxUSE_GUI
+    // The raw bytes are only meaningful when the files are UTF-8 encoded
+    return wxFontMapper::GetEncodingFromName(data->GetEncoding()) == wxFONTENCODING_UTF8;
+#else
+    return data->GetEncoding().CmpNoCase("UTF-8") == 0;
+#endif
+}
+
+bool SearchThread::DoSearchFileLiteral(const wxString& fileName, const SearchData* data, SearchResultList& results)
+{
+    // Read the whole file into a buffer with a single read(), the bytes are searched as-is and never decoded
+    clFileView view;
+    if(!view.Open(fileName)) { return false; }
+
+    const wxString& findWhat = data->GetFindString();
+    const wxScopedCharBuffer findWhatUtf8 = findWhat.ToUTF8();
+    clLiteralMatcher matcher(std::string(findWhatUtf8.data(), findWhatUtf8.length()), data->IsMatchCase());
+    const std::string& needle = matcher.GetNeedle();
+    const char* p = view.GetData();
+    const size_t len = view.GetLength();
+
+    // The "cursor" keeps track of the line and the character offset (in wxString units) of 'bytePos'. It only moves
+    // forward, from one match to the next
+    size_t bytePos = 0;
+    int charPos = 0;
+    int lineNumber = 1;
+    size_t lineStartByte = 0;
+    int lineStartChar = 0;
+
+    size_t offset = 0;
+    while(true) {
+        size_t where = matcher.Find(p, len, offset);
+        if(where == std::string::npos) { break; }
+        offset = where + needle.length();
+
+        if(data->IsMatchWholeWord()) {
+            unsigned char before = where > 0 ? p[where - 1] : 0;
+            unsigned char after = offset < len ? p[offset] : 0;
+            if((before && before < 128 && m_asciiWordChars[before]) ||
+               (after && after < 128 && m_asciiWordChars[after])) {
+                continue;
+            }
+        }
+
+        // Move the cursor up to the match
+        for(; bytePos < where; ++bytePos) {
+            unsigned char ch = p[bytePos];
+            if(ch == '\n') {
+                ++lineNumber;
+                lineStartByte = bytePos + 1;
+                lineStartChar = charPos + 1;
+            }
+            if((ch & 0xC0) != 0x80) {
+                // not a continuation byte
+                ++charPos;
+                // characters outside the BMP are stored as surrogate pairs when wchar_t is 16 bit
+                if(sizeof(wchar_t) == 2 && ch >= 0xF0) { ++charPos; }
+            }
+        }
+
+        const char* lineEnd = (const char*)memchr(p + where, '\n', len - where);
+        size_t lineLen = (lineEnd ? (size_t)(lineEnd - p) : len) - lineStartByte;
+        wxString line = wxString::FromUTF8(p + lineStartByte, lineLen);
+        if(line.empty() && lineLen) { line = wxString::From8BitData(p + lineStartByte, lineLen); }
+
+        int col = charPos - lineStartChar;
+        SearchResult result;
+        result.SetPosition(charPos);
+        result.SetColumnInChars(col);
+        result.SetColumn((int)(where - lineStartByte));
+        result.SetLineNumber(lineNumber);
+        // Dont use match pattern larger than 500 chars
+        result.SetPattern(line.length() > 500 ? line.Mid(0, 500) : line);
+        result.SetFileName(fileName);
+        result.SetLenInChars((int)findWhat.length());
+        result.SetLen((int)needle.length());
+        result.SetFindWhat(findWhat);
+        result.SetFlags(data->m_flags);
+        result.SetMatchState(CppWordScanner::STATE_NORMAL);
+        results.push_back(result);
+    }
+    return true;
 }
 
 void SearchThread::DoSearchLineRE(const wxString& line, const int lineNum, const int lineOffset,
-                                  const wxString& fileName, const SearchData* data, TextStatesPtr statesPtr)
+                                  const wxString& fileName, const SearchData* data, TextStatesPtr statesPtr,
+                                  wxRegEx& re, SearchResultList& results)
 {
-    wxRegEx& re = GetRegex(data->GetFindString(), data->IsMatchCase());
     size_t col = 0;
     int iCorrectedCol = 0;
     int iCorrectedLen = 0;
@@ -397,10 +699,7 @@ void SearchThread::DoSearchLineRE(const wxString& line, const int lineNum, const
                 }
             }
 
-            if(canAdd) {
-                m_results.push_back(result);
-                m_summary.SetNumMatchesFound(m_summary.GetNumMatchesFound() + 1);
-            }
+            if(canAdd) { results.push_back(result); }
 
             col += len;
 
@@ -413,7 +712,7 @@ void SearchThread::DoSearchLineRE(const wxString& line, const int lineNum, const
 
 void SearchThread::DoSearchLine(const wxString& line, const int lineNum, const int lineOffset, const wxString& fileName,
                                 const SearchData* data, const wxString& findWhat, const wxArrayString& filters,
-                                TextStatesPtr statesPtr)
+                                TextStatesPtr statesPtr, SearchResultList& results)
 {
     wxString modLine = line;
 
@@ -524,10 +823,7 @@ void SearchThread::DoSearchLine(const wxString& line, const int lineNum, const i
                 }
             }
 
-            if(canAdd) {
-                m_results.push_back(result);
-                m_summary.SetNumMatchesFound(m_summary.GetNumMatchesFound() + 1);
-            }
+            if(canAdd) { results.push_back(result); }
 
             if(!AdjustLine(modLine, pos, findWhat)) { break; }
             col += (int)findWhat.Length();
@@ -553,33 +849,17 @@ void SearchThread::SendEvent(wxEventType type, wxEvtHandler* owner)
 
     wxCommandEvent event(type, GetId());
 
-    if(type == wxEVT_SEARCH_THREAD_MATCHFOUND && m_counter == 10) {
-        // match found and we scanned 10 files
-        m_counter = 0;
-        event.SetClientData(new SearchResultList(m_results));
-        m_results.clear();
-        SEND_ST_EVENT();
-
-    } else if(type == wxEVT_SEARCH_THREAD_MATCHFOUND) {
-        // a match event, but we did not meet the minimum number of files
-        m_counter++;
-        wxThread::Sleep(10);
+    if(type == wxEVT_SEARCH_THREAD_MATCHFOUND) {
+        // Batch the matches: flush them once enough were collected or when the time budget is exhausted
+        if(m_results.size() >= SEARCH_RESULTS_FLUSH_COUNT ||
+           m_lastFlush.Time() >= SEARCH_RESULTS_FLUSH_INTERVAL_MS) {
+            FlushResults(owner);
+        }
 
     } else if((type == wxEVT_SEARCH_THREAD_SEARCHEND) || (type == wxEVT_SEARCH_THREAD_SEARCHCANCELED)) {
         // search eneded, if we got any matches "buffed" send them before the
         // the summary event
-        if(m_results.empty() == false) {
-            wxCommandEvent evt(wxEVT_SEARCH_THREAD_MATCHFOUND, GetId());
-            evt.SetClientData(new SearchResultList(m_results));
-            if(owner) {
-                wxPostEvent(owner, evt);
-            } else if(m_notifiedWindow) {
-                wxPostEvent(m_notifiedWindow, evt);
-            }
-        }
-
-        m_results.clear();
-        m_counter = 0;
+        FlushResults(owner);
 
         // Now send the summary event
         event.SetClientData(type == wxEVT_SEARCH_THREAD_SEARCHEND ? new SearchSummary(m_summary) : nullptr);
@@ -587,6 +867,19 @@ void SearchThread::SendEvent(wxEventType type, wxEvtHandler* owner)
     }
 }
 
+void SearchThread::FlushResults(wxEvtHandler* owner)
+{
+    m_lastFlush.Start();
+    if(m_results.empty()) { return; }
+
+    // Hand over the collected matches by moving them into the event's list, no copy is made
+    wxCommandEvent event(wxEVT_SEARCH_THREAD_MATCHFOUND, GetId());
+    SearchResultList* results = new SearchResultList();
+    results->swap(m_results);
+    event.SetClientData(results);
+    SEND_ST_EVENT();
+}
+
 void SearchThread::FilterFiles(wxArrayString& files, const SearchData* data)
 {
     wxArrayString tmpFiles;
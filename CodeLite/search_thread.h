@@ -35,13 +35,16 @@
 #include <deque>
 #include <list>
 #include <map>
+#include <vector>
 #include <wx/regex.h>
+#include <wx/stopwatch.h>
 #include <wx/string.h>
 #include "JSON.h"
 
 class wxEvtHandler;
 class SearchResult;
 class SearchThread;
+class clTrigramIndex;
 
 //----------------------------------------------------------
 // The searched data class to be passed to the search thread
@@ -325,6 +328,8 @@ class WXDLLIMPEXP_CL SearchThread : public WorkerThread
     friend class SearchThreadST;
     wxString m_wordChars;
     std::unordered_map<wxChar, bool> m_wordCharsMap; //< Internal
+    std::vector<bool> m_asciiWordChars;              //< Internal, used by the literal search
+    bool m_hasNonAsciiWordChars = false;             //< Internal
     SearchResultList m_results;
     bool m_stopSearch;
     SearchSummary m_summary;
@@ -332,7 +337,9 @@ class WXDLLIMPEXP_CL SearchThread : public WorkerThread
     wxRegEx m_regex;
     bool m_matchCase;
     wxCriticalSection m_cs;
-    int m_counter = 0;
+    wxStopWatch m_lastFlush;
+    size_t m_workersCount = 0;
+    clTrigramIndex* m_trigramIndex = nullptr;
 
 public:
     /**
@@ -371,6 +378,18 @@ public:
      */
     void SetWordChars(const wxString& chars);
 
+    /**
+     * @brief set the number of worker threads used for scanning the files. Passing 0 means: use one worker per CPU.
+     * Passing 1 disables the parallel search and scan the files on the search thread itself
+     */
+    void SetWorkersCount(size_t count) { m_workersCount = count; }
+    size_t GetWorkersCount() const;
+
+    /**
+     * @brief use 'index' to narrow down the list of files before they are scanned. Pass nullptr to disable it
+     */
+    void SetTrigramIndex(clTrigramIndex* index) { m_trigramIndex = index; }
+
 private:
     /**
      * Return files to search
@@ -393,21 +412,53 @@ private:
      */
     void DoSearchFiles(ThreadRequest* data);
 
-    // Perform search on a single file
-    void DoSearchFile(const wxString& fileName, const SearchData* data);
+    /**
+     * @brief scan the files one by one on the search thread
+     * @return false if the search was cancelled by the user
+     */
+    bool DoSearchFilesSerial(const wxArrayString& files, const SearchData* data);
+
+    /**
+     * @brief split the files between a pool of work-stealing workers. The results are merged back and reported in
+     * the same order as 'files'
+     * @return false if the search was cancelled by the user
+     */
+    bool DoSearchFilesParallel(const wxArrayString& files, const SearchData* data, size_t workersCount);
+
+    /**
+     * @brief report the results of a single file (in the order the files were scanned)
+     */
+    void DoFileScanned(const wxString& fileName, bool readOk, SearchResultList& results, const SearchData* data);
+
+    // Perform search on a single file, return false if the file could not be read
+    bool DoSearchFile(const wxString& fileName, const SearchData* data, wxRegEx& re, SearchResultList& results);
+
+    /**
+     * @brief can the search be performed by scanning the raw UTF-8 bytes of the file?
+     */
+    bool CanSearchLiteral(const SearchData* data) const;
+
+    /**
+     * @brief search the file without decoding it into a wxString. Line numbers and columns are only computed for
+     * the matches
+     */
+    bool DoSearchFileLiteral(const wxString& fileName, const SearchData* data, SearchResultList& results);
 
     // Perform search on a line
     void DoSearchLine(const wxString& line, const int lineNum, const int lineOffset, const wxString& fileName,
                       const SearchData* data, const wxString& findWhat, const wxArrayString& filters,
-                      TextStatesPtr statesPtr);
+                      TextStatesPtr statesPtr, SearchResultList& results);
 
     // Perform search on a line using regular expression
     void DoSearchLineRE(const wxString& line, const int lineNum, const int lineOffset, const wxString& fileName,
-                        const SearchData* data, TextStatesPtr statesPtr);
+                        const SearchData* data, TextStatesPtr statesPtr, wxRegEx& re, SearchResultList& results);
 
     // Send an event to the notified window
     void SendEvent(wxEventType type, wxEvtHandler* owner);
 
+    // Send the pending matches (if any) to the notified window
+    void FlushResults(wxEvtHandler* owner);
+
     // return a compiled regex object for the expression
     wxRegEx& GetRegex(const wxString& expr, bool matchCase);
 
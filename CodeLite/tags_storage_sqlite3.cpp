@@ -30,11 +30,20 @@
 #include <wx/longlong.h>
 #include <wx/tokenzr.h>
 
+#define INSERT_TAG_SQL wxT("INSERT OR REPLACE INTO TAGS VALUES (NULL, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)")
+
+// The indexes dropped while in bulk-load mode. They are re-created by CreateSchema(). FILE_IDX is kept so the tags
+// of a file can still be deleted right before its new tags are stored
+static const wxChar* BULK_LOAD_INDEXES[] = { wxT("TAGS_NAME"), wxT("TAGS_SCOPE"), wxT("TAGS_PATH"), wxT("TAGS_PARENT"),
+                                             wxT("TAGS_TYPEREF") };
+
 //-------------------------------------------------
 // Tags database class implementation
 //-------------------------------------------------
 TagsStorageSQLite::TagsStorageSQLite()
     : ITagsStorage()
+    , m_bulkInsertStmt(NULL)
+    , m_bulkRows(0)
 {
     m_db = new clSqliteDB();
     SetUseCache(true);
@@ -42,6 +51,7 @@ TagsStorageSQLite::TagsStorageSQLite()
 
 TagsStorageSQLite::~TagsStorageSQLite()
 {
+    EndBulkLoad();
     if(m_db) {
         m_db->Close();
         delete m_db;
@@ -60,6 +70,9 @@ void TagsStorageSQLite::OpenDatabase(const wxFileName& fileName)
     // do have an open database, so we will use it
     if(!fileName.IsOk()) return;
 
+    // the bulk-load statement belongs to the current database
+    EndBulkLoad();
+
     try {
         if(!m_fileName.IsOk()) {
             // First time we open the db
@@ -303,6 +316,69 @@ void TagsStorageSQLite::Store(TagTreePtr tree, const wxFileName& path, bool auto
     }
 }
 
+void TagsStorageSQLite::BeginBulkLoad()
+{
+    if(m_bulkInsertStmt) return;
+    try {
+        // Remember where the new tags start: since the 'tags_insert' trigger is dropped, the global_tags
+        // table is filled for the new tags when leaving the bulk-load mode
+        {
+            wxSQLite3ResultSet rs = m_db->ExecuteQuery(wxT("SELECT MAX(ID) FROM TAGS"));
+            m_bulkFirstId = (rs.NextRow() ? rs.GetInt64(0) : wxLongLong(0)) + 1;
+        }
+
+        // 'tags_delete' is kept: deleting the old tags of a file must still remove their global_tags entries
+        m_db->ExecuteUpdate(wxT("DROP TRIGGER IF EXISTS tags_insert"));
+        for(size_t i = 0; i < sizeof(BULK_LOAD_INDEXES) / sizeof(BULK_LOAD_INDEXES[0]); ++i) {
+            m_db->ExecuteUpdate(wxString() << wxT("DROP INDEX IF EXISTS ") << BULK_LOAD_INDEXES[i]);
+        }
+
+        // the insert statement is prepared once and re-used for all the tags
+        m_bulkInsertStmt = new wxSQLite3Statement(m_db->GetPrepareStatement(INSERT_TAG_SQL));
+        m_bulkRows = 0;
+        m_bulkStopWatch.Start();
+        if(GetUseCache()) { ClearCache(); }
+        clDEBUG() << "Tags database: bulk-load mode started" << clEndl;
+
+    } catch(wxSQLite3Exception& e) {
+        clWARNING() << "Tags database: failed to start bulk-load mode." << e.GetMessage() << clEndl;
+        // restore anything that was dropped
+        wxDELETE(m_bulkInsertStmt);
+        CreateSchema();
+    }
+}
+
+void TagsStorageSQLite::EndBulkLoad()
+{
+    if(!m_bulkInsertStmt) return;
+    wxDELETE(m_bulkInsertStmt);
+
+    long insertTime = m_bulkStopWatch.Time();
+    wxStopWatch sw;
+    try {
+        wxString sql;
+        sql << wxT("INSERT INTO global_tags (id, name, tag_id) SELECT NULL, name, id FROM tags WHERE scope = "
+                   "'<global>' AND id >= ")
+            << m_bulkFirstId.ToString();
+        m_db->Begin();
+        // An 'INSERT OR REPLACE' that collides with an existing tag deletes it without firing 'tags_delete', and the
+        // replaced tag may be older than m_bulkFirstId: remove the global_tags entries left without a tag
+        m_db->ExecuteUpdate(wxT("DELETE FROM global_tags WHERE tag_id NOT IN (SELECT id FROM tags)"));
+        m_db->ExecuteUpdate(sql);
+        m_db->Commit();
+
+    } catch(wxSQLite3Exception& e) {
+        clWARNING() << "Tags database: failed to update the global tags table." << e.GetMessage() << clEndl;
+    }
+
+    // re-create the indexes and the triggers
+    CreateSchema();
+
+    size_t rowsPerSec = (m_bulkRows * 1000) / (insertTime > 0 ? insertTime : 1);
+    clDEBUG() << "Tags database: bulk-load mode ended." << m_bulkRows << "tags stored in" << insertTime << "ms ("
+              << rowsPerSec << "rows/sec). Indexes rebuilt in" << sw.Time() << "ms" << clEndl;
+}
+
 void TagsStorageSQLite::SelectTagsByFile(const wxString& file, std::vector<TagEntryPtr>& tags, const wxFileName& path)
 {
     // Incase empty file path is provided, use the current file name
@@ -857,25 +933,31 @@ int TagsStorageSQLite::DoInsertTagEntry(const TagEntry& tag)
     if(!tag.IsOk()) return TagOk;
 
     // does not matter if we insert or update, the cache must be cleared for any related tags
-    if(GetUseCache()) { ClearCache(); }
+    // (in bulk-load mode, this was done once when the mode started)
+    if(GetUseCache() && !m_bulkInsertStmt) { ClearCache(); }
 
     try {
-        wxSQLite3Statement statement = m_db->GetPrepareStatement(
-            wxT("INSERT OR REPLACE INTO TAGS VALUES (NULL, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"));
-        statement.Bind(1, tag.GetName());
-        statement.Bind(2, tag.GetFile());
-        statement.Bind(3, tag.GetLine());
-        statement.Bind(4, tag.GetKind());
-        statement.Bind(5, tag.GetAccess());
-        statement.Bind(6, tag.GetSignature());
-        statement.Bind(7, tag.GetPattern());
-        statement.Bind(8, tag.GetParent());
-        statement.Bind(9, tag.GetInheritsAsString());
-        statement.Bind(10, tag.GetPath());
-        statement.Bind(11, tag.GetTyperef());
-        statement.Bind(12, tag.GetScope());
-        statement.Bind(13, tag.GetReturnValue());
-        statement.ExecuteUpdate();
+        wxSQLite3Statement localStatement;
+        wxSQLite3Statement* statement = m_bulkInsertStmt;
+        if(!statement) {
+            localStatement = m_db->GetPrepareStatement(INSERT_TAG_SQL);
+            statement = &localStatement;
+        }
+        statement->Bind(1, tag.GetName());
+        statement->Bind(2, tag.GetFile());
+        statement->Bind(3, tag.GetLine());
+        statement->Bind(4, tag.GetKind());
+        statement->Bind(5, tag.GetAccess());
+        statement->Bind(6, tag.GetSignature());
+        statement->Bind(7, tag.GetPattern());
+        statement->Bind(8, tag.GetParent());
+        statement->Bind(9, tag.GetInheritsAsString());
+        statement->Bind(10, tag.GetPath());
+        statement->Bind(11, tag.GetTyperef());
+        statement->Bind(12, tag.GetScope());
+        statement->Bind(13, tag.GetReturnValue());
+        statement->ExecuteUpdate();
+        if(m_bulkInsertStmt) { ++m_bulkRows; }
     } catch(wxSQLite3Exception& exc) {
         return TagError;
     }
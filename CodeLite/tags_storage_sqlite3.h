@@ -33,6 +33,7 @@
 #include "wxStringHash.h"
 #include <unordered_map>
 #include <wx/filename.h>
+#include <wx/stopwatch.h>
 #include <wx/wxsqlite3.h>
 
 /**
@@ -134,6 +135,12 @@ class WXDLLIMPEXP_CL TagsStorageSQLite : public ITagsStorage
     clSqliteDB* m_db;
     TagsStorageSQLiteCache m_cache;
 
+    // bulk-load mode
+    wxSQLite3Statement* m_bulkInsertStmt;
+    wxLongLong m_bulkFirstId;
+    size_t m_bulkRows;
+    wxStopWatch m_bulkStopWatch;
+
 private:
     /**
      * @brief fetch tags from the database
@@ -210,6 +217,9 @@ public:
      */
     void Store(TagTreePtr tree, const wxFileName& path, bool autoCommit = true);
 
+    void BeginBulkLoad();
+    void EndBulkLoad();
+
     /**
      * Return a result set of tags according to file name.
      * @param file Source file name
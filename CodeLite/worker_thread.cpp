@@ -103,6 +103,9 @@ void WorkerThread::ClearQueue()
 {
     std::unique_lock<std::mutex> lk(m_mutex);
     while(!m_Q.empty()) {
+        // the queue owns the requests
+        ThreadRequest* req = m_Q.front();
         m_Q.pop();
+        wxDELETE(req);
     }
 }
@@ -29,6 +29,7 @@
 #include "event_notifier.h"
 #include "gdb_parser_incl.h"
 #include "gdb_result_parser.h"
+#include "gdbmi.h"
 #include "gdbmi_parse_thread_info.h"
 #include "precompiled_header.h"
 #include "procutils.h"
@@ -148,6 +149,142 @@ wxString ExtractGdbChild(const std::map<std::string, std::string>& attr, const w
     return val;
 }
 
+static bool IsOctalDigit(char ch) { return ch >= '0' && ch <= '7'; }
+
+// Reproduce the GDB_STRING token of the flex lexer (ascii mode) for an MI c-string.
+// The handlers below (ExtractGdbChild, wxRemoveQuotes, wxGdbFixValue) expect their input in this form
+static std::string gdbmiLegacyString(const gdbmi::StringView& str)
+{
+    const char* p = str.data;
+    size_t len = str.length;
+
+    std::string res;
+    res.reserve(len + 2);
+    res.push_back('"');
+
+    size_t i = 0;
+    while(i < len) {
+        if(p[i] != '\\') {
+            res.push_back(p[i]);
+            ++i;
+            continue;
+        }
+
+        // [\\]{1,2}{octal_escape}: a byte, either escaped by gdb (\303) or inside a C literal in a value (\\303).
+        // Unlike the lexer, which always starts converting at the 3rd char, decode all 3 digits of a single
+        // backslash escape
+        size_t bs = (i + 1 < len && p[i + 1] == '\\') ? 2 : 1;
+        if(i + bs + 3 <= len && IsOctalDigit(p[i + bs]) && IsOctalDigit(p[i + bs + 1]) &&
+           IsOctalDigit(p[i + bs + 2])) {
+            unsigned int number = 0;
+            for(size_t n = i + bs; n < i + bs + 3; ++n) {
+                number = (number * 8) + (p[n] - '0');
+            }
+            if(number) { res.push_back((char)number); }
+            i += bs + 3;
+
+        } else if(i + 3 < len && p[i + 1] == '\\' && p[i + 2] == '\\' && p[i + 3] == '"') {
+            res += "\\\"";
+            i += 4;
+
+        } else if(i + 3 < len && p[i + 1] == '\\' && p[i + 2] == '\\' && p[i + 3] == '\\') {
+            res += "\\";
+            i += 4;
+
+        } else if(i + 2 < len && p[i + 1] == '\\' &&
+                  (p[i + 2] == 'n' || p[i + 2] == 'v' || p[i + 2] == 'r' || p[i + 2] == 't')) {
+            res.push_back('\\');
+            res.push_back(p[i + 2]);
+            i += 3;
+
+        } else if(i + 1 < len && p[i + 1] == '"') {
+            res += "\\\"";
+            i += 2;
+
+        } else if(i + 1 < len && p[i + 1] == '\\') {
+            res += "\\";
+            i += 2;
+
+        } else {
+            res.push_back('\\');
+            ++i;
+        }
+    }
+    res.push_back('"');
+    return res;
+}
+
+static void gdbmiAddChild(const gdbmi::Node& tuple, GdbChildrenInfo& info)
+{
+    GdbStringMap_t attr;
+    for(size_t i = 0; i < tuple.size(); ++i) {
+        const gdbmi::Node& member = tuple[i];
+        // nested values (new_children, thread-groups...) are not reported
+        if(!member.IsString()) { continue; }
+
+        std::string key = member.name.to_string();
+        std::string value = gdbmiLegacyString(member.value);
+        if(key == "has_more" || key == "dynamic") { info.has_more = (value == "\"1\""); }
+        attr[key] = value;
+    }
+    info.push_back(attr);
+}
+
+/**
+ * @brief parse the variable objects and locals replies into the structure produced by gdbParseListChildren()
+ * ^done,numchild="1",children=[child={name="var1.x",exp="x",numchild="0",value="1",type="int"}],has_more="0"
+ * ^done,locals=[{name="pcls",type="ChildClass *",value="0x0"}]
+ * ^done,locals={varobj={exp="str",value="{...}",name="var6",numchild="1",type="string"}}
+ * ^done,stack-args=[frame={level="0",args=[{name="argc",type="int",value="1"}]}]
+ * ^done,changelist=[{name="var2",in_scope="false",type_changed="false",has_more="0"}]
+ * ^done,name="var1",numchild="1",value="{...}",type="string"
+ */
+static void gdbmiParseChildren(const wxString& line, GdbChildrenInfo& info)
+{
+    info.clear();
+
+    gdbmi::Parser parser;
+    gdbmi::ParsedResult result;
+    parser.Parse(line, result);
+    if(result.line_type != gdbmi::LT_RESULT || result.line_type_context != "done") { return; }
+
+    const gdbmi::Node& tree = result.tree;
+    const gdbmi::Node* list = NULL;
+    const char* lists[] = { "children", "locals", "variables", "changelist" };
+    for(size_t i = 0; i < sizeof(lists) / sizeof(lists[0]) && !list; ++i) {
+        const gdbmi::Node& node = tree[lists[i]];
+        if(node.IsOk() && !node.IsString()) { list = &node; }
+    }
+
+    if(!list && tree["stack-args"].IsOk()) {
+        const gdbmi::Node& args = tree["stack-args"][(size_t)0]["args"];
+        if(args.IsOk()) { list = &args; }
+    }
+
+    if(list) {
+        for(size_t i = 0; i < list->size(); ++i) {
+            const gdbmi::Node& child = (*list)[i];
+            if(child.type == gdbmi::Node::kTuple) { gdbmiAddChild(child, info); }
+        }
+        const gdbmi::Node& hasMore = tree["has_more"];
+        if(hasMore.IsOk()) { info.has_more = (hasMore.value == "1"); }
+
+    } else if(tree["name"].IsOk() || tree["value"].IsOk()) {
+        gdbmiAddChild(tree, info);
+    }
+}
+
+static void gdbmiParseStackEntry(const gdbmi::Node& frame, StackEntry& entry)
+{
+    // keep the values as gdb printed them (escaped), like ParseStackEntry() does
+    entry.level = frame["level"].value.ToString();
+    entry.address = frame["addr"].value.ToString();
+    entry.function = frame["func"].value.ToString();
+    entry.line = frame["line"].value.ToString();
+    const gdbmi::Node& fullname = frame["fullname"];
+    entry.file = fullname.IsOk() ? fullname.value.ToString() : frame["file"].value.ToString();
+}
+
 // Keep a cache of all file paths converted from
 // Cygwin path into native path
 static std::map<wxString, wxString> g_fileCache;
@@ -591,7 +728,7 @@ bool DbgCmdHandlerLocals::ProcessOutput(const wxString& line)
     LocalVariables locals;
 
     GdbChildrenInfo info;
-    gdbParseListChildren(line.mb_str(wxConvUTF8).data(), info);
+    gdbmiParseChildren(line, info);
 
     for(size_t i = 0; i < info.children.size(); i++) {
         std::map<std::string, std::string> attr = info.children.at(i);
@@ -656,7 +793,7 @@ bool DbgCmdHandlerFuncArgs::ProcessOutput(const wxString& line)
     LocalVariables locals;
 
     GdbChildrenInfo info;
-    gdbParseListChildren(line.mb_str(wxConvUTF8).data(), info);
+    gdbmiParseChildren(line, info);
 
     for(size_t i = 0; i < info.children.size(); i++) {
         std::map<std::string, std::string> attr = info.children.at(i);
@@ -725,30 +862,18 @@ bool DbgCmdHandlerEvalExpr::ProcessOutput(const wxString& line)
 
 bool DbgCmdStackList::ProcessOutput(const wxString& line)
 {
-    wxString tmpLine(line);
-    line.StartsWith(wxT("^done,stack=["), &tmpLine);
+    // ^done,stack=[frame={level="0",addr="0x0040143f",func="main",file="a.cpp",fullname="/path/a.cpp",line="33"},...]
+    gdbmi::Parser parser;
+    gdbmi::ParsedResult result;
+    parser.Parse(line, result);
 
-    tmpLine = tmpLine.Trim();
-    tmpLine = tmpLine.Trim(false);
-
-    tmpLine.RemoveLast();
-    //--------------------------------------------------------
-    // tmpLine contains now string with the following format:
-    // frame={name="Value",...},frame={name="Value",...}
-    wxString remainder(tmpLine);
     StackEntryArray stackArray;
-    while(true) {
-        tmpLine = tmpLine.AfterFirst(wxT('{'));
-        if(tmpLine.IsEmpty()) { break; }
-
-        remainder = tmpLine.AfterFirst(wxT('}'));
-        tmpLine = tmpLine.BeforeFirst(wxT('}'));
-
+    const gdbmi::Node& stack = result["stack"];
+    stackArray.reserve(stack.size());
+    for(size_t i = 0; i < stack.size(); ++i) {
         StackEntry entry;
-        ParseStackEntry(tmpLine, entry);
+        gdbmiParseStackEntry(stack[i], entry);
         stackArray.push_back(entry);
-
-        tmpLine = remainder;
     }
 
     // Send it as an event
@@ -763,6 +888,7 @@ bool DbgCmdStackList::ProcessOutput(const wxString& line)
 bool DbgCmdSelectFrame::ProcessOutput(const wxString& line)
 {
     clCommandEvent evt(wxEVT_DEBUGGER_FRAME_SELECTED);
+    evt.SetInt(m_frame);
     EventNotifier::Get()->AddPendingEvent(evt);
     return true;
 }
@@ -1165,7 +1291,7 @@ bool DbgCmdCreateVarObj::ProcessOutput(const wxString& line)
     // Output sample:
     // ^done,name="var1",numchild="2",value="{...}",type="ChildClass",thread-id="1",has_more="0"
     GdbChildrenInfo info;
-    gdbParseListChildren(line.mb_str(wxConvUTF8).data(), info);
+    gdbmiParseChildren(line, info);
 
     if(info.children.empty() == false) {
         std::map<std::string, std::string> attr = info.children.at(0);
@@ -1259,8 +1385,6 @@ static VariableObjChild FromParserOutput(const std::map<std::string, std::string
             wxString v(iter->second.c_str(), wxConvUTF8);
             wxRemoveQuotes(v);
             child.value = wxGdbFixValue(v);
-
-            if(child.value.IsEmpty() == false) { child.varName << wxT(" = ") << child.value; }
         }
     }
     return child;
@@ -1269,19 +1393,19 @@ static VariableObjChild FromParserOutput(const std::map<std::string, std::string
 bool DbgCmdListChildren::ProcessOutput(const wxString& line)
 {
     DebuggerEventData e;
-    std::string cbuffer = line.mb_str(wxConvUTF8).data();
-
     GdbChildrenInfo info;
-    gdbParseListChildren(cbuffer, info);
+    gdbmiParseChildren(line, info);
 
     // Convert the parser output to codelite data structure
     for(size_t i = 0; i < info.children.size(); i++) {
         e.m_varObjChildren.push_back(FromParserOutput(info.children.at(i)));
     }
 
-    if(info.children.size() > 0) {
+    if(info.children.size() > 0 || m_paged) {
         e.m_updateReason = DBG_UR_LISTCHILDREN;
         e.m_expression = m_variable;
+        e.m_variableObject.gdbId = m_variable;
+        e.m_variableObject.has_more = info.has_more;
         e.m_userReason = m_userReason;
         m_observer->DebuggerUpdate(e);
 
@@ -1294,9 +1418,8 @@ bool DbgCmdListChildren::ProcessOutput(const wxString& line)
 
 bool DbgCmdEvalVarObj::ProcessOutput(const wxString& line)
 {
-    std::string cbuffer = line.mb_str(wxConvUTF8).data();
     GdbChildrenInfo info;
-    gdbParseListChildren(cbuffer, info);
+    gdbmiParseChildren(line, info);
 
     if(info.children.empty() == false) {
         wxString display_line = ExtractGdbChild(info.children.at(0), wxT("value"));
@@ -1369,9 +1492,8 @@ bool DbgVarObjUpdate::ProcessOutput(const wxString& line)
         return false; // let the default loop to handle this as well by passing DBG_CMD_ERR to the observer
     }
 
-    std::string cbuffer = line.mb_str(wxConvUTF8).data();
     GdbChildrenInfo info;
-    gdbParseListChildren(cbuffer, info);
+    gdbmiParseChildren(line, info);
 
     for(size_t i = 0; i < info.children.size(); i++) {
         wxString name = ExtractGdbChild(info.children.at(i), wxT("name"));
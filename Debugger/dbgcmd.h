@@ -278,9 +278,12 @@ public:
 // handler -list-stack-frames command
 class DbgCmdSelectFrame : public DbgCmdHandler
 {
+    int m_frame;
+
 public:
-    DbgCmdSelectFrame(IDebuggerObserver* observer)
+    DbgCmdSelectFrame(IDebuggerObserver* observer, int frame)
         : DbgCmdHandler(observer)
+        , m_frame(frame)
     {
     }
     virtual ~DbgCmdSelectFrame() {}
@@ -446,12 +449,14 @@ class DbgCmdListChildren : public DbgCmdHandler
 {
     wxString m_variable;
     int m_userReason;
+    bool m_paged; // a page of children was requested: the reply is reported even when the page is empty
 
 public:
-    DbgCmdListChildren(IDebuggerObserver* observer, const wxString& variable, int userReason)
+    DbgCmdListChildren(IDebuggerObserver* observer, const wxString& variable, int userReason, bool paged = false)
         : DbgCmdHandler(observer)
         , m_variable(variable)
         , m_userReason(userReason)
+        , m_paged(paged)
     {
     }
 
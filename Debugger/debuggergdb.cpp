@@ -345,7 +345,7 @@ void DbgGdb::DoCleanup()
     SetIsRemoteDebugging(false);
     SetIsRemoteExtended(false);
     EmptyQueue();
-    m_gdbOutputArr.Clear();
+    m_gdbOutputArr.clear();
     m_bpList.clear();
     m_debuggeeProjectName.Clear();
 
@@ -667,7 +667,7 @@ void DbgGdb::Poke()
 
     // poll the debugger output
     wxString curline;
-    if(!m_gdbProcess || m_gdbOutputArr.IsEmpty()) { return; }
+    if(!m_gdbProcess || m_gdbOutputArr.empty()) { return; }
 
     while(DoGetNextLine(curline)) {
 
@@ -891,7 +891,7 @@ bool DbgGdb::SetFrame(int frame)
 {
     wxString command;
     command << wxT("frame ") << frame;
-    return WriteCommand(command, new DbgCmdSelectFrame(m_observer));
+    return WriteCommand(command, new DbgCmdSelectFrame(m_observer, frame));
 }
 
 bool DbgGdb::ListThreads() { return WriteCommand(wxT("-thread-info"), new DbgCmdListThreads(m_observer)); }
@@ -1123,6 +1123,13 @@ bool DbgGdb::ListChildren(const wxString& name, int userReason)
     return WriteCommand(cmd, new DbgCmdListChildren(m_observer, name, userReason));
 }
 
+bool DbgGdb::ListChildren(const wxString& name, int userReason, int from, int count)
+{
+    wxString cmd;
+    cmd << "-var-list-children --simple-values " << name << " " << from << " " << (from + count);
+    return WriteCommand(cmd, new DbgCmdListChildren(m_observer, name, userReason, true));
+}
+
 bool DbgGdb::CreateVariableObject(const wxString& expression, bool persistent, int userReason)
 {
     wxString cmd;
@@ -1180,10 +1187,10 @@ void DbgGdb::OnDataRead(clProcessEvent& e)
 
         line.Replace(wxT("(gdb)"), wxT(""));
         line.Trim().Trim(false);
-        if(line.IsEmpty() == false) { m_gdbOutputArr.Add(line); }
+        if(line.IsEmpty() == false) { m_gdbOutputArr.push_back(line); }
     }
 
-    if(m_gdbOutputArr.IsEmpty() == false) {
+    if(m_gdbOutputArr.empty() == false) {
         // Trigger GDB processing
         Poke();
     }
@@ -1192,9 +1199,9 @@ void DbgGdb::OnDataRead(clProcessEvent& e)
 bool DbgGdb::DoGetNextLine(wxString& line)
 {
     line.Clear();
-    if(m_gdbOutputArr.IsEmpty()) { return false; }
-    line = m_gdbOutputArr.Item(0);
-    m_gdbOutputArr.RemoveAt(0);
+    if(m_gdbOutputArr.empty()) { return false; }
+    line.swap(m_gdbOutputArr.front());
+    m_gdbOutputArr.pop_front();
     line.Replace(wxT("(gdb)"), wxT(""));
     line.Trim().Trim(false);
     if(line.IsEmpty()) { return false; }
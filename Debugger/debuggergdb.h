@@ -32,6 +32,7 @@
 #include <wx/hashmap.h>
 #include "consolefinder.h"
 #include "cl_command_event.h"
+#include <deque>
 
 #ifdef MSVC_VER
 // declare the debugger function creation
@@ -63,7 +64,7 @@ class DbgGdb : public wxEvtHandler, public IDebugger
     std::vector<BreakpointInfo> m_bpList;
     DbgCmdCLIHandler* m_cliHandler;
     IProcess* m_gdbProcess;
-    wxArrayString m_gdbOutputArr;
+    std::deque<wxString> m_gdbOutputArr; // lines are consumed from the front, keep it O(1)
     wxString m_gdbOutputIncompleteLine;
     bool m_break_at_main;
     bool m_attachedMode;
@@ -150,6 +151,7 @@ public:
     virtual void SetDebuggerInformation(const DebuggerInformation& info);
     virtual void BreakList();
     virtual bool ListChildren(const wxString& name, int userReason);
+    virtual bool ListChildren(const wxString& name, int userReason, int from, int count);
     virtual bool CreateVariableObject(const wxString& expression, bool persistent, int userReason);
     virtual bool DeleteVariableObject(const wxString& name);
     virtual bool EvaluateVariableObject(const wxString& name, int userReason);
@@ -0,0 +1,259 @@
+#include "gdbmi.h"
+#include <string.h>
+
+// Protect the stack from malformed (or hostile) input
+#define MAX_NESTING_DEPTH 512
+
+namespace gdbmi
+{
+static const Node& GetNullNode()
+{
+    static Node nullNode;
+    return nullNode;
+}
+
+bool StringView::operator==(const char* str) const
+{
+    size_t len = strlen(str);
+    if(len != length) { return false; }
+    return len == 0 || memcmp(data, str, len) == 0;
+}
+
+const Node& Node::operator[](const char* name) const
+{
+    for(size_t i = 0; i < children.size(); ++i) {
+        if(children[i]->name == name) { return *children[i]; }
+    }
+    return GetNullNode();
+}
+
+const Node& Node::operator[](size_t index) const
+{
+    if(index >= children.size()) { return GetNullNode(); }
+    return *children[index];
+}
+
+bool Node::IsOk() const { return this != &GetNullNode(); }
+
+wxString Node::GetValue() const
+{
+    if(type != kString) { return wxEmptyString; }
+    return wxString::FromUTF8(Parser::Unescape(value).c_str());
+}
+
+bool Parser::Parse(const wxString& line, ParsedResult& result)
+{
+    result.buffer = line.mb_str(wxConvUTF8).data();
+    return DoParse(result);
+}
+
+bool Parser::Parse(const std::string& line, ParsedResult& result)
+{
+    result.buffer = line;
+    return DoParse(result);
+}
+
+bool Parser::DoParse(ParsedResult& result)
+{
+    result.line_type = LT_UNKNOWN;
+    result.txid = StringView();
+    result.line_type_context = StringView();
+    result.tree = Node();
+    result.tree.type = Node::kTuple;
+
+    m_pos = result.buffer.c_str();
+    m_end = m_pos + result.buffer.length();
+    m_depth = 0;
+
+    // [token]
+    const char* start = m_pos;
+    while(m_pos < m_end && *m_pos >= '0' && *m_pos <= '9') {
+        ++m_pos;
+    }
+    result.txid = StringView(start, m_pos - start);
+    if(m_pos == m_end) { return false; }
+
+    char ch = *m_pos++;
+    switch(ch) {
+    case LT_CONSOLE_STREAM:
+    case LT_TARGET_STREAM:
+    case LT_LOG_STREAM: {
+        result.line_type = (eLineType)ch;
+        Node::ptr_t stream(new Node());
+        result.tree.children.push_back(stream);
+        return ParseString(stream->value) && m_pos == m_end;
+    }
+    case LT_RESULT:
+    case LT_EXEC_ASYNC:
+    case LT_STATUS_ASYNC:
+    case LT_NOTIFY_ASYNC:
+        result.line_type = (eLineType)ch;
+        result.line_type_context = ReadUntil(",");
+        break;
+    default:
+        return false;
+    }
+
+    // ( "," result )*
+    while(m_pos < m_end) {
+        if(!Expect(',')) { return false; }
+        Node::ptr_t child(new Node());
+        result.tree.children.push_back(child);
+        if(!ParseResult(*child)) { return false; }
+    }
+    return true;
+}
+
+bool Parser::ParseResult(Node& node)
+{
+    node.name = ReadUntil("=");
+    if(node.name.empty() || !Expect('=')) { return false; }
+    return ParseValue(node);
+}
+
+bool Parser::ParseValue(Node& node)
+{
+    if(m_pos == m_end) { return false; }
+    switch(*m_pos) {
+    case '"':
+        node.type = Node::kString;
+        return ParseString(node.value);
+    case '{':
+    case '[': {
+        if(m_depth >= MAX_NESTING_DEPTH) { return false; }
+        ++m_depth;
+        bool res = (*m_pos == '{') ? ParseTuple(node) : ParseList(node);
+        --m_depth;
+        return res;
+    }
+    default:
+        return false;
+    }
+}
+
+bool Parser::ParseString(StringView& str)
+{
+    if(!Expect('"')) { return false; }
+    const char* start = m_pos;
+    while(m_pos < m_end) {
+        if(*m_pos == '\\') {
+            // skip the escaped char
+            m_pos = (m_end - m_pos) > 1 ? m_pos + 2 : m_end;
+        } else if(*m_pos == '"') {
+            str = StringView(start, m_pos - start);
+            ++m_pos;
+            return true;
+        } else {
+            ++m_pos;
+        }
+    }
+    return false;
+}
+
+bool Parser::ParseTuple(Node& node)
+{
+    // "{}" | "{" result ( "," result )* "}"
+    node.type = Node::kTuple;
+    if(!Expect('{')) { return false; }
+    if(Expect('}')) { return true; }
+    while(true) {
+        Node::ptr_t child(new Node());
+        node.children.push_back(child);
+        if(!ParseResult(*child)) { return false; }
+        if(Expect('}')) { return true; }
+        if(!Expect(',')) { return false; }
+    }
+}
+
+bool Parser::ParseList(Node& node)
+{
+    // "[]" | "[" value ( "," value )* "]" | "[" result ( "," result )* "]"
+    node.type = Node::kList;
+    if(!Expect('[')) { return false; }
+    if(Expect(']')) { return true; }
+    while(m_pos < m_end) {
+        Node::ptr_t child(new Node());
+        node.children.push_back(child);
+        char ch = *m_pos;
+        bool res = (ch == '"' || ch == '{' || ch == '[') ? ParseValue(*child) : ParseResult(*child);
+        if(!res) { return false; }
+        if(Expect(']')) { return true; }
+        if(!Expect(',')) { return false; }
+    }
+    return false;
+}
+
+StringView Parser::ReadUntil(const char* delims)
+{
+    const char* start = m_pos;
+    while(m_pos < m_end && strchr(delims, *m_pos) == nullptr) {
+        ++m_pos;
+    }
+    return StringView(start, m_pos - start);
+}
+
+bool Parser::Expect(char ch)
+{
+    if(m_pos < m_end && *m_pos == ch) {
+        ++m_pos;
+        return true;
+    }
+    return false;
+}
+
+std::string Parser::Unescape(const StringView& str)
+{
+    std::string res;
+    res.reserve(str.length);
+    for(size_t i = 0; i < str.length; ++i) {
+        char ch = str.data[i];
+        if(ch != '\\' || (i + 1) == str.length) {
+            res.push_back(ch);
+            continue;
+        }
+
+        ch = str.data[++i];
+        switch(ch) {
+        case 'n':
+            res.push_back('\n');
+            break;
+        case 't':
+            res.push_back('\t');
+            break;
+        case 'r':
+            res.push_back('\r');
+            break;
+        case 'v':
+            res.push_back('\v');
+            break;
+        case 'f':
+            res.push_back('\f');
+            break;
+        case 'a':
+            res.push_back('\a');
+            break;
+        case 'b':
+            res.push_back('\b');
+            break;
+        case 'e':
+            res.push_back('\033');
+            break;
+        default:
+            if(ch >= '0' && ch <= '7') {
+                // up to 3 octal digits
+                unsigned int number = ch - '0';
+                for(size_t n = 1; n < 3 && (i + 1) < str.length && str.data[i + 1] >= '0' && str.data[i + 1] <= '7';
+                    ++n) {
+                    number = (number * 8) + (str.data[++i] - '0');
+                }
+                res.push_back((char)number);
+            } else {
+                // \" \\ and unknown escapes
+                res.push_back(ch);
+            }
+            break;
+        }
+    }
+    return res;
+}
+} // namespace gdbmi
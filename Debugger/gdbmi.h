@@ -0,0 +1,145 @@
+#ifndef GDBMI_H
+#define GDBMI_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <wx/string.h>
+
+namespace gdbmi
+{
+/**
+ * @brief a non owning reference to a range of the parsed line
+ */
+struct StringView {
+    const char* data = nullptr;
+    size_t length = 0;
+
+    StringView() {}
+    StringView(const char* p, size_t len)
+        : data(p)
+        , length(len)
+    {
+    }
+
+    bool empty() const { return length == 0; }
+    bool operator==(const char* str) const;
+    bool operator!=(const char* str) const { return !(*this == str); }
+    std::string to_string() const { return std::string(data ? data : "", length); }
+    wxString ToString() const { return wxString::FromUTF8(data ? data : "", length); }
+};
+
+enum eLineType {
+    LT_RESULT = '^',
+    LT_EXEC_ASYNC = '*',
+    LT_STATUS_ASYNC = '+',
+    LT_NOTIFY_ASYNC = '=',
+    LT_CONSOLE_STREAM = '~',
+    LT_TARGET_STREAM = '@',
+    LT_LOG_STREAM = '&',
+    LT_UNKNOWN = 0,
+};
+
+/**
+ * @class Node
+ * @brief a single MI value: a c-string, a tuple ({...}) or a list ([...])
+ */
+class Node
+{
+public:
+    enum eType {
+        kString,
+        kTuple,
+        kList,
+    };
+    typedef std::shared_ptr<Node> ptr_t;
+
+    eType type = kString;
+    StringView name;  // the variable name, empty for list values
+    StringView value; // kString only: the text between the quotes, still escaped
+    std::vector<ptr_t> children;
+
+public:
+    /**
+     * @brief return the first child named 'name' or an empty node (see IsOk()) if there is no such child
+     */
+    const Node& operator[](const char* name) const;
+    /**
+     * @brief return the child at 'index' or an empty node (see IsOk())
+     */
+    const Node& operator[](size_t index) const;
+    size_t size() const { return children.size(); }
+    /**
+     * @brief false for the node returned by a failed lookup
+     */
+    bool IsOk() const;
+    bool IsString() const { return type == kString; }
+    /**
+     * @brief the unescaped value
+     */
+    wxString GetValue() const;
+};
+
+/**
+ * @class ParsedResult
+ * @brief the outcome of parsing a single line. All the nodes point into 'buffer'
+ * so this object can not be copied
+ */
+class ParsedResult
+{
+public:
+    eLineType line_type = LT_UNKNOWN;
+    StringView txid;              // the optional command token
+    StringView line_type_context; // the result/async class, e.g. "done", "error", "stopped"
+    Node tree; // kTuple with the results. For stream records: a single kString child
+    std::string buffer;
+
+public:
+    ParsedResult() {}
+    ParsedResult(const ParsedResult&) = delete;
+    ParsedResult& operator=(const ParsedResult&) = delete;
+
+    const Node& operator[](const char* name) const { return tree[name]; }
+};
+
+/**
+ * @class Parser
+ * @brief a re-entrant GDB/MI output parser. The line is copied once (as UTF-8) into the result and the tree
+ * references it instead of allocating a string per token. Unlike the flex/bison parser, it keeps no global state
+ * and can be used from multiple threads, each with its own Parser instance
+ */
+class Parser
+{
+    const char* m_pos = nullptr;
+    const char* m_end = nullptr;
+    size_t m_depth = 0;
+
+protected:
+    bool DoParse(ParsedResult& result);
+    bool ParseResult(Node& node);
+    bool ParseValue(Node& node);
+    bool ParseString(StringView& str);
+    bool ParseTuple(Node& node);
+    bool ParseList(Node& node);
+    StringView ReadUntil(const char* delims);
+    bool Expect(char ch);
+
+public:
+    Parser() {}
+    ~Parser() {}
+
+    /**
+     * @brief parse a line of MI output
+     * @return false if the line is not a well formed MI record. 'result' still holds whatever was parsed
+     */
+    bool Parse(const wxString& line, ParsedResult& result);
+    bool Parse(const std::string& line, ParsedResult& result);
+
+    /**
+     * @brief decode the C escapes of an MI c-string (\n, \t, \", \\, \ooo ...)
+     */
+    static std::string Unescape(const StringView& str);
+};
+} // namespace gdbmi
+
+#endif // GDBMI_H
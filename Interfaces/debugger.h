@@ -916,6 +916,13 @@ public:
      */
     virtual bool ListChildren(const wxString& name, int userReason) = 0;
 
+    /**
+     * @brief list a page of the children of a variable object: [from, from + count). Unlike the above, the reply
+     * carries the values of the simple (non aggregate) children and DebuggerEventData::m_variableObject.has_more is
+     * set when there are more children past the requested page. The reply is sent even when the page is empty
+     */
+    virtual bool ListChildren(const wxString& name, int userReason, int from, int count) = 0;
+
     /**
      * @brief create variable object from a given expression
      * @param expression the expression to create a variable object for
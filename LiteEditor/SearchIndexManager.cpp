@@ -0,0 +1,103 @@
+#include "SearchIndexManager.h"
+#include "clWorkspaceManager.h"
+#include "codelite_events.h"
+#include "event_notifier.h"
+#include "file_logger.h"
+#include "search_thread.h"
+#include "workspace.h"
+
+static SearchIndexManager* gs_searchIndexManager = nullptr;
+
+SearchIndexManager::SearchIndexManager()
+{
+    m_indexer = new clTrigramIndexer(&m_index);
+    m_indexer->Start(WXTHREAD_MIN_PRIORITY);
+    SearchThreadST::Get()->SetTrigramIndex(&m_index);
+
+    EventNotifier::Get()->Bind(wxEVT_WORKSPACE_LOADED, &SearchIndexManager::OnWorkspaceLoaded, this);
+    EventNotifier::Get()->Bind(wxEVT_WORKSPACE_CLOSED, &SearchIndexManager::OnWorkspaceClosed, this);
+    EventNotifier::Get()->Bind(wxEVT_WORKSPACE_RELOAD_ENDED, &SearchIndexManager::OnWorkspaceReloadEnded, this);
+    EventNotifier::Get()->Bind(wxEVT_FILE_SAVED, &SearchIndexManager::OnFileSaved, this);
+}
+
+SearchIndexManager::~SearchIndexManager()
+{
+    EventNotifier::Get()->Unbind(wxEVT_WORKSPACE_LOADED, &SearchIndexManager::OnWorkspaceLoaded, this);
+    EventNotifier::Get()->Unbind(wxEVT_WORKSPACE_CLOSED, &SearchIndexManager::OnWorkspaceClosed, this);
+    EventNotifier::Get()->Unbind(wxEVT_WORKSPACE_RELOAD_ENDED, &SearchIndexManager::OnWorkspaceReloadEnded, this);
+    EventNotifier::Get()->Unbind(wxEVT_FILE_SAVED, &SearchIndexManager::OnFileSaved, this);
+
+    SearchThreadST::Get()->SetTrigramIndex(nullptr);
+    m_indexer->ClearQueue();
+    m_indexer->Stop();
+    wxDELETE(m_indexer);
+    m_index.Save();
+}
+
+SearchIndexManager* SearchIndexManager::Get()
+{
+    if(!gs_searchIndexManager) { gs_searchIndexManager = new SearchIndexManager(); }
+    return gs_searchIndexManager;
+}
+
+void SearchIndexManager::Free() { wxDELETE(gs_searchIndexManager); }
+
+wxFileName SearchIndexManager::GetIndexFileName() const
+{
+    // Keep the index next to the tags database
+    wxFileName fn;
+    if(clCxxWorkspaceST::Get()->IsOpen()) {
+        fn = clCxxWorkspaceST::Get()->GetTagsFileName();
+    } else if(clWorkspaceManager::Get().IsWorkspaceOpened()) {
+        fn = clWorkspaceManager::Get().GetWorkspace()->GetFileName();
+        fn.AppendDir(".codelite");
+    } else {
+        return wxFileName();
+    }
+    fn.SetExt("trigrams");
+    if(!fn.DirExists()) { fn.Mkdir(wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL); }
+    return fn;
+}
+
+void SearchIndexManager::DoSync()
+{
+    wxFileName indexFile = GetIndexFileName();
+    if(!indexFile.IsOk()) { return; }
+
+    wxArrayString files;
+    clWorkspaceManager::Get().GetWorkspace()->GetWorkspaceFiles(files);
+    clDEBUG() << "Synchronising the search index:" << indexFile << "(" << files.size() << "files)" << clEndl;
+    m_indexer->ClearQueue();
+    m_indexer->Sync(indexFile, files);
+}
+
+void SearchIndexManager::OnWorkspaceLoaded(wxCommandEvent& event)
+{
+    event.Skip();
+    DoSync();
+}
+
+void SearchIndexManager::OnWorkspaceReloadEnded(clCommandEvent& event)
+{
+    event.Skip();
+    DoSync();
+}
+
+void SearchIndexManager::OnWorkspaceClosed(wxCommandEvent& event)
+{
+    event.Skip();
+    m_indexer->ClearQueue();
+    // Flush and unload the index. A Sync() of the next workspace will load its own index
+    m_index.Save();
+    m_index.Clear();
+}
+
+void SearchIndexManager::OnFileSaved(clCommandEvent& event)
+{
+    event.Skip();
+    if(!clWorkspaceManager::Get().IsWorkspaceOpened()) { return; }
+
+    wxArrayString files;
+    files.Add(event.GetFileName());
+    m_indexer->Update(files);
+}
@@ -0,0 +1,38 @@
+#ifndef SEARCHINDEXMANAGER_H
+#define SEARCHINDEXMANAGER_H
+
+#include "clTrigramIndex.h"
+#include "cl_command_event.h"
+#include <wx/event.h>
+#include <wx/filename.h>
+
+/**
+ * @class SearchIndexManager
+ * @brief keeps the "Find In Files" trigram index of the current workspace up to date. The index is stored next to the
+ * workspace tags database
+ */
+class SearchIndexManager : public wxEvtHandler
+{
+    clTrigramIndex m_index;
+    clTrigramIndexer* m_indexer = nullptr;
+
+protected:
+    void OnWorkspaceLoaded(wxCommandEvent& event);
+    void OnWorkspaceClosed(wxCommandEvent& event);
+    void OnWorkspaceReloadEnded(clCommandEvent& event);
+    void OnFileSaved(clCommandEvent& event);
+
+    void DoSync();
+    wxFileName GetIndexFileName() const;
+
+public:
+    SearchIndexManager();
+    virtual ~SearchIndexManager();
+
+    static SearchIndexManager* Get();
+    static void Free();
+
+    clTrigramIndex::Stats GetStats() const { return m_index.GetStats(); }
+};
+
+#endif // SEARCHINDEXMANAGER_H
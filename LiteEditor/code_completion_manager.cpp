@@ -23,6 +23,7 @@
 //////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////
 
+#include "CxxPreProcessorHeaderCache.h"
 #include "ServiceProviderManager.h"
 #include "bitmap_loader.h"
 #include "cl_editor.h"
@@ -533,6 +534,7 @@ void CodeCompletionManager::OnWorkspaceClosed(wxCommandEvent& event)
 {
     event.Skip();
     LanguageST::Get()->ClearAdditionalScopesCache();
+    CxxPreProcessorHeaderCache::Get().Clear();
 }
 
 void CodeCompletionManager::OnEnvironmentVariablesModified(clCommandEvent& event)
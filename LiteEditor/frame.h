@@ -393,6 +393,11 @@ public:
     clToolBar* GetMainToolBar() const { return m_toolbar; }
     void ShowBuildMenu(clToolBar* toolbar, wxWindowID buttonID);
 
+    /**
+     * @brief called by the build tab once the build output has been processed, so the build result is known
+     */
+    void BuildEnded();
+
 protected:
     //----------------------------------------------------
     // event handlers
@@ -403,7 +408,6 @@ protected:
 
     void OnRestoreDefaultLayout(wxCommandEvent& e);
     void OnIdle(wxIdleEvent& e);
-    void OnBuildEnded(clCommandEvent& event);
     void OnQuit(wxCommandEvent& WXUNUSED(event));
     void OnClose(wxCloseEvent& event);
     void OnCustomiseToolbar(wxCommandEvent& event);
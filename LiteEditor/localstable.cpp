@@ -23,6 +23,7 @@
 //////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////
 
+#include "codelite_events.h"
 #include "debuggerconfigtool.h"
 #include "debuggermanager.h"
 #include "drawingutils.h"
@@ -48,6 +49,8 @@ LocalsTable::LocalsTable(wxWindow* parent)
     : DebuggerTreeListCtrlBase(parent, wxID_ANY, false)
     , m_arrayAsCharPtr(false)
     , m_sortAsc(true)
+    , m_localsQueried(false)
+    , m_frame(0)
 {
     m_listTable->AddRoot(_("Locals"));
     m_listTable->AddHeader(_("Name"));
@@ -64,11 +67,27 @@ LocalsTable::LocalsTable(wxWindow* parent)
 
     EventNotifier::Get()->Connect(wxEVT_DEBUGGER_FRAME_SELECTED, clCommandEventHandler(LocalsTable::OnStackSelected),
                                   NULL, this);
+    EventNotifier::Get()->Connect(wxEVT_DEBUG_EDITOR_GOT_CONTROL,
+                                  wxCommandEventHandler(LocalsTable::OnDebuggerControlChanged), NULL, this);
+    EventNotifier::Get()->Connect(wxEVT_DEBUG_EDITOR_LOST_CONTROL,
+                                  wxCommandEventHandler(LocalsTable::OnDebuggerControlChanged), NULL, this);
 }
 
-LocalsTable::~LocalsTable() {}
+LocalsTable::~LocalsTable()
+{
+    EventNotifier::Get()->Disconnect(wxEVT_DEBUGGER_FRAME_SELECTED,
+                                     clCommandEventHandler(LocalsTable::OnStackSelected), NULL, this);
+    EventNotifier::Get()->Disconnect(wxEVT_DEBUG_EDITOR_GOT_CONTROL,
+                                     wxCommandEventHandler(LocalsTable::OnDebuggerControlChanged), NULL, this);
+    EventNotifier::Get()->Disconnect(wxEVT_DEBUG_EDITOR_LOST_CONTROL,
+                                     wxCommandEventHandler(LocalsTable::OnDebuggerControlChanged), NULL, this);
+}
 
-void LocalsTable::UpdateLocals(const LocalVariables& locals) { DoUpdateLocals(locals, DbgTreeItemData::Locals); }
+void LocalsTable::UpdateLocals(const LocalVariables& locals)
+{
+    m_frameLocals[m_frame] = locals;
+    DoUpdateLocals(locals, DbgTreeItemData::Locals);
+}
 
 void LocalsTable::UpdateFuncArgs(const LocalVariables& args) { DoUpdateLocals(args, DbgTreeItemData::FuncArgs); }
 
@@ -89,6 +108,49 @@ void LocalsTable::Initialize()
 
     m_preDefTypes = data.GetActiveSet();
     m_curStackInfo.Clear();
+    m_localsQueried = false;
+    m_frame = 0;
+    m_frameLocals.clear();
+}
+
+void LocalsTable::QueryLocals()
+{
+    // the values can only change while the debuggee is running: a new request is only needed once per stop
+    IDebugger* dbgr = DebuggerMgr::Get().GetActiveDebugger();
+    if(!dbgr || m_localsQueried) { return; }
+    m_localsQueried = true;
+
+    std::map<int, LocalVariables>::iterator iter = m_frameLocals.find(m_frame);
+    if(iter != m_frameLocals.end()) {
+        // this frame was already visited during this stop
+        DoUpdateLocals(iter->second, DbgTreeItemData::Locals);
+        return;
+    }
+    dbgr->QueryLocals();
+}
+
+void LocalsTable::ThreadSelected()
+{
+    Clear();
+    // gdb selects the innermost frame of the new thread
+    m_frame = 0;
+    m_frameLocals.clear();
+}
+
+void LocalsTable::Clear()
+{
+    DebuggerTreeListCtrlBase::Clear();
+    m_localsQueried = false;
+}
+
+void LocalsTable::OnDebuggerControlChanged(wxCommandEvent& event)
+{
+    event.Skip();
+    // a new stop (gdb selects the innermost frame) or the debuggee is running: the cached values are stale.
+    // Expanded variable objects are kept and refreshed with -var-update, which only reports what changed
+    m_localsQueried = false;
+    m_frame = 0;
+    m_frameLocals.clear();
 }
 
 void LocalsTable::OnCreateVariableObj(const DebuggerEventData& event)
@@ -113,8 +175,7 @@ void LocalsTable::OnCreateVariableObj(const DebuggerEventData& event)
             if(dbgr) DoRefreshItem(dbgr, iter->second, false);
 
             dbgr->UpdateVariableObject(data->_gdbId, m_DBG_USERR);
-            dbgr->ListChildren(data->_gdbId, m_LIST_CHILDS);
-            m_listChildItemId[data->_gdbId] = iter->second;
+            DoListChildren(dbgr, data->_gdbId, iter->second, 0);
         }
         m_createVarItemId.erase(iter);
     }
@@ -122,12 +183,9 @@ void LocalsTable::OnCreateVariableObj(const DebuggerEventData& event)
 
 void LocalsTable::OnListChildren(const DebuggerEventData& event)
 {
-    wxString gdbId = event.m_expression;
-    std::map<wxString, wxTreeItemId>::iterator iter = m_listChildItemId.find(gdbId);
-    if(iter == m_listChildItemId.end()) return;
-
-    wxTreeItemId item = iter->second;
-    m_listChildItemId.erase(iter);
+    int from = 0;
+    wxTreeItemId item = DoBeginListChildren(event.m_expression, from);
+    if(!item.IsOk()) return;
 
     if(event.m_userReason == m_LIST_CHILDS) {
         if(event.m_varObjChildren.empty() == false) {
@@ -140,8 +198,7 @@ void LocalsTable::OnListChildren(const DebuggerEventData& event)
                 if(ch.varName == wxT("public") || ch.varName == wxT("private") || ch.varName == wxT("protected")) {
                     // not really a node...
                     // ask for information about this node children
-                    dbgr->ListChildren(ch.gdbId, m_LIST_CHILDS);
-                    m_listChildItemId[ch.gdbId] = item;
+                    DoListChildren(dbgr, ch.gdbId, item, 0);
 
                 } else {
 
@@ -155,12 +212,19 @@ void LocalsTable::OnListChildren(const DebuggerEventData& event)
                     // Add a dummy node
                     if(child.IsOk() && ch.numChilds > 0) { m_listTable->AppendItem(child, wxT("<dummy>")); }
 
-                    // refresh this item only
-                    dbgr->EvaluateVariableObject(data->_gdbId, m_DBG_USERR);
-                    // ask the value for this node
-                    m_gdbIdToTreeId[data->_gdbId] = child;
+                    if(ch.value.IsEmpty() == false) {
+                        // gdb already sent the value of this node
+                        m_listTable->SetItemText(child, ch.value, 1);
+
+                    } else {
+                        // refresh this item only
+                        dbgr->EvaluateVariableObject(data->_gdbId, m_DBG_USERR);
+                        // ask the value for this node
+                        m_gdbIdToTreeId[data->_gdbId] = child;
+                    }
                 }
             }
+            DoEndListChildren(event, item, from);
         }
     }
 }
@@ -200,6 +264,12 @@ void LocalsTable::OnItemExpanding(wxTreeEvent& event)
         return;
     }
 
+    if(DoLoadMoreChildren(dbgr, event.GetItem())) {
+        // "Load more...": the next page is added to the parent item
+        event.Veto();
+        return;
+    }
+
     size_t childCount = m_listTable->GetChildrenCount(event.GetItem());
     if(childCount > 1) {
         // make sure there is no <dummy> node and continue
@@ -222,8 +292,7 @@ void LocalsTable::OnItemExpanding(wxTreeEvent& event)
         wxString gdbId = DoGetGdbId(event.GetItem());
         if(gdbId.IsEmpty() == false) {
             dbgr->UpdateVariableObject(gdbId, m_DBG_USERR);
-            dbgr->ListChildren(gdbId, m_LIST_CHILDS);
-            m_listChildItemId[gdbId] = event.GetItem();
+            DoListChildren(dbgr, gdbId, event.GetItem(), 0);
 
         } else {
             // first time
@@ -361,7 +430,8 @@ void LocalsTable::OnRefresh(wxCommandEvent& event)
     IDebugger* dbgr = DoGetDebugger();
     if(dbgr) {
         Clear();
-        dbgr->QueryLocals();
+        m_frameLocals.erase(m_frame);
+        QueryLocals();
     }
 }
 
@@ -390,6 +460,8 @@ void LocalsTable::OnEditValue(wxCommandEvent& event)
 
         // refresh the item
         DbgTreeItemData* data = (DbgTreeItemData*)m_listTable->GetItemData(selectedItem);
+        // the assignment may have changed values of any frame
+        m_frameLocals.clear();
         if(data && data->_gdbId.IsEmpty()) {
             m_listTable->Delete(selectedItem);
             debugger->QueryLocals();
@@ -448,9 +520,10 @@ void LocalsTable::OnStackSelected(clCommandEvent& event)
 {
     event.Skip();
     Clear();
+    m_frame = event.GetInt();
     IDebugger* dbgr = DebuggerMgr::Get().GetActiveDebugger();
     if(dbgr && dbgr->IsRunning() && ManagerST::Get()->IsDebuggerViewVisible(DebuggerPane::LOCALS)) {
-        dbgr->QueryLocals();
+        QueryLocals();
     }
 }
 
@@ -44,6 +44,9 @@ protected:
     bool m_arrayAsCharPtr;
     bool m_sortAsc;
     bool m_defaultHexDisplay;
+    bool m_localsQueried; // the locals of the selected frame were already requested for the current stop
+    int m_frame;          // the frame selected during the current stop
+    std::map<int, LocalVariables> m_frameLocals; // frame -> locals, for the frames visited during the current stop
 
 protected:
     void DoClearNonVariableObjectEntries(wxArrayString& itemsNotRemoved, size_t flags,
@@ -58,6 +61,7 @@ protected:
     void OnEditValue(wxCommandEvent& event);
     void OnEditValueUI(wxUpdateUIEvent& event);
     void OnStackSelected(clCommandEvent& event);
+    void OnDebuggerControlChanged(wxCommandEvent& event);
     void OnSortItems(wxCommandEvent& event);
     void SetSortingFunction();
 
@@ -81,6 +85,16 @@ public:
     void OnVariableObjUpdate(const DebuggerEventData& event);
 
     void UpdateLocals(const LocalVariables& locals);
+    /**
+     * @brief ask the debugger for the locals of the selected frame, unless they were already requested since the
+     * debuggee last stopped. A frame that was already visited during this stop is restored from the cache
+     */
+    void QueryLocals();
+    /**
+     * @brief another thread was selected: its frames have nothing in common with the cached ones
+     */
+    void ThreadSelected();
+    virtual void Clear();
     void UpdateFrameInfo();
 
     void UpdateFuncArgs(const LocalVariables& args);
@@ -100,6 +100,7 @@
 #include "processreaderthread.h"
 #include "reconcileproject.h"
 #include "refactorengine.h"
+#include "SearchIndexManager.h"
 #include "search_thread.h"
 #include "sessionmanager.h"
 #include "simpletable.h"
@@ -262,7 +263,9 @@ Manager::~Manager(void)
         // wxLogNull noLog;
         JobQueueSingleton::Instance()->Stop();
         ParseThreadST::Get()->Stop();
+        // Stop the search thread first, a search in progress may still be using the index
         SearchThreadST::Get()->Stop();
+        SearchIndexManager::Free();
     }
 
     // free all plugins
@@ -1918,7 +1921,7 @@ void Manager::DoUpdateDebuggerTabControl(wxWindow* curpage)
 
         if(curpage == (wxWindow*)pane->GetLocalsTable() || IsPaneVisible(wxGetTranslation(DebuggerPane::LOCALS))) {
             // update the locals tree
-            dbgr->QueryLocals();
+            pane->GetLocalsTable()->QueryLocals();
         }
 
         if(curpage == (wxWindow*)pane->GetDisassemblyTab() ||
@@ -2493,6 +2496,7 @@ void Manager::DbgSetThread(long threadId)
     if(dbgr && dbgr->IsRunning() && DbgCanInteract()) {
         // set the frame
         dbgr->SelectThread(threadId);
+        clMainFrame::Get()->GetDebuggerPane()->GetLocalsTable()->ThreadSelected();
         dbgr->QueryFileLine();
     }
 }
@@ -104,6 +104,9 @@ NewBuildTab::NewBuildTab(wxWindow* parent)
     , m_maxlineWidth(wxNOT_FOUND)
     , m_lastLineColoured(wxNOT_FOUND)
 {
+    m_classifier = new BuildOutputClassifier(this);
+    m_classifier->Start();
+
     SetSize(wxNOT_FOUND, 400);
     m_curError = m_errorsAndWarningsList.end();
     wxBoxSizer* bs = new wxBoxSizer(wxVERTICAL);
@@ -144,6 +147,9 @@ NewBuildTab::NewBuildTab(wxWindow* parent)
 
 NewBuildTab::~NewBuildTab()
 {
+    m_classifier->Stop();
+    wxDELETE(m_classifier);
+
     EventNotifier::Get()->Unbind(wxEVT_CL_THEME_CHANGED, &NewBuildTab::OnThemeChanged, this);
     EventNotifier::Get()->Disconnect(wxEVT_SHELL_COMMAND_STARTED, clCommandEventHandler(NewBuildTab::OnBuildStarted),
                                      NULL, this);
@@ -165,7 +171,14 @@ void NewBuildTab::OnBuildEnded(clCommandEvent& e)
     CL_DEBUG("Build Ended!");
     m_buildInProgress = false;
 
-    DoProcessOutput(true, false);
+    // The build is completed in OnBuildOutputFlushed(), once the remaining output has been classified
+    m_classifier->Flush();
+}
+
+void NewBuildTab::OnBuildOutputFlushed()
+{
+    std::vector<BuildOutputLine> lines;
+    if(m_classifier->TakeLines(lines)) { DoAppendLines(lines); }
 
     std::vector<clEditor*> editors;
     clMainFrame::Get()->GetMainBook()->GetAllEditors(editors, MainBook::kGetAll_Default);
@@ -185,14 +198,12 @@ void NewBuildTab::OnBuildEnded(clCommandEvent& e)
         term << wxString::Format(wxT(", %s: %02ld:%02ld:%02ld %s"), _("total time"), hours, minutes, sec, _("seconds"));
     }
 
-    m_output = term;
-    DoProcessOutput(true, true);
+    DoAppendText("====" + term + "====");
 
     if(m_buildInterrupted) {
         wxString InterruptedMsg;
         InterruptedMsg << _("(Build Cancelled)") << wxT("\n\n");
-        m_output = InterruptedMsg;
-        DoProcessOutput(true, false);
+        DoAppendText(InterruptedMsg);
     }
 
     // Hide / Show the build tab according to the settings
@@ -222,6 +233,9 @@ void NewBuildTab::OnBuildEnded(clCommandEvent& e)
     buildEvent.SetErrorCount(m_errorCount);
     buildEvent.SetWarningCount(m_warnCount);
     EventNotifier::Get()->AddPendingEvent(buildEvent);
+
+    // 'Build and Run' and the queued commands need the build result
+    clMainFrame::Get()->BuildEnded();
 }
 
 void NewBuildTab::OnBuildStarted(clCommandEvent& e)
@@ -249,10 +263,7 @@ void NewBuildTab::OnBuildStarted(clCommandEvent& e)
     m_showMe = (BuildTabSettingsData::ShowBuildPane)m_buildTabSettings.GetShowBuildPane();
     m_skipWarnings = m_buildTabSettings.GetSkipWarnings();
 
-    if(e.GetEventType() != wxEVT_SHELL_COMMAND_STARTED_NOCLEAN) {
-        DoClear();
-        DoCacheRegexes();
-    }
+    if(e.GetEventType() != wxEVT_SHELL_COMMAND_STARTED_NOCLEAN) { DoClear(); }
 
     // Show the tab if needed
     OutputPane* opane = clMainFrame::Get()->GetOutputPane();
@@ -287,83 +298,15 @@ void NewBuildTab::OnBuildStarted(clCommandEvent& e)
         const wxString& cmpname = clFileSystemWorkspace::Get().GetSettings().GetSelectedConfig()->GetCompiler();
         m_cmp = BuildSettingsConfigST::Get()->GetCompiler(cmpname);
     }
+
+    // The output that follows is classified using this compiler's patterns
+    m_classifier->Reset(m_cmp, m_cygwinRoot);
 }
 
 void NewBuildTab::OnBuildAddLine(clCommandEvent& e)
 {
     e.Skip(); // Always call skip..
-    m_output << e.GetString();
-    DoProcessOutput(false, false);
-}
-
-BuildLineInfo* NewBuildTab::DoProcessLine(const wxString& line)
-{
-    BuildLineInfo* buildLineInfo = new BuildLineInfo();
-    LINE_SEVERITY severity;
-    // Get the matching regex for this line
-    CmpPatternPtr cmpPatterPtr = GetMatchingRegex(line, severity);
-    buildLineInfo->SetSeverity(severity);
-    BuildLineInfo bli;
-    if(cmpPatterPtr && cmpPatterPtr->Matches(line, bli)) {
-        buildLineInfo->SetFilename(bli.GetFilename());
-        buildLineInfo->SetSeverity(bli.GetSeverity());
-        buildLineInfo->SetLineNumber(bli.GetLineNumber());
-        buildLineInfo->NormalizeFilename(m_directories, m_cygwinRoot);
-        buildLineInfo->SetRegexLineMatch(bli.GetRegexLineMatch());
-        buildLineInfo->SetColumn(bli.GetColumn());
-        if(severity == SV_WARNING) {
-            // Warning
-            m_errorsAndWarningsList.push_back(buildLineInfo);
-            m_warnCount++;
-        } else {
-            // Error
-            m_errorsAndWarningsList.push_back(buildLineInfo);
-            m_errorsList.push_back(buildLineInfo);
-            m_errorCount++;
-        }
-    }
-    return buildLineInfo;
-}
-
-void NewBuildTab::DoCacheRegexes()
-{
-    m_cmpPatterns.clear();
-
-    // Loop over all known compilers and cache the regular expressions
-    BuildSettingsConfigCookie cookie;
-    CompilerPtr cmp = BuildSettingsConfigST::Get()->GetFirstCompiler(cookie);
-    while(cmp) {
-        CmpPatterns cmpPatterns;
-        const Compiler::CmpListInfoPattern& errPatterns = cmp->GetErrPatterns();
-        const Compiler::CmpListInfoPattern& warnPatterns = cmp->GetWarnPatterns();
-        Compiler::CmpListInfoPattern::const_iterator iter;
-        for(iter = errPatterns.begin(); iter != errPatterns.end(); iter++) {
-
-            CmpPatternPtr compiledPatternPtr(new CmpPattern(new wxRegEx(iter->pattern, wxRE_ADVANCED | wxRE_ICASE),
-                                                            iter->fileNameIndex, iter->lineNumberIndex,
-                                                            iter->columnIndex, SV_ERROR));
-            if(compiledPatternPtr->GetRegex()->IsValid()) { cmpPatterns.errorsPatterns.push_back(compiledPatternPtr); }
-        }
-
-        for(iter = warnPatterns.begin(); iter != warnPatterns.end(); iter++) {
-
-            CmpPatternPtr compiledPatternPtr(new CmpPattern(new wxRegEx(iter->pattern, wxRE_ADVANCED | wxRE_ICASE),
-                                                            iter->fileNameIndex, iter->lineNumberIndex,
-                                                            iter->columnIndex, SV_WARNING));
-            if(compiledPatternPtr->GetRegex()->IsValid()) { cmpPatterns.warningPatterns.push_back(compiledPatternPtr); }
-        }
-
-        m_cmpPatterns.insert(std::make_pair(cmp->GetName(), cmpPatterns));
-        cmp = BuildSettingsConfigST::Get()->GetNextCompiler(cookie);
-    }
-}
-
-bool NewBuildTab::DoGetCompilerPatterns(const wxString& compilerName, CmpPatterns& patterns)
-{
-    MapCmpPatterns_t::iterator iter = m_cmpPatterns.find(compilerName);
-    if(iter == m_cmpPatterns.end()) { return false; }
-    patterns = iter->second;
-    return true;
+    m_classifier->AddOutput(e.GetString());
 }
 
 void NewBuildTab::DoClear()
@@ -372,13 +315,12 @@ void NewBuildTab::DoClear()
     m_lastLineColoured = wxNOT_FOUND;
     m_maxlineWidth = wxNOT_FOUND;
     m_buildInterrupted = false;
-    m_directories.Clear();
     m_buildInfoPerFile.clear();
     m_warnCount = 0;
     m_errorCount = 0;
     m_errorsAndWarningsList.clear();
     m_errorsList.clear();
-    m_cmpPatterns.clear();
+    m_classifier->Clear();
 
     // Delete all the user data
     std::for_each(m_viewData.begin(), m_viewData.end(), [&](std::pair<int, BuildLineInfo*> p) { delete p.second; });
@@ -481,25 +423,6 @@ void NewBuildTab::MarkEditor(clEditor* editor)
     editor->Refresh();
 }
 
-void NewBuildTab::DoSearchForDirectory(const wxString& line)
-{
-    // Check for makefile directory changes lines
-    if(line.Contains(wxT("Entering directory `"))) {
-        wxString currentDir = line.AfterFirst(wxT('`'));
-        currentDir = currentDir.BeforeLast(wxT('\''));
-
-        // Collect the m_baseDir
-        m_directories.Add(currentDir);
-
-    } else if(line.Contains(wxT("Entering directory '"))) {
-        wxString currentDir = line.AfterFirst(wxT('\''));
-        currentDir = currentDir.BeforeLast(wxT('\''));
-
-        // Collect the m_baseDir
-        m_directories.Add(currentDir);
-    }
-}
-
 void NewBuildTab::OnWorkspaceClosed(wxCommandEvent& e)
 {
     e.Skip();
@@ -514,72 +437,73 @@ void NewBuildTab::OnWorkspaceLoaded(wxCommandEvent& e)
     InitView();
 }
 
-void NewBuildTab::DoProcessOutput(bool compilationEnded, bool isSummaryLine)
+void NewBuildTab::DoAppendLines(const std::vector<BuildOutputLine>& lines)
 {
-    wxUnusedVar(isSummaryLine);
-    if(!compilationEnded && m_output.Find(wxT("\n")) == wxNOT_FOUND) {
-        // still dont have a complete line
-        return;
-    }
-
-    wxArrayString lines = ::wxStringTokenize(m_output, wxT("\n"), wxTOKEN_RET_DELIMS);
-    m_output.Clear();
+    if(lines.empty()) { return; }
 
-    // Process only completed lines (i.e. a line that ends with '\n')
-    for(size_t i = 0; i < lines.GetCount(); ++i) {
-        if(!compilationEnded && !lines.Item(i).EndsWith(wxT("\n"))) {
-            m_output << lines.Item(i);
-            return;
+    wxString text;
+    size_t longestLine = 0;
+    int firstLine = m_view->GetLineCount() - 1; // -1 because the view always has 1 extra "\n"
+    for(size_t i = 0; i < lines.size(); ++i) {
+        BuildLineInfo* buildLineInfo = lines[i].info;
+        if(buildLineInfo->GetSeverity() == SV_WARNING) {
+            m_errorsAndWarningsList.push_back(buildLineInfo);
+            m_warnCount++;
+        } else if(buildLineInfo->GetSeverity() == SV_ERROR) {
+            m_errorsAndWarningsList.push_back(buildLineInfo);
+            m_errorsList.push_back(buildLineInfo);
+            m_errorCount++;
         }
 
-        wxString buildLine = lines.Item(i); //.Trim().Trim(false);
-        // If this is a line similar to 'Entering directory `'
-        // add the path in the directories array
-        DoSearchForDirectory(buildLine);
-        BuildLineInfo* buildLineInfo = DoProcessLine(buildLine);
-
         // keep the line info
         if(buildLineInfo->GetFilename().IsEmpty() == false) {
             m_buildInfoPerFile.insert(std::make_pair(buildLineInfo->GetFilename(), buildLineInfo));
         }
 
-        if(isSummaryLine) {
-            buildLine.Trim();
-            buildLine.Prepend("====");
-            buildLine.Append("====");
-            buildLineInfo->SetSeverity(SV_NONE);
-        }
-
         // Keep the line number in the build tab
-        buildLineInfo->SetLineInBuildTab(m_view->GetLineCount() - 1); // -1 because the view always has 1 extra "\n"
+        buildLineInfo->SetLineInBuildTab(firstLine + (int)i);
         // Store the line info *before* we add the text
         // it is needed in the OnStyle function
         m_viewData.insert(std::make_pair(buildLineInfo->GetLineInBuildTab(), buildLineInfo));
 
-        m_view->SetEditable(true);
-        buildLine.Trim();
-        wxString modText;
-        ::clStripTerminalColouring(buildLine, modText);
+        if(lines[i].text.length() > lines[longestLine].text.length()) { longestLine = i; }
+        text << lines[i].text << "\n";
+    }
 
-        int curline = m_view->GetLineCount() - 1;
-        m_view->AppendText(modText + "\n");
+    m_view->SetEditable(true);
+    m_view->AppendText(text);
 
-        // get the newly added line width
-        int endPosition = m_view->GetLineEndPosition(curline); // get character position from begin
-        int beginPosition = m_view->PositionFromLine(curline); // and end of line
+    // get the width of the longest line added
+    int curline = firstLine + (int)longestLine;
+    int endPosition = m_view->GetLineEndPosition(curline); // get character position from begin
+    int beginPosition = m_view->PositionFromLine(curline); // and end of line
 
-        wxPoint beginPos = m_view->PointFromPosition(beginPosition);
-        wxPoint endPos = m_view->PointFromPosition(endPosition);
+    wxPoint beginPos = m_view->PointFromPosition(beginPosition);
+    wxPoint endPos = m_view->PointFromPosition(endPosition);
 
-        int curLen = (endPos.x - beginPos.x) + 10;
-        m_maxlineWidth = wxMax(m_maxlineWidth, curLen);
-        if(m_maxlineWidth > 0) { m_view->SetScrollWidth(m_maxlineWidth); }
-        m_view->SetEditable(false);
+    int curLen = (endPos.x - beginPos.x) + 10;
+    m_maxlineWidth = wxMax(m_maxlineWidth, curLen);
+    if(m_maxlineWidth > 0) { m_view->SetScrollWidth(m_maxlineWidth); }
+    m_view->SetEditable(false);
 
-        if(clConfig::Get().Read(kConfigBuildAutoScroll, true)) { m_view->ScrollToEnd(); }
-    }
+    if(clConfig::Get().Read(kConfigBuildAutoScroll, true)) { m_view->ScrollToEnd(); }
 }
 
+void NewBuildTab::DoAppendText(const wxString& text)
+{
+    // Messages generated by us (e.g. the summary line) are not classified
+    std::vector<BuildOutputLine> lines;
+    wxArrayString arr = ::wxStringTokenize(text, wxT("\n"), wxTOKEN_RET_EMPTY_ALL);
+    if(!arr.IsEmpty() && text.EndsWith("\n")) { arr.RemoveAt(arr.GetCount() - 1); }
+    for(size_t i = 0; i < arr.GetCount(); ++i) {
+        BuildOutputLine line;
+        line.text = arr.Item(i);
+        line.text.Trim();
+        line.info = new BuildLineInfo();
+        lines.push_back(line);
+    }
+    DoAppendLines(lines);
+}
 void NewBuildTab::CenterLineInView(int line)
 {
     if(line > m_view->GetLineCount()) return;
@@ -798,10 +722,12 @@ void NewBuildTab::OnClearUI(wxUpdateUIEvent& e) { e.Enable(!m_buildInProgress &&
 
 void NewBuildTab::ScrollToBottom() { m_view->ScrollToEnd(); }
 
-void NewBuildTab::AppendLine(const wxString& text)
+void NewBuildTab::AppendLine(const wxString& text) { m_classifier->AddOutput(text); }
+
+void NewBuildTab::OnBuildOutputClassified()
 {
-    m_output << text;
-    DoProcessOutput(false, false);
+    std::vector<BuildOutputLine> lines;
+    if(m_classifier->TakeLines(lines)) { DoAppendLines(lines); }
 }
 
 void NewBuildTab::OnStyleNeeded(wxStyledTextEvent& event)
@@ -961,10 +887,10 @@ void NewBuildTab::ColourOutput()
         m_view->StartStyling(startPos, 0x1f);
 #endif
 
-        // Run the regexes
-        wxString lineText = m_view->GetLine(i);
-        LINE_SEVERITY severity;
-        GetMatchingRegex(lineText, severity);
+        // The lines were already classified
+        LINE_SEVERITY severity = SV_NONE;
+        std::map<int, BuildLineInfo*>::iterator iter = m_viewData.find(i);
+        if(iter != m_viewData.end()) { severity = iter->second->GetSeverity(); }
         switch(severity) {
         case SV_WARNING:
             m_view->SetStyling((lineEndPos - startPos), LEX_GCC_WARNING);
@@ -987,58 +913,6 @@ void NewBuildTab::ColourOutput()
     m_lastLineColoured = untilLine;
 }
 
-CmpPatternPtr NewBuildTab::GetMatchingRegex(const wxString& lineText, LINE_SEVERITY& severity)
-{
-    if(lineText.Lower().Contains("entering directory") || lineText.Lower().Contains("leaving directory")) {
-        severity = SV_DIR_CHANGE;
-        return NULL;
-
-    } else if(lineText.StartsWith("====")) {
-        severity = SV_NONE;
-        return NULL;
-
-    } else {
-
-        // Find *warnings* first
-        bool isWarning = false;
-
-        if(!m_cmp) {
-            severity = SV_NONE;
-            return NULL;
-        }
-
-        CmpPatterns cmpPatterns;
-        if(!DoGetCompilerPatterns(m_cmp->GetName(), cmpPatterns)) {
-            severity = SV_NONE;
-            return NULL;
-        }
-
-        // If it is not an error, maybe it's a warning
-        for(size_t i = 0; i < cmpPatterns.warningPatterns.size(); i++) {
-            CmpPatternPtr cmpPatterPtr = cmpPatterns.warningPatterns.at(i);
-            BuildLineInfo bli;
-            if(cmpPatterPtr->Matches(lineText, bli)) {
-                severity = SV_WARNING;
-                return cmpPatterPtr;
-            }
-        }
-        if(!isWarning) {
-            for(size_t i = 0; i < cmpPatterns.errorsPatterns.size(); i++) {
-                BuildLineInfo bli;
-                CmpPatternPtr cmpPatterPtr = cmpPatterns.errorsPatterns.at(i);
-                if(cmpPatterPtr->Matches(lineText, bli)) {
-                    severity = SV_ERROR;
-                    return cmpPatterPtr;
-                }
-            }
-        }
-    }
-
-    // Default
-    severity = SV_NONE;
-    return NULL;
-}
-
 void NewBuildTab::OnIdle(wxIdleEvent& event)
 {
     if(m_view->IsEmpty()) { return; }
@@ -1154,3 +1028,376 @@ void BuildLineInfo::SetFilename(const wxString& filename)
     this->m_filename = filename;
 #endif
 }
+
+////////////////////////////////////////////
+// CmpPatternMatcher
+
+void CmpPatternMatcher::Build(const Compiler::CmpListInfoPattern& warningPatterns,
+                              const Compiler::CmpListInfoPattern& errorPatterns)
+{
+    m_patterns.clear();
+    m_literals.Clear();
+
+    // Warnings are tested first
+    DoAddPatterns(warningPatterns, SV_WARNING);
+    DoAddPatterns(errorPatterns, SV_ERROR);
+    m_literalFound.resize(m_literals.size());
+}
+
+void CmpPatternMatcher::DoAddPatterns(const Compiler::CmpListInfoPattern& patterns, LINE_SEVERITY severity)
+{
+    Compiler::CmpListInfoPattern::const_iterator iter = patterns.begin();
+    for(; iter != patterns.end(); ++iter) {
+        CmpPatternPtr compiledPatternPtr(new CmpPattern(new wxRegEx(iter->pattern, wxRE_ADVANCED | wxRE_ICASE),
+                                                        iter->fileNameIndex, iter->lineNumberIndex, iter->columnIndex,
+                                                        severity));
+        if(!compiledPatternPtr->GetRegex()->IsValid()) { continue; }
+
+        Entry entry;
+        entry.pattern = compiledPatternPtr;
+        entry.literal = wxNOT_FOUND;
+        wxString literal = GetRequiredLiteral(iter->pattern);
+        if(!literal.IsEmpty()) {
+            entry.literal = m_literals.Index(literal);
+            if(entry.literal == wxNOT_FOUND) { entry.literal = (int)m_literals.Add(literal); }
+        }
+        m_patterns.push_back(entry);
+    }
+}
+
+bool CmpPatternMatcher::Matches(const wxString& line, const wxString& lowerLine, BuildLineInfo& lineInfo)
+{
+    // Literals are shared between patterns (e.g. ":"), search each one at most once
+    std::fill(m_literalFound.begin(), m_literalFound.end(), wxNOT_FOUND);
+    for(size_t i = 0; i < m_patterns.size(); ++i) {
+        Entry& entry = m_patterns[i];
+        if(entry.literal != wxNOT_FOUND) {
+            int& found = m_literalFound[entry.literal];
+            if(found == wxNOT_FOUND) { found = lowerLine.Contains(m_literals.Item(entry.literal)) ? 1 : 0; }
+            if(found == 0) { continue; }
+        }
+        if(entry.pattern->Matches(line, lineInfo)) { return true; }
+    }
+    return false;
+}
+
+// Return the index of the ']' closing the bracket expression that starts at 'pos'
+static size_t SkipBracketExpression(const wxString& pattern, size_t pos)
+{
+    size_t i = pos + 1;
+    if(i < pattern.length() && pattern[i] == '^') { ++i; }
+    // a leading ']' is part of the list
+    if(i < pattern.length() && pattern[i] == ']') { ++i; }
+    while(i < pattern.length()) {
+        wxUniChar ch = pattern[i];
+        if(ch == '\\') {
+            i += 2;
+        } else if(ch == '[' && (i + 1) < pattern.length() &&
+                  (pattern[i + 1] == ':' || pattern[i + 1] == '.' || pattern[i + 1] == '=')) {
+            // [:class:], [.coll.] or [=equiv=]
+            wxString closing;
+            closing << pattern[i + 1] << "]";
+            size_t where = pattern.find(closing, i + 2);
+            if(where == wxString::npos) { return wxString::npos; }
+            i = where + 2;
+        } else if(ch == ']') {
+            return i;
+        } else {
+            ++i;
+        }
+    }
+    return wxString::npos;
+}
+
+wxString CmpPatternMatcher::GetRequiredLiteral(const wxString& pattern)
+{
+    // ARE directors and embedded options change the syntax of the pattern
+    if(pattern.StartsWith("***") || pattern.StartsWith("(?")) { return ""; }
+
+    struct Group {
+        wxString best; // the longest literal required by this group so far
+        wxString run;  // the literal being collected
+        bool alternation;
+        bool ignored; // lookahead constraints
+        Group()
+            : alternation(false)
+            , ignored(false)
+        {
+        }
+        void Commit()
+        {
+            if(run.length() > best.length()) { best = run; }
+            run.clear();
+        }
+    };
+
+    std::vector<Group> groups(1);
+    wxString closedGroup;      // the literal required by the group that was just closed
+    bool hasClosedGroup = false; // a group was just closed, we don't know yet if it is quantified
+    bool lastWasLiteral = false;
+    size_t i = 0;
+    while(i < pattern.length()) {
+        wxUniChar ch = pattern[i];
+        if(ch == '?' || ch == '*' || ch == '+' || ch == '{') {
+            // A quantifier: the previous atom is optional, or it may repeat
+            Group& cur = groups.back();
+            if(lastWasLiteral && ch != '+') { cur.run.RemoveLast(); }
+            cur.Commit();
+            if(hasClosedGroup && ch == '+' && closedGroup.length() > cur.best.length()) { cur.best = closedGroup; }
+            hasClosedGroup = false;
+            lastWasLiteral = false;
+            if(ch == '{') {
+                i = pattern.find('}', i);
+                if(i == wxString::npos) { return ""; }
+            }
+            ++i;
+            // non greedy quantifier
+            if(i < pattern.length() && pattern[i] == '?') { ++i; }
+            continue;
+        }
+
+        Group& cur = groups.back();
+        if(hasClosedGroup && closedGroup.length() > cur.best.length()) { cur.best = closedGroup; }
+        hasClosedGroup = false;
+        lastWasLiteral = false;
+
+        switch((int)ch.GetValue()) {
+        case '\\': {
+            if((i + 1) >= pattern.length()) { return ""; }
+            wxUniChar next = pattern[i + 1];
+            i += 2;
+            if(wxIsalnum(next)) {
+                // class shorthand, back reference, constraint escape or a character code (\x41, \u0041, \cA). The
+                // escape is opaque: its digits are not part of the literal that follows it
+                cur.Commit();
+                if(next == 'c') {
+                    ++i;
+                } else if(next == 'x' || next == 'u' || next == 'U' || wxIsdigit(next)) {
+                    while(i < pattern.length() && wxIsxdigit(pattern[i])) {
+                        ++i;
+                    }
+                }
+            } else {
+                cur.run << next;
+                lastWasLiteral = true;
+            }
+            break;
+        }
+        case '[': {
+            cur.Commit();
+            i = SkipBracketExpression(pattern, i);
+            if(i == wxString::npos) { return ""; }
+            ++i;
+            break;
+        }
+        case '(': {
+            cur.Commit();
+            Group group;
+            ++i;
+            if(pattern.Mid(i, 2) == "?:") {
+                i += 2;
+            } else if(pattern.Mid(i, 2) == "?=" || pattern.Mid(i, 2) == "?!") {
+                group.ignored = true;
+                i += 2;
+            } else if(i < pattern.length() && pattern[i] == '?') {
+                return "";
+            }
+            groups.push_back(group);
+            break;
+        }
+        case ')': {
+            if(groups.size() == 1) { return ""; }
+            Group group = groups.back();
+            groups.pop_back();
+            group.Commit();
+            closedGroup = (group.alternation || group.ignored) ? wxString() : group.best;
+            hasClosedGroup = true;
+            ++i;
+            break;
+        }
+        case '|':
+            cur.Commit();
+            cur.alternation = true;
+            ++i;
+            break;
+        case '.':
+        case '^':
+        case '$':
+            cur.Commit();
+            ++i;
+            break;
+        default:
+            cur.run << ch;
+            lastWasLiteral = true;
+            ++i;
+            break;
+        }
+    }
+
+    if(groups.size() != 1) { return ""; }
+    Group& top = groups.back();
+    if(hasClosedGroup && closedGroup.length() > top.best.length()) { top.best = closedGroup; }
+    top.Commit();
+    if(top.alternation) { return ""; }
+    return top.best.Lower();
+}
+
+////////////////////////////////////////////
+// BuildOutputClassifier
+
+BuildOutputClassifier::BuildOutputClassifier(NewBuildTab* owner)
+    : m_owner(owner)
+    , m_threadSession(0)
+    , m_session(0)
+    , m_notifyPending(false)
+{
+}
+
+BuildOutputClassifier::~BuildOutputClassifier()
+{
+    // The thread is stopped: delete the requests it did not get to
+    ClearQueue();
+    for(size_t i = 0; i < m_results.size(); ++i) {
+        wxDELETE(m_results[i].info);
+    }
+    m_results.clear();
+}
+
+void BuildOutputClassifier::DoAdd(Request* request)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_resultsMutex);
+        request->session = m_session;
+    }
+    Add(request);
+}
+
+void BuildOutputClassifier::Reset(CompilerPtr compiler, const wxString& cygwinRoot)
+{
+    Request* request = new Request(Request::kReset);
+    if(compiler) {
+        request->warningPatterns = compiler->GetWarnPatterns();
+        request->errorPatterns = compiler->GetErrPatterns();
+    }
+    request->cygwinRoot = cygwinRoot;
+    DoAdd(request);
+}
+
+void BuildOutputClassifier::AddOutput(const wxString& output)
+{
+    if(output.IsEmpty()) { return; }
+    Request* request = new Request(Request::kOutput);
+    request->output = output;
+    DoAdd(request);
+}
+
+void BuildOutputClassifier::Flush() { DoAdd(new Request(Request::kFlush)); }
+
+bool BuildOutputClassifier::TakeLines(std::vector<BuildOutputLine>& lines)
+{
+    std::lock_guard<std::mutex> lock(m_resultsMutex);
+    m_notifyPending = false;
+    lines.swap(m_results);
+    m_results.clear();
+    return !lines.empty();
+}
+
+void BuildOutputClassifier::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_resultsMutex);
+    for(size_t i = 0; i < m_results.size(); ++i) {
+        wxDELETE(m_results[i].info);
+    }
+    m_results.clear();
+    ++m_session;
+}
+
+void BuildOutputClassifier::DoClassifyLine(const wxString& line, std::vector<BuildOutputLine>& lines)
+{
+    BuildOutputLine outputLine;
+    outputLine.info = new BuildLineInfo();
+
+    wxString lowerLine = line.Lower();
+    if(lowerLine.Contains("entering directory") || lowerLine.Contains("leaving directory")) {
+        outputLine.info->SetSeverity(SV_DIR_CHANGE);
+
+        // Collect the directories, they are used to resolve relative file names
+        if(line.Contains(wxT("Entering directory `"))) {
+            wxString currentDir = line.AfterFirst(wxT('`'));
+            m_directories.Add(currentDir.BeforeLast(wxT('\'')));
+
+        } else if(line.Contains(wxT("Entering directory '"))) {
+            wxString currentDir = line.AfterFirst(wxT('\''));
+            m_directories.Add(currentDir.BeforeLast(wxT('\'')));
+        }
+
+    } else if(!line.StartsWith("====") && m_matcher.Matches(line, lowerLine, *outputLine.info)) {
+        outputLine.info->NormalizeFilename(m_directories, m_cygwinRoot);
+    }
+
+    wxString text = line;
+    text.Trim();
+    ::clStripTerminalColouring(text, outputLine.text);
+    lines.push_back(outputLine);
+}
+
+void BuildOutputClassifier::ProcessRequest(ThreadRequest* request)
+{
+    Request* req = dynamic_cast<Request*>(request);
+    CHECK_PTR_RET(req);
+
+    if(req->session != m_threadSession) {
+        // the build tab was cleared
+        m_threadSession = req->session;
+        m_remainder.Clear();
+        m_directories.Clear();
+    }
+
+    std::vector<BuildOutputLine> lines;
+    switch(req->type) {
+    case Request::kReset:
+        m_matcher.Build(req->warningPatterns, req->errorPatterns);
+        m_cygwinRoot = req->cygwinRoot;
+        break;
+    case Request::kOutput: {
+        // Process only completed lines (i.e. a line that ends with '\n')
+        m_remainder << req->output;
+        size_t start = 0;
+        size_t where = m_remainder.find('\n', start);
+        while(where != wxString::npos) {
+            DoClassifyLine(m_remainder.Mid(start, where - start + 1), lines);
+            start = where + 1;
+            where = m_remainder.find('\n', start);
+        }
+        m_remainder.erase(0, start);
+        break;
+    }
+    case Request::kFlush:
+        if(!m_remainder.IsEmpty()) {
+            DoClassifyLine(m_remainder, lines);
+            m_remainder.Clear();
+        }
+        break;
+    }
+
+    bool notify = false;
+    bool flushed = false;
+    {
+        std::lock_guard<std::mutex> lock(m_resultsMutex);
+        if(req->session == m_session) {
+            m_results.insert(m_results.end(), lines.begin(), lines.end());
+            // notify the build tab once per batch
+            notify = !m_results.empty() && !m_notifyPending;
+            if(notify) { m_notifyPending = true; }
+            flushed = (req->type == Request::kFlush);
+        } else {
+            // stale output
+            for(size_t i = 0; i < lines.size(); ++i) {
+                wxDELETE(lines[i].info);
+            }
+        }
+    }
+
+    if(notify) { m_owner->CallAfter(&NewBuildTab::OnBuildOutputClassified); }
+    if(flushed) { m_owner->CallAfter(&NewBuildTab::OnBuildOutputFlushed); }
+}
@@ -38,6 +38,9 @@
 #include <map>
 #include <wx/regex.h>
 #include "cl_command_event.h"
+#include "worker_thread.h"
+#include <mutex>
+#include <vector>
 #include <wx/stc/stc.h>
 
 class wxDataViewListCtrl;
@@ -137,9 +140,130 @@ typedef SmartPtr<CmpPattern> CmpPatternPtr;
 
 //////////////////////////////////////////////////////////////////
 
-struct CmpPatterns {
-    std::vector<CmpPatternPtr> errorsPatterns;
-    std::vector<CmpPatternPtr> warningPatterns;
+/**
+ * @class CmpPatternMatcher
+ * @brief the compiled warning and error patterns of a compiler. Every pattern is guarded by the longest literal that
+ * a line must contain in order to match it, so most of the build output lines are rejected without running any regex
+ */
+class CmpPatternMatcher
+{
+    struct Entry {
+        CmpPatternPtr pattern;
+        int literal; // index in m_literals or wxNOT_FOUND
+    };
+    std::vector<Entry> m_patterns; // warnings first, then errors
+    wxArrayString m_literals;      // lower case, each literal is searched once per line
+    std::vector<int> m_literalFound;
+
+protected:
+    void DoAddPatterns(const Compiler::CmpListInfoPattern& patterns, LINE_SEVERITY severity);
+
+public:
+    /**
+     * @brief compile the patterns
+     */
+    void Build(const Compiler::CmpListInfoPattern& warningPatterns, const Compiler::CmpListInfoPattern& errorPatterns);
+
+    /**
+     * @brief find the first pattern that matches 'line'
+     * @param lowerLine 'line' in lower case
+     * @param lineInfo [output]
+     */
+    bool Matches(const wxString& line, const wxString& lowerLine, BuildLineInfo& lineInfo);
+
+    /**
+     * @brief return the longest literal (in lower case) that any line matching 'pattern' contains. Return an empty
+     * string if no such literal can be found
+     */
+    static wxString GetRequiredLiteral(const wxString& pattern);
+};
+
+//////////////////////////////////////////////////////////////////
+
+struct BuildOutputLine {
+    wxString text; // the text to display
+    BuildLineInfo* info;
+    BuildOutputLine()
+        : info(NULL)
+    {
+    }
+};
+
+class NewBuildTab;
+/**
+ * @class BuildOutputClassifier
+ * @brief split the build output into lines and classify them (errors, warnings, directory changes) in a background
+ * thread. The classified lines are collected and taken by the build tab in batches
+ */
+class BuildOutputClassifier : public WorkerThread
+{
+public:
+    struct Request : public ThreadRequest {
+        enum eType { kReset, kOutput, kFlush };
+        eType type;
+        size_t session;
+        wxString output;
+        Compiler::CmpListInfoPattern warningPatterns;
+        Compiler::CmpListInfoPattern errorPatterns;
+        wxString cygwinRoot;
+        Request(eType t)
+            : type(t)
+            , session(0)
+        {
+        }
+    };
+
+protected:
+    NewBuildTab* m_owner;
+
+    // Accessed from the worker thread only
+    CmpPatternMatcher m_matcher;
+    wxString m_remainder;
+    wxArrayString m_directories;
+    wxString m_cygwinRoot;
+    size_t m_threadSession;
+
+    // Shared with the main thread
+    std::mutex m_resultsMutex;
+    std::vector<BuildOutputLine> m_results;
+    size_t m_session;
+    bool m_notifyPending;
+
+protected:
+    void DoAdd(Request* request);
+    void DoClassifyLine(const wxString& line, std::vector<BuildOutputLine>& lines);
+
+public:
+    BuildOutputClassifier(NewBuildTab* owner);
+    virtual ~BuildOutputClassifier();
+
+    /**
+     * @brief set the compiler whose patterns are used for the output that follows
+     */
+    void Reset(CompilerPtr compiler, const wxString& cygwinRoot);
+
+    /**
+     * @brief add build output. Only complete lines are classified
+     */
+    void AddOutput(const wxString& output);
+
+    /**
+     * @brief classify the last (incomplete) line. Once all the output added so far has been classified, the build
+     * tab is notified with NewBuildTab::OnBuildOutputFlushed
+     */
+    void Flush();
+
+    /**
+     * @brief take the lines classified so far
+     */
+    bool TakeLines(std::vector<BuildOutputLine>& lines);
+
+    /**
+     * @brief discard the output that was not taken yet and start a new session (directories etc are reset)
+     */
+    void Clear();
+
+    void ProcessRequest(ThreadRequest* request);
 };
 
 ///////////////////////////////////////////////////////////////////
@@ -148,14 +272,12 @@ class NewBuildTab : public wxPanel
 {
     enum BuildpaneScrollTo { ScrollToFirstError, ScrollToFirstItem, ScrollToEnd };
 
-    typedef std::map<wxString, CmpPatterns> MapCmpPatterns_t;
     typedef std::multimap<wxString, BuildLineInfo*> MultimapBuildInfo_t;
     typedef std::list<BuildLineInfo*> BuildInfoList_t;
 
-    wxString m_output;
     wxStyledTextCtrl* m_view;
     CompilerPtr m_cmp;
-    MapCmpPatterns_t m_cmpPatterns;
+    BuildOutputClassifier* m_classifier;
     int m_warnCount;
     int m_errorCount;
     BuildTabSettingsData m_buildTabSettings;
@@ -164,7 +286,6 @@ class NewBuildTab : public wxPanel
     BuildTabSettingsData::ShowBuildPane m_showMe;
     wxStopWatch m_sw;
     MultimapBuildInfo_t m_buildInfoPerFile;
-    wxArrayString m_directories;
     bool m_skipWarnings;
     BuildpaneScrollTo m_buildpaneScrollTo;
     BuildInfoList_t m_errorsAndWarningsList;
@@ -179,11 +300,8 @@ class NewBuildTab : public wxPanel
 protected:
     void InitView(const wxString& theme = "");
     void CenterLineInView(int line);
-    void DoCacheRegexes();
-    BuildLineInfo* DoProcessLine(const wxString& line);
-    void DoProcessOutput(bool compilationEnded, bool isSummaryLine);
-    void DoSearchForDirectory(const wxString& line);
-    bool DoGetCompilerPatterns(const wxString& compilerName, CmpPatterns& patterns);
+    void DoAppendLines(const std::vector<BuildOutputLine>& lines);
+    void DoAppendText(const wxString& text);
     void DoClear();
     void MarkEditor(clEditor* editor);
     void DoToggleWindow();
@@ -191,7 +309,6 @@ protected:
     wxFont DoGetFont() const;
     void DoCentreErrorLine(BuildLineInfo* bli, clEditor* editor, bool centerLine);
     void ColourOutput();
-    CmpPatternPtr GetMatchingRegex(const wxString& lineText, LINE_SEVERITY& severity);
 
 public:
     NewBuildTab(wxWindow* parent);
@@ -210,6 +327,16 @@ public:
     wxString GetBuildContent() const;
     void AppendLine(const wxString& text);
 
+    /**
+     * @brief called (from the main thread) when the classifier has lines ready
+     */
+    void OnBuildOutputClassified();
+
+    /**
+     * @brief called (from the main thread) when all the build output has been classified
+     */
+    void OnBuildOutputFlushed();
+
 protected:
     void OnThemeChanged(wxCommandEvent& event);
     void OnBuildStarted(clCommandEvent& e);
@@ -377,8 +377,8 @@ void WatchesTable::OnCreateVariableObject(const DebuggerEventData& event)
                 if(dbgr) DoRefreshItem(dbgr, item, true);
 
                 // Query the debugger to see if this node has a children
-                // In case it does, we add a dummy node so we will get the [+] sign
-                dbgr->ListChildren(data->_gdbId, m_QUERY_NUM_CHILDS);
+                // In case it does, we add a dummy node so we will get the [+] sign. A single child is enough
+                dbgr->ListChildren(data->_gdbId, m_QUERY_NUM_CHILDS, 0, 1);
                 m_listChildItemId[data->_gdbId] = item;
             }
 
@@ -394,12 +394,9 @@ void WatchesTable::OnCreateVariableObject(const DebuggerEventData& event)
 
 void WatchesTable::OnListChildren(const DebuggerEventData& event)
 {
-    wxString gdbId = event.m_expression;
-    std::map<wxString, wxTreeItemId>::iterator iter = m_listChildItemId.find(gdbId);
-    if(iter == m_listChildItemId.end()) return;
-
-    wxTreeItemId item = iter->second;
-    m_listChildItemId.erase(iter);
+    int from = 0;
+    wxTreeItemId item = DoBeginListChildren(event.m_expression, from);
+    if(!item.IsOk()) return;
 
     if(event.m_userReason == m_QUERY_NUM_CHILDS) {
         if(event.m_varObjChildren.empty() == false) m_listTable->AppendItem(item, wxT("<dummy>"));
@@ -414,8 +411,7 @@ void WatchesTable::OnListChildren(const DebuggerEventData& event)
                 if(ch.varName == wxT("public") || ch.varName == wxT("private") || ch.varName == wxT("protected")) {
                     // not really a node...
                     // ask for information about this node children
-                    dbgr->ListChildren(ch.gdbId, m_LIST_CHILDS);
-                    m_listChildItemId[ch.gdbId] = item;
+                    DoListChildren(dbgr, ch.gdbId, item, 0);
 
                 } else {
 
@@ -429,12 +425,19 @@ void WatchesTable::OnListChildren(const DebuggerEventData& event)
                         m_listTable->AppendItem(child, wxT("<dummy>"));
                     }
 
-                    // refresh this item only
-                    dbgr->EvaluateVariableObject(data->_gdbId, m_DBG_USERR);
-                    // ask the value for this node
-                    m_gdbIdToTreeId[data->_gdbId] = child;
+                    if(ch.value.IsEmpty() == false) {
+                        // gdb already sent the value of this node
+                        m_listTable->SetItemText(child, ch.value, 1);
+
+                    } else {
+                        // refresh this item only
+                        dbgr->EvaluateVariableObject(data->_gdbId, m_DBG_USERR);
+                        // ask the value for this node
+                        m_gdbIdToTreeId[data->_gdbId] = child;
+                    }
                 }
             }
+            DoEndListChildren(event, item, from);
         }
     }
 }
@@ -452,6 +455,12 @@ void WatchesTable::OnItemExpanding(wxTreeEvent& event)
         return;
     }
 
+    if(DoLoadMoreChildren(dbgr, event.GetItem())) {
+        // "Load more...": the next page is added to the parent item
+        event.Veto();
+        return;
+    }
+
     if(child.IsOk() && m_listTable->GetItemText(child) == wxT("<dummy>")) {
         // a dummy node, replace it with the real node content
         m_listTable->Delete(child);
@@ -460,8 +469,7 @@ void WatchesTable::OnItemExpanding(wxTreeEvent& event)
         if(data) {
             if(data->_gdbId.IsEmpty() == false) {
                 dbgr->UpdateVariableObject(data->_gdbId, m_DBG_USERR);
-                dbgr->ListChildren(data->_gdbId, m_LIST_CHILDS);
-                m_listChildItemId[data->_gdbId] = event.GetItem();
+                DoListChildren(dbgr, data->_gdbId, event.GetItem(), 0);
             }
         }
     }
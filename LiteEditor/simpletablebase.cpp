@@ -154,6 +154,7 @@ void DebuggerTreeListCtrlBase::Clear()
     }
 
     m_listChildItemId.clear();
+    m_listChildFrom.clear();
     m_createVarItemId.clear();
     m_gdbIdToTreeId.clear();
     m_curStackInfo.Clear();
@@ -280,6 +281,77 @@ wxString DebuggerTreeListCtrlBase::GetItemPath(const wxTreeItemId& item)
     return itemPath;
 }
 
+void DebuggerTreeListCtrlBase::DoListChildren(IDebugger* dbgr, const wxString& gdbId, const wxTreeItemId& item,
+                                              int from)
+{
+    dbgr->ListChildren(gdbId, m_LIST_CHILDS, from, DBG_CHILDREN_PAGE_SIZE);
+    m_listChildItemId[gdbId] = item;
+    m_listChildFrom[gdbId] = from;
+}
+
+bool DebuggerTreeListCtrlBase::DoLoadMoreChildren(IDebugger* dbgr, const wxTreeItemId& item)
+{
+    DbgTreeItemData* data = static_cast<DbgTreeItemData*>(m_listTable->GetItemData(item));
+    if(!data || data->_kind != DbgTreeItemData::MoreChildren) {
+        return false;
+    }
+
+    // fetch the next page into the parent item. This entry is removed once the page arrives
+    if(m_listChildItemId.count(data->_parentGdbId) == 0) {
+        m_listTable->SetItemText(item, _("Loading..."));
+        DoListChildren(dbgr, data->_parentGdbId, m_listTable->GetItemParent(item), data->_nextChild);
+    }
+    return true;
+}
+
+wxTreeItemId DebuggerTreeListCtrlBase::DoBeginListChildren(const wxString& gdbId, int& from)
+{
+    from = 0;
+    std::map<wxString, wxTreeItemId>::iterator iter = m_listChildItemId.find(gdbId);
+    if(iter == m_listChildItemId.end()) {
+        return wxTreeItemId();
+    }
+
+    wxTreeItemId item = iter->second;
+    m_listChildItemId.erase(iter);
+
+    std::map<wxString, int>::iterator fromIter = m_listChildFrom.find(gdbId);
+    if(fromIter != m_listChildFrom.end()) {
+        from = fromIter->second;
+        m_listChildFrom.erase(fromIter);
+    }
+
+    // remove the "Load more..." entry of this variable object, the new page (if any) replaces it
+    wxTreeItemIdValue cookie;
+    wxTreeItemId moreItem = m_listTable->GetFirstChild(item, cookie);
+    while(moreItem.IsOk()) {
+        DbgTreeItemData* moreData = static_cast<DbgTreeItemData*>(m_listTable->GetItemData(moreItem));
+        if(moreData && moreData->_kind == DbgTreeItemData::MoreChildren && moreData->_parentGdbId == gdbId) {
+            m_listTable->Delete(moreItem);
+            break;
+        }
+        moreItem = m_listTable->GetNextChild(item, cookie);
+    }
+    return item;
+}
+
+void DebuggerTreeListCtrlBase::DoEndListChildren(const DebuggerEventData& event, const wxTreeItemId& item, int from)
+{
+    if(!event.m_variableObject.has_more || event.m_varObjChildren.empty()) {
+        return;
+    }
+
+    // there are more children, they are requested when this entry is expanded
+    DbgTreeItemData* data = new DbgTreeItemData();
+    data->_kind = DbgTreeItemData::MoreChildren;
+    data->_parentGdbId = event.m_expression;
+    data->_nextChild = from + (int)event.m_varObjChildren.size();
+
+    wxTreeItemId moreItem = m_listTable->AppendItem(item, _("Load more..."), -1, -1, data);
+    m_listTable->AppendItem(moreItem, wxT("<dummy>"));
+    m_listTable->Collapse(moreItem);
+}
+
 void DebuggerTreeListCtrlBase::OnCreateVariableObjError(const DebuggerEventData& event)
 {
     // failed to create a variable object!
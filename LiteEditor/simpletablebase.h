@@ -46,6 +46,9 @@
 
 ///////////////////////////////////////////////////////////////////////////
 
+// Number of children requested at once when expanding a variable
+#define DBG_CHILDREN_PAGE_SIZE 100
+
 class DbgTreeItemData : public wxTreeItemData
 {
 public:
@@ -53,6 +56,8 @@ public:
     size_t _kind;
     bool _isFake;
     wxString _retValueGdbValue;
+    wxString _parentGdbId; // MoreChildren: the variable object whose next page of children this item loads
+    int _nextChild;        // MoreChildren: the index of the first child of that page
 
 public:
     enum {
@@ -60,19 +65,22 @@ public:
         FuncArgs = 0x00000002,
         VariableObject = 0x00000004,
         Watch = 0x00000010,
-        FuncRetValue = 0x00000020
+        FuncRetValue = 0x00000020,
+        MoreChildren = 0x00000040
     };
 
 public:
     DbgTreeItemData()
         : _kind(Locals)
         , _isFake(false)
+        , _nextChild(0)
     {
     }
 
     DbgTreeItemData(const wxString& gdbId)
         : _gdbId(gdbId)
         , _isFake(false)
+        , _nextChild(0)
     {
     }
 
@@ -103,6 +111,7 @@ protected:
 
     std::map<wxString, wxTreeItemId> m_gdbIdToTreeId;
     std::map<wxString, wxTreeItemId> m_listChildItemId;
+    std::map<wxString, int> m_listChildFrom; // gdbId -> index of the first child requested
     std::map<wxString, wxTreeItemId> m_createVarItemId;
     DbgStackInfo m_curStackInfo;
 
@@ -133,6 +142,27 @@ public:
     virtual wxTreeItemId DoFindItemByExpression(const wxString& expr);
     virtual void ResetTableColors();
     virtual wxString GetItemPath(const wxTreeItemId& item);
+
+    //////////////////////////////////////////////
+    // Paged children
+    //////////////////////////////////////////////
+    /**
+     * @brief request a page of the children of gdbId, starting at 'from'. The page is added under 'item'
+     */
+    virtual void DoListChildren(IDebugger* dbgr, const wxString& gdbId, const wxTreeItemId& item, int from);
+    /**
+     * @brief if 'item' is a "Load more..." entry, request the next page of its parent and return true
+     */
+    virtual bool DoLoadMoreChildren(IDebugger* dbgr, const wxTreeItemId& item);
+    /**
+     * @brief a page of children arrived: return the item it belongs to and remove the "Load more..." entry that
+     * requested it. 'from' is set to the index of the first child of the page
+     */
+    virtual wxTreeItemId DoBeginListChildren(const wxString& gdbId, int& from);
+    /**
+     * @brief append a "Load more..." entry under 'item' if gdb reported more children past the page
+     */
+    virtual void DoEndListChildren(const DebuggerEventData& event, const wxTreeItemId& item, int from);
 };
 
 #endif //__simpletablebase__
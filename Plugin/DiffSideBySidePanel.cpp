@@ -60,6 +60,7 @@ DiffSideBySidePanel::DiffSideBySidePanel(wxWindow* parent)
     , m_darkTheme(false)
     , m_flags(0)
     , m_storeFilepaths(true)
+    , m_cancelDiff(false)
 {
     m_config.Load();
     LexerConf::Ptr_t lexer = ColoursAndFontsManager::Get().GetLexer("text");
@@ -153,6 +154,9 @@ DiffSideBySidePanel::DiffSideBySidePanel(wxWindow* parent)
 
 DiffSideBySidePanel::~DiffSideBySidePanel()
 {
+    // The worker thread reads the files we are about to delete
+    DoStopDiffThread();
+
     if((m_flags & kDeleteLeftOnExit)) { clRemoveFile(m_textCtrlLeftFile->GetValue()); }
     if((m_flags & kDeleteRightOnExit)) { clRemoveFile(m_textCtrlRightFile->GetValue()); }
 
@@ -190,16 +194,54 @@ void DiffSideBySidePanel::Diff()
         return;
     }
 
+    // Cancel any diff in progress
+    DoStopDiffThread();
+
     // Cleanup
     DoClean();
 
     // Prepare the views
     PrepareViews();
 
-    // Prepare the diff
-    clDTL d;
-    d.Diff(m_textCtrlLeftFile->GetValue(), m_textCtrlRightFile->GetValue(),
-           m_config.IsSingleViewMode() ? clDTL::kOnePane : clDTL::kTwoPanes);
+    // Compute the diff in the background. Pass deep copies of the strings to the thread
+    m_diffResult.reset(new clDTL());
+    m_diffResult->SetCancelFlag(&m_cancelDiff);
+    m_diffThread = new std::thread(&DiffSideBySidePanel::DiffThreadMain, this, m_diffResult,
+                                   wxString(fnLeft.GetFullPath().c_str()), wxString(fnRight.GetFullPath().c_str()),
+                                   m_config.IsSingleViewMode() ? clDTL::kOnePane : clDTL::kTwoPanes);
+}
+
+void DiffSideBySidePanel::DiffThreadMain(DiffSideBySidePanel* panel, clDTL::Ptr_t d, const wxString& left,
+                                         const wxString& right, clDTL::DiffMode mode)
+{
+    d->Diff(left, right, mode);
+    if(!panel->m_cancelDiff.load()) { panel->CallAfter(&DiffSideBySidePanel::OnDiffCompleted, d); }
+}
+
+void DiffSideBySidePanel::DoStopDiffThread()
+{
+    if(m_diffThread) {
+        m_cancelDiff.store(true);
+        m_diffThread->join();
+        wxDELETE(m_diffThread);
+        m_cancelDiff.store(false);
+    }
+    m_diffResult.reset();
+}
+
+void DiffSideBySidePanel::OnDiffCompleted(clDTL::Ptr_t d)
+{
+    // Ignore results of a cancelled diff
+    if(!m_diffResult || d != m_diffResult) { return; }
+    DoStopDiffThread();
+    DoShowDiff(*d);
+}
+
+void DiffSideBySidePanel::DoShowDiff(clDTL& d)
+{
+    wxFileName fnLeft(m_textCtrlLeftFile->GetValue());
+    wxFileName fnRight(m_textCtrlRightFile->GetValue());
+
     clDTL::LineInfoVec_t& resultLeft = const_cast<clDTL::LineInfoVec_t&>(d.GetResultLeft());
     clDTL::LineInfoVec_t& resultRight = const_cast<clDTL::LineInfoVec_t&>(d.GetResultRight());
     m_sequences = d.GetSequences();
@@ -29,6 +29,8 @@
 #include "DiffConfig.h"
 #include "clDTL.h"
 #include "wxcrafter_plugin.h"
+#include <atomic>
+#include <thread>
 #include <vector>
 #include <wx/filename.h>
 #include "clPluginsFindBar.h"
@@ -96,6 +98,9 @@ protected:
     bool m_storeFilepaths;
     clToolBar* m_toolbar;
     clPluginsFindBar* m_findBar = nullptr;
+    std::thread* m_diffThread = nullptr;
+    std::atomic_bool m_cancelDiff;
+    clDTL::Ptr_t m_diffResult; // the diff being computed
 
 protected:
     virtual void OnBrowseLeftFile(wxCommandEvent& event);
@@ -162,6 +167,11 @@ public:
     void DoGetPositionsToCopy(wxStyledTextCtrl* stc, int& startPos, int& endPos, int& placeHolderMarkerFirstLine,
                               int& placeHolderMarkerLastLine);
     void DoSave(wxStyledTextCtrl* stc, const wxFileName& fn);
+    void DoShowDiff(clDTL& d);
+    void DoStopDiffThread();
+    void OnDiffCompleted(clDTL::Ptr_t d);
+    static void DiffThreadMain(DiffSideBySidePanel* panel, clDTL::Ptr_t d, const wxString& left,
+                               const wxString& right, clDTL::DiffMode mode);
 
     bool CanNextDiff();
     bool CanPrevDiff();
@@ -173,7 +183,8 @@ public:
 
     void DoLayout();
     /**
-     * @brief display a diff view for 2 files left and right
+     * @brief display a diff view for 2 files left and right. The diff is computed in a worker thread, the views are
+     * updated once it is done
      */
     void Diff();
 
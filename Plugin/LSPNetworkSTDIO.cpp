@@ -55,9 +55,13 @@ void LSPNetworkSTDIO::OnProcessTerminated(clProcessEvent& event)
 
 void LSPNetworkSTDIO::OnProcessOutput(clProcessEvent& event)
 {
-    const wxString& dataRead = event.GetOutput();
     clCommandEvent evt(wxEVT_LSP_NET_DATA_READY);
-    evt.SetString(dataRead);
+    if(!event.GetStringRaw().empty()) {
+        // pass the bytes as they were read from the process, the protocol layer does not need them as wxString
+        evt.SetStringRaw(event.GetStringRaw());
+    } else {
+        evt.SetString(event.GetOutput());
+    }
     AddPendingEvent(evt);
 }
 
@@ -1,3 +1,4 @@
+#include "LSP/CancelRequest.h"
 #include "LSP/CompletionRequest.h"
 #include "LSP/DidChangeTextDocumentRequest.h"
 #include "LSP/DidCloseTextDocumentRequest.h"
@@ -25,11 +26,19 @@
 #include "ieditor.h"
 #include "imanager.h"
 #include "processreaderthread.h"
+#include <algorithm>
 #include <iomanip>
 #include <sstream>
 #include <wx/filesys.h>
 #include <wx/stc/stc.h>
 
+// Above these limits, the pending edits of a document are dropped and the next change request sends the whole content
+#define LSP_MAX_PENDING_EDITS 1000
+#define LSP_MAX_PENDING_EDITS_BYTES (512 * 1024)
+
+// A request that did not get a reply after this many seconds no longer counts as in-flight
+#define LSP_REQUEST_TIMEOUT_SECONDS 30
+
 LanguageServerProtocol::LanguageServerProtocol(const wxString& name, eNetworkType netType, wxEvtHandler* owner,
                                                IPathConverter::Ptr_t pathConverter)
     : ServiceProvider(wxString() << "LSP: " << name, eServiceType::kCodeCompletion)
@@ -41,6 +50,7 @@ LanguageServerProtocol::LanguageServerProtocol(const wxString& name, eNetworkTyp
     EventNotifier::Get()->Bind(wxEVT_FILE_CLOSED, &LanguageServerProtocol::OnFileClosed, this);
     EventNotifier::Get()->Bind(wxEVT_FILE_LOADED, &LanguageServerProtocol::OnFileLoaded, this);
     EventNotifier::Get()->Bind(wxEVT_ACTIVE_EDITOR_CHANGED, &LanguageServerProtocol::OnEditorChanged, this);
+    EventNotifier::Get()->Bind(wxEVT_EDITOR_CLOSING, &LanguageServerProtocol::OnEditorClosing, this);
 
     Bind(wxEVT_CC_FIND_SYMBOL, &LanguageServerProtocol::OnFindSymbol, this);
     Bind(wxEVT_CC_FIND_SYMBOL_DECLARATION, &LanguageServerProtocol::OnFindSymbolDecl, this);
@@ -68,6 +78,7 @@ LanguageServerProtocol::~LanguageServerProtocol()
     EventNotifier::Get()->Unbind(wxEVT_FILE_CLOSED, &LanguageServerProtocol::OnFileClosed, this);
     EventNotifier::Get()->Unbind(wxEVT_FILE_LOADED, &LanguageServerProtocol::OnFileLoaded, this);
     EventNotifier::Get()->Unbind(wxEVT_ACTIVE_EDITOR_CHANGED, &LanguageServerProtocol::OnEditorChanged, this);
+    EventNotifier::Get()->Unbind(wxEVT_EDITOR_CLOSING, &LanguageServerProtocol::OnEditorClosing, this);
     Unbind(wxEVT_CC_FIND_SYMBOL, &LanguageServerProtocol::OnFindSymbol, this);
     Unbind(wxEVT_CC_FIND_SYMBOL_DECLARATION, &LanguageServerProtocol::OnFindSymbolDecl, this);
     Unbind(wxEVT_CC_FIND_SYMBOL_DEFINITION, &LanguageServerProtocol::OnFindSymbolImpl, this);
@@ -132,6 +143,13 @@ void LanguageServerProtocol::QueueMessage(LSP::MessageWithParams::Ptr_t request)
     if(!IsInitialized()) { return; }
     if(request->As<LSP::CompletionRequest>()) {
         m_lastCompletionRequestId = request->As<LSP::CompletionRequest>()->GetId();
+
+        // Older completion requests are superseded by this one
+        std::vector<int> ids = m_Queue.CancelCompletionRequests(m_lastCompletionRequestId);
+        for(int id : ids) {
+            clDEBUG() << GetLogPrefix() << "cancelling completion request ID#" << id;
+            m_Queue.Push(LSP::MessageWithParams::MakeRequest(new LSP::CancelRequest(id)));
+        }
     }
     m_Queue.Push(request);
     ProcessQueue();
@@ -185,12 +203,15 @@ bool LanguageServerProtocol::Start()
 
 void LanguageServerProtocol::DoClear()
 {
+    if(!m_Queue.GetLatency().empty()) { clDEBUG() << GetLogPrefix() << "requests latency:\n" << GetLatencyReport(); }
     m_filesSent.clear();
-    m_outputBuffer.clear();
+    m_framer.Clear();
     m_state = kUnInitialized;
     m_initializeRequestID = wxNOT_FOUND;
     m_Queue.Clear();
     m_lastCompletionRequestId = wxNOT_FOUND;
+    m_textDocumentSyncKind = kTextDocumentSyncFull;
+    m_documents.clear();
     // Destory the current connection
     m_network->Close();
 }
@@ -286,19 +307,8 @@ void LanguageServerProtocol::FindDefinition(IEditor* editor)
     CHECK_PTR_RET(editor);
     CHECK_COND_RET(ShouldHandleFile(editor));
 
-    // If the editor is modified, we need to tell the LSP to reparse the source file
-    const wxFileName& filename = editor->GetFileName();
-    if(m_filesSent.count(filename.GetFullPath()) && editor->IsModified()) {
-        // we already sent this file over, ask for change parse
-        std::string fileContent;
-        editor->GetEditorTextRaw(fileContent);
-        SendChangeRequest(filename, fileContent);
-
-    } else if(m_filesSent.count(filename.GetFullPath()) == 0) {
-        std::string fileContent;
-        editor->GetEditorTextRaw(fileContent);
-        SendOpenRequest(filename, fileContent, GetLanguageId(filename));
-    }
+    // Make sure the server is up to date with the editor content
+    DoSyncEditor(editor);
 
     LSP::GotoDefinitionRequest::Ptr_t req = LSP::MessageWithParams::MakeRequest(new LSP::GotoDefinitionRequest(
         editor->GetFileName(), editor->GetCurrentLine(), editor->GetCtrl()->GetColumn(editor->GetCurrentPosition())));
@@ -314,6 +324,7 @@ void LanguageServerProtocol::SendOpenRequest(const wxFileName& filename, const s
     req->SetStatusMessage(wxString() << GetLogPrefix() << " parsing file: " << filename.GetFullName());
 #endif
     QueueMessage(req);
+    if(IsInitialized()) { m_filesSent.insert(filename.GetFullPath()); }
 }
 
 void LanguageServerProtocol::SendCloseRequest(const wxFileName& filename)
@@ -327,10 +338,14 @@ void LanguageServerProtocol::SendCloseRequest(const wxFileName& filename)
         LSP::MessageWithParams::MakeRequest(new LSP::DidCloseTextDocumentRequest(filename));
     QueueMessage(req);
     m_filesSent.erase(filename.GetFullPath());
+    DoUntrackEditor(filename);
 }
 
 void LanguageServerProtocol::SendChangeRequest(const wxFileName& filename, const std::string& fileContent)
 {
+    // the server does not want to be told about changes
+    if(m_textDocumentSyncKind == kTextDocumentSyncNone) { return; }
+
     LSP::DidChangeTextDocumentRequest::Ptr_t req =
         LSP::MessageWithParams::MakeRequest(new LSP::DidChangeTextDocumentRequest(filename, fileContent));
 #ifndef __WXOSX__
@@ -339,6 +354,45 @@ void LanguageServerProtocol::SendChangeRequest(const wxFileName& filename, const
     QueueMessage(req);
 }
 
+void LanguageServerProtocol::SendChangeRequest(IEditor* editor, bool modifiedOnly)
+{
+    if(m_textDocumentSyncKind == kTextDocumentSyncNone) { return; }
+
+    const wxFileName& filename = editor->GetFileName();
+    auto iter = m_documents.find(filename.GetFullPath());
+    if(m_textDocumentSyncKind == kTextDocumentSyncIncremental && iter != m_documents.end() &&
+       !iter->second.fullSyncNeeded) {
+        DocumentChanges& doc = iter->second;
+        if(doc.changes.empty()) {
+            // the server is up to date
+            return;
+        }
+        clDEBUG1() << GetLogPrefix() << "sending" << doc.changes.size() << "edits for file:" << filename.GetFullName();
+        LSP::DidChangeTextDocumentRequest::Ptr_t req =
+            LSP::MessageWithParams::MakeRequest(new LSP::DidChangeTextDocumentRequest(filename, doc.changes));
+#ifndef __WXOSX__
+        req->SetStatusMessage(wxString() << GetLogPrefix() << " re-parsing file: " << filename.GetFullName());
+#endif
+        doc.changes.clear();
+        doc.bytes = 0;
+        QueueMessage(req);
+        return;
+    }
+
+    // Full document synchronization
+    if(modifiedOnly && !editor->IsModified() && (iter == m_documents.end() || !iter->second.fullSyncNeeded)) {
+        return;
+    }
+    if(iter != m_documents.end()) {
+        iter->second.changes.clear();
+        iter->second.bytes = 0;
+        iter->second.fullSyncNeeded = false;
+    }
+    std::string fileContent;
+    editor->GetEditorTextRaw(fileContent);
+    SendChangeRequest(filename, fileContent);
+}
+
 void LanguageServerProtocol::SendSaveRequest(const wxFileName& filename, const std::string& fileContent)
 {
     // LSP::DidSaveTextDocumentRequest req(filename, fileContent);
@@ -382,10 +436,23 @@ void LanguageServerProtocol::OnFileSaved(clCommandEvent& event)
     IEditor* editor = clGetManager()->GetActiveEditor();
     CHECK_PTR_RET(editor);
     if(ShouldHandleFile(editor)) {
-        std::string fileContent;
-        editor->GetEditorTextRaw(fileContent);
-        SendSaveRequest(editor->GetFileName(), fileContent);
+        if(m_filesSent.count(editor->GetFileName().GetFullPath())) {
+            SendChangeRequest(editor, false);
+        } else {
+            std::string fileContent;
+            editor->GetEditorTextRaw(fileContent);
+            SendSaveRequest(editor->GetFileName(), fileContent);
+        }
+    }
+}
+
+wxString LanguageServerProtocol::GetLatencyReport() const
+{
+    wxString report;
+    for(const auto& p : m_Queue.GetLatency()) {
+        report << p.first << ": " << p.second.ToString() << "\n";
     }
+    return report;
 }
 
 wxString LanguageServerProtocol::GetLogPrefix() const { return wxString() << "[" << GetName() << "] "; }
@@ -395,16 +462,12 @@ void LanguageServerProtocol::OpenEditor(IEditor* editor)
     clDEBUG() << "OpenEditor is called for" << editor->GetFileName();
     if(!IsInitialized()) { return; }
     if(editor && ShouldHandleFile(editor)) {
-        std::string fileContent;
-        editor->GetEditorTextRaw(fileContent);
-
         if(m_filesSent.count(editor->GetFileName().GetFullPath())) {
             clDEBUG() << "OpenEditor->SendChangeRequest called for:" << editor->GetFileName().GetFullName();
-            SendChangeRequest(editor->GetFileName(), fileContent);
+            SendChangeRequest(editor, false);
         } else {
-
             clDEBUG() << "OpenEditor->SendOpenRequest called for:" << editor->GetFileName().GetFullName();
-            SendOpenRequest(editor->GetFileName(), fileContent, GetLanguageId(editor->GetFileName()));
+            DoSyncEditor(editor);
         }
     }
 }
@@ -414,18 +477,9 @@ void LanguageServerProtocol::FunctionHelp(IEditor* editor)
     // sanity
     CHECK_PTR_RET(editor);
     CHECK_COND_RET(ShouldHandleFile(editor));
-    // If the editor is modified, we need to tell the LSP to reparse the source file
+    // Make sure the server is up to date with the editor content
     const wxFileName& filename = editor->GetFileName();
-    if(m_filesSent.count(filename.GetFullPath()) && editor->IsModified()) {
-        // we already sent this file over, ask for change parse
-        std::string fileContent;
-        editor->GetEditorTextRaw(fileContent);
-        SendChangeRequest(filename, fileContent);
-    } else if(m_filesSent.count(filename.GetFullPath()) == 0) {
-        std::string fileContent;
-        editor->GetEditorTextRaw(fileContent);
-        SendOpenRequest(filename, fileContent, GetLanguageId(filename));
-    }
+    DoSyncEditor(editor);
 
     if(ShouldHandleFile(filename)) {
         LSP::SignatureHelpRequest::Ptr_t req = LSP::MessageWithParams::MakeRequest(new LSP::SignatureHelpRequest(
@@ -439,18 +493,8 @@ void LanguageServerProtocol::CodeComplete(IEditor* editor)
     // sanity
     CHECK_PTR_RET(editor);
     CHECK_COND_RET(ShouldHandleFile(editor));
-    // If the editor is modified, we need to tell the LSP to reparse the source file
-    const wxFileName& filename = editor->GetFileName();
-
-    std::string text;
-    editor->GetEditorTextRaw(text);
-
-    if(m_filesSent.count(filename.GetFullPath()) && editor->IsModified()) {
-        // we already sent this file over, ask for change parse
-        SendChangeRequest(filename, text);
-    } else if(m_filesSent.count(filename.GetFullPath()) == 0) {
-        SendOpenRequest(filename, text, GetLanguageId(filename));
-    }
+    // Make sure the server is up to date with the editor content
+    DoSyncEditor(editor);
 
     // Now request the for code completion
     SendCodeCompleteRequest(editor->GetFileName(), editor->GetCurrentLine(),
@@ -460,21 +504,22 @@ void LanguageServerProtocol::CodeComplete(IEditor* editor)
 void LanguageServerProtocol::ProcessQueue()
 {
     if(m_Queue.IsEmpty()) { return; }
-    if(m_Queue.IsWaitingReponse()) {
-        clDEBUG() << "LSP is busy, will not send message";
-        return;
-    }
-    LSP::MessageWithParams::Ptr_t req = m_Queue.Get();
     if(!IsRunning()) {
         clDEBUG() << GetLogPrefix() << "is down.";
         return;
     }
 
-    // Write the message length as string of 10 bytes
-    m_network->Send(req->ToString(m_pathConverter));
-    m_Queue.SetWaitingReponse(true);
-    m_Queue.Pop();
-    if(!req->GetStatusMessage().IsEmpty()) { clGetManager()->SetStatusMessage(req->GetStatusMessage(), 1); }
+    while(true) {
+        LSP::MessageWithParams::Ptr_t req = m_Queue.TakeNext();
+        if(!req) { break; }
+        m_network->Send(req->ToString(m_pathConverter));
+        if(!req->GetStatusMessage().IsEmpty()) { clGetManager()->SetStatusMessage(req->GetStatusMessage(), 1); }
+    }
+
+    if(!m_Queue.IsEmpty()) {
+        clDEBUG() << GetLogPrefix() << m_Queue.GetInFlightCount()
+                  << "requests are waiting for a reply, will send the next message later";
+    }
 }
 
 void LanguageServerProtocol::CloseEditor(IEditor* editor)
@@ -493,18 +538,8 @@ void LanguageServerProtocol::FindDeclaration(IEditor* editor)
         CHECK_PTR_RET(editor);
         CHECK_COND_RET(ShouldHandleFile(editor));
 
-        // If the editor is modified, we need to tell the LSP to reparse the source file
-        const wxFileName& filename = editor->GetFileName();
-        if(m_filesSent.count(filename.GetFullPath()) && editor->IsModified()) {
-            // we already sent this file over, ask for change parse
-            std::string content;
-            editor->GetEditorTextRaw(content);
-            SendChangeRequest(filename, content);
-        } else if(m_filesSent.count(filename.GetFullPath()) == 0) {
-            std::string content;
-            editor->GetEditorTextRaw(content);
-            SendOpenRequest(filename, content, GetLanguageId(filename));
-        }
+        // Make sure the server is up to date with the editor content
+        DoSyncEditor(editor);
 
         LSP::GotoDeclarationRequest::Ptr_t req = LSP::MessageWithParams::MakeRequest(
             new LSP::GotoDeclarationRequest(editor->GetFileName(), editor->GetCurrentLine(),
@@ -540,17 +575,26 @@ void LanguageServerProtocol::OnNetError(clCommandEvent& event)
 
 void LanguageServerProtocol::OnNetDataReady(clCommandEvent& event)
 {
-    clDEBUG() << GetLogPrefix() << event.GetString();
-    wxString buffer = std::move(event.GetString());
-    m_outputBuffer << buffer;
-    m_Queue.SetWaitingReponse(false);
-
-    while(true) {
-        // Did we get a complete message?
-        LSP::ResponseMessage res(m_outputBuffer, m_pathConverter);
-        if(res.IsOk()) {
+    if(!event.GetStringRaw().empty()) {
+        m_framer.Append(event.GetStringRaw().c_str(), event.GetStringRaw().length());
+    } else {
+        const wxScopedCharBuffer buffer = event.GetString().mb_str(wxConvUTF8);
+        m_framer.Append(buffer.data(), buffer.length());
+    }
+    clDEBUG1() << GetLogPrefix() << "received data." << m_framer.GetBufferedSize() << "bytes buffered";
+
+    // Process the complete messages
+    const char* payload = nullptr;
+    size_t payloadLen = 0;
+    while(m_framer.Next(payload, payloadLen)) {
+        LSP::ResponseMessage res(payload, payloadLen, m_pathConverter);
+        if(!res.IsOk()) {
+            clWARNING() << GetLogPrefix() << "received an invalid JSON message (" << payloadLen << "bytes)";
+        } else {
             if(IsInitialized()) {
-                LSP::MessageWithParams::Ptr_t msg_ptr = m_Queue.TakePendingReplyMessage(res.GetId());
+                // Messages with a "method" are sent by the server (notifications or requests), they are not replies
+                LSP::MessageWithParams::Ptr_t msg_ptr;
+                if(!res.Has("method")) { msg_ptr = m_Queue.TakePendingReplyMessage(res.GetId()); }
                 // Is this an error message?
                 if(res.Has("error")) {
                     clDEBUG() << GetLogPrefix() << "received an error message";
@@ -566,6 +610,12 @@ void LanguageServerProtocol::OnNetDataReady(clCommandEvent& event)
                     }
                     case LSP::ResponseError::kErrorCodeMethodNotFound: {
                         // User requested a mesasge which is not supported by this server
+                        if(!msg_ptr) {
+                            // a reply to a request we no longer track (timed out or cleared)
+                            clDEBUG() << GetLogPrefix() << "method not found for an unknown request ID#"
+                                      << res.GetId();
+                            break;
+                        }
                         clGetManager()->SetStatusMessage(wxString() << GetLogPrefix() << _("method: ")
                                                                     << msg_ptr->GetMethod() << _(" is not supported"));
                         m_unimplementedMethods.insert(msg_ptr->GetMethod());
@@ -595,20 +645,21 @@ void LanguageServerProtocol::OnNetDataReady(clCommandEvent& event)
                         if(editor) {
                             LSP::Request* preq = msg_ptr->As<LSP::Request>();
                             if(preq->As<LSP::CompletionRequest>() && (preq->GetId() < m_lastCompletionRequestId)) {
+                                // keep processing the other messages in the buffer
                                 clDEBUG() << "Received a response for completion message ID#" << preq->GetId()
                                           << ". However, a newer completion request with ID#"
                                           << m_lastCompletionRequestId << "was already sent. Dropping response";
-                                return;
-                            }
-                            // let the originating request to handle it
-                            const wxFileName& filename = editor->GetFileName();
-                            size_t line = editor->GetCurrentLine();
-                            size_t column = editor->GetCtrl()->GetColumn(editor->GetCurrentPosition());
-                            if(false && preq->IsPositionDependantRequest() &&
-                               !preq->IsValidAt(filename, line, column)) {
-                                clDEBUG() << "Response is no longer valid. Discarding its result";
                             } else {
-                                preq->OnResponse(res, m_owner, m_pathConverter);
+                                // let the originating request to handle it
+                                const wxFileName& filename = editor->GetFileName();
+                                size_t line = editor->GetCurrentLine();
+                                size_t column = editor->GetCtrl()->GetColumn(editor->GetCurrentPosition());
+                                if(false && preq->IsPositionDependantRequest() &&
+                                   !preq->IsValidAt(filename, line, column)) {
+                                    clDEBUG() << "Response is no longer valid. Discarding its result";
+                                } else {
+                                    preq->OnResponse(res, m_owner, m_pathConverter);
+                                }
                             }
                         }
 
@@ -644,9 +695,25 @@ void LanguageServerProtocol::OnNetDataReady(clCommandEvent& event)
                 // we only accept initialization responses here
                 if(res.GetId() == m_initializeRequestID) {
                     clDEBUG() << GetLogPrefix() << "initialization completed";
+                    m_Queue.TakePendingReplyMessage(m_initializeRequestID);
                     m_initializeRequestID = wxNOT_FOUND;
                     m_state = kInitialized;
 
+                    // "textDocumentSync" is either a TextDocumentSyncKind or a TextDocumentSyncOptions object
+                    JSONItem capabilities = res.Get("result").namedObject("capabilities");
+                    JSONItem textDocumentSync = capabilities.namedObject("textDocumentSync");
+                    if(textDocumentSync.isNumber()) {
+                        m_textDocumentSyncKind = (eTextDocumentSyncKind)textDocumentSync.toInt(kTextDocumentSyncFull);
+                    } else if(textDocumentSync.isOk() && !textDocumentSync.isNull()) {
+                        // TextDocumentSyncOptions.change defaults to None
+                        m_textDocumentSyncKind =
+                            (eTextDocumentSyncKind)textDocumentSync.namedObject("change").toInt(kTextDocumentSyncNone);
+                    }
+                    clDEBUG() << GetLogPrefix() << "document synchronization:"
+                              << (m_textDocumentSyncKind == kTextDocumentSyncIncremental
+                                      ? "incremental"
+                                      : (m_textDocumentSyncKind == kTextDocumentSyncNone ? "none" : "full"));
+
                     // Notify about this
                     LSPEvent initEvent(wxEVT_LSP_INITIALIZED);
                     initEvent.SetServerName(GetName());
@@ -655,10 +722,7 @@ void LanguageServerProtocol::OnNetDataReady(clCommandEvent& event)
                     clDEBUG() << GetLogPrefix() << "Server not initialized. This message is ignored";
                 }
             }
-            // A message was consumed from the buffer, see if we got more messages
-            if(!m_outputBuffer.empty()) { continue; }
         }
-        break;
     }
     ProcessQueue();
 }
@@ -686,18 +750,8 @@ void LanguageServerProtocol::FindImplementation(IEditor* editor)
         CHECK_PTR_RET(editor);
         CHECK_COND_RET(ShouldHandleFile(editor));
 
-        // If the editor is modified, we need to tell the LSP to reparse the source file
-        const wxFileName& filename = editor->GetFileName();
-        if(m_filesSent.count(filename.GetFullPath()) && editor->IsModified()) {
-            // we already sent this file over, ask for change parse
-            std::string content;
-            editor->GetEditorTextRaw(content);
-            SendChangeRequest(filename, content);
-        } else if(m_filesSent.count(filename.GetFullPath()) == 0) {
-            std::string content;
-            editor->GetEditorTextRaw(content);
-            SendOpenRequest(filename, content, GetLanguageId(filename));
-        }
+        // Make sure the server is up to date with the editor content
+        DoSyncEditor(editor);
 
         LSP::GotoImplementationRequest::Ptr_t req = LSP::MessageWithParams::MakeRequest(
             new LSP::GotoImplementationRequest(editor->GetFileName(), editor->GetCurrentLine(),
@@ -708,45 +762,233 @@ void LanguageServerProtocol::FindImplementation(IEditor* editor)
 
 wxString LanguageServerProtocol::GetLanguageId(const wxFileName& fn) { return GetLanguageId(fn.GetFullPath()); }
 
+void LanguageServerProtocol::DoSyncEditor(IEditor* editor)
+{
+    const wxFileName& filename = editor->GetFileName();
+    if(m_filesSent.count(filename.GetFullPath())) {
+        // we already sent this file over, send the changes made since
+        SendChangeRequest(editor, true);
+        return;
+    }
+
+    std::string fileContent;
+    editor->GetEditorTextRaw(fileContent);
+    SendOpenRequest(filename, fileContent, GetLanguageId(filename));
+    if(m_filesSent.count(filename.GetFullPath())) { DoTrackEditor(editor); }
+}
+
+void LanguageServerProtocol::DoTrackEditor(IEditor* editor)
+{
+    wxStyledTextCtrl* ctrl = editor->GetCtrl();
+    CHECK_PTR_RET(ctrl);
+
+    // the server now has the content of the editor, start recording the edits from here
+    wxString fullpath = editor->GetFileName().GetFullPath();
+    DoUntrackEditor(ctrl);
+    DocumentChanges& doc = m_documents[fullpath];
+    doc.ctrl = ctrl;
+    doc.changes.clear();
+    doc.bytes = 0;
+    doc.fullSyncNeeded = false;
+
+    // avoid binding twice (the binding is removed by wx when either side is destroyed)
+    ctrl->Unbind(wxEVT_STC_MODIFIED, &LanguageServerProtocol::OnEditorModified, this);
+    ctrl->Bind(wxEVT_STC_MODIFIED, &LanguageServerProtocol::OnEditorModified, this);
+}
+
+void LanguageServerProtocol::DoUntrackEditor(const wxFileName& filename)
+{
+    // the editor might already be destroyed, so only forget about it
+    m_documents.erase(filename.GetFullPath());
+}
+
+void LanguageServerProtocol::DoUntrackEditor(wxStyledTextCtrl* ctrl)
+{
+    // The address of a destroyed editor may be reused by a new one: make sure its edits are not recorded for the
+    // document of the old one
+    for(auto iter = m_documents.begin(); iter != m_documents.end();) {
+        if(iter->second.ctrl == ctrl) {
+            iter = m_documents.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+}
+
+void LanguageServerProtocol::OnEditorClosing(wxCommandEvent& event)
+{
+    event.Skip();
+    IEditor* editor = reinterpret_cast<IEditor*>(event.GetClientData());
+    if(editor) { DoUntrackEditor(editor->GetCtrl()); }
+}
+
+/**
+ * @brief convert a Scintilla position into LSP position. LSP columns are counted in UTF-16 code units
+ */
+static LSP::Position ToLSPPosition(wxStyledTextCtrl* ctrl, int pos)
+{
+    int line = ctrl->LineFromPosition(pos);
+    int lineStart = ctrl->PositionFromLine(line);
+    int character = 0;
+    if(pos > lineStart) {
+        wxString prefix = ctrl->GetTextRange(lineStart, pos);
+        for(wxUniChar ch : prefix) {
+            character += (ch.GetValue() > 0xFFFF) ? 2 : 1;
+        }
+    }
+    return LSP::Position(line, character);
+}
+
+void LanguageServerProtocol::OnEditorModified(wxStyledTextEvent& event)
+{
+    event.Skip();
+    if(m_textDocumentSyncKind != kTextDocumentSyncIncremental) { return; }
+
+    wxStyledTextCtrl* ctrl = dynamic_cast<wxStyledTextCtrl*>(event.GetEventObject());
+    auto iter = m_documents.begin();
+    while(iter != m_documents.end() && iter->second.ctrl != ctrl) {
+        ++iter;
+    }
+    if(iter == m_documents.end() || iter->second.fullSyncNeeded) { return; }
+
+    // Edits are recorded in the order they happen, each range is relative to the document after the previous edit.
+    // Deletions are recorded before they happen so the range end is still part of the document
+    LSP::TextDocumentContentChangeEvent change;
+    int type = event.GetModificationType();
+    if(type & wxSTC_MOD_INSERTTEXT) {
+        LSP::Position start = ToLSPPosition(ctrl, event.GetPosition());
+        change.SetRange(LSP::Range(start, start));
+        change.SetText(event.GetText().mb_str(wxConvUTF8).data());
+
+    } else if(type & wxSTC_MOD_BEFOREDELETE) {
+        change.SetRange(LSP::Range(ToLSPPosition(ctrl, event.GetPosition()),
+                                   ToLSPPosition(ctrl, event.GetPosition() + event.GetLength())));
+    } else {
+        return;
+    }
+
+    DocumentChanges& doc = iter->second;
+    doc.bytes += change.GetText().length();
+    doc.changes.push_back(change);
+    if(doc.changes.size() > LSP_MAX_PENDING_EDITS || doc.bytes > LSP_MAX_PENDING_EDITS_BYTES) {
+        // too many edits (e.g. the file was reloaded or replaced), sending the whole content is cheaper
+        doc.changes.clear();
+        doc.bytes = 0;
+        doc.fullSyncNeeded = true;
+    }
+}
+
 //===------------------------------------------------------------------
 // LSPRequestMessageQueue
 //===------------------------------------------------------------------
 
-void LSPRequestMessageQueue::Push(LSP::MessageWithParams::Ptr_t message)
-{
-    m_Queue.push(message);
+const size_t LSPRequestMessageQueue::LatencyHistogram::kBuckets[] = { 10, 25, 50, 100, 250, 500, 1000, (size_t)-1 };
 
-    // Messages of type 'Request' require responses from the server
-    LSP::Request* req = message->As<LSP::Request>();
-    if(req) { m_pendingReplyMessages.insert({ req->GetId(), message }); }
+void LSPRequestMessageQueue::LatencyHistogram::Add(double ms)
+{
+    size_t i = 0;
+    while(i < (kBucketsCount - 1) && ms > kBuckets[i]) {
+        ++i;
+    }
+    ++counts[i];
+    ++total;
+    totalMs += ms;
+    maxMs = wxMax(maxMs, ms);
 }
 
-void LSPRequestMessageQueue::Pop()
+wxString LSPRequestMessageQueue::LatencyHistogram::ToString() const
 {
-    if(!m_Queue.empty()) { m_Queue.pop(); }
-    SetWaitingReponse(false);
+    wxString s;
+    s << "count: " << total << ", avg: " << wxString::Format("%.1f", total ? (totalMs / total) : 0.0)
+      << "ms, max: " << wxString::Format("%.1f", maxMs) << "ms, cancelled: " << cancelled << " [";
+    for(size_t i = 0; i < kBucketsCount; ++i) {
+        if(i) { s << ", "; }
+        if(i == (kBucketsCount - 1)) {
+            s << ">" << kBuckets[i - 1] << "ms: " << counts[i];
+        } else {
+            s << "<=" << kBuckets[i] << "ms: " << counts[i];
+        }
+    }
+    s << "]";
+    return s;
 }
 
-LSP::MessageWithParams::Ptr_t LSPRequestMessageQueue::Get()
+void LSPRequestMessageQueue::Push(LSP::MessageWithParams::Ptr_t message) { m_Queue.push_back(message); }
+
+LSP::MessageWithParams::Ptr_t LSPRequestMessageQueue::TakeNext()
 {
     if(m_Queue.empty()) { return LSP::MessageWithParams::Ptr_t(nullptr); }
-    return m_Queue.front();
+
+    bool canSendRequest = true;
+    if(m_pendingReplyMessages.size() >= m_maxInFlight) {
+        // Forget about requests that never got a reply, so they don't block the pipeline forever
+        Clock_t::time_point now = Clock_t::now();
+        for(auto iter = m_pendingReplyMessages.begin(); iter != m_pendingReplyMessages.end();) {
+            if((now - iter->second.sentAt) > std::chrono::seconds(LSP_REQUEST_TIMEOUT_SECONDS)) {
+                clWARNING() << "LSP: no reply for request" << iter->second.message->GetMethod() << "ID#"
+                            << iter->first << "dropping it";
+                iter = m_pendingReplyMessages.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+        canSendRequest = m_pendingReplyMessages.size() < m_maxInFlight;
+    }
+
+    // The server must see the messages in the order they were queued: a notification (e.g. didChange) may not
+    // overtake a request that was queued before it against the previous document version. A notification does not
+    // take room in the pipeline though, so it is not held back by the requests that are waiting for a reply
+    LSP::MessageWithParams::Ptr_t message = m_Queue.front();
+    LSP::Request* req = message->As<LSP::Request>();
+    if(req) {
+        if(!canSendRequest) { return LSP::MessageWithParams::Ptr_t(nullptr); }
+
+        // Messages of type 'Request' require responses from the server
+        InFlight& inflight = m_pendingReplyMessages[req->GetId()];
+        inflight.message = message;
+        inflight.sentAt = Clock_t::now();
+    }
+    m_Queue.erase(m_Queue.begin());
+    return message;
 }
 
-void LSPRequestMessageQueue::Clear()
+std::vector<int> LSPRequestMessageQueue::CancelCompletionRequests(int exceptId)
 {
-    while(!m_Queue.empty()) {
-        m_Queue.pop();
+    auto isSuperseded = [&](const LSP::MessageWithParams::Ptr_t& message) {
+        LSP::CompletionRequest* req = message->As<LSP::CompletionRequest>();
+        return req && req->GetId() != exceptId;
+    };
+
+    // Not sent yet, simply remove them
+    m_Queue.erase(std::remove_if(m_Queue.begin(), m_Queue.end(), isSuperseded), m_Queue.end());
+
+    // Already sent: the server will reply to them anyway, keep them in the in-flight list until it does
+    std::vector<int> ids;
+    for(auto& p : m_pendingReplyMessages) {
+        if(!p.second.cancelled && isSuperseded(p.second.message)) {
+            p.second.cancelled = true;
+            ids.push_back(p.first);
+        }
     }
-    SetWaitingReponse(false);
+    return ids;
+}
+
+void LSPRequestMessageQueue::Clear()
+{
+    m_Queue.clear();
     m_pendingReplyMessages.clear();
 }
 
 LSP::MessageWithParams::Ptr_t LSPRequestMessageQueue::TakePendingReplyMessage(int msgid)
 {
-    if(m_pendingReplyMessages.empty()) { return LSP::MessageWithParams::Ptr_t(nullptr); }
-    if(m_pendingReplyMessages.count(msgid) == 0) { return LSP::MessageWithParams::Ptr_t(nullptr); }
-    LSP::MessageWithParams::Ptr_t msgptr = m_pendingReplyMessages[msgid];
-    m_pendingReplyMessages.erase(msgid);
+    auto iter = m_pendingReplyMessages.find(msgid);
+    if(iter == m_pendingReplyMessages.end()) { return LSP::MessageWithParams::Ptr_t(nullptr); }
+
+    LSP::MessageWithParams::Ptr_t msgptr = iter->second.message;
+    double ms = std::chrono::duration<double, std::milli>(Clock_t::now() - iter->second.sentAt).count();
+    LatencyHistogram& histogram = m_latency[msgptr->GetMethod()];
+    histogram.Add(ms);
+    if(iter->second.cancelled) { ++histogram.cancelled; }
+    m_pendingReplyMessages.erase(iter);
     return msgptr;
 }
@@ -2,6 +2,8 @@
 #define LANGUAG_ESERVER_PROTOCOL_H
 
 #include "LSP/IPathConverter.hpp"
+#include "LSP/MessageFramer.h"
+#include "LSP/basic_types.h"
 #include "LSP/MessageWithParams.h"
 #include "LSPNetwork.h"
 #include "ServiceProvider.h"
@@ -10,33 +12,87 @@
 #include "cl_command_event.h"
 #include "codelite_exports.h"
 #include "macros.h"
+#include <chrono>
+#include <deque>
 #include <map>
-#include <queue>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <wx/filename.h>
 #include <wx/sharedptr.h>
 #include <wxStringHash.h>
 
 class IEditor;
+class wxStyledTextCtrl;
+class wxStyledTextEvent;
+/**
+ * @class LSPRequestMessageQueue
+ * @brief the outgoing JSON-RPC pipeline. Requests are sent in the order they were queued, as long as there are less
+ * than GetMaxInFlight() requests waiting for a reply. Notifications keep their place in the queue but don't need room
+ * in the pipeline. Replies are matched to their request by id
+ */
 class WXDLLIMPEXP_SDK LSPRequestMessageQueue
 {
-    std::queue<LSP::MessageWithParams::Ptr_t> m_Queue;
-    std::unordered_map<int, LSP::MessageWithParams::Ptr_t> m_pendingReplyMessages;
-    bool m_waitingReponse = false;
+public:
+    /**
+     * @brief request round-trip times histogram (per method)
+     */
+    struct LatencyHistogram {
+        static const size_t kBucketsCount = 8;
+        static const size_t kBuckets[kBucketsCount]; // upper bound of each bucket in milliseconds
+
+        size_t counts[kBucketsCount] = {};
+        size_t total = 0;
+        size_t cancelled = 0;
+        double totalMs = 0.0;
+        double maxMs = 0.0;
+
+        void Add(double ms);
+        wxString ToString() const;
+    };
+    typedef std::map<wxString, LatencyHistogram> LatencyMap_t;
+
+protected:
+    typedef std::chrono::steady_clock Clock_t;
+    struct InFlight {
+        LSP::MessageWithParams::Ptr_t message;
+        Clock_t::time_point sentAt;
+        bool cancelled = false;
+    };
+
+    std::deque<LSP::MessageWithParams::Ptr_t> m_Queue;
+    std::unordered_map<int, InFlight> m_pendingReplyMessages; // requests that were sent, waiting for a reply
+    size_t m_maxInFlight = 8;
+    LatencyMap_t m_latency;
 
 public:
     LSPRequestMessageQueue() {}
     virtual ~LSPRequestMessageQueue() {}
 
+    /**
+     * @brief remove the request matching a reply from the in-flight list and record its latency
+     */
     LSP::MessageWithParams::Ptr_t TakePendingReplyMessage(int msgid);
     void Push(LSP::MessageWithParams::Ptr_t message);
-    void Pop();
-    LSP::MessageWithParams::Ptr_t Get();
+
+    /**
+     * @brief return the next message that can be sent now (null if none). Requests returned by this method are
+     * considered in-flight until TakePendingReplyMessage() is called with their id
+     */
+    LSP::MessageWithParams::Ptr_t TakeNext();
+
+    /**
+     * @brief a new completion request supersedes any older one: remove the completion requests that were not sent
+     * yet and return the ids of the ones in-flight so they can be cancelled
+     */
+    std::vector<int> CancelCompletionRequests(int exceptId);
+
     void Clear();
     bool IsEmpty() const { return m_Queue.empty(); }
-    void SetWaitingReponse(bool waitingReponse) { this->m_waitingReponse = waitingReponse; }
-    bool IsWaitingReponse() const { return m_waitingReponse; }
+    size_t GetInFlightCount() const { return m_pendingReplyMessages.size(); }
+    void SetMaxInFlight(size_t maxInFlight) { this->m_maxInFlight = maxInFlight; }
+    size_t GetMaxInFlight() const { return m_maxInFlight; }
+    const LatencyMap_t& GetLatency() const { return m_latency; }
 };
 
 class WXDLLIMPEXP_SDK LanguageServerProtocol : public ServiceProvider
@@ -46,6 +102,22 @@ class WXDLLIMPEXP_SDK LanguageServerProtocol : public ServiceProvider
         kInitialized,
     };
 
+    // TextDocumentSyncKind, as reported by the server
+    enum eTextDocumentSyncKind {
+        kTextDocumentSyncNone = 0,
+        kTextDocumentSyncFull = 1,
+        kTextDocumentSyncIncremental = 2,
+    };
+
+    // The edits made to an opened document since it was last synchronised with the server
+    struct DocumentChanges {
+        wxStyledTextCtrl* ctrl = nullptr; // the editor recording the edits, only used for lookups
+
+        std::vector<LSP::TextDocumentContentChangeEvent> changes;
+        size_t bytes = 0;
+        bool fullSyncNeeded = false;
+    };
+
     wxString m_name;
     wxEvtHandler* m_owner = nullptr;
     LSPNetwork::Ptr_t m_network;
@@ -53,7 +125,7 @@ class WXDLLIMPEXP_SDK LanguageServerProtocol : public ServiceProvider
     wxString m_workingDirectory;
     wxStringSet_t m_filesSent;
     wxStringSet_t m_languages;
-    wxString m_outputBuffer;
+    LSP::MessageFramer m_framer;
     wxString m_rootFolder;
     wxString m_connectionString;
     IPathConverter::Ptr_t m_pathConverter;
@@ -68,6 +140,8 @@ class WXDLLIMPEXP_SDK LanguageServerProtocol : public ServiceProvider
     wxStringSet_t m_unimplementedMethods;
     bool m_disaplayDiagnostics = true;
     int m_lastCompletionRequestId = wxNOT_FOUND;
+    eTextDocumentSyncKind m_textDocumentSyncKind = kTextDocumentSyncFull;
+    std::unordered_map<wxString, DocumentChanges> m_documents; // keyed by the document full path
 
 public:
     typedef wxSharedPtr<LanguageServerProtocol> Ptr_t;
@@ -86,6 +160,8 @@ protected:
     void OnFindSymbolImpl(clCodeCompletionEvent& event);
     void OnFindSymbol(clCodeCompletionEvent& event);
     void OnFunctionCallTip(clCodeCompletionEvent& event);
+    void OnEditorModified(wxStyledTextEvent& event);
+    void OnEditorClosing(wxCommandEvent& event);
 
 protected:
     void DoClear();
@@ -96,6 +172,15 @@ protected:
     static wxString GetLanguageId(const wxFileName& fn);
     static wxString GetLanguageId(const wxString& fn);
 
+    /**
+     * @brief make sure that the server has the latest content of the editor: open the document or send the changes
+     * made since the last synchronization
+     */
+    void DoSyncEditor(IEditor* editor);
+    void DoTrackEditor(IEditor* editor);
+    void DoUntrackEditor(const wxFileName& filename);
+    void DoUntrackEditor(wxStyledTextCtrl* ctrl);
+
 protected:
     /**
      * @brief notify about file open
@@ -112,6 +197,13 @@ protected:
      */
     void SendChangeRequest(const wxFileName& filename, const std::string& fileContent);
 
+    /**
+     * @brief report a file-changed notification for an opened editor. When the server supports incremental
+     * synchronization, only the edits made since the last synchronization are sent. Otherwise the entire content is
+     * sent (when 'modifiedOnly' is true, only if the editor is modified)
+     */
+    void SendChangeRequest(IEditor* editor, bool modifiedOnly);
+
     /**
      * @brief report a file-save notification
      */
@@ -157,6 +249,16 @@ public:
     const wxString& GetName() const { return m_name; }
     bool IsInitialized() const { return (m_state == kInitialized); }
 
+    /**
+     * @brief return the request latency histograms, per method
+     */
+    const LSPRequestMessageQueue::LatencyMap_t& GetLatencyStats() const { return m_Queue.GetLatency(); }
+
+    /**
+     * @brief return a printable report of the request latencies
+     */
+    wxString GetLatencyReport() const;
+
     /**
      * @brief return list of all supported languages by LSP. The list contains the abbreviation entry and a description
      */
@@ -24,12 +24,250 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include "clDTL.h"
-#include "dtl/dtl.hpp"
+#include <climits>
+#include <unordered_map>
 #include <wx/ffile.h>
-#include <wx/tokenzr.h>
 #include <wx/utils.h>
+#include "wxStringHash.h"
+
+namespace
+{
+enum eSesType { SES_DELETE = -1, SES_COMMON = 0, SES_ADD = 1 };
+
+/**
+ * @class LinearSpaceDiff
+ * @brief Myers' O(ND) difference algorithm, in its linear space (divide and conquer) variant. Lines are compared as
+ * integers. Like GNU diff, the search for the middle snake gives up on an optimal result when it becomes too
+ * expensive and splits the range at the furthest point reached so far
+ */
+class LinearSpaceDiff
+{
+    const std::vector<int>& m_a;
+    const std::vector<int>& m_b;
+    std::vector<char>& m_deleted;
+    std::vector<char>& m_inserted;
+    std::vector<int> m_fdiag;
+    std::vector<int> m_bdiag;
+    int m_offset;
+    int m_tooExpensive;
+    const std::atomic_bool* m_cancel;
+
+    int& Fd(int d) { return m_fdiag[d + m_offset]; }
+    int& Bd(int d) { return m_bdiag[d + m_offset]; }
+    bool IsCancelled() const { return m_cancel && m_cancel->load(); }
+
+    /**
+     * @brief find the point where a shortest edit script of a[xoff, xlim) and b[yoff, ylim) crosses its middle
+     * diagonal. Both ranges are non empty and their first and last elements differ
+     */
+    bool Split(int xoff, int xlim, int yoff, int ylim, int& xmid, int& ymid)
+    {
+        const int dmin = xoff - ylim;
+        const int dmax = xlim - yoff;
+        const int fmid = xoff - yoff;
+        const int bmid = xlim - ylim;
+        int fmin = fmid, fmax = fmid;
+        int bmin = bmid, bmax = bmid;
+        const bool odd = (fmid - bmid) & 1;
+
+        Fd(fmid) = xoff;
+        Bd(bmid) = xlim;
+
+        for(int c = 1;; ++c) {
+            if((c & 0xFF) == 0 && IsCancelled()) { return false; }
+
+            // Extend the forward search by one edit
+            if(fmin > dmin) {
+                Fd(--fmin - 1) = -1;
+            } else {
+                ++fmin;
+            }
+            if(fmax < dmax) {
+                Fd(++fmax + 1) = -1;
+            } else {
+                --fmax;
+            }
+            for(int d = fmax; d >= fmin; d -= 2) {
+                int tlo = Fd(d - 1);
+                int thi = Fd(d + 1);
+                int x = (tlo >= thi) ? tlo + 1 : thi;
+                int y = x - d;
+                while(x < xlim && y < ylim && m_a[x] == m_b[y]) {
+                    ++x;
+                    ++y;
+                }
+                Fd(d) = x;
+                if(odd && bmin <= d && d <= bmax && Bd(d) <= x) {
+                    xmid = x;
+                    ymid = y;
+                    return true;
+                }
+            }
+
+            // Extend the backward search by one edit
+            if(bmin > dmin) {
+                Bd(--bmin - 1) = INT_MAX;
+            } else {
+                ++bmin;
+            }
+            if(bmax < dmax) {
+                Bd(++bmax + 1) = INT_MAX;
+            } else {
+                --bmax;
+            }
+            for(int d = bmax; d >= bmin; d -= 2) {
+                int tlo = Bd(d - 1);
+                int thi = Bd(d + 1);
+                int x = (tlo < thi) ? tlo : thi - 1;
+                int y = x - d;
+                while(x > xoff && y > yoff && m_a[x - 1] == m_b[y - 1]) {
+                    --x;
+                    --y;
+                }
+                Bd(d) = x;
+                if(!odd && fmin <= d && d <= fmax && x <= Fd(d)) {
+                    xmid = x;
+                    ymid = y;
+                    return true;
+                }
+            }
+
+            if(c >= m_tooExpensive) {
+                // Settle for the point that got the furthest, in either direction
+                int fxybest = -1, fxbest = xoff;
+                for(int d = fmax; d >= fmin; d -= 2) {
+                    int x = wxMin(Fd(d), xlim);
+                    int y = x - d;
+                    if(ylim < y) {
+                        x = ylim + d;
+                        y = ylim;
+                    }
+                    if(fxybest < x + y) {
+                        fxybest = x + y;
+                        fxbest = x;
+                    }
+                }
+
+                int bxybest = INT_MAX, bxbest = xlim;
+                for(int d = bmax; d >= bmin; d -= 2) {
+                    int x = wxMax(xoff, Bd(d));
+                    int y = x - d;
+                    if(y < yoff) {
+                        x = yoff + d;
+                        y = yoff;
+                    }
+                    if(x + y < bxybest) {
+                        bxybest = x + y;
+                        bxbest = x;
+                    }
+                }
+
+                if((xlim + ylim) - bxybest < fxybest - (xoff + yoff)) {
+                    xmid = fxbest;
+                    ymid = fxybest - fxbest;
+                } else {
+                    xmid = bxbest;
+                    ymid = bxybest - bxbest;
+                }
+                return true;
+            }
+        }
+    }
+
+    void Compare(int xoff, int xlim, int yoff, int ylim)
+    {
+        // Skip the common prefix and suffix
+        while(xoff < xlim && yoff < ylim && m_a[xoff] == m_b[yoff]) {
+            ++xoff;
+            ++yoff;
+        }
+        while(xlim > xoff && ylim > yoff && m_a[xlim - 1] == m_b[ylim - 1]) {
+            --xlim;
+            --ylim;
+        }
+
+        if(xoff == xlim) {
+            for(int y = yoff; y < ylim; ++y) {
+                m_inserted[y] = 1;
+            }
+        } else if(yoff == ylim) {
+            for(int x = xoff; x < xlim; ++x) {
+                m_deleted[x] = 1;
+            }
+        } else {
+            int xmid = xoff, ymid = yoff;
+            if(!Split(xoff, xlim, yoff, ylim, xmid, ymid)) { return; }
+            if((xmid == xoff && ymid == yoff) || (xmid == xlim && ymid == ylim)) {
+                // No progress, replace the whole range
+                for(int x = xoff; x < xlim; ++x) {
+                    m_deleted[x] = 1;
+                }
+                for(int y = yoff; y < ylim; ++y) {
+                    m_inserted[y] = 1;
+                }
+                return;
+            }
+            Compare(xoff, xmid, yoff, ymid);
+            Compare(xmid, xlim, ymid, ylim);
+        }
+    }
+
+public:
+    LinearSpaceDiff(const std::vector<int>& a, const std::vector<int>& b, std::vector<char>& deleted,
+                    std::vector<char>& inserted, const std::atomic_bool* cancel)
+        : m_a(a)
+        , m_b(b)
+        , m_deleted(deleted)
+        , m_inserted(inserted)
+        , m_cancel(cancel)
+    {
+        size_t diags = a.size() + b.size() + 3;
+        m_fdiag.resize(diags);
+        m_bdiag.resize(diags);
+        m_offset = b.size() + 1;
+
+        // Roughly the square root of the input size, but not less than 4096
+        m_tooExpensive = 1;
+        for(; diags != 0; diags >>= 2) {
+            m_tooExpensive <<= 1;
+        }
+        m_tooExpensive = wxMax(4096, m_tooExpensive);
+    }
+
+    void Run()
+    {
+        m_deleted.assign(m_a.size(), 0);
+        m_inserted.assign(m_b.size(), 0);
+        Compare(0, m_a.size(), 0, m_b.size());
+    }
+};
+
+// Split 'content' into lines, keeping the line terminators
+void SplitLines(const wxString& content, std::vector<wxString>& lines)
+{
+    size_t start = 0;
+    while(start < content.length()) {
+        size_t eol = content.find('\n', start);
+        size_t end = (eol == wxString::npos) ? content.length() : eol + 1;
+        lines.push_back(content.Mid(start, end - start));
+        start = end;
+    }
+}
+
+// Map each line to an integer, identical lines share the same integer
+void HashLines(const std::vector<wxString>& lines, std::unordered_map<wxString, int>& ids, std::vector<int>& hashes)
+{
+    hashes.reserve(lines.size());
+    for(size_t i = 0; i < lines.size(); ++i) {
+        std::pair<std::unordered_map<wxString, int>::iterator, bool> where =
+            ids.insert(std::make_pair(lines[i], (int)ids.size()));
+        hashes.push_back(where.first->second);
+    }
+}
+} // namespace
 
 clDTL::clDTL()
+    : m_cancel(NULL)
 {
 }
 
@@ -57,22 +295,53 @@ void clDTL::Diff(const wxFileName& fnLeft, const wxFileName& fnRight, DiffMode m
     m_resultRight.clear();
     m_sequences.clear();
 
-    typedef wxString elem;
-    typedef std::pair<elem, dtl::elemInfo> sesElem;
+    std::vector<wxString> leftLines, rightLines;
+    SplitLines(leftFile, leftLines);
+    SplitLines(rightFile, rightLines);
+    leftFile.clear();
+    rightFile.clear();
 
-    wxArrayString leftLines = wxStringTokenize(leftFile, "\n", wxTOKEN_RET_DELIMS);
-    wxArrayString rightLines = wxStringTokenize(rightFile, "\n", wxTOKEN_RET_DELIMS);
+    std::vector<int> leftHashes, rightHashes;
+    {
+        std::unordered_map<wxString, int> ids;
+        HashLines(leftLines, ids, leftHashes);
+        HashLines(rightLines, ids, rightHashes);
+    }
 
-    std::vector<elem> leftLinesVec;
-    std::vector<elem> rightLinesVec;
-    leftLinesVec.insert(leftLinesVec.end(), leftLines.begin(), leftLines.end());
-    rightLinesVec.insert(rightLinesVec.end(), rightLines.begin(), rightLines.end());
+    std::vector<char> deleted, inserted;
+    LinearSpaceDiff diff(leftHashes, rightHashes, deleted, inserted, m_cancel);
+    diff.Run();
+    if ( m_cancel && m_cancel->load() )
+        return;
+
+    // Build the edit script: <type, line>
+    typedef std::pair<int, const wxString*> sesElem;
+    std::vector<sesElem> seq;
+    seq.reserve( wxMax(leftLines.size(), rightLines.size()) );
+    size_t editDistance = 0;
+    size_t l = 0, r = 0;
+    while ( l < leftLines.size() || r < rightLines.size() ) {
+        if ( l < leftLines.size() && r < rightLines.size() && !deleted[l] && !inserted[r] ) {
+            seq.push_back( std::make_pair((int)SES_COMMON, &leftLines[l]) );
+            ++l;
+            ++r;
+            continue;
+        }
 
-    dtl::Diff<elem, std::vector<elem> > diff(leftLinesVec, rightLinesVec);
-    diff.onHuge();
-    diff.compose();
+        size_t before = editDistance;
+        for(; l < leftLines.size() && deleted[l]; ++l, ++editDistance) {
+            seq.push_back( std::make_pair((int)SES_DELETE, &leftLines[l]) );
+        }
+        for(; r < rightLines.size() && inserted[r]; ++r, ++editDistance) {
+            seq.push_back( std::make_pair((int)SES_ADD, &rightLines[r]) );
+        }
+        if ( before == editDistance ) {
+            // can't happen
+            break;
+        }
+    }
 
-    if ( 0 == diff.getEditDistance() ) {
+    if ( 0 == editDistance ) {
         // nothing to be done - files are identical
         return;
     }
@@ -86,7 +355,6 @@ void clDTL::Diff(const wxFileName& fnLeft, const wxFileName& fnRight, DiffMode m
         ///////////////////////////////////////////////////////////////////
 
         // Loop over the diff and check if it is a whitespace only diff
-        std::vector<sesElem> seq = diff.getSes().getSequence();
         m_resultLeft.reserve( seq.size() );
         m_resultRight.reserve( seq.size() );
 
@@ -101,8 +369,8 @@ void clDTL::Diff(const wxFileName& fnLeft, const wxFileName& fnRight, DiffMode m
         LineInfoVec_t tmpSeqRight;
 
         for(size_t i=0; i<seq.size(); ++i) {
-            switch(seq.at(i).second.type) {
-            case dtl::SES_COMMON: {
+            switch(seq.at(i).first) {
+            case SES_COMMON: {
                 if ( state == STATE_IN_SEQ ) {
 
                     // set the sequence size
@@ -123,14 +391,14 @@ void clDTL::Diff(const wxFileName& fnLeft, const wxFileName& fnRight, DiffMode m
                     tmpSeqRight.clear();
                     seqSize = 0;
                 }
-                clDTL::LineInfo line(seq.at(i).first, LINE_COMMON);
+                clDTL::LineInfo line(*seq.at(i).second, LINE_COMMON);
                 m_resultLeft.push_back( line );
                 m_resultRight.push_back( line );
                 break;
 
             }
-            case dtl::SES_ADD: {
-                clDTL::LineInfo lineRight(seq.at(i).first, LINE_ADDED);
+            case SES_ADD: {
+                clDTL::LineInfo lineRight(*seq.at(i).second, LINE_ADDED);
                 tmpSeqRight.push_back( lineRight );
 
                 if ( state == STATE_NONE ) {
@@ -140,8 +408,8 @@ void clDTL::Diff(const wxFileName& fnLeft, const wxFileName& fnRight, DiffMode m
                 break;
 
             }
-            case dtl::SES_DELETE: {
-                clDTL::LineInfo lineLeft(seq.at(i).first, LINE_REMOVED);
+            case SES_DELETE: {
+                clDTL::LineInfo lineLeft(*seq.at(i).second, LINE_REMOVED);
                 tmpSeqLeft.push_back( lineLeft );
 
                 if ( state == STATE_NONE ) {
@@ -178,34 +446,33 @@ void clDTL::Diff(const wxFileName& fnLeft, const wxFileName& fnRight, DiffMode m
         // One pane diff view
         // designed for displayed on a single editor
         ///////////////////////////////////////////////////////////////////
-        std::vector<sesElem> seq = diff.getSes().getSequence();
         m_resultLeft.reserve( seq.size() );
         int seqStartLine = wxNOT_FOUND;
         for(size_t i=0; i<seq.size(); ++i) {
-            switch(seq.at(i).second.type) {
-            case dtl::SES_COMMON: {
+            switch(seq.at(i).first) {
+            case SES_COMMON: {
                 if ( seqStartLine != wxNOT_FOUND ) {
                     m_sequences.push_back( std::make_pair(seqStartLine, m_resultLeft.size()) );
                     seqStartLine = wxNOT_FOUND;
                 }
-                clDTL::LineInfo line(seq.at(i).first, LINE_COMMON);
+                clDTL::LineInfo line(*seq.at(i).second, LINE_COMMON);
                 m_resultLeft.push_back( line );
                 break;
             }
-            case dtl::SES_ADD: {
+            case SES_ADD: {
                 if ( seqStartLine == wxNOT_FOUND ) {
                     seqStartLine = m_resultLeft.size();
                 }
-                clDTL::LineInfo line(seq.at(i).first, LINE_ADDED);
+                clDTL::LineInfo line(*seq.at(i).second, LINE_ADDED);
                 m_resultLeft.push_back( line );
                 break;
 
             }
-            case dtl::SES_DELETE: {
+            case SES_DELETE: {
                 if ( seqStartLine == wxNOT_FOUND ) {
                     seqStartLine = m_resultLeft.size();
                 }
-                clDTL::LineInfo line(seq.at(i).first, LINE_REMOVED);
+                clDTL::LineInfo line(*seq.at(i).second, LINE_REMOVED);
                 m_resultLeft.push_back( line );
                 break;
             }
@@ -27,13 +27,16 @@
 #define CLDTL_H
 
 #include <wx/string.h>
+#include <atomic>
+#include <memory>
 #include <vector>
 #include <wx/filename.h>
 #include "codelite_exports.h"
 
 /**
  * @class clDTL
- * @brief Diff 2 files and return the result
+ * @brief Diff 2 files and return the result. The lines are hashed to integers and compared using a linear space
+ * variant of Myers' algorithm. This class does not use any UI so it can be used from a worker thread
  * @code
 
     // An example of using the clDTL class:
@@ -78,6 +81,7 @@ public:
     };
     typedef std::vector<LineInfo> LineInfoVec_t;
     typedef std::vector<std::pair<int, int> > SeqLinePair_t;
+    typedef std::shared_ptr<clDTL> Ptr_t;
     
     enum DiffMode {
         kTwoPanes = 0x01,
@@ -88,6 +92,7 @@ private:
     LineInfoVec_t m_resultLeft;
     LineInfoVec_t m_resultRight;
     SeqLinePair_t m_sequences;
+    const std::atomic_bool* m_cancel;
 
 public:
     clDTL();
@@ -99,6 +104,13 @@ public:
      */
     void Diff(const wxFileName& fnLeft, const wxFileName& fnRight, DiffMode mode);
 
+    /**
+     * @brief when 'cancel' is set (by another thread) Diff() stops and returns an empty result
+     */
+    void SetCancelFlag(const std::atomic_bool* cancel) {
+        m_cancel = cancel;
+    }
+
     const LineInfoVec_t& GetResultLeft() const {
         return m_resultLeft;
     }
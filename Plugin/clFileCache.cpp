@@ -2,23 +2,109 @@
 
 void clFileCache::Add(const wxFileName& fn)
 {
-    if(Contains(fn)) {
+    wxString fullpath = fn.GetFullPath();
+    if(m_filesIndex.count(fullpath)) {
         return;
     }
+    m_filesIndex.insert({ fullpath, m_files.size() });
     m_files.push_back(fn);
-    m_filesSet.insert(fn.GetFullPath());
+
+    // Register the folder, and link it to its parents up to the first one that is already known
+    wxString folder = fn.GetPath();
+    bool known = m_folderFiles.count(folder) || m_subFolders.count(folder);
+    m_folderFiles[folder].insert(fullpath);
+    while(!known) {
+        wxString parent = folder.BeforeLast(wxFILE_SEP_PATH);
+        if(parent.IsEmpty() || parent == folder) {
+            break;
+        }
+        known = m_folderFiles.count(parent) || m_subFolders.count(parent);
+        m_subFolders[parent].insert(folder);
+        folder = parent;
+    }
 }
 
 void clFileCache::Clear()
 {
-    m_filesSet.clear();
+    m_filesIndex.clear();
     m_files.clear();
+    m_folderFiles.clear();
+    m_subFolders.clear();
+}
+
+void clFileCache::DoRemoveFile(const wxString& fullpath)
+{
+    auto iter = m_filesIndex.find(fullpath);
+    if(iter == m_filesIndex.end()) {
+        return;
+    }
+
+    // Move the last file into the hole, so a removal does not shift the whole array
+    size_t index = iter->second;
+    m_filesIndex.erase(iter);
+    if(index != m_files.size() - 1) {
+        m_files[index] = m_files.back();
+        m_filesIndex[m_files[index].GetFullPath()] = index;
+    }
+    m_files.pop_back();
+}
+
+void clFileCache::Remove(const wxFileName& fn)
+{
+    wxString fullpath = fn.GetFullPath();
+    if(!m_filesIndex.count(fullpath)) {
+        return;
+    }
+    DoRemoveFile(fullpath);
+
+    // the (possibly empty) folder entry is kept, it is needed to walk the tree in RemoveFolder()
+    auto folder = m_folderFiles.find(fn.GetPath());
+    if(folder != m_folderFiles.end()) {
+        folder->second.erase(fullpath);
+    }
+}
+
+wxArrayString clFileCache::RemoveFolder(const wxString& folder)
+{
+    wxString root = folder;
+    while(root.length() > 1 && root.EndsWith(wxFILE_SEP_PATH)) {
+        root.RemoveLast();
+    }
+
+    wxArrayString removed;
+    std::vector<wxString> queue = { root };
+    while(!queue.empty()) {
+        wxString current = queue.back();
+        queue.pop_back();
+
+        auto files = m_folderFiles.find(current);
+        if(files != m_folderFiles.end()) {
+            for(const wxString& fullpath : files->second) {
+                DoRemoveFile(fullpath);
+                removed.Add(fullpath);
+            }
+            m_folderFiles.erase(files);
+        }
+
+        auto subFolders = m_subFolders.find(current);
+        if(subFolders != m_subFolders.end()) {
+            queue.insert(queue.end(), subFolders->second.begin(), subFolders->second.end());
+            m_subFolders.erase(subFolders);
+        }
+    }
+
+    // unlink the removed tree from its parent
+    auto parent = m_subFolders.find(root.BeforeLast(wxFILE_SEP_PATH));
+    if(parent != m_subFolders.end()) {
+        parent->second.erase(root);
+    }
+    return removed;
 }
 
-bool clFileCache::Contains(const wxFileName& fn) const { return m_filesSet.count(fn.GetFullPath()); }
+bool clFileCache::Contains(const wxFileName& fn) const { return m_filesIndex.count(fn.GetFullPath()); }
 
 void clFileCache::Alloc(size_t size)
 {
     m_files.reserve(size);
-    m_filesSet.reserve(size);
+    m_filesIndex.reserve(size);
 }
@@ -2,15 +2,25 @@
 #define CLFILECACHE_HPP
 
 #include <codelite_exports.h>
+#include <macros.h>
+#include <wx/arrstr.h>
 #include <vector>
-#include <unordered_set>
+#include <unordered_map>
 #include <wx/filename.h>
 #include <wxStringHash.h>
 
 class WXDLLIMPEXP_SDK clFileCache
 {
     std::vector<wxFileName> m_files;
-    std::unordered_set<wxString> m_filesSet;
+    // full path -> index in m_files
+    std::unordered_map<wxString, size_t> m_filesIndex;
+    // folder -> the files directly placed in it
+    std::unordered_map<wxString, wxStringSet_t> m_folderFiles;
+    // folder -> its direct sub folders (those that have files, or sub folders with files)
+    std::unordered_map<wxString, wxStringSet_t> m_subFolders;
+
+protected:
+    void DoRemoveFile(const wxString& fullpath);
 
 public:
     typedef std::vector<wxFileName>::const_iterator const_iterator;
@@ -28,6 +38,16 @@ public:
     void Add(const wxFileName& fn);
     void Clear();
     bool Contains(const wxFileName& fn) const;
+    /**
+     * @brief remove a file from the cache. The last file takes its place, so the order of the files is not kept
+     */
+    void Remove(const wxFileName& fn);
+    /**
+     * @brief remove all the files placed under 'folder' from the cache. Only the folders of the removed tree are
+     * visited
+     * @return the removed files
+     */
+    wxArrayString RemoveFolder(const wxString& folder);
     size_t GetSize() const { return m_files.size(); }
     bool IsEmpty() const { return m_files.empty(); }
 };
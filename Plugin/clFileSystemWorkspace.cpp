@@ -46,6 +46,10 @@
         event.Skip(false); \
     }
 
+// Number of files sent to the main thread at once while the workspace is being scanned
+#define SCAN_BATCH_SIZE 2000
+
+wxDEFINE_EVENT(wxEVT_FS_SCAN_PROGRESS, clFileSystemEvent);
 wxDEFINE_EVENT(wxEVT_FS_SCAN_COMPLETED, clFileSystemEvent);
 clFileSystemWorkspace::clFileSystemWorkspace(bool dummy)
     : m_dummy(dummy)
@@ -56,6 +60,7 @@ clFileSystemWorkspace::clFileSystemWorkspace(bool dummy)
         EventNotifier::Get()->Bind(wxEVT_CMD_OPEN_WORKSPACE, &clFileSystemWorkspace::OnOpenWorkspace, this);
         EventNotifier::Get()->Bind(wxEVT_CMD_CREATE_NEW_WORKSPACE, &clFileSystemWorkspace::OnNewWorkspace, this);
         EventNotifier::Get()->Bind(wxEVT_ALL_EDITORS_CLOSED, &clFileSystemWorkspace::OnAllEditorsClosed, this);
+        EventNotifier::Get()->Bind(wxEVT_FS_SCAN_PROGRESS, &clFileSystemWorkspace::OnScanProgress, this);
         EventNotifier::Get()->Bind(wxEVT_FS_SCAN_COMPLETED, &clFileSystemWorkspace::OnScanCompleted, this);
         EventNotifier::Get()->Bind(wxEVT_CMD_RETAG_WORKSPACE, &clFileSystemWorkspace::OnParseWorkspace, this);
         EventNotifier::Get()->Bind(wxEVT_CMD_RETAG_WORKSPACE_FULL, &clFileSystemWorkspace::OnParseWorkspace, this);
@@ -87,6 +92,14 @@ clFileSystemWorkspace::clFileSystemWorkspace(bool dummy)
         EventNotifier::Get()->Bind(wxEVT_DBG_UI_START, &clFileSystemWorkspace::OnDebug, this);
 
         EventNotifier::Get()->Bind(wxEVT_FILE_CREATED, &clFileSystemWorkspace::OnFileSystemUpdated, this);
+
+        // File system watcher events (the watcher sends them to us directly)
+        m_watcher.reset(new clFileSystemWatcher());
+        m_watcher->SetOwner(this);
+        Bind(wxEVT_FILE_CREATED, &clFileSystemWorkspace::OnWatcherFilesCreated, this);
+        Bind(wxEVT_FILE_MODIFIED, &clFileSystemWorkspace::OnWatcherFileModified, this);
+        Bind(wxEVT_FILE_NOT_FOUND, &clFileSystemWorkspace::OnWatcherFileNotFound, this);
+        Bind(wxEVT_FILE_WATCHER_OVERFLOW, &clFileSystemWorkspace::OnWatcherOverflow, this);
     }
 }
 
@@ -97,6 +110,7 @@ clFileSystemWorkspace::~clFileSystemWorkspace()
         EventNotifier::Get()->Unbind(wxEVT_CMD_OPEN_WORKSPACE, &clFileSystemWorkspace::OnOpenWorkspace, this);
         EventNotifier::Get()->Unbind(wxEVT_CMD_CREATE_NEW_WORKSPACE, &clFileSystemWorkspace::OnNewWorkspace, this);
         EventNotifier::Get()->Unbind(wxEVT_ALL_EDITORS_CLOSED, &clFileSystemWorkspace::OnAllEditorsClosed, this);
+        EventNotifier::Get()->Unbind(wxEVT_FS_SCAN_PROGRESS, &clFileSystemWorkspace::OnScanProgress, this);
         EventNotifier::Get()->Unbind(wxEVT_FS_SCAN_COMPLETED, &clFileSystemWorkspace::OnScanCompleted, this);
         EventNotifier::Get()->Unbind(wxEVT_SAVE_SESSION_NEEDED, &clFileSystemWorkspace::OnSaveSession, this);
 
@@ -131,6 +145,13 @@ clFileSystemWorkspace::~clFileSystemWorkspace()
         EventNotifier::Get()->Unbind(wxEVT_DBG_UI_START, &clFileSystemWorkspace::OnDebug, this);
 
         EventNotifier::Get()->Unbind(wxEVT_FILE_CREATED, &clFileSystemWorkspace::OnFileSystemUpdated, this);
+
+        m_watcher->Clear();
+        m_watcher->SetOwner(nullptr);
+        Unbind(wxEVT_FILE_CREATED, &clFileSystemWorkspace::OnWatcherFilesCreated, this);
+        Unbind(wxEVT_FILE_MODIFIED, &clFileSystemWorkspace::OnWatcherFileModified, this);
+        Unbind(wxEVT_FILE_NOT_FOUND, &clFileSystemWorkspace::OnWatcherFileNotFound, this);
+        Unbind(wxEVT_FILE_WATCHER_OVERFLOW, &clFileSystemWorkspace::OnWatcherOverflow, this);
     }
 }
 
@@ -182,20 +203,34 @@ void clFileSystemWorkspace::CacheFiles(bool force)
     if(!m_files.IsEmpty()) {
         m_files.Clear();
     }
+    // Results of a previous scan that is still running are ignored
+    size_t scanId = ++m_scanId;
+    wxString filesMask = GetFilesMask();
     std::thread thr(
         [=](const wxString& rootFolder) {
             clFilesScanner fs;
-            std::vector<wxString> files;
             wxStringSet_t excludeFolders = { ".git", ".svn", ".codelite" };
-            fs.Scan(rootFolder, files, GetFilesMask(), "", excludeFolders);
+
+            // Stream the files to the main thread while the scan is running
+            wxArrayString batch;
+            clFilesScanner::FilesCallback_t callback = [&](const std::vector<wxString>& files) {
+                for(const wxString& f : files) {
+                    batch.Add(f);
+                }
+                if(batch.size() >= SCAN_BATCH_SIZE) {
+                    clFileSystemEvent event(wxEVT_FS_SCAN_PROGRESS);
+                    event.SetInt(scanId);
+                    event.SetPaths(batch);
+                    EventNotifier::Get()->QueueEvent(event.Clone());
+                    batch.clear();
+                }
+                return true;
+            };
+            fs.ScanWithCallback(rootFolder, callback, filesMask, "", excludeFolders);
 
             clFileSystemEvent event(wxEVT_FS_SCAN_COMPLETED);
-            wxArrayString arrfiles;
-            arrfiles.Alloc(files.size());
-            for(const wxString& f : files) {
-                arrfiles.Add(f);
-            }
-            event.SetPaths(arrfiles);
+            event.SetInt(scanId);
+            event.SetPaths(batch);
             EventNotifier::Get()->QueueEvent(event.Clone());
         },
         GetFileName().GetPath());
@@ -340,6 +375,8 @@ void clFileSystemWorkspace::DoClose()
     // avoid any file re-cache, we are closing
     Save(false);
     DoClear();
+    // Drop the results of a scan that is still running
+    ++m_scanId;
 
     // Clear the UI
     GetView()->Clear();
@@ -371,6 +408,10 @@ void clFileSystemWorkspace::DoClose()
 
 void clFileSystemWorkspace::DoClear()
 {
+    if(m_watcher) {
+        m_watcher->Clear();
+    }
+    m_watcherParsePending = false;
     m_filename.Clear();
     m_settings.Clear();
 }
@@ -396,20 +437,46 @@ clFileSystemWorkspace& clFileSystemWorkspace::Get()
 
 void clFileSystemWorkspace::New(const wxString& folder) { DoCreate("", folder, true); }
 
+void clFileSystemWorkspace::OnScanProgress(clFileSystemEvent& event)
+{
+    if(event.GetInt() != (int)m_scanId) { return; }
+    for(const wxString& filename : event.GetPaths()) {
+        m_files.Add(filename);
+    }
+    clGetManager()->SetStatusMessage(wxString() << _("Scanning workspace folder: ") << m_files.GetSize()
+                                                << _(" files found"));
+}
+
 void clFileSystemWorkspace::OnScanCompleted(clFileSystemEvent& event)
 {
-    clDEBUG() << "FSW: CacheFiles completed. Found" << event.GetPaths().size() << "files";
-    m_files.Clear();
-    m_files.Alloc(event.GetPaths().size());
+    if(event.GetInt() != (int)m_scanId) {
+        clDEBUG() << "FSW: ignoring the results of an outdated scan";
+        return;
+    }
     for(const wxString& filename : event.GetPaths()) {
         m_files.Add(filename);
     }
+    clDEBUG() << "FSW: CacheFiles completed. Found" << m_files.GetSize() << "files";
     clGetManager()->SetStatusMessage(_("File system scan completed"));
 
+    // From now on, keep the cache up to date using the file system watcher instead of re-scanning the tree
+    StartWatcher();
+
     // Trigger a non full reparse
     Parse(false);
 }
 
+void clFileSystemWorkspace::StartWatcher()
+{
+    if(!m_watcher || !clFileSystemWatcher::IsFolderWatchSupported() || !m_isLoaded) {
+        return;
+    }
+    m_watcher->Clear();
+    m_watcher->AddFolder(GetFileName().GetPath(), { ".git", ".svn", ".codelite" });
+    m_watcher->Start();
+    clDEBUG() << "FSW: watching folder:" << GetFileName().GetPath() << clEndl;
+}
+
 void clFileSystemWorkspace::OnParseWorkspace(wxCommandEvent& event)
 {
     if(!m_isLoaded) {
@@ -877,8 +944,13 @@ void clFileSystemWorkspace::OnSourceControlPulled(clSourceControlEvent& event)
     clDEBUG() << "Refreshing tree + re-parsing";
     GetView()->RefreshTree();
 
-    // Re-Cache the files and trigger a workspace parse
-    CacheFiles(true);
+    if(m_watcher && m_watcher->IsRunning()) {
+        // the file cache is kept up to date by the watcher, only re-parse
+        Parse(false);
+    } else {
+        // Re-Cache the files and trigger a workspace parse
+        CacheFiles(true);
+    }
 }
 
 void clFileSystemWorkspace::TriggerQuickParse()
@@ -887,7 +959,14 @@ void clFileSystemWorkspace::TriggerQuickParse()
     EventNotifier::Get()->TopFrame()->GetEventHandler()->QueueEvent(eventParse.Clone());
 }
 
-void clFileSystemWorkspace::FileSystemUpdated() { CacheFiles(true); }
+void clFileSystemWorkspace::FileSystemUpdated()
+{
+    if(m_watcher && m_watcher->IsRunning()) {
+        // the watcher already reported the changes
+        return;
+    }
+    CacheFiles(true);
+}
 
 void clFileSystemWorkspace::OnDebug(clDebugEvent& event)
 {
@@ -993,3 +1072,82 @@ void clFileSystemWorkspace::OnFileSystemUpdated(clFileSystemEvent& event)
         Parse(false);
     }
 }
+
+void clFileSystemWorkspace::OnWatcherFilesCreated(clFileSystemEvent& event)
+{
+    if(!IsOpen()) {
+        return;
+    }
+
+    wxString mask = GetFilesMask();
+    size_t count = 0;
+    for(const wxString& path : event.GetPaths()) {
+        if(!m_files.Contains(path) && FileUtils::WildMatch(mask, path)) {
+            m_files.Add(path);
+            ++count;
+        }
+    }
+
+    if(count) {
+        clDEBUG() << "FSW:" << count << "new files" << clEndl;
+        ScheduleWatcherParse();
+    }
+}
+
+void clFileSystemWorkspace::OnWatcherFileModified(clFileSystemEvent& event)
+{
+    if(IsOpen() && m_files.Contains(event.GetPath())) {
+        ScheduleWatcherParse();
+    }
+}
+
+void clFileSystemWorkspace::OnWatcherFileNotFound(clFileSystemEvent& event)
+{
+    if(!IsOpen()) {
+        return;
+    }
+
+    const wxString& path = event.GetPath();
+    wxArrayString removed;
+    if(event.IsFolder()) {
+        // a folder was deleted (or moved out of the workspace)
+        removed = m_files.RemoveFolder(path);
+    } else if(m_files.Contains(path)) {
+        m_files.Remove(path);
+        removed.Add(path);
+    }
+
+    if(!removed.IsEmpty()) {
+        clDEBUG() << "FSW:" << removed.size() << "files removed" << clEndl;
+        TagsManagerST::Get()->DeleteFilesTags(removed);
+    }
+}
+
+void clFileSystemWorkspace::OnWatcherOverflow(clFileSystemEvent& event)
+{
+    if(!IsOpen()) {
+        return;
+    }
+
+    // Changes were lost, the cache can no longer be trusted. The watcher is restarted once the scan completes
+    clWARNING() << "FSW: file system changes were lost, re-scanning the workspace folder" << clEndl;
+    m_watcher->Stop();
+    CacheFiles(true);
+}
+
+void clFileSystemWorkspace::ScheduleWatcherParse()
+{
+    // the watcher reports changes in batches, parse once per batch
+    if(!m_watcherParsePending) {
+        m_watcherParsePending = true;
+        CallAfter(&clFileSystemWorkspace::DoWatcherParse);
+    }
+}
+
+void clFileSystemWorkspace::DoWatcherParse()
+{
+    if(m_watcherParsePending && IsOpen()) {
+        m_watcherParsePending = false;
+        Parse(false);
+    }
+}
@@ -6,6 +6,7 @@
 #include "clConsoleBase.h"
 #include "clDebuggerTerminal.h"
 #include "clFileSystemEvent.h"
+#include "clFileSystemWatcher.h"
 #include "clFileSystemWorkspaceConfig.hpp"
 #include "clRemoteBuilder.hpp"
 #include "cl_command_event.h"
@@ -34,6 +35,9 @@ class WXDLLIMPEXP_SDK clFileSystemWorkspace : public IWorkspace
     clRemoteBuilder::Ptr_t m_remoteBuilder;
     clDebuggerTerminalPOSIX m_debuggerTerminal;
     int m_execPID = wxNOT_FOUND;
+    clFileSystemWatcher::Ptr_t m_watcher;
+    bool m_watcherParsePending = false;
+    size_t m_scanId = 0;
 
 protected:
     void CacheFiles(bool force = false);
@@ -64,6 +68,7 @@ protected:
     void OnOpenWorkspace(clCommandEvent& event);
     void OnCloseWorkspace(clCommandEvent& event);
     void OnAllEditorsClosed(wxCommandEvent& event);
+    void OnScanProgress(clFileSystemEvent& event);
     void OnScanCompleted(clFileSystemEvent& event);
     void OnParseWorkspace(wxCommandEvent& event);
     void OnParseThreadScanIncludeCompleted(wxCommandEvent& event);
@@ -78,6 +83,10 @@ protected:
     void OnSourceControlPulled(clSourceControlEvent& event);
     void OnDebug(clDebugEvent& event);
     void OnFileSystemUpdated(clFileSystemEvent& event);
+    void OnWatcherFilesCreated(clFileSystemEvent& event);
+    void OnWatcherFileModified(clFileSystemEvent& event);
+    void OnWatcherFileNotFound(clFileSystemEvent& event);
+    void OnWatcherOverflow(clFileSystemEvent& event);
 
 protected:
     bool Load(const wxFileName& file);
@@ -88,6 +97,9 @@ protected:
     void RestoreSession();
     void DoBuild(const wxString& target);
     void TriggerQuickParse();
+    void StartWatcher();
+    void ScheduleWatcherParse();
+    void DoWatcherParse();
     clFileSystemWorkspaceConfig::Ptr_t GetConfig() const;
 
 public:
@@ -72,7 +72,7 @@ wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_SDK, wxEVT_DEBUGGER_LIST_REGISTERS, clComma
 // Call stack
 wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_SDK, wxEVT_DEBUGGER_LIST_FRAMES, clCommandEvent);
 
-// frame selected (user double clicked a stack entry)
+// frame selected (user double clicked a stack entry). event.GetInt() is the index of the selected frame
 wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_SDK, wxEVT_DEBUGGER_FRAME_SELECTED, clCommandEvent);
 
 class WXDLLIMPEXP_SDK DebuggerMgr
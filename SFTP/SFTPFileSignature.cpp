@@ -0,0 +1,59 @@
+#include "SFTPFileSignature.h"
+
+#define SFTP_SIGNATURE_BLOCK_SIZE 8192
+#define SFTP_SIGNATURE_MIN_FILE_SIZE (64 * 1024)
+
+SFTPFileSignature::SFTPFileSignature(const wxMemoryBuffer& content, SFTPAttribute::Ptr_t remoteAttr)
+    : m_remoteSize(remoteAttr ? (wxInt64)remoteAttr->GetSize() : -1)
+    , m_remoteModificationTime(remoteAttr ? remoteAttr->GetModificationTime() : 0)
+{
+    const char* data = (const char*)content.GetData();
+    size_t size = content.GetDataLen();
+    m_blocks.reserve((size + SFTP_SIGNATURE_BLOCK_SIZE - 1) / SFTP_SIGNATURE_BLOCK_SIZE);
+    for(size_t offset = 0; offset < size; offset += SFTP_SIGNATURE_BLOCK_SIZE) {
+        size_t len = (size - offset) > SFTP_SIGNATURE_BLOCK_SIZE ? SFTP_SIGNATURE_BLOCK_SIZE : (size - offset);
+        m_blocks.push_back(Checksum(data + offset, len));
+    }
+}
+
+SFTPFileSignature::~SFTPFileSignature() {}
+
+wxUint64 SFTPFileSignature::Checksum(const char* data, size_t len)
+{
+    // 64 bit FNV-1a
+    wxUint64 hash = wxULL(14695981039346656037);
+    for(size_t i = 0; i < len; ++i) {
+        hash ^= (unsigned char)data[i];
+        hash *= wxULL(1099511628211);
+    }
+    return hash;
+}
+
+bool SFTPFileSignature::IsRemoteUnchanged(SFTPAttribute::Ptr_t remoteAttr) const
+{
+    return remoteAttr && remoteAttr->IsFile() && (wxInt64)remoteAttr->GetSize() == m_remoteSize &&
+           remoteAttr->GetModificationTime() == m_remoteModificationTime;
+}
+
+wxInt64 SFTPFileSignature::Diff(const wxMemoryBuffer& content, clSFTP::Ranges_t& ranges) const
+{
+    ranges.clear();
+    const char* data = (const char*)content.GetData();
+    size_t size = content.GetDataLen();
+    wxInt64 changedBytes = 0;
+    for(size_t offset = 0, block = 0; offset < size; offset += SFTP_SIGNATURE_BLOCK_SIZE, ++block) {
+        size_t len = (size - offset) > SFTP_SIGNATURE_BLOCK_SIZE ? SFTP_SIGNATURE_BLOCK_SIZE : (size - offset);
+        // The last old block may be shorter than the new one: its checksum won't match
+        if(block < m_blocks.size() && m_blocks[block] == Checksum(data + offset, len)) { continue; }
+
+        changedBytes += len;
+        if(!ranges.empty() && (ranges.back().first + ranges.back().second) == (wxInt64)offset) {
+            ranges.back().second += len;
+        } else {
+            ranges.push_back(std::make_pair((wxInt64)offset, (wxInt64)len));
+        }
+    }
+    return changedBytes;
+}
+
+bool SFTPFileSignature::IsWorthSigning(wxInt64 size) { return size >= SFTP_SIGNATURE_MIN_FILE_SIZE; }
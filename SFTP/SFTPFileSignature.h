@@ -0,0 +1,50 @@
+#ifndef SFTPFILESIGNATURE_H
+#define SFTPFILESIGNATURE_H
+
+#include "cl_sftp.h"
+#include <memory>
+#include <vector>
+#include <wx/buffer.h>
+
+/**
+ * @class SFTPFileSignature
+ * @brief the block checksums of a file as it was last uploaded (or downloaded), together with the remote size and
+ * modification time at that point. It is used to upload only the blocks that changed since then
+ */
+class SFTPFileSignature
+{
+    std::vector<wxUint64> m_blocks;
+    wxInt64 m_remoteSize;
+    time_t m_remoteModificationTime;
+
+protected:
+    static wxUint64 Checksum(const char* data, size_t len);
+
+public:
+    typedef std::shared_ptr<SFTPFileSignature> Ptr_t;
+
+    /**
+     * @brief sign 'content', which is now the content of the remote file described by 'remoteAttr'
+     */
+    SFTPFileSignature(const wxMemoryBuffer& content, SFTPAttribute::Ptr_t remoteAttr);
+    virtual ~SFTPFileSignature();
+
+    /**
+     * @brief return true if the remote file was not modified by someone else since it was signed
+     */
+    bool IsRemoteUnchanged(SFTPAttribute::Ptr_t remoteAttr) const;
+
+    /**
+     * @brief compare 'content' against the signed content
+     * @param ranges [output] the ranges of 'content' that need to be written (adjacent blocks are merged)
+     * @return the number of bytes that need to be written
+     */
+    wxInt64 Diff(const wxMemoryBuffer& content, clSFTP::Ranges_t& ranges) const;
+
+    /**
+     * @brief files smaller than this are always uploaded in full: the delta would not save a round trip
+     */
+    static bool IsWorthSigning(wxInt64 size);
+};
+
+#endif // SFTPFILESIGNATURE_H
@@ -0,0 +1,68 @@
+#ifndef SFTPREQUESTQUEUE_H
+#define SFTPREQUESTQUEUE_H
+
+#include "wxStringHash.h"
+#include <vector>
+#include <wx/defs.h>
+
+/**
+ * @class SFTPRequestQueue
+ * @brief the pending SFTP requests and the order in which they are executed. T provides GetKey() and GetPriority().
+ * The queue owns the pending requests; the caller owns a request once it is taken. Not thread safe: the caller
+ * protects it with its own lock
+ */
+template <class T> class SFTPRequestQueue
+{
+    std::vector<T*> m_pending;
+    wxStringSet_t m_busyKeys;
+
+public:
+    SFTPRequestQueue() {}
+    ~SFTPRequestQueue() { Clear(); }
+
+    void Push(T* req) { m_pending.push_back(req); }
+
+    /**
+     * @brief take the oldest request of the highest priority. A request can not run while a request with the same
+     * key is running or was queued before it. The request key is busy until Done() is called
+     * @return nullptr if no request can run now
+     */
+    T* Take()
+    {
+        wxStringSet_t queuedKeys;
+        int best = wxNOT_FOUND;
+        for(size_t i = 0; i < m_pending.size(); ++i) {
+            wxString key = m_pending[i]->GetKey();
+            bool blocked = m_busyKeys.count(key) || queuedKeys.count(key);
+            queuedKeys.insert(key);
+            if(blocked) { continue; }
+            if(best == wxNOT_FOUND || m_pending[i]->GetPriority() > m_pending[best]->GetPriority()) { best = i; }
+        }
+        if(best == wxNOT_FOUND) { return nullptr; }
+
+        T* req = m_pending[best];
+        m_pending.erase(m_pending.begin() + best);
+        m_busyKeys.insert(req->GetKey());
+        return req;
+    }
+
+    /**
+     * @brief the request taken with Take() completed, requests with the same key can run now
+     */
+    void Done(T* req) { m_busyKeys.erase(req->GetKey()); }
+
+    bool IsEmpty() const { return m_pending.empty(); }
+
+    /**
+     * @brief discard the pending requests
+     */
+    void Clear()
+    {
+        for(size_t i = 0; i < m_pending.size(); ++i) {
+            delete m_pending[i];
+        }
+        m_pending.clear();
+    }
+};
+
+#endif // SFTPREQUESTQUEUE_H
@@ -333,10 +333,12 @@ void SFTP::OnSaveFile(clSFTPEvent& e)
     }
 }
 
-void SFTP::DoSaveRemoteFile(const RemoteFileInfo& remoteFile)
+void SFTP::DoSaveRemoteFile(const RemoteFileInfo& remoteFile, eSFTPPriority priority)
 {
-    SFTPWorkerThread::Instance()->Add(new SFTPThreadRequet(remoteFile.GetAccount(), remoteFile.GetRemoteFile(),
-                                                           remoteFile.GetLocalFile(), remoteFile.GetPremissions()));
+    SFTPThreadRequet* req = new SFTPThreadRequet(remoteFile.GetAccount(), remoteFile.GetRemoteFile(),
+                                                 remoteFile.GetLocalFile(), remoteFile.GetPremissions());
+    req->SetPriority(priority);
+    SFTPWorkerThread::Instance()->Add(req);
 }
 
 void SFTP::FileDownloadedSuccessfully(const SFTPClientData& cd)
@@ -419,12 +421,18 @@ void SFTP::DoFileSaved(const wxString& filename)
     if(filename.IsEmpty())
         return;
 
+    // The user is waiting for the active editor, upload it before anything else
+    IEditor* activeEditor = m_mgr->GetActiveEditor();
+    eSFTPPriority priority = (activeEditor && activeEditor->GetFileName().GetFullPath() == filename)
+                                 ? eSFTPPriority::kHigh
+                                 : eSFTPPriority::kNormal;
+
     // Check to see if this file is part of a remote files managed by our plugin
     if(m_remoteFiles.count(filename)) {
         // ----------------------------------------------------------------------------------------------
         // this file was opened by the SFTP explorer
         // ----------------------------------------------------------------------------------------------
-        DoSaveRemoteFile(m_remoteFiles.find(filename)->second);
+        DoSaveRemoteFile(m_remoteFiles.find(filename)->second, priority);
 
     } else {
         // ----------------------------------------------------------------------------------------------
@@ -441,7 +449,9 @@ void SFTP::DoFileSaved(const wxString& filename)
 
         SSHAccountInfo account;
         if(settings.GetAccount(m_workspaceSettings.GetAccount(), account)) {
-            SFTPWorkerThread::Instance()->Add(new SFTPThreadRequet(account, remoteFile, filename, 0));
+            SFTPThreadRequet* req = new SFTPThreadRequet(account, remoteFile, filename, 0);
+            req->SetPriority(priority);
+            SFTPWorkerThread::Instance()->Add(req);
 
         } else {
 
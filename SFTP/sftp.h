@@ -33,6 +33,7 @@
 #include "macros.h"
 #include "plugin.h"
 #include "remote_file_info.h"
+#include "sftp_worker_thread.h"
 #include "sftp_workspace_settings.h"
 #include <SFTPClientData.hpp>
 
@@ -79,7 +80,7 @@ protected:
     void OnInitDone(wxCommandEvent& event);
     void DoFileSaved(const wxString& filename);
     bool IsWorkspaceOpened() const { return m_workspaceFile.IsOk(); }
-    void DoSaveRemoteFile(const RemoteFileInfo& remoteFile);
+    void DoSaveRemoteFile(const RemoteFileInfo& remoteFile, eSFTPPriority priority);
     bool IsPaneDetached(const wxString& name) const;
 
     // API calls
@@ -25,16 +25,23 @@
 
 #include "SFTPStatusPage.h"
 #include "cl_ssh.h"
+#include "file_logger.h"
 #include "sftp.h"
 #include "sftp_worker_thread.h"
+#include <algorithm>
 #include <libssh/sftp.h>
+#include <thread>
 #include <wx/ffile.h>
 
+// Number of requests executed in parallel, each worker uses its own SSH session
+#define SFTP_WORKERS_COUNT 4
+
 SFTPWorkerThread* SFTPWorkerThread::ms_instance = 0;
 
 SFTPWorkerThread::SFTPWorkerThread()
-    : m_sftp(NULL)
-    , m_plugin(NULL)
+    : m_plugin(NULL)
+    , m_activeCount(0)
+    , m_stopping(false)
 {
 }
 
@@ -55,40 +62,161 @@ void SFTPWorkerThread::Release()
     ms_instance = 0;
 }
 
-void SFTPWorkerThread::ProcessRequest(ThreadRequest* request)
+void SFTPWorkerThread::Add(ThreadRequest* request)
 {
     SFTPThreadRequet* req = dynamic_cast<SFTPThreadRequet*>(request);
-    // Check if we need to open an ssh connection
-    wxString currentAccout = m_sftp ? m_sftp->GetAccount() : "";
-    wxString requestAccount = req->GetAccount().GetAccountName();
+    if(!req) {
+        wxDELETE(request);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_queue.Push(req);
+    lock.unlock();
+    m_cv.notify_one();
+}
 
-    if(currentAccout.IsEmpty() || currentAccout != requestAccount) {
-        m_sftp.reset(NULL);
-        DoConnect(req);
+void SFTPWorkerThread::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        m_queue.Clear();
+    }
+    m_cv.notify_all();
+    WorkerThread::Stop();
+
+    // The workers are gone, close the sessions
+    std::lock_guard<std::mutex> lock(m_sessionsMutex);
+    m_sessions.clear();
+}
+
+SFTPTransferStats SFTPWorkerThread::GetStats()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_totalStats;
+}
+
+void* SFTPWorkerThread::Entry()
+{
+    // This thread is one of the workers
+    std::vector<std::thread> workers;
+    for(size_t i = 1; i < SFTP_WORKERS_COUNT; ++i) {
+        workers.push_back(std::thread(&SFTPWorkerThread::DoWorkerLoop, this));
+    }
+    DoWorkerLoop();
+    std::for_each(workers.begin(), workers.end(), [&](std::thread& t) { t.join(); });
+    return NULL;
+}
+
+void SFTPWorkerThread::DoWorkerLoop()
+{
+    while(true) {
+        SFTPThreadRequet* req = DoTakeRequest();
+        if(!req) { break; }
+        ProcessRequest(req);
+        wxDELETE(req);
     }
+}
+
+SFTPThreadRequet* SFTPWorkerThread::DoTakeRequest()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while(!m_stopping) {
+        SFTPThreadRequet* req = m_queue.Take();
+        if(req) {
+            if(m_activeCount == 0 && m_batchStats.files == 0) { m_batchTimer.Start(); }
+            ++m_activeCount;
+            return req;
+        }
+        m_cv.wait(lock);
+    }
+    return nullptr;
+}
+
+void SFTPWorkerThread::DoRequestDone(SFTPThreadRequet* req, const SFTPTransferStats& stats)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_queue.Done(req);
+    --m_activeCount;
+    m_batchStats.Add(stats);
+    m_totalStats.Add(stats);
+
+    // Summarize once all the queued transfers are done
+    SFTPTransferStats batch;
+    if(m_queue.IsEmpty() && m_activeCount == 0) {
+        batch = m_batchStats;
+        batch.elapsedMs = m_batchTimer.Time(); // the transfers overlap, use the wall clock time
+        m_batchStats = SFTPTransferStats();
+    }
+    lock.unlock();
+
+    // Requests waiting for this file can run now
+    m_cv.notify_all();
+    if(batch.files > 1) {
+        wxString msg;
+        msg << "Transferred " << batch.files << " files. " << batch.ToString();
+        DoReportMessage(req->GetAccount().GetAccountName(), msg, SFTPThreadMessage::STATUS_OK);
+    }
+}
+
+clSFTP::Ptr_t SFTPWorkerThread::DoGetSession(SFTPThreadRequet* req)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sessionsMutex);
+        std::vector<clSFTP::Ptr_t>& sessions = m_sessions[req->GetAccount().GetAccountName()];
+        if(!sessions.empty()) {
+            clSFTP::Ptr_t sftp = sessions.back();
+            sessions.pop_back();
+            return sftp;
+        }
+    }
+    // No idle session for this account, open a new one
+    return DoConnect(req);
+}
 
+void SFTPWorkerThread::DoReleaseSession(clSFTP::Ptr_t sftp)
+{
+    if(!sftp || !sftp->IsConnected()) { return; }
+    std::lock_guard<std::mutex> lock(m_sessionsMutex);
+    m_sessions[sftp->GetAccount()].push_back(sftp);
+}
+
+void SFTPWorkerThread::ProcessRequest(ThreadRequest* request)
+{
+    SFTPThreadRequet* req = dynamic_cast<SFTPThreadRequet*>(request);
+    SFTPTransferStats stats;
+    DoProcessRequest(req, stats);
+    DoRequestDone(req, stats);
+}
+
+void SFTPWorkerThread::DoProcessRequest(SFTPThreadRequet* req, SFTPTransferStats& stats)
+{
+    // Borrow a session to the request account
+    clSFTP::Ptr_t sftp = DoGetSession(req);
     if(req->GetAction() == eSFTPActions::kConnect) {
-        // Nothing more to be done here
-        // Disconnect
-        m_sftp.reset(NULL);
+        // Nothing more to be done here, keep the session for the next requests
+        DoReleaseSession(sftp);
         return;
     }
 
     wxString msg;
     wxString accountName = req->GetAccount().GetAccountName();
-    if(m_sftp && m_sftp->IsConnected()) {
+    if(sftp && sftp->IsConnected()) {
         msg.Clear();
         try {
+            wxStopWatch sw;
             switch(req->GetAction()) {
             case eSFTPActions::kConnect:
                 // We don't really need this case. Just make the compiler silence
                 return;
             case eSFTPActions::kUpload: {
                 DoReportStatusBarMessage(wxString() << _("Uploading file: ") << req->GetRemoteFile());
-                SFTPAttribute::Ptr_t attr(new SFTPAttribute(NULL));
-                attr->SetPermissions(req->GetPermissions());
-                m_sftp->CreateRemoteFile(req->GetRemoteFile(), wxFileName(req->GetLocalFile()), attr);
-                msg << "Successfully uploaded file: " << req->GetLocalFile() << " -> " << req->GetRemoteFile();
+                stats.files = 1;
+                stats.bytes = DoUpload(sftp, req);
+                stats.elapsedMs = sw.Time();
+                msg << "Successfully uploaded file: " << req->GetLocalFile() << " -> " << req->GetRemoteFile() << ". "
+                    << stats.ToString();
                 DoReportMessage(accountName, msg, SFTPThreadMessage::STATUS_OK);
                 DoReportStatusBarMessage("");
                 break;
@@ -98,14 +226,22 @@ void SFTPWorkerThread::ProcessRequest(ThreadRequest* request)
             case eSFTPActions::kDownloadAndOpenWithDefaultApp: {
                 DoReportStatusBarMessage(wxString() << _("Downloading file: ") << req->GetRemoteFile());
                 wxMemoryBuffer buffer;
-                SFTPAttribute::Ptr_t fileAttr = m_sftp->Read(req->GetRemoteFile(), buffer);
+                SFTPAttribute::Ptr_t fileAttr = sftp->Read(req->GetRemoteFile(), buffer);
                 wxFFile fp(req->GetLocalFile(), "w+b");
                 if(fp.IsOpened()) {
                     fp.Write(buffer.GetData(), buffer.GetDataLen());
                     fp.Close();
                 }
 
-                msg << "Successfully downloaded file: " << req->GetLocalFile() << " <- " << req->GetRemoteFile();
+                stats.files = 1;
+                stats.bytes = buffer.GetDataLen();
+                stats.elapsedMs = sw.Time();
+                if(SFTPFileSignature::IsWorthSigning(buffer.GetDataLen())) {
+                    // The next save of this file only needs to upload what the user changed
+                    DoSetSignature(req->GetKey(), SFTPFileSignature::Ptr_t(new SFTPFileSignature(buffer, fileAttr)));
+                }
+                msg << "Successfully downloaded file: " << req->GetLocalFile() << " <- " << req->GetRemoteFile()
+                    << ". " << stats.ToString();
                 DoReportMessage(accountName, msg, SFTPThreadMessage::STATUS_OK);
                 DoReportStatusBarMessage("");
 
@@ -129,7 +265,8 @@ void SFTPWorkerThread::ProcessRequest(ThreadRequest* request)
             case eSFTPActions::kRename: {
                 DoReportStatusBarMessage(wxString() << _("Renaming: ") << req->GetRemoteFile() << " -> "
                                                     << req->GetNewRemoteFile());
-                m_sftp->Rename(req->GetRemoteFile(), req->GetNewRemoteFile());
+                DoSetSignature(req->GetKey(), SFTPFileSignature::Ptr_t(nullptr));
+                sftp->Rename(req->GetRemoteFile(), req->GetNewRemoteFile());
                 wxString msg;
                 msg << _("Renamed ") << req->GetRemoteFile() << " -> " << req->GetNewRemoteFile();
                 DoReportMessage(accountName, msg, SFTPThreadMessage::STATUS_OK);
@@ -137,7 +274,8 @@ void SFTPWorkerThread::ProcessRequest(ThreadRequest* request)
             }
             case eSFTPActions::kDelete: {
                 DoReportStatusBarMessage(wxString() << _("Deleting: ") << req->GetRemoteFile());
-                m_sftp->UnlinkFile(req->GetRemoteFile());
+                DoSetSignature(req->GetKey(), SFTPFileSignature::Ptr_t(nullptr));
+                sftp->UnlinkFile(req->GetRemoteFile());
                 wxString msg;
                 msg << _("Deleted ") << req->GetRemoteFile();
                 DoReportMessage(accountName, msg, SFTPThreadMessage::STATUS_OK);
@@ -150,7 +288,8 @@ void SFTPWorkerThread::ProcessRequest(ThreadRequest* request)
             msg << "SFTP error: " << e.What();
             DoReportMessage(accountName, msg, SFTPThreadMessage::STATUS_ERROR);
             DoReportStatusBarMessage(msg);
-            m_sftp.reset(NULL);
+            // The session is probably broken, don't return it to the pool
+            sftp.reset(NULL);
 
             // Requeue our request
             if(req->GetRetryCounter() == 0) {
@@ -165,9 +304,87 @@ void SFTPWorkerThread::ProcessRequest(ThreadRequest* request)
             }
         }
     }
+    DoReleaseSession(sftp);
+}
+
+wxInt64 SFTPWorkerThread::DoUpload(clSFTP::Ptr_t sftp, SFTPThreadRequet* req)
+{
+    wxFFile fp(req->GetLocalFile(), "rb");
+    if(!fp.IsOpened()) {
+        throw clException(wxString() << "Could not open file '" << req->GetLocalFile() << "'");
+    }
+    wxMemoryBuffer content;
+    wxFileOffset fileSize = fp.Length();
+    if(fileSize > 0 && (wxFileOffset)fp.Read(content.GetWriteBuf(fileSize), fileSize) != fileSize) {
+        content.UngetWriteBuf(0);
+        throw clException(wxString() << "Could not read file '" << req->GetLocalFile() << "'");
+    }
+    content.UngetWriteBuf(fileSize > 0 ? fileSize : 0);
+    fp.Close();
+
+    const wxString& remoteFile = req->GetRemoteFile();
+    bool signContent = SFTPFileSignature::IsWorthSigning(content.GetDataLen());
+    SFTPFileSignature::Ptr_t signature = DoGetSignature(req->GetKey());
+    if(signContent && signature) {
+        // We know what the remote file contains: if nobody else modified it since, only send the blocks that changed
+        SFTPAttribute::Ptr_t remoteAttr;
+        try {
+            remoteAttr = sftp->Stat(remoteFile);
+        } catch(clException&) {
+            // The file was removed
+        }
+
+        clSFTP::Ranges_t ranges;
+        wxInt64 changedBytes = signature->IsRemoteUnchanged(remoteAttr) ? signature->Diff(content, ranges) : -1;
+        // When most of the file changed (e.g. a line was inserted at the top), an atomic full upload is cheaper
+        if(changedBytes >= 0 && changedBytes <= (wxInt64)(content.GetDataLen() / 2)) {
+            // SFTP can't copy a file on the server, so the blocks are written into the live file. Forget the
+            // signature first: if the update does not complete, the remote content is unknown until the next
+            // full upload
+            DoSetSignature(req->GetKey(), SFTPFileSignature::Ptr_t(nullptr));
+            try {
+                sftp->WriteRanges(content, remoteFile, ranges);
+                signature.reset(new SFTPFileSignature(content, sftp->Stat(remoteFile)));
+                DoSetSignature(req->GetKey(), signature);
+                return changedBytes;
+
+            } catch(clException& e) {
+                // Replace the partially updated file with an atomic full upload
+                clWARNING() << "SFTP: delta upload of" << remoteFile << "failed:" << e.What()
+                            << ". Uploading the whole file" << clEndl;
+            }
+        }
+    }
+
+    SFTPAttribute::Ptr_t attr(new SFTPAttribute(NULL));
+    attr->SetPermissions(req->GetPermissions());
+    sftp->Mkpath(wxFileName(remoteFile).GetPath());
+    sftp->Write(content, remoteFile, attr);
+
+    signature.reset();
+    if(signContent) { signature.reset(new SFTPFileSignature(content, sftp->Stat(remoteFile))); }
+    DoSetSignature(req->GetKey(), signature);
+    return content.GetDataLen();
+}
+
+SFTPFileSignature::Ptr_t SFTPWorkerThread::DoGetSignature(const wxString& key)
+{
+    std::lock_guard<std::mutex> lock(m_signaturesMutex);
+    std::unordered_map<wxString, SFTPFileSignature::Ptr_t>::iterator iter = m_signatures.find(key);
+    return iter == m_signatures.end() ? SFTPFileSignature::Ptr_t(nullptr) : iter->second;
+}
+
+void SFTPWorkerThread::DoSetSignature(const wxString& key, SFTPFileSignature::Ptr_t signature)
+{
+    std::lock_guard<std::mutex> lock(m_signaturesMutex);
+    if(signature) {
+        m_signatures[key] = signature;
+    } else {
+        m_signatures.erase(key);
+    }
 }
 
-void SFTPWorkerThread::DoConnect(SFTPThreadRequet* req)
+clSFTP::Ptr_t SFTPWorkerThread::DoConnect(SFTPThreadRequet* req)
 {
     wxString accountName = req->GetAccount().GetAccountName();
     clSSH::Ptr_t ssh(new clSSH(req->GetAccount().GetHost(), req->GetAccount().GetUsername(),
@@ -180,22 +397,23 @@ void SFTPWorkerThread::DoConnect(SFTPThreadRequet* req)
         if(!ssh->AuthenticateServer(message)) { ssh->AcceptServerAuthentication(); }
 
         ssh->Login();
-        m_sftp.reset(new clSFTP(ssh));
+        clSFTP::Ptr_t sftp(new clSFTP(ssh));
 
         // associate the account with the connection
-        m_sftp->SetAccount(req->GetAccount().GetAccountName());
-        m_sftp->Initialize();
+        sftp->SetAccount(req->GetAccount().GetAccountName());
+        sftp->Initialize();
 
         wxString msg;
         msg << "Successfully connected to " << accountName;
         DoReportMessage(accountName, msg, SFTPThreadMessage::STATUS_OK);
+        return sftp;
 
     } catch(clException& e) {
         wxString msg;
         msg << "Connect error. " << e.What();
         DoReportMessage(accountName, msg, SFTPThreadMessage::STATUS_ERROR);
-        m_sftp.reset(NULL);
     }
+    return clSFTP::Ptr_t(NULL);
 }
 
 void SFTPWorkerThread::DoReportMessage(const wxString& account, const wxString& message, int status)
@@ -273,6 +491,9 @@ SFTPThreadRequet& SFTPThreadRequet::operator=(const SFTPThreadRequet& other)
     m_uploadSuccess = other.m_uploadSuccess;
     m_action = other.m_action;
     m_permissions = other.m_permissions;
+    m_newRemoteFile = other.m_newRemoteFile;
+    m_lineNumber = other.m_lineNumber;
+    m_priority = other.m_priority;
     return *this;
 }
 
@@ -280,6 +501,19 @@ SFTPThreadRequet::~SFTPThreadRequet() {}
 
 ThreadRequest* SFTPThreadRequet::Clone() const { return new SFTPThreadRequet(*this); }
 
+// -----------------------------------------
+// SFTPTransferStats
+// -----------------------------------------
+
+wxString SFTPTransferStats::ToString() const
+{
+    double kb = bytes / 1024.0;
+    wxString str;
+    str << wxString::Format("%.1f KB in %ld ms", kb, elapsedMs);
+    if(elapsedMs > 0) { str << wxString::Format(" (%.1f KB/s)", kb * 1000.0 / elapsedMs); }
+    return str;
+}
+
 // -----------------------------------------
 // SFTPThreadMessage
 // -----------------------------------------
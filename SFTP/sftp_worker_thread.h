@@ -26,10 +26,16 @@
 #ifndef SFTPWRITERTHREAD_H
 #define SFTPWRITERTHREAD_H
 
+#include "SFTPFileSignature.h"
+#include "SFTPRequestQueue.h"
 #include "cl_sftp.h"
 #include "remote_file_info.h"
 #include "ssh_account_info.h"
 #include "worker_thread.h" // Base class: WorkerThread
+#include "wxStringHash.h"
+#include <unordered_map>
+#include <vector>
+#include <wx/stopwatch.h>
 
 class SFTP;
 
@@ -43,6 +49,11 @@ enum class eSFTPActions {
     kDelete,
 };
 
+enum class eSFTPPriority {
+    kNormal,
+    kHigh, // e.g. saving the active editor: the user is waiting for it
+};
+
 class SFTPThreadRequet : public ThreadRequest
 {
     SSHAccountInfo m_account;
@@ -54,6 +65,7 @@ class SFTPThreadRequet : public ThreadRequest
     size_t m_permissions = 0;
     wxString m_newRemoteFile;
     int m_lineNumber = wxNOT_FOUND;
+    eSFTPPriority m_priority = eSFTPPriority::kNormal;
 
 public:
     SFTPThreadRequet(const SSHAccountInfo& accountInfo, const wxString& remoteFile, const wxString& localFile,
@@ -85,6 +97,12 @@ public:
     const wxString& GetNewRemoteFile() const { return m_newRemoteFile; }
     void SetLineNumber(int lineNumber) { this->m_lineNumber = lineNumber; }
     int GetLineNumber() const { return m_lineNumber; }
+    void SetPriority(eSFTPPriority priority) { this->m_priority = priority; }
+    eSFTPPriority GetPriority() const { return m_priority; }
+    /**
+     * @brief requests with the same key are executed in the order they were queued
+     */
+    wxString GetKey() const { return m_account.GetAccountName() + ":" + m_remoteFile; }
 };
 
 class SFTPThreadMessage
@@ -113,12 +131,52 @@ public:
     int GetStatus() const { return m_status; }
 };
 
+/**
+ * @class SFTPTransferStats
+ * @brief the amount of data transferred and the time it took. For the totals, the time is the sum of the time
+ * spent on each transfer
+ */
+struct SFTPTransferStats {
+    size_t files = 0;
+    wxInt64 bytes = 0;
+    long elapsedMs = 0;
+
+    void Add(const SFTPTransferStats& other)
+    {
+        files += other.files;
+        bytes += other.bytes;
+        elapsedMs += other.elapsedMs;
+    }
+    wxString ToString() const;
+};
+
+/**
+ * @class SFTPWorkerThread
+ * @brief executes the SFTP requests with a pool of workers. Every worker borrows a session to the request's account
+ * from a shared pool, so several files are transferred in parallel over separate sessions. High priority requests
+ * are served first; requests on the same remote file are executed in the order they were added
+ */
 class SFTPWorkerThread : public WorkerThread
 {
     static SFTPWorkerThread* ms_instance;
-    clSFTP::Ptr_t m_sftp;
     SFTP* m_plugin;
 
+    // The queue (protected by the base class mutex)
+    SFTPRequestQueue<SFTPThreadRequet> m_queue;
+    size_t m_activeCount;
+    bool m_stopping;
+    SFTPTransferStats m_batchStats;
+    SFTPTransferStats m_totalStats;
+    wxStopWatch m_batchTimer;
+
+    // Idle sessions, per account
+    std::mutex m_sessionsMutex;
+    std::unordered_map<wxString, std::vector<clSFTP::Ptr_t> > m_sessions;
+
+    // The signature of the last known content of the remote files, by request key
+    std::mutex m_signaturesMutex;
+    std::unordered_map<wxString, SFTPFileSignature::Ptr_t> m_signatures;
+
 public:
     static SFTPWorkerThread* Instance();
     static void Release();
@@ -126,13 +184,38 @@ public:
 private:
     SFTPWorkerThread();
     virtual ~SFTPWorkerThread();
-    void DoConnect(SFTPThreadRequet* req);
+    clSFTP::Ptr_t DoConnect(SFTPThreadRequet* req);
     void DoReportMessage(const wxString& account, const wxString& message, int status);
     void DoReportStatusBarMessage(const wxString& message);
+    void DoWorkerLoop();
+    SFTPThreadRequet* DoTakeRequest();
+    void DoRequestDone(SFTPThreadRequet* req, const SFTPTransferStats& stats);
+    clSFTP::Ptr_t DoGetSession(SFTPThreadRequet* req);
+    void DoReleaseSession(clSFTP::Ptr_t sftp);
+    void DoProcessRequest(SFTPThreadRequet* req, SFTPTransferStats& stats);
+    wxInt64 DoUpload(clSFTP::Ptr_t sftp, SFTPThreadRequet* req);
+    SFTPFileSignature::Ptr_t DoGetSignature(const wxString& key);
+    void DoSetSignature(const wxString& key, SFTPFileSignature::Ptr_t signature);
+
+protected:
+    virtual void* Entry();
 
 public:
     virtual void ProcessRequest(ThreadRequest* request);
     void SetSftpPlugin(SFTP* sftp);
+
+    /**
+     * @brief queue a request. The worker thread takes ownership of it
+     */
+    void Add(ThreadRequest* request);
+    /**
+     * @brief stop the workers. Pending requests are discarded
+     */
+    void Stop();
+    /**
+     * @brief return the statistics of all the transfers completed so far
+     */
+    SFTPTransferStats GetStats();
 };
 
 #endif // SFTPWRITERTHREAD_H
@@ -0,0 +1,96 @@
+#include "SFTPFileSignature.h"
+#include "tester.h"
+#include <stdio.h>
+#include <string.h>
+#include <wx/init.h>
+#include <wx/log.h>
+
+// Must match SFTP_SIGNATURE_BLOCK_SIZE
+#define BLOCK_SIZE 8192
+
+static wxMemoryBuffer MakeContent(size_t size, char fill)
+{
+    wxMemoryBuffer buffer;
+    memset(buffer.GetWriteBuf(size), fill, size);
+    buffer.UngetWriteBuf(size);
+    return buffer;
+}
+
+static SFTPFileSignature Sign(const wxMemoryBuffer& content)
+{
+    return SFTPFileSignature(content, SFTPAttribute::Ptr_t(nullptr));
+}
+
+TEST_FUNC(test_signature_unchanged)
+{
+    wxMemoryBuffer content = MakeContent(10 * BLOCK_SIZE + 100, 'a');
+    clSFTP::Ranges_t ranges;
+    CHECK_SIZE((int)Sign(content).Diff(content, ranges), 0);
+    CHECK_SIZE((int)ranges.size(), 0);
+    return true;
+}
+
+TEST_FUNC(test_signature_changed_blocks)
+{
+    wxMemoryBuffer oldContent = MakeContent(10 * BLOCK_SIZE, 'a');
+    wxMemoryBuffer newContent = MakeContent(10 * BLOCK_SIZE, 'a');
+    char* p = (char*)newContent.GetData();
+    p[BLOCK_SIZE + 1] = 'b';     // block 1
+    p[2 * BLOCK_SIZE + 5] = 'b'; // block 2
+    p[7 * BLOCK_SIZE] = 'b';     // block 7
+
+    clSFTP::Ranges_t ranges;
+    CHECK_SIZE((int)Sign(oldContent).Diff(newContent, ranges), 3 * BLOCK_SIZE);
+
+    // adjacent blocks are merged into a single range
+    CHECK_SIZE((int)ranges.size(), 2);
+    CHECK_BOOL(ranges[0].first == BLOCK_SIZE && ranges[0].second == 2 * BLOCK_SIZE);
+    CHECK_BOOL(ranges[1].first == 7 * BLOCK_SIZE && ranges[1].second == BLOCK_SIZE);
+    return true;
+}
+
+TEST_FUNC(test_signature_append)
+{
+    // the last old block is partial: it is rewritten together with the appended data
+    wxMemoryBuffer oldContent = MakeContent(4 * BLOCK_SIZE + 10, 'a');
+    wxMemoryBuffer newContent = MakeContent(6 * BLOCK_SIZE, 'a');
+
+    clSFTP::Ranges_t ranges;
+    CHECK_SIZE((int)Sign(oldContent).Diff(newContent, ranges), 2 * BLOCK_SIZE);
+    CHECK_SIZE((int)ranges.size(), 1);
+    CHECK_BOOL(ranges[0].first == 4 * BLOCK_SIZE && ranges[0].second == 2 * BLOCK_SIZE);
+    return true;
+}
+
+TEST_FUNC(test_signature_truncate)
+{
+    // a shorter file needs no data, the caller truncates the remote file
+    wxMemoryBuffer oldContent = MakeContent(6 * BLOCK_SIZE, 'a');
+    wxMemoryBuffer newContent = MakeContent(3 * BLOCK_SIZE, 'a');
+
+    clSFTP::Ranges_t ranges;
+    CHECK_SIZE((int)Sign(oldContent).Diff(newContent, ranges), 0);
+    CHECK_SIZE((int)ranges.size(), 0);
+
+    // unless the new last block is partial
+    newContent = MakeContent(3 * BLOCK_SIZE - 1, 'a');
+    CHECK_SIZE((int)Sign(oldContent).Diff(newContent, ranges), BLOCK_SIZE - 1);
+    CHECK_SIZE((int)ranges.size(), 1);
+    CHECK_BOOL(ranges[0].first == 2 * BLOCK_SIZE);
+    return true;
+}
+
+TEST_FUNC(test_signature_remote_unchanged)
+{
+    wxMemoryBuffer content = MakeContent(BLOCK_SIZE, 'a');
+    CHECK_BOOL(!Sign(content).IsRemoteUnchanged(SFTPAttribute::Ptr_t(nullptr)));
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    wxInitializer initializer(argc, argv);
+    wxLogNull NOLOG;
+    Tester::Instance()->RunTests();
+    return 0;
+}
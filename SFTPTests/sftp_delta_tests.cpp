@@ -0,0 +1,55 @@
+#include "SFTPFileSignature.h"
+#include "sftp_test_server.h"
+#include "tester.h"
+#include <wx/stopwatch.h>
+
+TEST_FUNC(test_sftp_delta_round_trip)
+{
+    SFTPTestServer server;
+    if(!server.Load()) {
+        printf("test_sftp_delta_round_trip: CL_SFTP_TEST_HOST/USER/DIR are not set, skipping\n");
+        return true;
+    }
+
+    try {
+        clSFTP::Ptr_t sftp = server.Connect();
+        wxString remoteFile = server.dir + "/delta.bin";
+        wxMemoryBuffer content = SFTPTestContent(server.sizeMB * 1024 * 1024, 1);
+        sftp->Write(content, remoteFile);
+
+        // Change a few blocks and send only them
+        SFTPFileSignature signature(content, sftp->Stat(remoteFile));
+        char* p = (char*)content.GetData();
+        p[100] ^= 0xFF;
+        p[content.GetDataLen() / 2] ^= 0xFF;
+        content.AppendData("appended", 8);
+
+        clSFTP::Ranges_t ranges;
+        wxInt64 changedBytes = signature.Diff(content, ranges);
+        wxStopWatch sw;
+        sftp->WriteRanges(content, remoteFile, ranges);
+        SFTPTestReportTransfer("delta upload", changedBytes, sw.Time());
+
+        wxMemoryBuffer remoteContent;
+        sftp->Read(remoteFile, remoteContent);
+        CHECK_BOOL(SFTPTestIsSameContent(content, remoteContent));
+
+        // Shrink the file: no data is sent, the remote file is truncated
+        SFTPFileSignature signature2(content, sftp->Stat(remoteFile));
+        content.SetDataLen(content.GetDataLen() / 3);
+        signature2.Diff(content, ranges);
+        sftp->WriteRanges(content, remoteFile, ranges);
+
+        remoteContent.SetDataLen(0);
+        sftp->Read(remoteFile, remoteContent);
+        CHECK_BOOL(SFTPTestIsSameContent(content, remoteContent));
+
+        sftp->UnlinkFile(remoteFile);
+        sftp->Close();
+
+    } catch(clException& e) {
+        printf("test_sftp_delta_round_trip: %s\n", e.What().mb_str(wxConvUTF8).data());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,107 @@
+#include "sftp_test_server.h"
+#include "tester.h"
+#include <libssh/libssh.h>
+#include <thread>
+#include <vector>
+#include <wx/stopwatch.h>
+
+TEST_FUNC(test_sftp_engine_round_trip)
+{
+    SFTPTestServer server;
+    if(!server.Load()) {
+        printf("test_sftp_engine_round_trip: CL_SFTP_TEST_HOST/USER/DIR are not set, skipping\n");
+        return true;
+    }
+
+#if LIBSSH_VERSION_INT >= SSH_VERSION_INT(0, 11, 0)
+    printf("    libssh %s: uploads are pipelined\n", SSH_STRINGIFY(LIBSSH_VERSION));
+#else
+    printf("    libssh %s: uploads are NOT pipelined (requires libssh >= 0.11)\n", SSH_STRINGIFY(LIBSSH_VERSION));
+#endif
+
+    try {
+        clSFTP::Ptr_t sftp = server.Connect();
+        wxString remoteFile = server.dir + "/round_trip.bin";
+        wxMemoryBuffer content = SFTPTestContent(server.sizeMB * 1024 * 1024, 1);
+
+        wxStopWatch sw;
+        sftp->Write(content, remoteFile);
+        SFTPTestReportTransfer("upload", content.GetDataLen(), sw.Time());
+
+        wxMemoryBuffer remoteContent;
+        sw.Start();
+        sftp->Read(remoteFile, remoteContent);
+        SFTPTestReportTransfer("download", remoteContent.GetDataLen(), sw.Time());
+        CHECK_BOOL(SFTPTestIsSameContent(content, remoteContent));
+
+        sftp->UnlinkFile(remoteFile);
+        sftp->Close();
+
+    } catch(clException& e) {
+        printf("test_sftp_engine_round_trip: %s\n", e.What().mb_str(wxConvUTF8).data());
+        return false;
+    }
+    return true;
+}
+
+TEST_FUNC(test_sftp_engine_parallel_sessions)
+{
+    SFTPTestServer server;
+    if(!server.Load()) {
+        printf("test_sftp_engine_parallel_sessions: CL_SFTP_TEST_HOST/USER/DIR are not set, skipping\n");
+        return true;
+    }
+
+    // Upload one file per session, concurrently, the way the SFTP worker pool does
+    size_t sessions = server.sessions > 0 ? server.sessions : 1;
+    std::vector<clSFTP::Ptr_t> connections;
+    try {
+        for(size_t i = 0; i < sessions; ++i) {
+            connections.push_back(server.Connect());
+        }
+    } catch(clException& e) {
+        printf("test_sftp_engine_parallel_sessions: %s\n", e.What().mb_str(wxConvUTF8).data());
+        return false;
+    }
+
+    std::vector<wxMemoryBuffer> contents;
+    std::vector<wxString> remoteFiles;
+    for(size_t i = 0; i < sessions; ++i) {
+        contents.push_back(SFTPTestContent(server.sizeMB * 1024 * 1024, i + 2));
+        remoteFiles.push_back(wxString() << server.dir << "/parallel_" << i << ".bin");
+    }
+
+    std::vector<char> results(sessions, false); // not vector<bool>: written from several threads
+    std::vector<std::thread> threads;
+    wxStopWatch sw;
+    for(size_t i = 0; i < sessions; ++i) {
+        threads.push_back(std::thread([&, i]() {
+            try {
+                connections[i]->Write(contents[i], remoteFiles[i]);
+                results[i] = true;
+            } catch(clException& e) {
+                printf("test_sftp_engine_parallel_sessions: %s\n", e.What().mb_str(wxConvUTF8).data());
+            }
+        }));
+    }
+    for(std::thread& t : threads) {
+        t.join();
+    }
+    wxString what = wxString::Format("upload x %u sessions", (unsigned int)sessions);
+    SFTPTestReportTransfer(what.mb_str(wxConvUTF8).data(), sessions * server.sizeMB * 1024 * 1024, sw.Time());
+
+    for(size_t i = 0; i < sessions; ++i) {
+        CHECK_BOOL(results[i]);
+        try {
+            wxMemoryBuffer remoteContent;
+            connections[i]->Read(remoteFiles[i], remoteContent);
+            CHECK_BOOL(SFTPTestIsSameContent(contents[i], remoteContent));
+            connections[i]->UnlinkFile(remoteFiles[i]);
+            connections[i]->Close();
+        } catch(clException& e) {
+            printf("test_sftp_engine_parallel_sessions: %s\n", e.What().mb_str(wxConvUTF8).data());
+            return false;
+        }
+    }
+    return true;
+}
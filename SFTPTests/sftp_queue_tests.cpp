@@ -0,0 +1,103 @@
+#include "SFTPRequestQueue.h"
+#include "tester.h"
+
+// The scheduling used by SFTPWorkerThread. It runs offline, with requests that only have a key and a priority
+namespace
+{
+enum class ePriority {
+    kNormal,
+    kHigh,
+};
+
+struct FakeRequest {
+    wxString key;
+    ePriority priority;
+    int id;
+
+    FakeRequest(const wxString& k, ePriority p, int i)
+        : key(k)
+        , priority(p)
+        , id(i)
+    {
+    }
+    const wxString& GetKey() const { return key; }
+    ePriority GetPriority() const { return priority; }
+};
+
+// Take the next request, mark it done and return its id
+int TakeAndComplete(SFTPRequestQueue<FakeRequest>& queue)
+{
+    FakeRequest* req = queue.Take();
+    if(!req) { return wxNOT_FOUND; }
+    int id = req->id;
+    queue.Done(req);
+    delete req;
+    return id;
+}
+} // namespace
+
+TEST_FUNC(test_sftp_queue_high_priority_first)
+{
+    SFTPRequestQueue<FakeRequest> queue;
+    queue.Push(new FakeRequest("a", ePriority::kNormal, 1));
+    queue.Push(new FakeRequest("b", ePriority::kNormal, 2));
+    queue.Push(new FakeRequest("c", ePriority::kHigh, 3));
+    queue.Push(new FakeRequest("d", ePriority::kNormal, 4));
+
+    // The high priority request first, then the others in the order they were queued
+    CHECK_SIZE(TakeAndComplete(queue), 3);
+    CHECK_SIZE(TakeAndComplete(queue), 1);
+    CHECK_SIZE(TakeAndComplete(queue), 2);
+    CHECK_SIZE(TakeAndComplete(queue), 4);
+    CHECK_BOOL(queue.IsEmpty());
+    CHECK_BOOL(queue.Take() == nullptr);
+    return true;
+}
+
+TEST_FUNC(test_sftp_queue_same_key_in_queue_order)
+{
+    SFTPRequestQueue<FakeRequest> queue;
+    queue.Push(new FakeRequest("a", ePriority::kNormal, 1));
+    queue.Push(new FakeRequest("a", ePriority::kHigh, 2));
+    queue.Push(new FakeRequest("b", ePriority::kNormal, 3));
+
+    // A high priority request does not overtake an earlier request on the same file
+    FakeRequest* first = queue.Take();
+    CHECK_BOOL(first != nullptr);
+    CHECK_SIZE(first->id, 1);
+
+    // While "a" runs, the second "a" is blocked but "b" is not
+    FakeRequest* second = queue.Take();
+    CHECK_BOOL(second != nullptr);
+    CHECK_SIZE(second->id, 3);
+    CHECK_BOOL(queue.Take() == nullptr);
+    CHECK_BOOL(!queue.IsEmpty());
+
+    queue.Done(first);
+    delete first;
+    CHECK_SIZE(TakeAndComplete(queue), 2);
+
+    queue.Done(second);
+    delete second;
+    CHECK_BOOL(queue.IsEmpty());
+    return true;
+}
+
+TEST_FUNC(test_sftp_queue_clear)
+{
+    SFTPRequestQueue<FakeRequest> queue;
+    queue.Push(new FakeRequest("a", ePriority::kNormal, 1));
+    queue.Push(new FakeRequest("a", ePriority::kNormal, 2));
+
+    FakeRequest* running = queue.Take();
+    CHECK_BOOL(running != nullptr);
+    queue.Clear();
+    CHECK_BOOL(queue.IsEmpty());
+    queue.Done(running);
+    delete running;
+
+    // The key is free again
+    queue.Push(new FakeRequest("a", ePriority::kNormal, 3));
+    CHECK_SIZE(TakeAndComplete(queue), 3);
+    return true;
+}
@@ -0,0 +1,90 @@
+#ifndef SFTP_TEST_SERVER_H
+#define SFTP_TEST_SERVER_H
+
+#include "cl_exception.h"
+#include "cl_sftp.h"
+#include "cl_ssh.h"
+#include <stdio.h>
+#include <string.h>
+#include <wx/utils.h>
+
+// The live tests run the SFTP engine against a real server. They are skipped unless the server is described by the
+// environment, e.g. for a local sshd:
+//
+//  CL_SFTP_TEST_HOST=localhost CL_SFTP_TEST_USER=$USER CL_SFTP_TEST_PASSWORD=... \
+//  CL_SFTP_TEST_DIR=/tmp/sftp-tests ./SFTPTests
+//
+// CL_SFTP_TEST_PORT (default: 22), CL_SFTP_TEST_SIZE (file size in MB, default: 4) and CL_SFTP_TEST_SESSIONS
+// (default: 4) are optional
+
+struct SFTPTestServer {
+    wxString host;
+    wxString user;
+    wxString password;
+    wxString dir;
+    long port = 22;
+    long sizeMB = 4;
+    long sessions = 4;
+
+    /**
+     * @brief read the server details from the environment
+     * @return false if the live tests should be skipped
+     */
+    bool Load()
+    {
+        if(!::wxGetEnv("CL_SFTP_TEST_HOST", &host) || !::wxGetEnv("CL_SFTP_TEST_USER", &user) ||
+           !::wxGetEnv("CL_SFTP_TEST_DIR", &dir)) {
+            return false;
+        }
+        ::wxGetEnv("CL_SFTP_TEST_PASSWORD", &password);
+
+        wxString value;
+        if(::wxGetEnv("CL_SFTP_TEST_PORT", &value)) { value.ToCLong(&port); }
+        if(::wxGetEnv("CL_SFTP_TEST_SIZE", &value)) { value.ToCLong(&sizeMB); }
+        if(::wxGetEnv("CL_SFTP_TEST_SESSIONS", &value)) { value.ToCLong(&sessions); }
+        return true;
+    }
+
+    /**
+     * @brief open a new session and make sure that the test folder exists
+     * @throw clException
+     */
+    clSFTP::Ptr_t Connect() const
+    {
+        clSSH::Ptr_t ssh(new clSSH(host, user, password, port));
+        ssh->Connect();
+        wxString message;
+        if(!ssh->AuthenticateServer(message)) { ssh->AcceptServerAuthentication(); }
+        ssh->Login();
+
+        clSFTP::Ptr_t sftp(new clSFTP(ssh));
+        sftp->Initialize();
+        sftp->Mkpath(dir);
+        return sftp;
+    }
+};
+
+inline wxMemoryBuffer SFTPTestContent(size_t size, unsigned int seed)
+{
+    wxMemoryBuffer buffer;
+    unsigned char* p = (unsigned char*)buffer.GetWriteBuf(size);
+    for(size_t i = 0; i < size; ++i) {
+        seed = seed * 1103515245 + 12345;
+        p[i] = (unsigned char)(seed >> 16);
+    }
+    buffer.UngetWriteBuf(size);
+    return buffer;
+}
+
+inline bool SFTPTestIsSameContent(const wxMemoryBuffer& a, const wxMemoryBuffer& b)
+{
+    return a.GetDataLen() == b.GetDataLen() && memcmp(a.GetData(), b.GetData(), a.GetDataLen()) == 0;
+}
+
+inline void SFTPTestReportTransfer(const char* what, size_t bytes, long ms)
+{
+    double mbs = ms > 0 ? ((double)bytes / (1024.0 * 1024.0)) / ((double)ms / 1000.0) : 0.0;
+    printf("    %-24s %10u bytes in %6ld ms (%.2f MB/s)\n", what, (unsigned int)bytes, ms, mbs);
+}
+
+#endif // SFTP_TEST_SERVER_H
@@ -8,12 +8,14 @@ class TailData
 {
 public:
     wxFileName filename;
+    size_t firstPos; // the file offset of the first line in the view
     size_t lastPos;
-    wxString displayedText;
+    wxString filter;
 
 public:
     TailData()
-        : lastPos(0)
+        : firstPos(0)
+        , lastPos(0)
     {
     }
 };
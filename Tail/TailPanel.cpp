@@ -11,11 +11,28 @@
 #include <imanager.h>
 #include <wx/ffile.h>
 #include <wx/filedlg.h>
+#include <wx/msgdlg.h>
+#include <wx/textdlg.h>
 #include "clThemeUpdater.h"
+#include <string.h>
+
+// The file is read in chunks of this size
+#define TAIL_CHUNK_SIZE (64 * 1024)
+
+// When the file grew by more than this since the last read (e.g. the view was paused), only its end is read
+#define TAIL_MAX_CATCHUP_BYTES (4 * 1024 * 1024)
+
+// A line without EOL that is longer than this is displayed as is
+#define TAIL_MAX_LINE_LENGTH (1024 * 1024)
+
+// "Load older lines" gives up after scanning this many chunks without a line to display (filtered out)
+#define TAIL_SCROLLBACK_CHUNKS 16
 
 TailPanel::TailPanel(wxWindow* parent, Tail* plugin)
     : TailPanelBase(parent)
+    , m_firstPos(0)
     , m_lastPos(0)
+    , m_olderLines(0)
     , m_plugin(plugin)
     , m_isDetached(false)
     , m_frame(NULL)
@@ -23,6 +40,7 @@ TailPanel::TailPanel(wxWindow* parent, Tail* plugin)
     clThemeUpdater::Get().RegisterWindow(this);
     clThemeUpdater::Get().RegisterWindow(m_staticTextFileName);
     
+    m_maxLines = wxMax(clConfig::Get().Read("tail-max-lines", 10000), 100);
     DoBuildToolbar();
     m_fileWatcher.reset(new clFileSystemWatcher());
     m_fileWatcher->SetOwner(this);
@@ -55,37 +73,148 @@ void TailPanel::DoClear()
     m_fileWatcher->Clear();
 
     m_file.Clear();
-    m_stc->SetReadOnly(false);
-    m_stc->ClearAll();
-    m_stc->SetReadOnly(true);
-    m_lastPos = 0;
+    m_partialLine.clear();
+    m_firstPos = m_lastPos = 0;
+    DoClearView();
 
     m_staticTextFileName->SetLabel(_("<No opened file>"));
     SetFrameTitle();
     Layout();
 }
 
+void TailPanel::DoClearView()
+{
+    m_stc->SetReadOnly(false);
+    m_stc->ClearAll();
+    m_stc->SetReadOnly(true);
+    m_lineOffsets.clear();
+    m_olderLines = 0;
+    // the partial line was not displayed yet
+    m_firstPos = m_lastPos - m_partialLine.length();
+}
+
 void TailPanel::OnFileModified(clFileSystemEvent& event)
 {
-    wxFileName fn(event.GetPath());
+    wxUnusedVar(event);
     // Get the current file size
     size_t cursize = FileUtils::GetFileSize(m_file);
+    if(cursize < m_lastPos) {
+        // Start over with the new content
+        m_partialLine.clear();
+        m_firstPos = m_lastPos = 0;
+        DoClearView();
+        m_lineOffsets.push_back(0);
+        DoAppendText(_(">>> File truncated <<<\n"));
+    }
+
+    if(cursize == m_lastPos) { return; }
+
+    bool skipFirstLine = false;
+    if((cursize - m_lastPos) > TAIL_MAX_CATCHUP_BYTES) {
+        // Too far behind: show the end of the file only. The skipped lines can be loaded with "Load older lines"
+        m_partialLine.clear();
+        m_lastPos = cursize - TAIL_MAX_CATCHUP_BYTES;
+        DoClearView();
+        skipFirstLine = true;
+    }
+    DoRead(cursize, skipFirstLine);
+}
+
+void TailPanel::DoRead(size_t upTo, bool skipFirstLine)
+{
     wxFFile fp(m_file.GetFullPath(), "rb");
-    if(fp.IsOpened() && fp.Seek(m_lastPos)) {
-        if(cursize > m_lastPos) {
-            size_t bufferSize = cursize - m_lastPos;
-            char* buffer = new char[bufferSize + 1];
-            if(fp.Read(buffer, bufferSize) == bufferSize) {
-                buffer[bufferSize] = '\0';
-                wxString content((const char*)buffer, wxConvUTF8);
-                DoAppendText(content);
+    if(!fp.IsOpened() || !fp.Seek(m_lastPos)) { return; }
+
+    std::vector<char> buffer(TAIL_CHUNK_SIZE);
+    while(m_lastPos < upTo) {
+        size_t count = wxMin((size_t)TAIL_CHUNK_SIZE, upTo - m_lastPos);
+        if(fp.Read(buffer.data(), count) != count) { break; }
+        m_lastPos += count;
+
+        size_t start = 0;
+        if(skipFirstLine) {
+            // We started reading in the middle of a line
+            const char* eol = (const char*)memchr(buffer.data(), '\n', count);
+            if(!eol) {
+                m_firstPos = m_lastPos;
+                continue;
             }
-            wxDELETEA(buffer);
-        } else {
-            DoAppendText(_("\n>>> File truncated <<<\n"));
+            start = (eol - buffer.data()) + 1;
+            m_firstPos = m_lastPos - count + start;
+            skipFirstLine = false;
+        }
+
+        // m_partialLine holds everything that was read since the last complete line
+        m_partialLine.append(buffer.data() + start, count - start);
+        size_t offset = m_lastPos - m_partialLine.length();
+        bool flush = (m_partialLine.length() >= TAIL_MAX_LINE_LENGTH);
+
+        wxString text;
+        std::vector<size_t> offsets;
+        size_t consumed = DoSplitLines(m_partialLine.c_str(), m_partialLine.length(), offset, flush, text, offsets);
+        m_partialLine.erase(0, consumed);
+
+        if(!offsets.empty()) {
+            m_lineOffsets.insert(m_lineOffsets.end(), offsets.begin(), offsets.end());
+            DoAppendText(text);
+            DoTrimHistory();
+        }
+    }
+}
+
+size_t TailPanel::DoSplitLines(const char* buffer, size_t len, size_t offset, bool flush, wxString& text,
+                               std::vector<size_t>& offsets) const
+{
+    size_t start = 0;
+    while(start < len) {
+        const char* eol = (const char*)memchr(buffer + start, '\n', len - start);
+        if(!eol && !flush) { break; }
+        size_t end = eol ? (eol - buffer) + 1 : len;
+
+        // Convert the line without its EOL, so patterns like "foo$" work
+        size_t lineLen = end - start;
+        while(lineLen && (buffer[start + lineLen - 1] == '\n' || buffer[start + lineLen - 1] == '\r')) {
+            --lineLen;
+        }
+        wxString line(buffer + start, wxConvUTF8, lineLen);
+        if(line.IsEmpty() && lineLen) { line = wxString::From8BitData(buffer + start, lineLen); }
+
+        if(!m_filterRegex || m_filterRegex->Matches(line)) {
+            // The view must have exactly one line per offset, but the editor breaks lines on a lone CR too
+            line.Replace("\r", " ");
+            text << line << (((end - start) > (lineLen + 1)) ? "\r\n" : "\n");
+            offsets.push_back(offset + start);
         }
-        m_lastPos = cursize;
+        start = end;
     }
+    return start;
+}
+
+void TailPanel::DoTrimHistory()
+{
+    // Don't drop the lines the user has just asked for with "Load older lines"
+    size_t maxLines = m_maxLines + m_olderLines;
+    if(m_lineOffsets.size() <= maxLines) { return; }
+
+    size_t excess = m_lineOffsets.size() - maxLines;
+    m_stc->SetReadOnly(false);
+    m_stc->DeleteRange(0, m_stc->PositionFromLine(excess));
+    m_stc->SetReadOnly(true);
+    m_lineOffsets.erase(m_lineOffsets.begin(), m_lineOffsets.begin() + excess);
+    m_firstPos = m_lineOffsets.front();
+}
+
+void TailPanel::DoReload()
+{
+    if(!m_file.IsOk()) { return; }
+
+    // Read the lines in the view again (e.g. with a new filter)
+    size_t upTo = m_lastPos;
+    size_t firstPos = m_firstPos;
+    m_partialLine.clear();
+    m_lastPos = ((upTo - firstPos) > TAIL_MAX_CATCHUP_BYTES) ? (upTo - TAIL_MAX_CATCHUP_BYTES) : firstPos;
+    DoClearView();
+    DoRead(upTo, m_lastPos > firstPos);
 }
 
 void TailPanel::DoAppendText(const wxString& text)
@@ -108,12 +237,7 @@ void TailPanel::OnThemeChanged(wxCommandEvent& event)
     m_stc->SetViewWhiteSpace(wxSTC_WS_VISIBLEALWAYS);
 }
 
-void TailPanel::OnClear(wxCommandEvent& event)
-{
-    m_stc->SetReadOnly(false);
-    m_stc->ClearAll();
-    m_stc->SetReadOnly(true);
-}
+void TailPanel::OnClear(wxCommandEvent& event) { DoClearView(); }
 
 void TailPanel::OnClearUI(wxUpdateUIEvent& event) { event.Enable(!m_stc->IsEmpty()); }
 
@@ -141,6 +265,8 @@ void TailPanel::DoOpen(const wxString& filename)
 {
     m_file = filename;
     m_lastPos = FileUtils::GetFileSize(m_file);
+    m_firstPos = m_lastPos;
+    m_partialLine.clear();
 
     wxArrayString recentItems = clConfig::Get().Read("tail", wxArrayString());
     if(recentItems.Index(m_file.GetFullPath()) == wxNOT_FOUND) {
@@ -193,10 +319,16 @@ void TailPanel::OnDetachWindowUI(wxUpdateUIEvent& event) { event.Enable(!m_isDet
 void TailPanel::Initialize(const TailData& tailData)
 {
     DoClear();
+    DoSetFilter(tailData.filter);
     if(tailData.filename.IsOk() && tailData.filename.Exists()) {
         DoOpen(tailData.filename.GetFullPath());
-        DoAppendText(tailData.displayedText);
-        m_lastPos = tailData.lastPos;
+
+        // Read the lines that were displayed back from the file
+        size_t upTo = wxMin(tailData.lastPos, m_lastPos);
+        size_t firstPos = wxMin(tailData.firstPos, upTo);
+        m_lastPos = ((upTo - firstPos) > TAIL_MAX_CATCHUP_BYTES) ? (upTo - TAIL_MAX_CATCHUP_BYTES) : firstPos;
+        m_firstPos = m_lastPos;
+        DoRead(upTo, m_lastPos > firstPos);
         SetFrameTitle();
     }
 }
@@ -204,12 +336,82 @@ void TailPanel::Initialize(const TailData& tailData)
 TailData TailPanel::GetTailData() const
 {
     TailData dt;
-    dt.displayedText = m_stc->GetText();
     dt.filename = m_file;
-    dt.lastPos = m_lastPos;
+    dt.firstPos = m_firstPos;
+    // the partial line is read again
+    dt.lastPos = m_lastPos - m_partialLine.length();
+    dt.filter = m_filter;
     return dt;
 }
 
+bool TailPanel::DoSetFilter(const wxString& filter)
+{
+    if(filter.IsEmpty()) {
+        m_filter.clear();
+        m_filterRegex.reset();
+        return true;
+    }
+
+    wxSharedPtr<wxRegEx> re(new wxRegEx(filter, wxRE_DEFAULT | wxRE_NOSUB));
+    if(!re->IsValid()) { return false; }
+    m_filter = filter;
+    m_filterRegex = re;
+    return true;
+}
+
+void TailPanel::OnFilter(wxCommandEvent& event)
+{
+    wxUnusedVar(event);
+    wxTextEntryDialog dlg(this, _("Show only the lines matching this regular expression (empty: show all lines)"),
+                          _("Filter lines"), m_filter);
+    if(dlg.ShowModal() != wxID_OK) { return; }
+
+    if(!DoSetFilter(dlg.GetValue())) {
+        ::wxMessageBox(_("Invalid regular expression"), "CodeLite", wxICON_WARNING | wxOK | wxCENTER, this);
+        return;
+    }
+    DoReload();
+}
+
+void TailPanel::OnFilterUI(wxUpdateUIEvent& event) { event.Check(!m_filter.IsEmpty()); }
+
+void TailPanel::OnLoadOlderLines(wxCommandEvent& event)
+{
+    wxUnusedVar(event);
+    wxFFile fp(m_file.GetFullPath(), "rb");
+    if(!fp.IsOpened()) { return; }
+
+    // Seek backward from the first line in the view
+    wxString text;
+    std::vector<size_t> offsets;
+    std::vector<char> buffer(TAIL_CHUNK_SIZE);
+    for(size_t i = 0; i < TAIL_SCROLLBACK_CHUNKS && offsets.empty() && m_firstPos > 0; ++i) {
+        size_t from = (m_firstPos > TAIL_CHUNK_SIZE) ? (m_firstPos - TAIL_CHUNK_SIZE) : 0;
+        size_t count = m_firstPos - from;
+        if(!fp.Seek(from) || fp.Read(buffer.data(), count) != count) { break; }
+
+        size_t start = 0;
+        if(from > 0) {
+            // the chunk starts in the middle of a line: leave it for the next chunk. A line longer than the chunk is
+            // split
+            const char* eol = (const char*)memchr(buffer.data(), '\n', count);
+            if(eol && (size_t)(eol - buffer.data() + 1) < count) { start = (eol - buffer.data()) + 1; }
+        }
+        DoSplitLines(buffer.data() + start, count - start, from + start, true, text, offsets);
+        m_firstPos = from + start;
+    }
+
+    if(offsets.empty()) { return; }
+    m_stc->SetReadOnly(false);
+    m_stc->InsertText(0, text);
+    m_stc->SetReadOnly(true);
+    m_lineOffsets.insert(m_lineOffsets.begin(), offsets.begin(), offsets.end());
+    m_olderLines += offsets.size();
+    m_stc->ScrollToLine(0);
+}
+
+void TailPanel::OnLoadOlderLinesUI(wxUpdateUIEvent& event) { event.Enable(m_file.IsOk() && m_firstPos > 0); }
+
 wxString TailPanel::GetTailTitle() const
 {
     wxString title;
@@ -237,6 +439,11 @@ void TailPanel::DoBuildToolbar()
     m_toolbar->AddTool(XRCID("tail_close"), _("Close file"), clGetManager()->GetStdIcons()->LoadBitmap("file_close"));
     m_toolbar->AddTool(XRCID("tail_clear"), _("Clear"), clGetManager()->GetStdIcons()->LoadBitmap("clear"));
     m_toolbar->AddSeparator();
+    m_toolbar->AddTool(XRCID("tail_filter"), _("Filter lines"), clGetManager()->GetStdIcons()->LoadBitmap("find"), "",
+                       wxITEM_CHECK);
+    m_toolbar->AddTool(XRCID("tail_load_older"), _("Load older lines"),
+                       clGetManager()->GetStdIcons()->LoadBitmap("up"));
+    m_toolbar->AddSeparator();
     m_toolbar->AddTool(XRCID("tail_pause"), _("Pause"), clGetManager()->GetStdIcons()->LoadBitmap("interrupt"));
     m_toolbar->AddTool(XRCID("tail_play"), _("Play"), clGetManager()->GetStdIcons()->LoadBitmap("debugger_start"));
     m_toolbar->AddSeparator();
@@ -247,12 +454,16 @@ void TailPanel::DoBuildToolbar()
     m_toolbar->Bind(wxEVT_TOOL_DROPDOWN, &TailPanel::OnOpenMenu, this, XRCID("tail_open"));
     m_toolbar->Bind(wxEVT_TOOL, &TailPanel::OnClose, this, XRCID("tail_close"));
     m_toolbar->Bind(wxEVT_TOOL, &TailPanel::OnClear, this, XRCID("tail_clear"));
+    m_toolbar->Bind(wxEVT_TOOL, &TailPanel::OnFilter, this, XRCID("tail_filter"));
+    m_toolbar->Bind(wxEVT_TOOL, &TailPanel::OnLoadOlderLines, this, XRCID("tail_load_older"));
     m_toolbar->Bind(wxEVT_TOOL, &TailPanel::OnPause, this, XRCID("tail_pause"));
     m_toolbar->Bind(wxEVT_TOOL, &TailPanel::OnPlay, this, XRCID("tail_play"));
     m_toolbar->Bind(wxEVT_TOOL, &TailPanel::OnDetachWindow, this, XRCID("tail_detach"));
 
     m_toolbar->Bind(wxEVT_UPDATE_UI, &TailPanel::OnCloseUI, this, XRCID("tail_close"));
     m_toolbar->Bind(wxEVT_UPDATE_UI, &TailPanel::OnClearUI, this, XRCID("tail_clear"));
+    m_toolbar->Bind(wxEVT_UPDATE_UI, &TailPanel::OnFilterUI, this, XRCID("tail_filter"));
+    m_toolbar->Bind(wxEVT_UPDATE_UI, &TailPanel::OnLoadOlderLinesUI, this, XRCID("tail_load_older"));
     m_toolbar->Bind(wxEVT_UPDATE_UI, &TailPanel::OnPauseUI, this, XRCID("tail_pause"));
     m_toolbar->Bind(wxEVT_UPDATE_UI, &TailPanel::OnPlayUI, this, XRCID("tail_play"));
     m_toolbar->Bind(wxEVT_UPDATE_UI, &TailPanel::OnDetachWindowUI, this, XRCID("tail_detach"));
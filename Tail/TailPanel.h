@@ -6,9 +6,13 @@
 #include "clEditorEditEventsHandler.h"
 #include "clFileSystemEvent.h"
 #include "clFileSystemWatcher.h"
+#include <deque>
 #include <map>
+#include <string>
 #include <vector>
 #include <wx/filename.h>
+#include <wx/regex.h>
+#include <wx/sharedptr.h>
 
 class TailFrame;
 class clToolBar;
@@ -17,7 +21,14 @@ class TailPanel : public TailPanelBase
 {
     clFileSystemWatcher::Ptr_t m_fileWatcher;
     wxFileName m_file;
-    size_t m_lastPos;
+    size_t m_firstPos; // the file offset of the first line in the view
+    size_t m_lastPos;  // the file offset we read up to
+    std::deque<size_t> m_lineOffsets; // the file offset of every line in the view
+    std::string m_partialLine;        // the last line, until its EOL is written
+    size_t m_maxLines;
+    size_t m_olderLines; // lines added by "Load older lines", kept on top of m_maxLines
+    wxString m_filter;
+    wxSharedPtr<wxRegEx> m_filterRegex;
     clEditEventsHandler::Ptr_t m_editEvents;
     std::map<int, wxString> m_recentItemsMap;
     Tail* m_plugin;
@@ -35,12 +46,23 @@ protected:
     virtual void OnClose(wxCommandEvent& event);
     virtual void OnCloseUI(wxUpdateUIEvent& event);
     void OnOpenRecentItem(wxCommandEvent& event);
+    void OnFilter(wxCommandEvent& event);
+    void OnFilterUI(wxUpdateUIEvent& event);
+    void OnLoadOlderLines(wxCommandEvent& event);
+    void OnLoadOlderLinesUI(wxUpdateUIEvent& event);
 
 private:
     void DoBuildToolbar();
     void DoClear();
+    void DoClearView();
     void DoOpen(const wxString& filename);
     void DoAppendText(const wxString& text);
+    void DoRead(size_t upTo, bool skipFirstLine);
+    void DoReload();
+    void DoTrimHistory();
+    bool DoSetFilter(const wxString& filter);
+    size_t DoSplitLines(const char* buffer, size_t len, size_t offset, bool flush, wxString& text,
+                        std::vector<size_t>& offsets) const;
     void DoPrepareRecentItemsMenu(wxMenu& menu);
     wxString GetTailTitle() const;
 
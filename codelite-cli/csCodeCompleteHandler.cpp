@@ -18,8 +18,9 @@ void csCodeCompleteHandler::DoProcessCommand(const JSONItem& options)
     handlerName << "code-complete-" << m_lang;
     csCommandHandlerBase::Ptr_t handler = m_codeCompleteHandlers.FindHandler(handlerName);
     if(!handler) {
-        clERROR() << "I have no handler for:" << handlerName;
+        ReportError(wxString() << "I have no handler for: " << handlerName);
         return;
     }
+    handler->SetReply(GetReply());
     handler->DoProcessCommand(options);
 }
@@ -12,6 +12,7 @@ class csCodeCompleteHandler : public csCommandHandlerBase
 
 public:
     virtual void DoProcessCommand(const JSONItem& options);
+    virtual csCommandHandlerBase::Ptr_t Clone() const { return Ptr_t(new csCodeCompleteHandler(m_manager)); }
     csCodeCompleteHandler(csManager* manager);
     virtual ~csCodeCompleteHandler();
 };
@@ -12,6 +12,7 @@ class csCodeCompletePhpHandler : public csCommandHandlerBase
 
 public:
     virtual void DoProcessCommand(const JSONItem& options);
+    virtual csCommandHandlerBase::Ptr_t Clone() const { return Ptr_t(new csCodeCompletePhpHandler(m_manager)); }
 
     csCodeCompletePhpHandler(csManager* manager);
     virtual ~csCodeCompletePhpHandler();
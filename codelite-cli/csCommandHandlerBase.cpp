@@ -1,10 +1,12 @@
 #include "csCommandHandlerBase.h"
 #include "csManager.h"
+#include <iostream>
 wxDEFINE_EVENT(wxEVT_COMMAND_PROCESSED, clCommandEvent);
 
 csCommandHandlerBase::csCommandHandlerBase(csManager* manager)
     : m_manager(manager)
     , m_notifyOnExit(true)
+    , m_reply(nullptr)
 {
 }
 
@@ -12,6 +14,8 @@ csCommandHandlerBase::~csCommandHandlerBase() {}
 
 void csCommandHandlerBase::NotifyCompletion()
 {
+    // The daemon keeps running after a command is processed
+    if(m_reply) { return; }
     clCommandEvent e(wxEVT_COMMAND_PROCESSED);
     m_manager->AddPendingEvent(e);
 }
@@ -24,3 +28,21 @@ void csCommandHandlerBase::Process(const JSONItem& options)
         NotifyCompletion();
     }
 }
+
+void csCommandHandlerBase::WriteResult(const JSONItem& result)
+{
+    if(m_reply) {
+        m_reply->result = result.format(false);
+        return;
+    }
+    char* output = result.FormatRawString(m_manager->GetConfig().IsPrettyJSON());
+    std::cout << output << std::endl;
+    clDEBUG1() << output;
+    free(output);
+}
+
+void csCommandHandlerBase::ReportError(const wxString& message)
+{
+    clERROR() << message;
+    if(m_reply) { m_reply->error = message; }
+}
@@ -11,36 +11,36 @@
 class csManager;
 wxDECLARE_EVENT(wxEVT_COMMAND_PROCESSED, clCommandEvent);
 
-#define CHECK_STR_PARAM(str_option, sVal)                       \
-    if(!options.hasNamedObject(str_option)) {                   \
-        clERROR() << "Command is missing field:" << str_option; \
-        NotifyCompletion();                                     \
-        return;                                                 \
-    }                                                           \
+#define CHECK_STR_PARAM(str_option, sVal)                                      \
+    if(!options.hasNamedObject(str_option)) {                                  \
+        ReportError(wxString() << "Command is missing field: " << str_option); \
+        NotifyCompletion();                                                    \
+        return;                                                                \
+    }                                                                          \
     sVal = options.namedObject(str_option).toString();
 
-#define CHECK_INT_PARAM(str_option, iVal)                       \
-    if(!options.hasNamedObject(str_option)) {                   \
-        clERROR() << "Command is missing field:" << str_option; \
-        NotifyCompletion();                                     \
-        return;                                                 \
-    }                                                           \
+#define CHECK_INT_PARAM(str_option, iVal)                                      \
+    if(!options.hasNamedObject(str_option)) {                                  \
+        ReportError(wxString() << "Command is missing field: " << str_option); \
+        NotifyCompletion();                                                    \
+        return;                                                                \
+    }                                                                          \
     iVal = options.namedObject(str_option).toInt();
 
-#define CHECK_BOOL_PARAM(str_option, bVal)                      \
-    if(!options.hasNamedObject(str_option)) {                   \
-        clERROR() << "Command is missing field:" << str_option; \
-        NotifyCompletion();                                     \
-        return;                                                 \
-    }                                                           \
+#define CHECK_BOOL_PARAM(str_option, bVal)                                     \
+    if(!options.hasNamedObject(str_option)) {                                  \
+        ReportError(wxString() << "Command is missing field: " << str_option); \
+        NotifyCompletion();                                                    \
+        return;                                                                \
+    }                                                                          \
     bVal = options.namedObject(str_option).toBool();
 
-#define CHECK_ARRSTR_PARAM(str_option, arrVal)                  \
-    if(!options.hasNamedObject(str_option)) {                   \
-        clERROR() << "Command is missing field:" << str_option; \
-        NotifyCompletion();                                     \
-        return;                                                 \
-    }                                                           \
+#define CHECK_ARRSTR_PARAM(str_option, arrVal)                                 \
+    if(!options.hasNamedObject(str_option)) {                                  \
+        ReportError(wxString() << "Command is missing field: " << str_option); \
+        NotifyCompletion();                                                    \
+        return;                                                                \
+    }                                                                          \
     arrVal = options.namedObject(str_option).toArrayString();
 
 #define CHECK_STR_PARAM_OPTIONAL(str_option, sVal) \
@@ -55,11 +55,21 @@ wxDECLARE_EVENT(wxEVT_COMMAND_PROCESSED, clCommandEvent);
 #define CHECK_ARRSTR_PARAM_OPTIONAL(str_option, arrVal) \
     if(options.hasNamedObject(str_option)) { arrVal = options.namedObject(str_option).toArrayString(); }
 
+/**
+ * @class csCommandReply
+ * @brief the outcome of a command processed by the daemon
+ */
+struct csCommandReply {
+    wxString result; // the command output, already formatted as JSON
+    wxString error;
+};
+
 class csCommandHandlerBase
 {
 protected:
     csManager* m_manager;
     bool m_notifyOnExit;
+    csCommandReply* m_reply;
 
 public:
     typedef wxSharedPtr<csCommandHandlerBase> Ptr_t;
@@ -67,6 +77,15 @@ public:
 protected:
     void NotifyCompletion();
     void SetNotifyCompletion(bool b) { m_notifyOnExit = b; }
+    /**
+     * @brief print the command result to stdout. When running inside the daemon, the result is stored in the reply
+     * instead
+     */
+    void WriteResult(const JSONItem& result);
+    /**
+     * @brief log an error. When running inside the daemon, the error is also returned to the client
+     */
+    void ReportError(const wxString& message);
 
 public:
     /**
@@ -81,6 +100,19 @@ public:
 
     csManager* GetSink() { return m_manager; }
 
+    /**
+     * @brief create a new handler of the same type. The daemon processes every request with its own handler
+     * instance so requests from different clients can run in parallel
+     */
+    virtual csCommandHandlerBase::Ptr_t Clone() const = 0;
+
+    /**
+     * @brief when set, the handler is running inside the daemon: the output goes to 'reply' instead of stdout
+     * and no completion event is sent
+     */
+    void SetReply(csCommandReply* reply) { m_reply = reply; }
+    csCommandReply* GetReply() const { return m_reply; }
+
     /**
      * @brief process a request from the command line and print the result to the stdout
      * @param the handler options
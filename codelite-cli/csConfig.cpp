@@ -4,6 +4,10 @@
 #include "file_logger.h"
 #include <wx/filename.h>
 
+#ifdef __WXMSW__
+#define DEFAULT_CONNECTION_STRING "tcp://127.0.0.1:5098"
+#endif
+
 csConfig::csConfig()
     : m_flags(0)
 {
@@ -22,4 +26,14 @@ void csConfig::Load()
     bool pretty_json = false;
     ini.Read("pretty_json", &pretty_json);
     EnableFlag(kPrettyJSON, pretty_json);
+
+    // The address the daemon listens on
+#ifdef __WXMSW__
+    wxString defaultConnectionString = DEFAULT_CONNECTION_STRING;
+#else
+    wxFileName socketPath(clStandardPaths::Get().GetUserDataDir(), "codelite-cli.sock");
+    wxString defaultConnectionString = "unix://" + socketPath.GetFullPath();
+#endif
+    ini.Read("connection_string", &m_connectionString, defaultConnectionString);
+    clDEBUG() << "connection_string =" << m_connectionString;
 }
@@ -0,0 +1,103 @@
+#include "csConnectionThread.h"
+#include "csManager.h"
+#include <ctype.h>
+#include <file_logger.h>
+#include <string>
+
+// Requests larger than this are rejected (and the connection is closed)
+#define CS_MAX_MESSAGE_SIZE (64 * 1024 * 1024)
+// A client that stops sending in the middle of a request for this long is disconnected
+#define CS_FRAME_TIMEOUT_SECONDS 30
+
+csConnectionThread::csConnectionThread(csManager* manager, clSocketBase* socket)
+    : csJoinableThread(manager)
+    , m_owner(manager)
+    , m_socket(socket)
+{
+}
+
+csConnectionThread::~csConnectionThread()
+{
+    // Join the thread before we close the socket it is using
+    Stop();
+    wxDELETE(m_socket);
+}
+
+void* csConnectionThread::Entry()
+{
+    FileLoggerNameRegistrar logName("Connection");
+    clDEBUG() << "Connection thread started";
+    try {
+        while(!TestDestroy()) {
+            wxString request;
+            int rc = DoReadRequest(request);
+            if(rc == clSocketBase::kTimeout) {
+                continue;
+            } else if(rc == clSocketBase::kError) {
+                break;
+            }
+            m_socket->WriteMessage(m_owner->ProcessRequest(request));
+        }
+    } catch(clSocketException& e) {
+        clDEBUG() << "Connection closed:" << e.what();
+    }
+
+    // Let the manager free us
+    NotifyGoingDown();
+    return NULL;
+}
+
+int csConnectionThread::DoReadRequest(wxString& request)
+{
+    // Wait for the next request in short slices, so we can notice that the daemon is going down
+    int rc = m_socket->SelectRead(1);
+    if(rc != clSocketBase::kSuccess) { return rc; }
+
+    // The frame is the message length as 10 decimal digits, followed by the UTF-8 message (see
+    // clSocketBase::WriteMessage()). Once it started, a frame is read as a whole: a read can not be resumed in the
+    // middle of it without losing the framing
+    char msglen[11] = { 0 };
+    if(DoReadFrame(msglen, sizeof(msglen) - 1) != clSocketBase::kSuccess) { return clSocketBase::kError; }
+    for(size_t i = 0; i < sizeof(msglen) - 1; ++i) {
+        if(!isdigit((unsigned char)msglen[i])) {
+            clWARNING() << "Invalid request header received, closing the connection" << clEndl;
+            return clSocketBase::kError;
+        }
+    }
+
+    long messageLen = ::atol(msglen);
+    if(messageLen > CS_MAX_MESSAGE_SIZE) {
+        clWARNING() << "Request of" << messageLen << "bytes is too big, closing the connection" << clEndl;
+        return clSocketBase::kError;
+    }
+
+    std::string message(messageLen, 0);
+    if(messageLen > 0 && DoReadFrame(&message[0], messageLen) != clSocketBase::kSuccess) {
+        return clSocketBase::kError;
+    }
+    request = wxString::FromUTF8(message.c_str(), message.length());
+    return clSocketBase::kSuccess;
+}
+
+int csConnectionThread::DoReadFrame(char* buffer, size_t length)
+{
+    size_t totalRead = 0;
+    int idleSeconds = 0;
+    while(totalRead < length) {
+        size_t bytesRead = 0;
+        int rc = m_socket->Read(buffer + totalRead, length - totalRead, bytesRead, 1);
+        if(rc == clSocketBase::kTimeout) {
+            if(TestDestroy() || ++idleSeconds >= CS_FRAME_TIMEOUT_SECONDS) {
+                clDEBUG() << "Timed out while reading a request, closing the connection" << clEndl;
+                return clSocketBase::kError;
+            }
+            continue;
+
+        } else if(rc != clSocketBase::kSuccess) {
+            return rc;
+        }
+        idleSeconds = 0;
+        totalRead += bytesRead;
+    }
+    return clSocketBase::kSuccess;
+}
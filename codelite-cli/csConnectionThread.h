@@ -0,0 +1,30 @@
+#ifndef CSCONNECTIONTHREAD_H
+#define CSCONNECTIONTHREAD_H
+
+#include "SocketAPI/clSocketBase.h"
+#include "csJoinableThread.h"
+
+class csManager;
+
+/**
+ * @class csConnectionThread
+ * @brief serve a single daemon client: read a request, process it and write back the reply, until the client
+ * disconnects. Requests from the same client are processed in order
+ */
+class csConnectionThread : public csJoinableThread
+{
+protected:
+    csManager* m_owner;
+    clSocketBase* m_socket;
+
+protected:
+    void* Entry();
+    int DoReadRequest(wxString& request);
+    int DoReadFrame(char* buffer, size_t length);
+
+public:
+    csConnectionThread(csManager* manager, clSocketBase* socket);
+    virtual ~csConnectionThread();
+};
+
+#endif // CSCONNECTIONTHREAD_H
@@ -1,4 +1,5 @@
 #include "csFindInFilesCommandHandler.h"
+#include "csFindInFilesResults.h"
 #include "search_thread.h"
 #include "csManager.h"
 
@@ -17,26 +18,38 @@ void csFindInFilesCommandHandler::DoProcessCommand(const JSONItem& options)
     CHECK_STR_PARAM("mask", m_mask);
     CHECK_BOOL_PARAM("case", m_case);
     CHECK_BOOL_PARAM("word", m_word);
+    bool refresh = false;
+    CHECK_BOOL_PARAM_OPTIONAL("refresh", refresh);
 
     if(m_folder.IsEmpty() || !wxFileName::DirExists(m_folder)) {
-        clERROR() << "Invalid input directory:" << m_folder;
+        ReportError(wxString() << "Invalid input directory: " << m_folder);
         return;
     }
     if(m_what.IsEmpty()) {
-        clERROR() << "what field is empty";
+        ReportError("what field is empty");
         return;
     }
 
-    // Since we use a background thread to process the data for us
-    // we don't want that the base class will notify-completion until the background thread
-    // has completed the search. We will do it ourself when the search thread complete its task
-    SetNotifyCompletion(false);
-
     SearchData* req = new SearchData();
     req->SetExtensions(m_mask);
     req->SetFindString(m_what);
     req->SetMatchCase(m_case);
     req->SetMatchWholeWord(m_word);
+
+    if(GetReply()) {
+        // Running inside the daemon: search the cached file list of the folder instead of crawling it again
+        wxArrayString files;
+        m_manager->GetFolderFiles(m_folder, m_mask, refresh, files);
+        req->SetFiles(files);
+        GetReply()->result = csFindInFilesResults::Search(req);
+        return;
+    }
+
+    // Since we use a background thread to process the data for us
+    // we don't want that the base class will notify-completion until the background thread
+    // has completed the search. We will do it ourself when the search thread complete its task
+    SetNotifyCompletion(false);
+
     wxArrayString folders;
     folders.Add(m_folder);
     req->SetRootDirs(folders);
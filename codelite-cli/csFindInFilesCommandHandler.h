@@ -14,6 +14,7 @@ class csFindInFilesCommandHandler : public csCommandHandlerBase
 
 public:
     virtual void DoProcessCommand(const JSONItem& options);
+    virtual csCommandHandlerBase::Ptr_t Clone() const { return Ptr_t(new csFindInFilesCommandHandler(m_manager)); }
 
 public:
     csFindInFilesCommandHandler(csManager* manager);
@@ -1,5 +1,83 @@
 #include "csFindInFilesResults.h"
+#include "file_logger.h"
+#include "search_thread.h"
+#include <chrono>
+#include <wx/app.h>
+#include <wx/thread.h>
 
-csFindInFilesResults::csFindInFilesResults() {}
+csFindInFilesResults::csFindInFilesResults(State::Ptr_t state)
+    : m_state(state)
+    , m_matches(cJSON_Array)
+{
+    Bind(wxEVT_SEARCH_THREAD_MATCHFOUND, &csFindInFilesResults::OnSearchThreadMatch, this);
+    Bind(wxEVT_SEARCH_THREAD_SEARCHSTARTED, &csFindInFilesResults::OnSearchThreadStarted, this);
+    Bind(wxEVT_SEARCH_THREAD_SEARCHCANCELED, &csFindInFilesResults::OnSearchThreadCancelled, this);
+    Bind(wxEVT_SEARCH_THREAD_SEARCHEND, &csFindInFilesResults::OnSearchThreadEneded, this);
+}
 
-csFindInFilesResults::~csFindInFilesResults() {}
+csFindInFilesResults::~csFindInFilesResults()
+{
+    Unbind(wxEVT_SEARCH_THREAD_MATCHFOUND, &csFindInFilesResults::OnSearchThreadMatch, this);
+    Unbind(wxEVT_SEARCH_THREAD_SEARCHSTARTED, &csFindInFilesResults::OnSearchThreadStarted, this);
+    Unbind(wxEVT_SEARCH_THREAD_SEARCHCANCELED, &csFindInFilesResults::OnSearchThreadCancelled, this);
+    Unbind(wxEVT_SEARCH_THREAD_SEARCHEND, &csFindInFilesResults::OnSearchThreadEneded, this);
+}
+
+wxString csFindInFilesResults::Search(SearchData* req)
+{
+    // The collector outlives this call if we stop waiting early, so the results are exchanged through a shared state.
+    // It deletes itself once the search thread is done with it
+    State::Ptr_t state(new State());
+    req->SetOwner(new csFindInFilesResults(state));
+    SearchThreadST::Get()->Add(req);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    while(!state->done) {
+        state->cv.wait_for(lock, std::chrono::milliseconds(100));
+        if(!state->done && wxThread::This() && wxThread::This()->TestDestroy()) {
+            clDEBUG() << "Search aborted: the daemon is going down";
+            return wxEmptyString;
+        }
+    }
+    return state->output;
+}
+
+void csFindInFilesResults::OnSearchThreadMatch(wxCommandEvent& event)
+{
+    SearchResultList* res = reinterpret_cast<SearchResultList*>(event.GetClientData());
+    JSONItem arr = m_matches.toElement();
+    SearchResultList::iterator iter = res->begin();
+    for(; iter != res->end(); ++iter) {
+        arr.arrayAppend(iter->ToJSON());
+    }
+    wxDELETE(res);
+}
+
+void csFindInFilesResults::OnSearchThreadStarted(wxCommandEvent& event)
+{
+    SearchData* data = reinterpret_cast<SearchData*>(event.GetClientData());
+    wxDELETE(data);
+}
+
+void csFindInFilesResults::OnSearchThreadCancelled(wxCommandEvent& event)
+{
+    // The search thread always sends the "end" event after the "cancelled" one
+    wxUnusedVar(event);
+}
+
+void csFindInFilesResults::OnSearchThreadEneded(wxCommandEvent& event)
+{
+    SearchSummary* summary = reinterpret_cast<SearchSummary*>(event.GetClientData());
+    if(summary) {
+        m_matches.toElement().arrayAppend(summary->ToJSON());
+        wxDELETE(summary);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        m_state->output = m_matches.toElement().format(false);
+        m_state->done = true;
+    }
+    m_state->cv.notify_one();
+    wxTheApp->ScheduleForDestruction(this);
+}
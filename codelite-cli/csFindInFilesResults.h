@@ -1,12 +1,49 @@
 #ifndef CSFINDINFILESRESULTS_H
 #define CSFINDINFILESRESULTS_H
 
-class csFindInFilesResults
+#include "JSON.h"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <wx/event.h>
+
+class SearchData;
+
+/**
+ * @class csFindInFilesResults
+ * @brief collect the matches of a single search request and hand them to the thread waiting for them.
+ * The search thread events are processed on the main thread, while the caller of Search() blocks in its own thread
+ */
+class csFindInFilesResults : public wxEvtHandler
 {
+    struct State {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool done = false;
+        wxString output;
+        typedef std::shared_ptr<State> Ptr_t;
+    };
+
+    State::Ptr_t m_state;
+    JSON m_matches;
+
+protected:
+    void OnSearchThreadMatch(wxCommandEvent& event);
+    void OnSearchThreadStarted(wxCommandEvent& event);
+    void OnSearchThreadCancelled(wxCommandEvent& event);
+    void OnSearchThreadEneded(wxCommandEvent& event);
+
+    csFindInFilesResults(State::Ptr_t state);
 
 public:
-    csFindInFilesResults();
     virtual ~csFindInFilesResults();
+
+    /**
+     * @brief queue 'req' to the search thread and wait for it to complete. Must not be called from the main thread
+     * @return the matches followed by the search summary, formatted as a JSON array. Empty if the calling thread
+     * was asked to exit before the search completed
+     */
+    static wxString Search(SearchData* req);
 };
 
 #endif // CSFINDINFILESRESULTS_H
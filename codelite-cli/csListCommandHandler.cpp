@@ -19,6 +19,10 @@ void csListCommandHandler::DoProcessCommand(const JSONItem& options)
 
     // Prepare the output
     wxDir dir(m_folder);
+    if(!dir.IsOpened()) {
+        ReportError(wxString() << "Could not open folder: " << m_folder);
+        return;
+    }
     wxString filename;
     bool cont = dir.GetFirst(&filename);
     JSON json(cJSON_Array);
@@ -32,8 +36,5 @@ void csListCommandHandler::DoProcessCommand(const JSONItem& options)
         arr.arrayAppend(entry);
         cont = dir.GetNext(&filename);
     }
-    char* result = arr.FormatRawString(m_manager->GetConfig().IsPrettyJSON());
-    clDEBUG() << result;
-    std::cout << result << std::endl;
-    free(result);
+    WriteResult(arr);
 }
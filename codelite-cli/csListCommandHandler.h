@@ -10,6 +10,7 @@ class csListCommandHandler : public csCommandHandlerBase
 
 public:
     virtual void DoProcessCommand(const JSONItem& options);
+    virtual csCommandHandlerBase::Ptr_t Clone() const { return Ptr_t(new csListCommandHandler(m_manager)); }
 
 public:
     csListCommandHandler(csManager* manager);
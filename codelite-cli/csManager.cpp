@@ -1,4 +1,6 @@
+#include "clFilesCollector.h"
 #include "csCodeCompleteHandler.h"
+#include "csConnectionThread.h"
 #include "csFindInFilesCommandHandler.h"
 #include "csListCommandHandler.h"
 #include "csManager.h"
@@ -10,9 +12,16 @@
 #include <algorithm>
 #include <iostream>
 #include <wx/app.h>
+#ifndef __WXMSW__
+#include <signal.h>
+#endif
+
+// How long the daemon trusts a cached folder listing
+#define FILES_CACHE_TTL_SECONDS 60
 
 csManager::csManager()
-    : m_startupCalled(false)
+    : m_networkThread(nullptr)
+    , m_startupCalled(false)
     , m_exitNow(false)
 {
     m_handlers.Register("list", csCommandHandlerBase::Ptr_t(new csListCommandHandler(this)));
@@ -36,6 +45,16 @@ csManager::~csManager()
         Unbind(wxEVT_SEARCH_THREAD_SEARCHCANCELED, &csManager::OnSearchThreadCancelled, this);
         Unbind(wxEVT_SEARCH_THREAD_SEARCHEND, &csManager::OnSearchThreadEneded, this);
     }
+
+    // Stop accepting new clients before we disconnect the existing ones
+    wxDELETE(m_networkThread);
+    std::for_each(m_connections.begin(), m_connections.end(), [&](csConnectionThread* conn) { delete conn; });
+    m_connections.clear();
+    if(m_startupCalled) {
+        Unbind(wxEVT_SOCKET_CONNECTION_READY, &csManager::OnNewConnection, this);
+        Unbind(wxEVT_SOCKET_SERVER_ERROR, &csManager::OnServerError, this);
+        Unbind(wxEVT_THREAD_GOING_DOWN, &csManager::OnConnectionThreadGoingDown, this);
+    }
     SearchThreadST::Get()->Stop();
 }
 
@@ -58,6 +77,11 @@ bool csManager::Startup()
     clDEBUG() << "Command:" << GetCommand();
     clDEBUG() << "Options:" << GetOptions();
 
+    if(m_command == "daemon") {
+        JSON root(m_options);
+        return StartDaemon(root.toElement());
+    }
+
     // Make sure we know how to handle this command
     csCommandHandlerBase::Ptr_t handler = m_handlers.FindHandler(m_command);
     if(handler == nullptr) {
@@ -112,3 +136,124 @@ void csManager::LoadCommandFromINI()
 }
 
 void csManager::OnExit() { wxExit(); }
+
+bool csManager::StartDaemon(const JSONItem& options)
+{
+    if(options.isOk() && options.hasNamedObject("connection-string")) {
+        m_config.SetConnectionString(options.namedObject("connection-string").toString());
+    }
+
+#ifndef __WXMSW__
+    // A client that disconnects while we are writing the reply must not kill the daemon
+    signal(SIGPIPE, SIG_IGN);
+#endif
+
+    Bind(wxEVT_SOCKET_CONNECTION_READY, &csManager::OnNewConnection, this);
+    Bind(wxEVT_SOCKET_SERVER_ERROR, &csManager::OnServerError, this);
+    Bind(wxEVT_THREAD_GOING_DOWN, &csManager::OnConnectionThreadGoingDown, this);
+
+    clDEBUG() << "Starting daemon on:" << m_config.GetConnectionString();
+    m_networkThread = new csNetworkThread(this, m_config);
+    m_networkThread->Start();
+    return true;
+}
+
+void csManager::OnNewConnection(clCommandEvent& event)
+{
+    clSocketBase* socket = reinterpret_cast<clSocketBase*>(event.GetClientData());
+    csConnectionThread* conn = new csConnectionThread(this, socket);
+    m_connections.insert(conn);
+    conn->Start();
+}
+
+void csManager::OnServerError(clCommandEvent& event)
+{
+    clERROR() << "Daemon error:" << event.GetString();
+    std::cerr << "codelite-cli: " << event.GetString() << std::endl;
+    wxExit();
+}
+
+void csManager::OnConnectionThreadGoingDown(clCommandEvent& event)
+{
+    csConnectionThread* conn = reinterpret_cast<csConnectionThread*>(event.GetClientData());
+    if(m_connections.erase(conn)) {
+        clDEBUG() << "Client disconnected";
+        delete conn;
+    }
+}
+
+wxString csManager::ProcessRequest(const wxString& request)
+{
+    csCommandReply reply;
+    int id = -1;
+    JSON root(request);
+    JSONItem req = root.toElement();
+    if(!req.isOk()) {
+        reply.error = "Invalid request: expected a JSON object";
+    } else {
+        id = req.namedObject("id").toInt(-1);
+        wxString command = req.namedObject("command").toString();
+        csCommandHandlerBase::Ptr_t handler = m_handlers.FindHandler(command);
+        if(!handler) {
+            reply.error << "Don't know how to handle command: " << command;
+        } else {
+            // Each request gets its own handler so clients can be served in parallel
+            csCommandHandlerBase::Ptr_t requestHandler = handler->Clone();
+            requestHandler->SetReply(&reply);
+            requestHandler->DoProcessCommand(req.namedObject("options"));
+        }
+    }
+    if(!reply.error.IsEmpty()) { clERROR() << "Request" << id << "failed:" << reply.error; }
+
+    // The command output is already formatted, splice it into the reply as-is instead of parsing it back
+    JSON response(cJSON_Object);
+    JSONItem res = response.toElement();
+    res.addProperty("id", id);
+    if(!reply.error.IsEmpty()) { res.addProperty("error", reply.error); }
+    wxString output = res.format(false);
+    output.RemoveLast();
+    output << ",\"result\":" << (reply.result.IsEmpty() ? wxString("null") : reply.result) << "}";
+    return output;
+}
+
+csPhpSymbols::Ptr_t csManager::GetPhpSymbols(const wxFileName& dbpath)
+{
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    wxString key = dbpath.GetFullPath();
+    std::unordered_map<wxString, csPhpSymbols::Ptr_t>::iterator iter = m_phpSymbols.find(key);
+    if(iter != m_phpSymbols.end()) { return iter->second; }
+
+    csPhpSymbols::Ptr_t symbols(new csPhpSymbols());
+    symbols->lookup.Open(dbpath);
+    if(!symbols->lookup.IsOpened()) { return csPhpSymbols::Ptr_t(); }
+    m_phpSymbols.insert({ key, symbols });
+    return symbols;
+}
+
+void csManager::GetFolderFiles(const wxString& folder, const wxString& mask, bool refresh, wxArrayString& files)
+{
+    wxString key;
+    key << folder << "|" << mask;
+    time_t now = time(nullptr);
+    if(!refresh) {
+        std::lock_guard<std::mutex> lock(m_cacheMutex);
+        std::unordered_map<wxString, FolderFiles>::iterator iter = m_folderFiles.find(key);
+        if(iter != m_folderFiles.end() && (now - iter->second.timestamp) < FILES_CACHE_TTL_SECONDS) {
+            files = iter->second.files;
+            return;
+        }
+    }
+
+    // Scan without holding the lock, other requests should not wait for us
+    clFilesScanner scanner;
+    std::vector<wxString> filesV;
+    scanner.Scan(folder, filesV, mask);
+    files.clear();
+    files.Alloc(filesV.size());
+    std::for_each(filesV.begin(), filesV.end(), [&](const wxString& file) { files.Add(file); });
+
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    FolderFiles& entry = m_folderFiles[key];
+    entry.timestamp = now;
+    entry.files = files;
+}
@@ -5,14 +5,44 @@
 #include "csCommandHandlerManager.h"
 #include "csConfig.h"
 #include "file_logger.h"
+#include "PHPLookupTable.h"
+#include "wxStringHash.h"
 #include <cl_command_event.h>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <unordered_set>
 #include <wx/event.h>
 
+class csNetworkThread;
+class csConnectionThread;
+
+/**
+ * @class csPhpSymbols
+ * @brief an opened PHP symbols database, kept by the daemon across requests. Lock 'mutex' while using 'lookup'
+ */
+struct csPhpSymbols {
+    std::mutex mutex;
+    PHPLookupTable lookup;
+    typedef std::shared_ptr<csPhpSymbols> Ptr_t;
+};
+
 class csManager : public wxEvtHandler
 {
+    struct FolderFiles {
+        time_t timestamp;
+        wxArrayString files;
+    };
+
     csConfig m_config;
     csCommandHandlerManager m_handlers;
+    csNetworkThread* m_networkThread;
+    std::unordered_set<csConnectionThread*> m_connections;
+
+    // Daemon caches, accessed from the connection threads
+    std::mutex m_cacheMutex;
+    std::unordered_map<wxString, csPhpSymbols::Ptr_t> m_phpSymbols;
+    std::unordered_map<wxString, FolderFiles> m_folderFiles;
 
     wxString m_command;
     wxString m_options;
@@ -32,9 +62,34 @@ public:
     const csConfig& GetConfig() const { return m_config; }
     void LoadCommandFromINI();
     void SetExitNow(bool b) { m_exitNow = b; }
-    
+
+    /**
+     * @brief process a single daemon request and return the reply. Called from the connection threads.
+     * The request is a JSON object: { "id": <number>, "command": <string>, "options": <object> } and the reply is:
+     * { "id": <number>, "error": <string, only on failure>, "result": <the command output or null> }
+     */
+    wxString ProcessRequest(const wxString& request);
+
+    /**
+     * @brief return the symbols database at 'dbpath', opening it on first use. Returns null if the database can
+     * not be opened
+     */
+    csPhpSymbols::Ptr_t GetPhpSymbols(const wxFileName& dbpath);
+
+    /**
+     * @brief return the files under 'folder' matching 'mask'. The list is cached for a short while, pass
+     * 'refresh' to scan the folder again
+     */
+    void GetFolderFiles(const wxString& folder, const wxString& mask, bool refresh, wxArrayString& files);
+
 protected:
     void OnExit();
+    bool StartDaemon(const JSONItem& options);
+
+    // Daemon events
+    void OnNewConnection(clCommandEvent& event);
+    void OnServerError(clCommandEvent& event);
+    void OnConnectionThreadGoingDown(clCommandEvent& event);
     
     // The handler completed
     void OnCommandProcessedCompleted(clCommandEvent& event);
@@ -20,9 +20,10 @@ void csParseFolderHandler::DoProcessCommand(const JSONItem& options)
     handlerName << "parse-" << m_language << "-" << (isDir ? "folder" : "file");
     csCommandHandlerBase::Ptr_t handler = m_parseHandlers.FindHandler(handlerName);
     if(!handler) {
-        clERROR() << "I have no handler for:" << handlerName;
+        ReportError(wxString() << "I have no handler for: " << handlerName);
         return;
     }
     clDEBUG() << "Using handler:" << handlerName;
+    handler->SetReply(GetReply());
     handler->DoProcessCommand(options);
 }
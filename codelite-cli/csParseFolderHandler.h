@@ -13,6 +13,7 @@ class csParseFolderHandler : public csCommandHandlerBase
 
 public:
     virtual void DoProcessCommand(const JSONItem& options);
+    virtual csCommandHandlerBase::Ptr_t Clone() const { return Ptr_t(new csParseFolderHandler(m_manager)); }
 
 public:
     csParseFolderHandler(csManager* manager);
@@ -14,6 +14,7 @@ protected:
     virtual void DoProcessCommand(const JSONItem& options);
 
 public:
+    virtual csCommandHandlerBase::Ptr_t Clone() const { return Ptr_t(new csParsePHPFolderHandler(m_manager)); }
     csParsePHPFolderHandler(csManager* manager);
     virtual ~csParsePHPFolderHandler();
 };
@@ -0,0 +1,154 @@
+#include "gdbmi.h"
+#include <stdio.h>
+#include <string.h>
+
+// Unit tests of the re-entrant MI parser (Debugger/gdbmi.cpp)
+
+static int s_failures = 0;
+
+#define MI_CHECK(cond)                                                  \
+    if(!(cond)) {                                                       \
+        printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        ++s_failures;                                                   \
+    }
+
+static bool testResultRecord()
+{
+    gdbmi::Parser parser;
+    gdbmi::ParsedResult result;
+    MI_CHECK(parser.Parse(std::string("123^done,value=\"42\",empty=\"\""), result));
+    MI_CHECK(result.line_type == gdbmi::LT_RESULT);
+    MI_CHECK(result.txid == "123");
+    MI_CHECK(result.line_type_context == "done");
+    MI_CHECK(result["value"].IsOk() && result["value"].IsString());
+    MI_CHECK(gdbmi::Parser::Unescape(result["value"].value) == "42");
+    MI_CHECK(result["empty"].IsOk() && result["empty"].value.empty());
+    MI_CHECK(!result["no_such_child"].IsOk());
+    MI_CHECK(!result.tree[10].IsOk());
+
+    MI_CHECK(parser.Parse(std::string("^error,msg=\"No symbol \\\"foo\\\" in current context.\""), result));
+    MI_CHECK(result.txid.empty());
+    MI_CHECK(result.line_type_context == "error");
+    MI_CHECK(gdbmi::Parser::Unescape(result["msg"].value) == "No symbol \"foo\" in current context.");
+    return true;
+}
+
+static bool testAsyncRecords()
+{
+    gdbmi::Parser parser;
+    gdbmi::ParsedResult result;
+    MI_CHECK(parser.Parse(std::string("*stopped,reason=\"breakpoint-hit\",frame={func=\"main\",args=[]},"
+                                      "thread-id=\"1\",stopped-threads=\"all\""),
+                          result));
+    MI_CHECK(result.line_type == gdbmi::LT_EXEC_ASYNC);
+    MI_CHECK(result.line_type_context == "stopped");
+    MI_CHECK(result["frame"].type == gdbmi::Node::kTuple);
+    MI_CHECK(result["frame"]["func"].value == "main");
+    MI_CHECK(result["frame"]["args"].type == gdbmi::Node::kList && result["frame"]["args"].size() == 0);
+    MI_CHECK(result["thread-id"].value == "1");
+
+    MI_CHECK(parser.Parse(std::string("=thread-group-added,id=\"i1\""), result));
+    MI_CHECK(result.line_type == gdbmi::LT_NOTIFY_ASYNC);
+    MI_CHECK(parser.Parse(std::string("+download"), result));
+    MI_CHECK(result.line_type == gdbmi::LT_STATUS_ASYNC && result.line_type_context == "download");
+    return true;
+}
+
+static bool testStreamRecords()
+{
+    gdbmi::Parser parser;
+    gdbmi::ParsedResult result;
+    MI_CHECK(parser.Parse(std::string("~\"Reading symbols...\\n\""), result));
+    MI_CHECK(result.line_type == gdbmi::LT_CONSOLE_STREAM);
+    MI_CHECK(result.tree.size() == 1);
+    MI_CHECK(gdbmi::Parser::Unescape(result.tree.children[0]->value) == "Reading symbols...\n");
+
+    MI_CHECK(parser.Parse(std::string("&\"warning\\t\\\"x\\\"\""), result));
+    MI_CHECK(result.line_type == gdbmi::LT_LOG_STREAM);
+    MI_CHECK(gdbmi::Parser::Unescape(result.tree.children[0]->value) == "warning\t\"x\"");
+
+    // garbage after the string
+    MI_CHECK(!parser.Parse(std::string("@\"out\"trailing"), result));
+    return true;
+}
+
+static bool testFrames()
+{
+    // Braces in function names used to break the old frame splitting
+    gdbmi::Parser parser;
+    gdbmi::ParsedResult result;
+    MI_CHECK(parser.Parse(std::string("^done,stack=[frame={level=\"0\",addr=\"0x0000000000401136\","
+                                      "func=\"operator()<{lambda(int)#1}>\",file=\"main.cpp\",line=\"7\"},"
+                                      "frame={level=\"1\",func=\"main\",file=\"main.cpp\",line=\"12\"}]"),
+                          result));
+    const gdbmi::Node& stack = result["stack"];
+    MI_CHECK(stack.type == gdbmi::Node::kList);
+    MI_CHECK(stack.size() == 2);
+    MI_CHECK(stack.children[0]->name == "frame");
+    MI_CHECK((*stack.children[0])["func"].value == "operator()<{lambda(int)#1}>");
+    MI_CHECK((*stack.children[0])["line"].value == "7");
+    MI_CHECK(stack[1]["level"].value == "1");
+    MI_CHECK(stack[1]["func"].value == "main");
+
+    // a list of values
+    MI_CHECK(parser.Parse(std::string("^done,register-names=[\"rax\",\"rbx\",\"\",\"rcx\"]"), result));
+    MI_CHECK(result["register-names"].size() == 4);
+    MI_CHECK(result["register-names"][3].value == "rcx");
+    MI_CHECK(result["register-names"][2].value.empty());
+    return true;
+}
+
+static bool testOctalEscapes()
+{
+    // Non ASCII bytes are printed as 3 digit octal escapes: "é" is \303\251. All the digits count
+    gdbmi::StringView str("\\303\\251", 8);
+    MI_CHECK(gdbmi::Parser::Unescape(str) == "\xc3\xa9");
+
+    gdbmi::StringView mixed("a\\101b\\0c", 9);
+    MI_CHECK(gdbmi::Parser::Unescape(mixed) == std::string("aAb\0c", 5));
+
+    // at most 3 digits
+    gdbmi::StringView longer("\\1011", 5);
+    MI_CHECK(gdbmi::Parser::Unescape(longer) == "A1");
+
+    // a trailing backslash is kept
+    gdbmi::StringView trailing("x\\", 2);
+    MI_CHECK(gdbmi::Parser::Unescape(trailing) == "x\\");
+    return true;
+}
+
+static bool testMalformed()
+{
+    gdbmi::Parser parser;
+    gdbmi::ParsedResult result;
+    MI_CHECK(!parser.Parse(std::string(""), result));
+    MI_CHECK(!parser.Parse(std::string("123"), result));
+    MI_CHECK(!parser.Parse(std::string("(gdb) "), result));
+    MI_CHECK(!parser.Parse(std::string("^done,value=\"unterminated"), result));
+    MI_CHECK(!parser.Parse(std::string("^done,value=\"1\"\\"), result));
+    MI_CHECK(!parser.Parse(std::string("^done,tuple={a=\"1\""), result));
+    MI_CHECK(!parser.Parse(std::string("^done,list=[\"1\",]"), result));
+    MI_CHECK(!parser.Parse(std::string("^done,=\"1\""), result));
+
+    // the partial result is still usable
+    MI_CHECK(!parser.Parse(std::string("^done,a=\"1\",b="), result));
+    MI_CHECK(result["a"].value == "1");
+
+    // deep nesting is rejected instead of overflowing the stack
+    std::string deep = "^done,v=" + std::string(100000, '[');
+    MI_CHECK(!parser.Parse(deep, result));
+    return true;
+}
+
+bool testMIParser()
+{
+    s_failures = 0;
+    testResultRecord();
+    testAsyncRecords();
+    testStreamRecords();
+    testFrames();
+    testOctalEscapes();
+    testMalformed();
+    printf("gdbmi::Parser: %s (%d failure(s))\n", s_failures ? "FAILED" : "OK", s_failures);
+    return s_failures == 0;
+}
@@ -61,11 +61,13 @@ bool testParseLocals();
 bool testTokens();
 bool testChildrenParser();
 void testRegisterNames();
+bool testMIParser();
 
 int main(int argc, char **argv)
 {
     //testTokens();
     testChildrenParser();
+    testMIParser();
 //  testRegisterNames();
     return 0;
 }
@@ -310,58 +310,50 @@ void GitConsole::OnConfigurationChanged(wxCommandEvent& e)
     m_isVerbose = (data.GetFlags() & GitEntry::Git_Verbose_Log);
 }
 
-void GitConsole::UpdateTreeView(const wxString& output)
+void GitConsole::UpdateTreeView(const GitStatusCache::Entry::Vec_t& entries)
 {
     Clear();
     wxVector<wxVariant> cols;
-    wxArrayString files = ::wxStringTokenize(output, "\n\r", wxTOKEN_STRTOK);
-    std::sort(files.begin(), files.end());
-
-    BitmapLoader* bitmaps = clGetManager()->GetStdIcons();
-    for(size_t i = 0; i < files.GetCount(); ++i) {
-        wxString filename = files.Item(i);
-        filename.Trim().Trim(false);
-        filename.Replace("\t", " ");
-        wxString prefix = filename.BeforeFirst(' ');
-        filename = filename.AfterFirst(' ');
+    for(size_t i = 0; i < entries.size(); ++i) {
+        const GitStatusCache::Entry& entry = entries[i];
+        const wxString& filename = entry.relativePath;
         wxString filenameFullpath = filename;
 
-        filename.Trim().Trim(false);
-
-        wxFileName fn(filename);
-        if(fn.IsRelative()) {
-            fn.MakeAbsolute(m_git->GetRepositoryDirectory());
-            if(fn.FileExists()) { filenameFullpath = fn.GetFullPath(); }
-        }
-
-        if(filename.EndsWith("/")) { continue; }
-        wxChar chX = prefix[0];
-        wxChar chY = 0;
-        if(prefix.length() > 1) { chY = prefix[1]; }
+        wxFileName fn(entry.fullpath);
+        if(fn.FileExists()) { filenameFullpath = fn.GetFullPath(); }
 
+        wxChar chX = entry.GetKind();
         wxBitmap statusBmp;
         eGitFile kind = eGitFile::kUntrackedFile;
-        switch(chX) {
-        case 'M':
+        if(entry.IsConflict()) {
+            chX = 'U';
             statusBmp = m_modifiedBmp;
             kind = eGitFile::kModifiedFile;
-            break;
-        case 'A':
-            statusBmp = m_newBmp;
-            kind = eGitFile::kNewFile;
-            break;
-        case 'D':
-            statusBmp = m_deleteBmp;
-            kind = eGitFile::kDeletedFile;
-            break;
-        case 'R':
-            statusBmp = m_modifiedBmp;
-            kind = eGitFile::kRenamedFile;
-            break;
-        default:
-            statusBmp = m_untrackedBmp;
-            kind = eGitFile::kUntrackedFile;
-            break;
+        } else {
+            switch(chX) {
+            case 'M':
+            case 'T':
+                statusBmp = m_modifiedBmp;
+                kind = eGitFile::kModifiedFile;
+                break;
+            case 'A':
+            case 'C':
+                statusBmp = m_newBmp;
+                kind = eGitFile::kNewFile;
+                break;
+            case 'D':
+                statusBmp = m_deleteBmp;
+                kind = eGitFile::kDeletedFile;
+                break;
+            case 'R':
+                statusBmp = m_modifiedBmp;
+                kind = eGitFile::kRenamedFile;
+                break;
+            default:
+                statusBmp = m_untrackedBmp;
+                kind = eGitFile::kUntrackedFile;
+                break;
+            }
         }
 
         if(kind != eGitFile::kUntrackedFile) {
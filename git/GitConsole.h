@@ -25,6 +25,7 @@
 
 #ifndef GITCONSOLE_H
 #define GITCONSOLE_H
+#include "GitStatusCache.h"
 #include "bitmap_loader.h"
 #include "clGenericSTCStyler.h"
 #include "gitui.h"
@@ -51,7 +52,7 @@ public:
     void AddRawText(const wxString& text);
     void AddText(const wxString& text);
     bool IsVerbose() const;
-    void UpdateTreeView(const wxString& output);
+    void UpdateTreeView(const GitStatusCache::Entry::Vec_t& entries);
 
     /**
      * @brief return true if there are any deleted/new/modified items
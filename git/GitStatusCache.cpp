@@ -0,0 +1,193 @@
+#include "GitStatusCache.h"
+#include <algorithm>
+#include <wx/filename.h>
+#include <wx/tokenzr.h>
+
+// Return the position following the first 'count' space separated fields of 'line'
+static size_t SkipFields(const wxString& line, size_t count)
+{
+    size_t pos = 0;
+    for(size_t i = 0; i < count; ++i) {
+        pos = line.find(' ', pos);
+        if(pos == wxString::npos) { return wxString::npos; }
+        ++pos;
+    }
+    return pos;
+}
+
+static bool SortByRelativePath(const GitStatusCache::Entry& a, const GitStatusCache::Entry& b)
+{
+    return a.relativePath < b.relativePath;
+}
+
+GitStatusCache::GitStatusCache() {}
+
+GitStatusCache::~GitStatusCache() {}
+
+wxString GitStatusCache::Unquote(const wxString& path) const
+{
+    // git quotes paths containing "unusual" characters the same way as a C string
+    if(path.length() < 2 || !path.StartsWith("\"") || !path.EndsWith("\"")) { return path; }
+
+    wxString res;
+    for(size_t i = 1; i < path.length() - 1; ++i) {
+        wxChar ch = path[i];
+        if(ch != '\\' || (i + 2) == path.length()) {
+            res << ch;
+            continue;
+        }
+
+        ch = path[++i];
+        switch(ch) {
+        case 'n':
+            res << '\n';
+            break;
+        case 't':
+            res << '\t';
+            break;
+        case 'r':
+            res << '\r';
+            break;
+        case 'a':
+            res << '\a';
+            break;
+        case 'b':
+            res << '\b';
+            break;
+        case 'f':
+            res << '\f';
+            break;
+        case 'v':
+            res << '\v';
+            break;
+        default:
+            if(ch >= '0' && ch <= '7') {
+                unsigned int number = ch - '0';
+                for(size_t n = 1; n < 3 && (i + 2) < path.length() && path[i + 1] >= '0' && path[i + 1] <= '7'; ++n) {
+                    number = (number * 8) + ((wxChar)path[++i] - '0');
+                }
+                res << (wxChar)number;
+            } else {
+                // \" and \\ .
+                res << ch;
+            }
+            break;
+        }
+    }
+    return res;
+}
+
+bool GitStatusCache::ParseLine(const wxString& line, const wxString& repoDir, Entry& entry) const
+{
+    // The porcelain v2 format:
+    // 1 XY sub mH mI mW hH hI path
+    // 2 XY sub mH mI mW hH hI Xscore path<TAB>origPath
+    // u XY sub m1 m2 m3 mW h1 h2 h3 path
+    // ? path
+    // ! path
+    // # header (branch info)
+    if(line.length() < 3) { return false; }
+
+    size_t pathPos = wxString::npos;
+    switch((wxChar)line[0]) {
+    case '1':
+        pathPos = SkipFields(line, 8);
+        break;
+    case '2':
+        pathPos = SkipFields(line, 9);
+        break;
+    case 'u':
+        pathPos = SkipFields(line, 10);
+        break;
+    case '?':
+        entry.x = entry.y = '?';
+        pathPos = 2;
+        break;
+    default:
+        // ignored files and headers
+        return false;
+    }
+
+    if(pathPos == wxString::npos || pathPos >= line.length()) { return false; }
+    if(line[0] != '?') {
+        entry.x = line[2];
+        entry.y = line.length() > 3 ? (wxChar)line[3] : (wxChar)'.';
+    }
+
+    wxString path = line.Mid(pathPos);
+    if(line[0] == '2') {
+        // we only keep the new name of a renamed (or copied) file
+        path = path.BeforeFirst('\t');
+    }
+    path = Unquote(path);
+
+    // untracked folders (without --untracked-files=all) are listed with a trailing slash
+    if(path.IsEmpty() || path.EndsWith("/")) { return false; }
+
+    wxFileName fn(path);
+    fn.MakeAbsolute(repoDir);
+    entry.fullpath = fn.GetFullPath();
+    entry.relativePath = path;
+    return true;
+}
+
+bool GitStatusCache::Update(const wxString& output, const wxString& repoDir, wxStringSet_t& changed)
+{
+    Entry::Map_t entries;
+    wxArrayString lines = ::wxStringTokenize(output, "\r\n", wxTOKEN_STRTOK);
+    for(size_t i = 0; i < lines.GetCount(); ++i) {
+        Entry entry;
+        if(ParseLine(lines.Item(i), repoDir, entry)) { entries[entry.fullpath] = entry; }
+    }
+
+    // Diff against the previous snapshot
+    Entry::Map_t::const_iterator iter = entries.begin();
+    for(; iter != entries.end(); ++iter) {
+        Entry::Map_t::const_iterator prev = m_entries.find(iter->first);
+        if(prev == m_entries.end() || prev->second != iter->second) { changed.insert(iter->first); }
+    }
+
+    iter = m_entries.begin();
+    for(; iter != m_entries.end(); ++iter) {
+        if(entries.count(iter->first) == 0) { changed.insert(iter->first); }
+    }
+
+    bool firstSnapshot = !m_hasSnapshot;
+    m_entries.swap(entries);
+    m_hasSnapshot = true;
+    return firstSnapshot || !changed.empty();
+}
+
+const GitStatusCache::Entry* GitStatusCache::Find(const wxString& fullpath) const
+{
+    Entry::Map_t::const_iterator iter = m_entries.find(fullpath);
+    if(iter == m_entries.end()) { return nullptr; }
+    return &iter->second;
+}
+
+GitStatusCache::Entry::Vec_t GitStatusCache::GetSortedEntries() const
+{
+    Entry::Vec_t entries;
+    entries.reserve(m_entries.size());
+    Entry::Map_t::const_iterator iter = m_entries.begin();
+    for(; iter != m_entries.end(); ++iter) {
+        entries.push_back(iter->second);
+    }
+    std::sort(entries.begin(), entries.end(), SortByRelativePath);
+    return entries;
+}
+
+void GitStatusCache::GetModifiedFiles(wxStringSet_t& files) const
+{
+    files.clear();
+    Entry::Map_t::const_iterator iter = m_entries.begin();
+    for(; iter != m_entries.end(); ++iter) {
+        if(!iter->second.IsUntracked()) { files.insert(iter->first); }
+    }
+}
+
+void GitStatusCache::Clear()
+{
+    m_entries.clear();
+    m_hasSnapshot = false;
+}
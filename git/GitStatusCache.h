@@ -0,0 +1,80 @@
+#ifndef GITSTATUSCACHE_H
+#define GITSTATUSCACHE_H
+
+#include "macros.h"
+#include "wxStringHash.h"
+#include <unordered_map>
+#include <vector>
+#include <wx/string.h>
+
+/**
+ * @class GitStatusCache
+ * @brief the last known "git status" of the repository. Each refresh is diffed against the previous snapshot so
+ * the UI only needs to update the files whose status actually changed
+ */
+class GitStatusCache
+{
+public:
+    struct Entry {
+        wxString fullpath;
+        wxString relativePath; // as reported by git, relative to the repository root
+        wxChar x = '.';        // the index status ('?' for untracked files)
+        wxChar y = '.';        // the work tree status
+
+        /**
+         * @brief the single letter describing the change ('M', 'A', 'D', 'R', 'U', '?' ...)
+         */
+        wxChar GetKind() const { return x != '.' ? x : y; }
+        bool IsUntracked() const { return x == '?'; }
+        bool IsConflict() const { return x == 'U' || y == 'U' || (x == 'A' && y == 'A') || (x == 'D' && y == 'D'); }
+        bool operator==(const Entry& other) const
+        {
+            return x == other.x && y == other.y && relativePath == other.relativePath;
+        }
+        bool operator!=(const Entry& other) const { return !(*this == other); }
+
+        typedef std::vector<Entry> Vec_t;
+        typedef std::unordered_map<wxString, Entry> Map_t;
+    };
+
+protected:
+    Entry::Map_t m_entries;
+    bool m_hasSnapshot = false;
+
+protected:
+    bool ParseLine(const wxString& line, const wxString& repoDir, Entry& entry) const;
+    wxString Unquote(const wxString& path) const;
+
+public:
+    GitStatusCache();
+    virtual ~GitStatusCache();
+
+    /**
+     * @brief replace the snapshot with the output of "git status --porcelain=v2"
+     * @param changed [output] the full path of every file whose status differs from the previous snapshot
+     * @return true if the view needs to be updated (something changed or this is the first snapshot)
+     */
+    bool Update(const wxString& output, const wxString& repoDir, wxStringSet_t& changed);
+
+    /**
+     * @brief return the file status or nullptr if the file is unmodified (or unknown)
+     */
+    const Entry* Find(const wxString& fullpath) const;
+
+    /**
+     * @brief return the entries sorted by their relative path
+     */
+    Entry::Vec_t GetSortedEntries() const;
+
+    /**
+     * @brief return the tracked files with local changes (staged or not)
+     */
+    void GetModifiedFiles(wxStringSet_t& files) const;
+
+    /**
+     * @brief drop the snapshot. The next update is reported as a change
+     */
+    void Clear();
+};
+
+#endif // GITSTATUSCACHE_H
@@ -58,6 +58,7 @@
 #include "dirsaver.h"
 #include "environmentconfig.h"
 #include "file_logger.h"
+#include "fileutils.h"
 #include "gitBlameDlg.h"
 #include "gitCloneDlg.h"
 #include "icons/icon_git.xpm"
@@ -115,6 +116,8 @@ END_EVENT_TABLE()
 
 GitPlugin::GitPlugin(IManager* manager)
     : IPlugin(manager)
+    , m_indexModificationTime(0)
+    , m_indexSize(0)
     , m_colourTrackedFile(wxT("DARK GREEN"))
     , m_colourDiffFile(wxT("MAROON"))
     , m_pathGITExecutable(wxT("git"))
@@ -154,6 +157,7 @@ GitPlugin::GitPlugin(IManager* manager)
     EventNotifier::Get()->Bind(wxEVT_CONTEXT_MENU_FOLDER, &GitPlugin::OnFolderMenu, this);
     EventNotifier::Get()->Bind(wxEVT_ACTIVE_PROJECT_CHANGED, &GitPlugin::OnActiveProjectChanged, this);
     EventNotifier::Get()->Bind(wxEVT_CODELITE_MAINFRAME_GOT_FOCUS, &GitPlugin::OnAppActivated, this);
+    Bind(wxEVT_FILE_MODIFIED, &GitPlugin::OnRepositoryFileModified, this);
     EventNotifier::Get()->Bind(wxEVT_FILES_MODIFIED_REPLACE_IN_FILES, &GitPlugin::OnReplaceInFiles, this);
 
     wxTheApp->Bind(wxEVT_MENU, &GitPlugin::OnFolderPullRebase, this, XRCID("git_pull_rebase_folder"));
@@ -408,6 +412,7 @@ void GitPlugin::UnPlug()
                                      wxCommandEventHandler(GitPlugin::OnWorkspaceConfigurationChanged), NULL, this);
     EventNotifier::Get()->Unbind(wxEVT_ACTIVE_PROJECT_CHANGED, &GitPlugin::OnActiveProjectChanged, this);
     EventNotifier::Get()->Unbind(wxEVT_CODELITE_MAINFRAME_GOT_FOCUS, &GitPlugin::OnAppActivated, this);
+    Unbind(wxEVT_FILE_MODIFIED, &GitPlugin::OnRepositoryFileModified, this);
     EventNotifier::Get()->Unbind(wxEVT_FILES_MODIFIED_REPLACE_IN_FILES, &GitPlugin::OnReplaceInFiles, this);
 
     /*Context Menu*/
@@ -502,6 +507,7 @@ void GitPlugin::DoSetRepoPath(const wxString& repoPath, bool promptUser)
         conf.Save();
 
         GIT_MESSAGE1("Git repo path is now set to '%s'", m_repositoryDirectory);
+        DoWatchRepository();
 
         // Update the status bar icon to reflect that we are using "Git"
         clStatusBar* sb = m_mgr->GetStatusBar();
@@ -978,26 +984,7 @@ void GitPlugin::OnBisectReset(wxCommandEvent& e)
 void GitPlugin::OnFileSaved(clCommandEvent& e)
 {
     e.Skip();
-    std::map<wxString, wxTreeItemId>::const_iterator it;
-
-    // First get an up to date map of the filepaths/treeitemids of modified files
-    // (Trying to cache these results in segfaults when the tree has been modified)
-    std::map<wxString, wxTreeItemId> modifiedIDs;
-    CreateFilesTreeIDsMap(modifiedIDs, true);
-
-    for(it = modifiedIDs.begin(); it != modifiedIDs.end(); ++it) {
-        if(!it->second.IsOk()) {
-            GIT_MESSAGE(wxT("Stored item not found in tree, rebuilding item IDs"));
-            gitAction ga(gitListAll, wxT(""));
-            m_gitActionQueue.push_back(ga);
-            break;
-        }
-        DoSetTreeItemImage(m_mgr->GetWorkspaceTree(), it->second, OverlayTool::Bmp_Modified);
-    }
-
-    gitAction ga(gitListModified, wxT(""));
-    m_gitActionQueue.push_back(ga);
-    ProcessGitActionQueue();
+    // The status refresh updates only the files whose status changed
     RefreshFileListView();
 }
 
@@ -1101,7 +1088,7 @@ void GitPlugin::ProcessGitActionQueue()
         break;
 
     case gitStatus:
-        command << " --no-pager status -s";
+        command << " -c core.quotePath=false --no-pager status --porcelain=v2";
         GIT_MESSAGE1("%s", command.c_str());
         GIT_MESSAGE1(wxT("%s. Repo path: %s"), command.c_str(), m_repositoryDirectory.c_str());
         break;
@@ -1112,12 +1099,6 @@ void GitPlugin::ProcessGitActionQueue()
         GIT_MESSAGE1(wxT("%s. Repo path: %s"), command.c_str(), m_repositoryDirectory.c_str());
         break;
 
-    case gitListModified:
-        GIT_MESSAGE1(wxT("Listing modified files in git repository"));
-        command << wxT(" --no-pager ls-files -m");
-        GIT_MESSAGE1(wxT("%s. Repo path: %s"), command.c_str(), m_repositoryDirectory.c_str());
-        break;
-
     case gitUpdateRemotes:
         GIT_MESSAGE1(wxT("Updating remotes"));
         command << wxT(" --no-pager remote update");
@@ -1346,37 +1327,17 @@ void GitPlugin::FinishGitListAction(const gitAction& ga)
 
     if(ga.action == gitListAll) {
         m_mgr->SetStatusMessage(_("Colouring tracked git files..."), 0);
-        ColourFileTree(m_mgr->GetWorkspaceTree(), gitFileSet, OverlayTool::Bmp_OK);
-        m_trackedFiles.swap(gitFileSet);
-
-    } else if(ga.action == gitListModified) {
-        m_mgr->SetStatusMessage(_("Colouring modified git files..."), 0);
-        // Reset modified files
-        ColourFileTree(m_mgr->GetWorkspaceTree(), m_modifiedFiles, OverlayTool::Bmp_OK);
-        // First get an up to date map of the filepaths/treeitemids
-        // (Trying to cache these results in segfaults when the tree has been modified)
-        std::map<wxString, wxTreeItemId> IDs;
-        CreateFilesTreeIDsMap(IDs);
-
-        // Now filter using the list of modified files, gitFileList, to find which IDs to colour differently
-        wxStringSet_t toColour;
+        // The tree was reset: restore the files known to be modified as well
+        std::map<wxString, OverlayTool::BmpType> files;
         wxStringSet_t::const_iterator iter = gitFileSet.begin();
         for(; iter != gitFileSet.end(); ++iter) {
-            wxTreeItemId id = IDs[(*iter)];
-            if(id.IsOk()) {
-                DoSetTreeItemImage(m_mgr->GetWorkspaceTree(), id, OverlayTool::Bmp_Modified);
-
-            } else {
-                toColour.insert(*iter);
-            }
+            files.insert(std::make_pair(*iter, OverlayTool::Bmp_OK));
         }
-
-        if(!toColour.empty()) {
-            ColourFileTree(m_mgr->GetWorkspaceTree(), toColour, OverlayTool::Bmp_Modified);
+        for(iter = m_modifiedFiles.begin(); iter != m_modifiedFiles.end(); ++iter) {
+            files[*iter] = OverlayTool::Bmp_Modified;
         }
-
-        // Finally, cache the modified-files list: it's used in other functions
-        m_modifiedFiles.swap(gitFileSet);
+        ColourFileTree(m_mgr->GetWorkspaceTree(), files);
+        m_trackedFiles.swap(gitFileSet);
     }
     m_mgr->SetStatusMessage("", 0);
 }
@@ -1572,7 +1533,6 @@ void GitPlugin::OnProcessTerminated(clProcessEvent& event)
         EventNotifier::Get()->QueueEvent(evt.Clone());
     } break;
     case gitListAll:
-    case gitListModified:
     case gitResetRepo: {
         if(ga.action == gitListAll && m_bActionRequiresTreUpdate) {
             if(m_commandOutput.Lower().Contains(_("created"))) {
@@ -1591,8 +1551,11 @@ void GitPlugin::OnProcessTerminated(clProcessEvent& event)
         }
     } break;
     case gitStatus: {
-        m_console->UpdateTreeView(m_commandOutput);
-        FinishGitListAction(ga);
+        // "git status" may have refreshed the index: remember its state so the index watcher ignores that write
+        wxFileName indexFile = DoGetIndexFile();
+        m_indexModificationTime = FileUtils::GetFileModificationTime(indexFile);
+        m_indexSize = FileUtils::GetFileSize(indexFile);
+        DoUpdateStatus();
     } break;
     case gitListRemotes: {
         wxArrayString gitList = wxStringTokenize(m_commandOutput, wxT("\n"));
@@ -1636,7 +1599,7 @@ void GitPlugin::OnProcessTerminated(clProcessEvent& event)
         EventNotifier::Get()->PostReloadExternallyModifiedEvent(true);
 
         gitAction newAction;
-        newAction.action = gitListModified;
+        newAction.action = gitStatus;
         m_gitActionQueue.push_back(newAction);
 
         if(ga.action == gitResetFile) {
@@ -1703,7 +1666,7 @@ void GitPlugin::OnProcessTerminated(clProcessEvent& event)
             // update the tree
             gitAction ga(gitListAll, wxT(""));
             m_gitActionQueue.push_back(ga);
-            ga.action = gitListModified;
+            ga.action = gitStatus;
             m_gitActionQueue.push_back(ga);
         }
 
@@ -1888,6 +1851,7 @@ void GitPlugin::InitDefaults()
 
     if(!repoPath.IsEmpty() && wxFileName::DirExists(repoPath + wxFileName::GetPathSeparator() + wxT(".git"))) {
         m_repositoryDirectory = repoPath;
+        DoWatchRepository();
 
     } else {
         DoCleanup();
@@ -1917,9 +1881,6 @@ void GitPlugin::AddDefaultActions()
     //    ga.action = gitListAll;
     //    m_gitActionQueue.push_back(ga);
 
-    ga.action = gitListModified;
-    m_gitActionQueue.push_back(ga);
-
     // ga.action = gitUpdateRemotes;
     // m_gitActionQueue.push_back(ga);
 
@@ -1937,8 +1898,11 @@ void GitPlugin::AddDefaultActions()
 }
 
 /*******************************************************************************/
-void GitPlugin::ColourFileTree(clTreeCtrl* tree, const wxStringSet_t& files, OverlayTool::BmpType bmpType) const
+void GitPlugin::ColourFileTree(clTreeCtrl* tree, const std::map<wxString, OverlayTool::BmpType>& files) const
 {
+    if(files.empty())
+        return;
+
     clConfig conf("git.conf");
     GitEntry data;
     conf.ReadItem(&data);
@@ -1957,8 +1921,11 @@ void GitPlugin::ColourFileTree(clTreeCtrl* tree, const wxStringSet_t& files, Ove
         if(next != tree->GetRootItem()) {
             FilewViewTreeItemData* data = static_cast<FilewViewTreeItemData*>(tree->GetItemData(next));
             const wxString& path = data->GetData().GetFile();
-            if(!path.IsEmpty() && files.count(path)) {
-                DoSetTreeItemImage(tree, next, bmpType);
+            if(!path.IsEmpty()) {
+                std::map<wxString, OverlayTool::BmpType>::const_iterator iter = files.find(path);
+                if(iter != files.end()) {
+                    DoSetTreeItemImage(tree, next, iter->second);
+                }
             }
         }
 
@@ -2055,6 +2022,11 @@ void GitPlugin::DoCleanup()
     m_remoteBranchList.Clear();
     m_trackedFiles.clear();
     m_modifiedFiles.clear();
+    m_statusCache.Clear();
+    if(m_indexWatcher) { m_indexWatcher->Clear(); }
+    if(m_headWatcher) { m_headWatcher->Clear(); }
+    m_indexModificationTime = 0;
+    m_indexSize = 0;
     m_addedFiles = false;
     m_progressMessage.Clear();
     m_commandOutput.Clear();
@@ -2190,6 +2162,16 @@ void GitPlugin::UndoAddFiles(const wxArrayString& files)
 
 void GitPlugin::RefreshFileListView()
 {
+    // A status refresh which did not start yet will pick up this change as well
+    std::list<gitAction>::const_iterator iter = m_gitActionQueue.begin();
+    if(m_process && iter != m_gitActionQueue.end()) { ++iter; }
+    for(; iter != m_gitActionQueue.end(); ++iter) {
+        if(iter->action == gitStatus) {
+            ProcessGitActionQueue();
+            return;
+        }
+    }
+
     gitAction ga;
     ga.action = gitStatus;
     m_gitActionQueue.push_back(ga);
@@ -2686,7 +2668,7 @@ void GitPlugin::OnActiveProjectChanged(clProjectSettingsEvent& event)
     // Clear any stale repo data, otherwise it looks as if there's a valid git
     // repo when it actually belongs to a different project
     DoCleanup();
-    m_console->UpdateTreeView("");
+    m_console->UpdateTreeView(GitStatusCache::Entry::Vec_t());
 
     wxFileName projectFile(event.GetFileName());
     DoSetRepoPath(projectFile.GetPath(), false);
@@ -2758,8 +2740,101 @@ void GitPlugin::OnAppActivated(wxCommandEvent& event)
 {
     event.Skip();
     if(IsGitEnabled()) {
-        CallAfter(&GitPlugin::DoRefreshView, false);
+        // Changes made to the work tree outside of CodeLite do not touch the index: refresh the status only. The
+        // branches and the tracked files are refreshed when the repository HEAD changes
+        CallAfter(&GitPlugin::RefreshFileListView);
+    }
+}
+
+void GitPlugin::OnRepositoryFileModified(clFileSystemEvent& event)
+{
+    if(!IsGitEnabled()) {
+        return;
+    }
+
+    wxFileName fn(event.GetPath());
+    if(fn.GetFullName() == "HEAD") {
+        // a checkout (or reset) was done outside of CodeLite
+        DoRefreshView(false);
+
+    } else {
+        // The index was written by a git command. "git status" refreshes the index as well: ignore the writes made
+        // while it runs and the ones that left the index as the last run saw it, or each run would trigger another
+        if(DoIsStatusRunning()) {
+            return;
+        }
+
+        wxFileName indexFile = DoGetIndexFile();
+        if(FileUtils::GetFileModificationTime(indexFile) == m_indexModificationTime &&
+           FileUtils::GetFileSize(indexFile) == m_indexSize) {
+            return;
+        }
+        RefreshFileListView();
+    }
+}
+
+wxFileName GitPlugin::DoGetIndexFile() const
+{
+    wxFileName indexFile(m_repositoryDirectory, "index");
+    indexFile.AppendDir(".git");
+    return indexFile;
+}
+
+bool GitPlugin::DoIsStatusRunning() const
+{
+    // the action at the head of the queue is the one being executed
+    return m_process && !m_gitActionQueue.empty() && m_gitActionQueue.front().action == gitStatus;
+}
+
+void GitPlugin::DoWatchRepository()
+{
+    if(!m_indexWatcher) {
+        m_indexWatcher.reset(new clFileSystemWatcher());
+        m_indexWatcher->SetOwner(this);
+        m_headWatcher.reset(new clFileSystemWatcher());
+        m_headWatcher->SetOwner(this);
+    }
+    m_indexWatcher->Clear();
+    m_headWatcher->Clear();
+
+    wxFileName gitDir(m_repositoryDirectory, "");
+    gitDir.AppendDir(".git");
+    if(!gitDir.DirExists()) {
+        // submodules and work trees use a ".git" file, fallback to the focus based refresh
+        return;
+    }
+
+    m_indexWatcher->SetFile(wxFileName(gitDir.GetPath(), "index"));
+    m_indexWatcher->Start();
+    m_headWatcher->SetFile(wxFileName(gitDir.GetPath(), "HEAD"));
+    m_headWatcher->Start();
+}
+
+void GitPlugin::DoUpdateStatus()
+{
+    wxStringSet_t changed;
+    if(!m_statusCache.Update(m_commandOutput, m_repositoryDirectory, changed)) {
+        // nothing changed since the previous snapshot
+        return;
+    }
+
+    m_console->UpdateTreeView(m_statusCache.GetSortedEntries());
+    m_statusCache.GetModifiedFiles(m_modifiedFiles);
+    if(changed.empty()) {
+        return;
+    }
+
+    // Update the tree only for the files whose status changed, in a single pass
+    std::map<wxString, OverlayTool::BmpType> files;
+    wxStringSet_t::const_iterator iter = changed.begin();
+    for(; iter != changed.end(); ++iter) {
+        if(m_modifiedFiles.count(*iter)) {
+            files.insert(std::make_pair(*iter, OverlayTool::Bmp_Modified));
+        } else if(!m_statusCache.Find(*iter)) {
+            files.insert(std::make_pair(*iter, OverlayTool::Bmp_OK));
+        }
     }
+    ColourFileTree(m_mgr->GetWorkspaceTree(), files);
 }
 
 bool GitPlugin::IsGitEnabled() const { return !m_repositoryDirectory.IsEmpty(); }
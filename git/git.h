@@ -50,6 +50,8 @@
 #include "gitui.h"
 #include <vector>
 #include "clTabTogglerHelper.h"
+#include "GitStatusCache.h"
+#include "clFileSystemWatcher.h"
 
 class clTreeCtrl;
 class clCommandProcessor;
@@ -107,7 +109,6 @@ class GitPlugin : public IPlugin
         gitNone = 0,
         gitUpdateRemotes,
         gitListAll,
-        gitListModified,
         gitListRemotes,
         gitAddFile,
         gitDeleteFile,
@@ -145,6 +146,11 @@ class GitPlugin : public IPlugin
     wxArrayString m_remoteBranchList;
     wxStringSet_t m_trackedFiles;
     wxStringSet_t m_modifiedFiles;
+    GitStatusCache m_statusCache;
+    clFileSystemWatcher::Ptr_t m_indexWatcher;
+    clFileSystemWatcher::Ptr_t m_headWatcher;
+    time_t m_indexModificationTime; // .git/index as seen when the last "git status" completed
+    size_t m_indexSize;
     bool m_addedFiles;
     wxArrayString m_remotes;
     wxColour m_colourTrackedFile;
@@ -185,10 +191,14 @@ private:
     void AddDefaultActions();
     void LoadDefaultGitCommands(GitEntry& data, bool overwrite = false);
     void ProcessGitActionQueue();
-    void ColourFileTree(clTreeCtrl* tree, const wxStringSet_t& files, OverlayTool::BmpType bmpType) const;
+    void ColourFileTree(clTreeCtrl* tree, const std::map<wxString, OverlayTool::BmpType>& files) const;
     void CreateFilesTreeIDsMap(std::map<wxString, wxTreeItemId>& IDs, bool ifmodified = false) const;
     void DoShowCommitDialog(const wxString& diff, wxString& commitArgs);
     void DoRefreshView(bool ensureVisible);
+    void DoUpdateStatus();
+    void DoWatchRepository();
+    wxFileName DoGetIndexFile() const;
+    bool DoIsStatusRunning() const;
 
     /// Workspace management
     bool IsWorkspaceOpened() const;
@@ -256,6 +266,7 @@ private:
     void OnActiveProjectChanged(clProjectSettingsEvent& event);
     void OnFileGitBlame(wxCommandEvent& event);
     void OnAppActivated(wxCommandEvent& event);
+    void OnRepositoryFileModified(clFileSystemEvent& event);
 
 #if 0
     void OnBisectStart(wxCommandEvent& e);
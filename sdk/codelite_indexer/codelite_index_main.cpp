@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <vector>
 #include "workerthread.h"
 #include "utils.h"
 #include "equeue.h"
@@ -11,9 +12,14 @@
 #define PIPE_NAME "\\\\.\\pipe\\codelite_indexer_%s"
 HINSTANCE gHandler = NULL;
 #else
+#include <signal.h>
 #define PIPE_NAME "/tmp/codelite_indexer.%s.sock"
 #endif
 
+// number of connections that can be served at the same time
+#define DEFAULT_WORKERS 4
+#define MAX_WORKERS     32
+
 static eQueue<clNamedPipe*> g_connectionQueue;
 
 int main(int argc, char **argv)
@@ -24,18 +30,25 @@ int main(int argc, char **argv)
 	// as described in http://jrfonseca.dyndns.org/projects/gnu-win32/software/drmingw/
 	// load the exception handler dll so we will get Dr MinGW at runtime
 	gHandler = LoadLibrary("exchndl.dll");
+#else
+	// A client may close its connection before all the replies were sent (e.g. the parsing was cancelled).
+	// Writing to it must fail with EPIPE so the worker can move on, instead of killing the indexer
+	signal(SIGPIPE, SIG_IGN);
 #endif
 
 	int  max_requests(5000);
 	int  requests(0);
 	long parent_pid (0);
+	int  workers(DEFAULT_WORKERS);
 	if(argc < 2){
-		printf("Usage: %s <string> [--pid]\n",    argv[0]);
+		printf("Usage: %s <string> [--pid] [--workers <count>]\n",    argv[0]);
 		printf("Usage: %s --batch <file_list> <output file>\n", argv[0]);
-		printf("   <string> - a unique string that identifies this indexer from other instances               \n");
-		printf("   --pid    - when set, <string> is handled as process number and the indexer will            \n");
-		printf("              check if this process alive. If it is down, the indexer will go down as well\n");
-		printf("   --batch  - when set, batch parsing is done using list of files set in file_list argument   \n");
+		printf("   <string>  - a unique string that identifies this indexer from other instances               \n");
+		printf("   --pid     - when set, <string> is handled as process number and the indexer will            \n");
+		printf("               check if this process alive. If it is down, the indexer will go down as well\n");
+		printf("               (a suffix, e.g. <pid>_1, can be used to run several indexers per process)   \n");
+		printf("   --workers - number of connections served in parallel (default: %d)                         \n", DEFAULT_WORKERS);
+		printf("   --batch   - when set, batch parsing is done using list of files set in file_list argument   \n");
 		return 1;
 	}
 
@@ -45,9 +58,19 @@ int main(int argc, char **argv)
 		return 0;
 	}
 
-	if ( argc == 3 && strcmp( argv[2], "--pid") == 0 ) {
-		parent_pid = atol( argv[1] );
-		printf("INFO: parent PID is set on %s\n", argv[1]);
+	for ( int i = 2; i < argc; i++ ) {
+		if ( strcmp( argv[i], "--pid") == 0 ) {
+			parent_pid = atol( argv[1] );
+			printf("INFO: parent PID is set on %s\n", argv[1]);
+
+		} else if ( strcmp( argv[i], "--workers") == 0 && (i + 1) < argc ) {
+			workers = atoi( argv[++i] );
+			if ( workers < 1 ) {
+				workers = 1;
+			} else if ( workers > MAX_WORKERS ) {
+				workers = MAX_WORKERS;
+			}
+		}
 	}
 
 	// create the connection factory
@@ -56,17 +79,21 @@ int main(int argc, char **argv)
 
 	clNamedPipeConnectionsServer server(channel_name);
 
-	// start the worker thread
-	WorkerThread  worker( &g_connectionQueue );
+	// start the worker threads. All of them are serving the same connection queue so a long
+	// request (e.g. a retag) does not block the short ones
+	std::vector<WorkerThread*> pool;
+	for ( int i = 0; i < workers; i++ ) {
+		pool.push_back( new WorkerThread( &g_connectionQueue ) );
+		pool.back()->run();
+	}
 
 	// start the 'is alive thread'
 	IsAliveThread isAliveThread( parent_pid, channel_name  );
-	worker.run();
 	if ( parent_pid ) {
 		isAliveThread.run();
 	}
 
-	printf("INFO: codelite_indexer started\n");
+	printf("INFO: codelite_indexer started with %d workers\n", workers);
 	printf("INFO: listening on %s\n", channel_name);
 
 	while (true) {
@@ -83,10 +110,16 @@ int main(int argc, char **argv)
 		requests ++;
 
 		if(requests == max_requests) {
-			// stop the worker thread and exit
+			// stop the worker threads and exit
 			printf("INFO: Max requests reached, going down\n");
-			worker.requestStop();
-			worker.wait(-1);
+			for ( size_t i = 0; i < pool.size(); i++ ) {
+				pool.at(i)->requestStop();
+			}
+			for ( size_t i = 0; i < pool.size(); i++ ) {
+				pool.at(i)->wait(-1);
+				delete pool.at(i);
+			}
+			pool.clear();
 
 			// stop the isAlive thread
 			if ( parent_pid ) {
@@ -0,0 +1,76 @@
+#ifndef __emutex_h__
+#define __emutex_h__
+
+#ifdef __WXMSW__
+#	include <windows.h>
+#else
+#	include <pthread.h>
+#endif
+
+/**
+ * \class eMutex
+ * \brief a minimal, non recursive, mutex
+ */
+class eMutex
+{
+#ifdef __WXMSW__
+	CRITICAL_SECTION m_cs;
+#else
+	pthread_mutex_t m_mutex;
+#endif
+
+	eMutex(const eMutex&);
+	eMutex& operator=(const eMutex&);
+
+public:
+	eMutex() {
+#ifdef __WXMSW__
+		InitializeCriticalSection(&m_cs);
+#else
+		pthread_mutex_init(&m_mutex, NULL);
+#endif
+	}
+
+	~eMutex() {
+#ifdef __WXMSW__
+		DeleteCriticalSection(&m_cs);
+#else
+		pthread_mutex_destroy(&m_mutex);
+#endif
+	}
+
+	void lock() {
+#ifdef __WXMSW__
+		EnterCriticalSection(&m_cs);
+#else
+		pthread_mutex_lock(&m_mutex);
+#endif
+	}
+
+	void unlock() {
+#ifdef __WXMSW__
+		LeaveCriticalSection(&m_cs);
+#else
+		pthread_mutex_unlock(&m_mutex);
+#endif
+	}
+};
+
+/**
+ * \class eMutexLocker
+ * \brief lock a mutex for the lifetime of the locker
+ */
+class eMutexLocker
+{
+	eMutex& m_mutex;
+
+public:
+	eMutexLocker(eMutex& mutex) : m_mutex(mutex) {
+		m_mutex.lock();
+	}
+	~eMutexLocker() {
+		m_mutex.unlock();
+	}
+};
+
+#endif // __emutex_h__
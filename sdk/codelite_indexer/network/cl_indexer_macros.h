@@ -51,12 +51,8 @@
 	memcpy((void*)&len, p, sizeof(len));\
 	p += sizeof(len);\
 	if(len > 0){\
-		char *tmp = new char[len+1];\
-		memcpy(tmp, p, len);\
-		tmp[len] = 0;\
+		s.assign(p, len);\
 		p += len;\
-		s = tmp;\
-		delete []tmp;\
 	}\
 }
 
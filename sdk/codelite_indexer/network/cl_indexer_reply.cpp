@@ -50,6 +50,33 @@ void clIndexerReply::fromBinary(char* data)
 	UNPACK_STD_STRING(m_tags, data);
 }
 
+size_t clIndexerReply::toBinaryHeader(std::string& header) const
+{
+	size_t tagsLen = m_tags.length();
+	header.clear();
+	header.reserve(sizeof(m_completionCode) + (2 * sizeof(size_t)) + m_fileName.length());
+	header.append((const char*)&m_completionCode, sizeof(m_completionCode));
+
+	size_t fileNameLen = m_fileName.length();
+	header.append((const char*)&fileNameLen, sizeof(fileNameLen));
+	header.append(m_fileName);
+	header.append((const char*)&tagsLen, sizeof(tagsLen));
+	return header.length() + tagsLen;
+}
+
+void clIndexerReply::appendTags(const char* tags, size_t len)
+{
+	if(len == 0) {
+		return;
+	}
+
+	if(!m_tags.empty()) {
+		m_tags.append(1, '\n');
+	}
+	// std::string grows geometrically, so appending N files is linear
+	m_tags.append(tags, len);
+}
+
 char* clIndexerReply::toBinary(size_t& buffer_size)
 {
 	buffer_size = 0;
@@ -40,6 +40,19 @@ public:
 	void fromBinary(char *data);
 	char *toBinary(size_t &buffer_size);
 
+	/**
+	 * \brief serialize everything but the tags string itself (which is the bulk of the reply). The tags are expected
+	 * to be written right after the header, see clIndexerProtocol::SendReply
+	 * \param header [output] the serialized header
+	 * \return the size of the complete reply (header + tags)
+	 */
+	size_t toBinaryHeader(std::string &header) const;
+
+	/**
+	 * \brief append tags to the reply, separated from the existing tags by a new line
+	 */
+	void appendTags(const char *tags, size_t len);
+
 	void setCompletionCode(const size_t& completionCode) {
 		this->m_completionCode = completionCode;
 	}
@@ -38,7 +38,9 @@ class clIndexerRequest
 public:
 	enum {
 		CLI_PARSE,
-		CLI_PARSE_AND_SAVE
+		CLI_PARSE_AND_SAVE,
+		// parse the files and send a reply per file (in the order they were requested)
+		CLI_PARSE_FILES
 	};
 
 public:
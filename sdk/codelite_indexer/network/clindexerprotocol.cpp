@@ -136,19 +136,11 @@ bool clIndexerProtocol::ReadRequest(clNamedPipe* conn, clIndexerRequest& req)
     return true;
 }
 
-bool clIndexerProtocol::SendReply(clNamedPipe* conn, clIndexerReply& reply)
+static bool WriteChunks(clNamedPipe* conn, const char* data, size_t size)
 {
-    size_t buff_size(0);
-    char* data = reply.toBinary(buff_size);
-    CharDeleter deleter(data);
-
-    // send the reply size
-    size_t written(0);
-    conn->write((void*)&buff_size, sizeof(buff_size), &written, -1);
-
-    int bytes_left(buff_size);
-    int bytes_to_write(0);
-    int bytes_written(0);
+    size_t bytes_left(size);
+    size_t bytes_to_write(0);
+    size_t bytes_written(0);
 
     while(bytes_left > 0) {
         // we write in chunks of 3000 bytes
@@ -166,11 +158,28 @@ bool clIndexerProtocol::SendReply(clNamedPipe* conn, clIndexerReply& reply)
         bytes_left -= actual_written;
         bytes_written += actual_written;
     }
-
-    // the above problem does not exist under Windows' NamedPipes
     return true;
 }
 
+bool clIndexerProtocol::SendReply(clNamedPipe* conn, clIndexerReply& reply)
+{
+    // The tags are written directly from the reply instead of being copied into
+    // a serialization buffer first. The bytes on the wire are the same as toBinary()
+    std::string header;
+    size_t buff_size = reply.toBinaryHeader(header);
+
+    // send the reply size
+    size_t written(0);
+    if(!conn->write((void*)&buff_size, sizeof(buff_size), &written, -1)) {
+        return false;
+    }
+
+    if(!WriteChunks(conn, header.c_str(), header.length())) {
+        return false;
+    }
+    return WriteChunks(conn, reply.getTags().c_str(), reply.getTags().length());
+}
+
 bool clIndexerProtocol::SendRequest(clNamedPipe* conn, clIndexerRequest& req)
 {
     size_t size(0);
@@ -7,10 +7,22 @@
 #include "network/clindexerprotocol.h"
 #include "libctags/libctags.h"
 #include "utils.h"
+#include "emutex.h"
 #include <stdlib.h>
+#include <string.h>
 #include <cstdio>
 #include <memory>
 
+// libctags keeps its state in global variables: only one thread at a time may run it. To parse
+// on all the cores, codelite deals large batches of files to several indexer processes
+static eMutex g_ctagsMutex;
+
+static char* make_tags(const std::string &options, const std::string &file)
+{
+	eMutexLocker locker(g_ctagsMutex);
+	return ctags_make_tags(options.c_str(), file.c_str());
+}
+
 WorkerThread::WorkerThread(eQueue<clNamedPipe*> *queue)
 		: m_queue(queue)
 {
@@ -37,68 +49,78 @@ void WorkerThread::start()
 				continue;
 			}
 
-			char *tags(NULL);
-			// create fies for the requested files
-			for (size_t i=0; i<req.getFiles().size(); i++) {
+			bool ok(false);
+			if ( req.getCmd() == clIndexerRequest::CLI_PARSE_FILES ) {
+				ok = streamReplies(conn, req);
+			} else {
+				ok = processRequest(conn, req);
+			}
+
+			if ( !ok ) {
+				// the client went away, drop the connection and serve the next one
+				fprintf(stderr, "ERROR: Protocol error: failed to send reply\n");
+			}
+		}
+	}
+	printf("INFO: WorkerThread: Going down\n");
+	exit(-1);
+}
+
+bool WorkerThread::processRequest(clNamedPipe *conn, const clIndexerRequest &req)
+{
+	// the tags of all the files are collected directly into the reply
+	clIndexerReply reply;
+	reply.setCompletionCode(0);
+	// create fies for the requested files
+	for (size_t i=0; i<req.getFiles().size(); i++) {
 
 #ifdef __DEBUG
-				printf("------------------------------------------------------------------\n");
-				printf("INFO: Source        : %s\n", req.getFiles().at(i).c_str());
-				printf("INFO: Command       : %d\n", req.getCmd());
-				printf("INFO: CTAGS options : %s\n", req.getCtagOptions().c_str());
-				printf("INFO: Database      : %s\n", req.getDatabaseFileName().c_str());
+		printf("------------------------------------------------------------------\n");
+		printf("INFO: Source        : %s\n", req.getFiles().at(i).c_str());
+		printf("INFO: Command       : %d\n", (int)req.getCmd());
+		printf("INFO: CTAGS options : %s\n", req.getCtagOptions().c_str());
+		printf("INFO: Database      : %s\n", req.getDatabaseFileName().c_str());
 #endif
 
-				char *new_tags = ctags_make_tags(req.getCtagOptions().c_str(), req.getFiles().at(i).c_str());
-				if (tags && new_tags) {
-					// re-allocate the buffer to containt the new tags + 2 chars: 1 for terminating null and one for the '\n'
-					// that will be appended
-					char *ptmp = (char*)malloc(strlen(tags) + strlen(new_tags) + 2);
-					memset(ptmp, 0, strlen(tags) + strlen(new_tags) + 2);
-					strcat(ptmp, tags);
-					strcat(ptmp, "\n");
-					strcat(ptmp, new_tags);
-
-					ctags_free(new_tags);
-					ctags_free(tags);
-
-					tags = ptmp;
-
-				} else if(new_tags) {
-					// first time
-					tags = new_tags;
-					new_tags = NULL;
-				}
-			}
+		char *new_tags = make_tags(req.getCtagOptions(), req.getFiles().at(i));
+		if (new_tags) {
+			reply.setCompletionCode(1);
+			reply.appendTags(new_tags, strlen(new_tags));
+			ctags_free(new_tags);
+		}
+	}
 
-			// prepare the reply
 #ifdef __DEBUG
-			std::vector<std::string> lines = string_tokenize(tags, "\n");
-			for(size_t i=0; i<lines.size(); i++){
-				printf("%s\n", lines.at(i).c_str());
-			}
+	std::vector<std::string> lines = string_tokenize(reply.getTags(), "\n");
+	for(size_t i=0; i<lines.size(); i++){
+		printf("%s\n", lines.at(i).c_str());
+	}
 #endif
 
-			clIndexerReply reply;
-			if (tags) {
-				// prepare reply
-				reply.setCompletionCode(1);
-				reply.setTags(tags);
-			} else {
-				reply.setCompletionCode(0);
-			}
+	// send the reply
+	return clIndexerProtocol::SendReply(conn, reply);
+}
 
+bool WorkerThread::streamReplies(clNamedPipe *conn, const clIndexerRequest &req)
+{
+	// the client consumes the tags of a file while we are parsing the next one
+	const std::vector<std::string> &files = req.getFiles();
+	for (size_t i=0; i<files.size(); i++) {
+		clIndexerReply reply;
+		reply.setFileName(files.at(i));
+
+		char *tags = make_tags(req.getCtagOptions(), files.at(i));
+		if (tags) {
+			reply.setCompletionCode(1);
+			reply.appendTags(tags, strlen(tags));
 			ctags_free(tags);
+		}
 
-			// send the reply
-			if ( !clIndexerProtocol::SendReply(conn, reply) ) {
-				fprintf(stderr, "ERROR: Protocol error: failed to send reply for file %s\n", reply.getFileName().c_str());
-				break;
-			}
+		if ( !clIndexerProtocol::SendReply(conn, reply) ) {
+			return false;
 		}
 	}
-	printf("INFO: WorkerThread: Going down\n");
-	exit(-1);
+	return true;
 }
 
 // ---------------------------------------------
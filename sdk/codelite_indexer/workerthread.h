@@ -9,9 +9,21 @@
 // parsing thread
 // ---------------------------------------------
 
+class clIndexerRequest;
 class WorkerThread : public eThread {
 	eQueue<clNamedPipe*> *m_queue;
 
+protected:
+	/**
+	 * \brief parse all the files of the request and send their tags back as a single reply
+	 */
+	bool processRequest(clNamedPipe *conn, const clIndexerRequest &req);
+
+	/**
+	 * \brief parse the files of the request one by one and send a reply per file, as soon as it is ready
+	 */
+	bool streamReplies(clNamedPipe *conn, const clIndexerRequest &req);
+
 public:
 	WorkerThread(eQueue<clNamedPipe*> *queue);
 	~WorkerThread();